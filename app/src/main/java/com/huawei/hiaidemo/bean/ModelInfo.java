@@ -10,6 +10,8 @@
 
 package com.huawei.hiaidemo.bean;
 
+import com.huawei.hiaidemo.utils.Constant;
+
 import java.io.Serializable;
 
 
@@ -210,4 +212,150 @@ public class ModelInfo implements Serializable{
     public void setFramework(String framework) {
         this.framework = framework;
     }
+
+    /**
+     * Classes kept by native post-processing. 0 returns the whole output;
+     * otherwise every output is {index0, score0, index1, score1, ...}, best first.
+     * Read when the model is loaded.
+     */
+    private int postTopK = 0;
+
+    /**
+     * Report softmax probabilities of the kept classes instead of raw scores
+     */
+    private boolean postSoftmax = false;
+
+    public int getPostTopK() {
+        return postTopK;
+    }
+
+    public void setPostTopK(int postTopK) {
+        this.postTopK = postTopK;
+    }
+
+    public boolean getPostSoftmax() {
+        return postSoftmax;
+    }
+
+    public void setPostSoftmax(boolean postSoftmax) {
+        this.postSoftmax = postSoftmax;
+    }
+
+    /**
+     * Requests of this model that runModelAsync can keep in flight. Each one
+     * owns its input and output tensors. Read when the model is loaded.
+     */
+    private int asyncDepth = 2;
+
+    public int getAsyncDepth() {
+        return asyncDepth;
+    }
+
+    public void setAsyncDepth(int asyncDepth) {
+        this.asyncDepth = asyncDepth;
+    }
+
+    /**
+     * For models compiled with batch N > 1: how long runModelBatchedSync waits
+     * for other images before running a partial batch. Read when the model is loaded.
+     */
+    private int batchWaitUs = 2000;
+
+    public int getBatchWaitUs() {
+        return batchWaitUs;
+    }
+
+    public void setBatchWaitUs(int batchWaitUs) {
+        this.batchWaitUs = batchWaitUs;
+    }
+
+    /**
+     * Inferences run on zero inputs in the background right after the model is
+     * loaded, so that the first real one is not slowed down by the first Process.
+     * 0 disables warm-up. Read when the model is loaded.
+     */
+    private int warmupRuns = 0;
+
+    public int getWarmupRuns() {
+        return warmupRuns;
+    }
+
+    public void setWarmupRuns(int warmupRuns) {
+        this.warmupRuns = warmupRuns;
+    }
+
+    /**
+     * One of Constant.QOS_*: priority of the sync requests of threads that did not
+     * call ModelManager.setThreadQosClass, and NPU frequency the model is loaded
+     * with (high, medium, low). Read when the model is loaded.
+     */
+    private int qosClass = Constant.QOS_INTERACTIVE;
+
+    public int getQosClass() {
+        return qosClass;
+    }
+
+    public void setQosClass(int qosClass) {
+        this.qosClass = qosClass;
+    }
+
+    /**
+     * Normalization of the model input, out = (pixel - mean) / std per plane, planes
+     * in B,G,R order when normalizeBgr is set. Set by ModelManager.readModelBundle for
+     * a bundle, the Caffe means of Constant otherwise.
+     */
+    private float[] normalizeMean = {(float) Constant.meanValueOfBlue, (float) Constant.meanValueOfGreen,
+            (float) Constant.meanValueOfRed};
+
+    private float[] normalizeStd = {1.f, 1.f, 1.f};
+
+    private boolean normalizeBgr = true;
+
+    public float[] getNormalizeMean() {
+        return normalizeMean;
+    }
+
+    public float[] getNormalizeStd() {
+        return normalizeStd;
+    }
+
+    public boolean getNormalizeBgr() {
+        return normalizeBgr;
+    }
+
+    /**
+     * AIPP parameters of runModelAippSync for a model with useAIPP, set by
+     * ModelManager.readModelBundle: one of Constant.IMAGE_TYPE_*, NV21 chroma order,
+     * crop {x, y, width, height} and DTC mean and variance reciprocal. null crop, mean
+     * or varReci leave the step out.
+     */
+    private int aippImageType = Constant.IMAGE_TYPE_BT_601_NARROW;
+
+    private boolean aippNv21 = false;
+
+    private int[] aippCrop = null;
+
+    private float[] aippMean = null;
+
+    private float[] aippVarReci = null;
+
+    public int getAippImageType() {
+        return aippImageType;
+    }
+
+    public boolean getAippNv21() {
+        return aippNv21;
+    }
+
+    public int[] getAippCrop() {
+        return aippCrop;
+    }
+
+    public float[] getAippMean() {
+        return aippMean;
+    }
+
+    public float[] getAippVarReci() {
+        return aippVarReci;
+    }
 }
@@ -20,4 +20,39 @@ public class Constant {
     public static final double meanValueOfGreen = 116.779;
     public static final double meanValueOfRed = 123.68;
 
+    // colour matrix of the AIPP input, same values as ImageType in HiAiAippPara.h
+    public static final int IMAGE_TYPE_JPEG = 0;
+    public static final int IMAGE_TYPE_BT_601_NARROW = 1;
+    public static final int IMAGE_TYPE_BT_601_FULL = 2;
+    public static final int IMAGE_TYPE_BT_709_NARROW = 3;
+
+    // cores of the native task pool, same values as CoreAffinity in task_pool.h
+    public static final int CORES_ANY = 0;
+    public static final int CORES_BIG = 1;
+    public static final int CORES_LITTLE = 2;
+
+    // warm-up state of a loaded model, same values as WarmupState in warmup.h
+    public static final int WARMUP_COLD = 0;
+    public static final int WARMUP_RUNNING = 1;
+    public static final int WARMUP_READY = 2;
+    public static final int WARMUP_FAILED = 3;
+
+    // priority class of inference requests, same values as QosClass in qos_scheduler.h
+    public static final int QOS_INTERACTIVE = 0;
+    public static final int QOS_NORMAL = 1;
+    public static final int QOS_BACKGROUND = 2;
+    // inFlight of configureQos that never holds a request back
+    public static final int QOS_IN_FLIGHT_UNBOUNDED = 0;
+    // inFlight until configureQos is called, same value as QOS_DEFAULT_IN_FLIGHT in qos_scheduler.h
+    public static final int QOS_DEFAULT_IN_FLIGHT = 2;
+
+    // tensor set handle of acquireTensorsSync when none came free, as NO_SYNC_TENSORS in sync_session.h
+    public static final int NO_SYNC_TENSORS = -1;
+
+    // stage of a submitModelBuild job, same values as BUILD_STAGE in buildmodel.cpp
+    public static final int BUILD_CHECKING = 0;
+    public static final int BUILD_BUILDING = 1;
+    public static final int BUILD_DONE = 2;
+    public static final int BUILD_FAILED = 3;
+
 }
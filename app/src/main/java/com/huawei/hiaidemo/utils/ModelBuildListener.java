@@ -0,0 +1,23 @@
+/*
+*@file ModelBuildListener.java
+*
+* Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+package com.huawei.hiaidemo.utils;
+
+public interface ModelBuildListener {
+
+    /**
+     * Called on a native worker as a job of submitModelBuild goes through its stages.
+     * BUILD_BUILDING is skipped when the model is compatible or cached; BUILD_DONE and
+     * BUILD_FAILED are the last call of a job.
+     * @param stage one of Constant.BUILD_*
+     */
+    void onBuildProgress(int jobId, String modelPath, int stage);
+
+}
@@ -0,0 +1,25 @@
+/*
+*@file ModelLoadListener.java
+*
+* Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+package com.huawei.hiaidemo.utils;
+
+import com.huawei.hiaidemo.bean.ModelInfo;
+
+import java.util.ArrayList;
+
+public interface ModelLoadListener {
+
+    /**
+     * Called on a native thread once the models are loaded, with the list passed
+     * to the load and its dimensions filled in, or null if a model failed to load.
+     */
+    void onModelsLoaded(ArrayList<ModelInfo> modelInfo);
+
+}
@@ -11,10 +11,12 @@
 package com.huawei.hiaidemo.utils;
 
 import android.content.res.AssetManager;
+import android.graphics.Bitmap;
 import android.util.Log;
 import android.widget.Toast;
 
 import com.huawei.hiaidemo.bean.ModelInfo;
+import java.nio.ByteBuffer;
 import java.util.ArrayList;
 
 public class ModelManager {
@@ -38,21 +40,389 @@ public class ModelManager {
 
     public static native ArrayList<float[]> runModelSync(ModelInfo modelInfo, ArrayList<byte[]> buf);
 
+    /**
+     * Run one image on a sync model compiled with batch N > 1. Concurrent calls are
+     * coalesced into batches of up to N, run when full or after ModelInfo.batchWaitUs.
+     * @param buf one image per model input, 1/N of the input tensor each
+     * @return outputs of this image only, as runModelSync; null on failure
+     */
+    public static native ArrayList<float[]> runModelBatchedSync(ModelInfo modelInfo, ArrayList<byte[]> buf);
+
     public static native long GetTimeUseSync();
 
+    /**
+     * Check a set of input and output tensors of a sync model out of its small pool,
+     * for the calls that fill and run them separately. The handle may be used from
+     * any thread; give it back with releaseTensorsSync in a finally block, as the
+     * pool only has a few sets and waits at most a second for one to come free.
+     * @return handle of the set, Constant.NO_SYNC_TENSORS if none came free
+     */
+    public static native int acquireTensorsSync(ModelInfo modelInfo);
+
+    /**
+     * Give a tensor set back to the pool of the model. The views of
+     * getInputBuffersSync and leaseOutputBuffersSync must not be used anymore.
+     */
+    public static native void releaseTensorsSync(ModelInfo modelInfo, int tensors);
+
+    /**
+     * Direct views of the input tensors of a tensor set, in native byte order.
+     * Fill them in place and call runModelInPlaceSync; nothing is copied.
+     */
+    public static native ArrayList<ByteBuffer> getInputBuffersSync(ModelInfo modelInfo, int tensors);
+
+    /**
+     * Run a sync model on the current content of the input tensors of a tensor set.
+     * The set stays checked out: fill and run it again, or release it.
+     * @return model outputs as runModelSync, null on failure
+     */
+    public static native ArrayList<float[]> runModelInPlaceSync(ModelInfo modelInfo, int tensors);
+
+    /**
+     * Fill an input of a tensor set with mean-subtracted B/G/R planes straight from an
+     * ARGB_8888 bitmap, then call runModelInPlaceSync with the same set.
+     * @return false if the bitmap does not match the model input
+     */
+    public static native boolean setInputFromBitmapSync(ModelInfo modelInfo, int tensors, Bitmap bitmap,
+                                                        int inputIndex, float meanB, float meanG, float meanR);
+
+    /**
+     * Convert an ARGB_8888 bitmap to YUV420SP (NV12, or NV21) straight into the
+     * AIPP input of a tensor set, then call runModelInPlaceSync with the same set.
+     * @param imageType one of Constant.IMAGE_TYPE_*
+     * @return false if the bitmap does not match the model input
+     */
+    public static native boolean setAippInputFromBitmapSync(ModelInfo modelInfo, int tensors, Bitmap bitmap,
+                                                            int inputIndex, int imageType, boolean nv21);
+
+    /**
+     * Center-crop, bilinear-resize and normalize a decoded ARGB_8888 bitmap of any size
+     * into an input of a tensor set in one pass: out = (pixel - mean) / std.
+     * @param mean per output plane, 3 values
+     * @param std  per output plane, 3 values
+     * @param bgr  write planes in B,G,R order instead of R,G,B
+     * @return false if the model input is not a 3 channel float tensor
+     */
+    public static native boolean setInputFromBitmapFusedSync(ModelInfo modelInfo, int tensors, Bitmap bitmap,
+                                                             int inputIndex, float[] mean, float[] std, boolean bgr);
+
+    /**
+     * Run a sync model on the current content of the input tensors of a tensor set
+     * and keep the results in its output tensors, without creating float arrays.
+     * @return false if Process failed or the outputs stayed leased for a second
+     */
+    public static native boolean runModelBuffersSync(ModelInfo modelInfo, int tensors);
+
+    /**
+     * Direct views of the output tensors runModelBuffersSync filled, in native byte
+     * order. The model does not run again on the set until releaseOutputBuffersSync
+     * or releaseTensorsSync.
+     */
+    public static native ArrayList<ByteBuffer> leaseOutputBuffersSync(ModelInfo modelInfo, int tensors);
+
+    /**
+     * The views of leaseOutputBuffersSync must not be read anymore; the set stays
+     * checked out for the next run.
+     */
+    public static native void releaseOutputBuffersSync(ModelInfo modelInfo, int tensors);
+
+    /**
+     * Run a sync model on a raw YUV420SP camera frame. Crop, colour conversion to RGB,
+     * resize to the model input and (pixel - mean) * varReci are done by dynamic AIPP
+     * on the NPU, or by the CPU AIPP engine when the DDK or the model lacks it.
+     * @param crop     {x, y, width, height} in frame pixels, null for the whole frame
+     * @param imageType one of Constant.IMAGE_TYPE_*
+     * @param mean     per RGB channel, null for 0
+     * @param varReci  per RGB channel, null for 1
+     * @return model outputs as runModelSync, null on failure
+     */
+    public static native ArrayList<float[]> runModelAippSync(ModelInfo modelInfo, byte[] frame, int frameW, int frameH,
+                                                             int[] crop, int imageType, boolean nv21,
+                                                             float[] mean, float[] varReci);
+
     public static native void runModelAsync(ModelInfo modelInfo, ArrayList<byte[]> buf, ModelManagerListener listener);
 
+    /**
+     * runModelAsync that remembers a caller tag with the request.
+     * @param tag       also the id cancelAsyncRequest drops the request by, 0 for none
+     * @param timeoutMs deadline from now, 0 for none. A request still waiting for a slot
+     *                  at its deadline is dropped without running, and the time left is
+     *                  the timeout of the inference.
+     * @return taskId passed to the listener, -1 on failure or if the request was dropped
+     */
+    public static native int runModelAsyncTagged(ModelInfo modelInfo, ArrayList<byte[]> buf, long tag,
+                                                 int timeoutMs, ModelManagerListener listener);
+
+    /**
+     * Tag given to runModelAsyncTagged or runModelInPlaceAsync. Valid inside the
+     * listener callback of the request, and until releaseOutputBuffersAsync for
+     * leased outputs.
+     * @return 0 if taskId is not in flight
+     */
+    public static native long getAsyncTaskTag(int taskId);
+
+    /**
+     * Reserve a free input slot of an async model, blocking while every slot is in
+     * flight. The reservation may be used from any thread; pass it to
+     * runModelInPlaceAsync, or to releaseInputSlotAsync if it is not run, as the
+     * ring only has a few slots.
+     * @return reservation of the slot, -1 if the model is not loaded
+     */
+    public static native int acquireInputSlotAsync(ModelInfo modelInfo);
+
+    /**
+     * Direct views of the input tensors of a reserved slot, in native byte order.
+     * @return null if reservation is not reserved
+     */
+    public static native ArrayList<ByteBuffer> getInputBuffersAsync(int reservation);
+
+    /**
+     * Give back a slot reserved by acquireInputSlotAsync without running it.
+     */
+    public static native void releaseInputSlotAsync(int reservation);
+
+    /**
+     * Submit a slot reserved by acquireInputSlotAsync, without copying. The
+     * reservation ends with the call, even if it fails. The buffers must not be
+     * written again until listener.OnProcessDone.
+     * @param tag       as in runModelAsyncTagged
+     * @param timeoutMs as in runModelAsyncTagged
+     * @return taskId passed to the listener, -1 if nothing was reserved or Process failed
+     */
+    public static native int runModelInPlaceAsync(ModelInfo modelInfo, int reservation, long tag, int timeoutMs,
+                                                  ModelManagerListener listener);
+
+    /**
+     * Return the output buffers passed to ModelManagerBufferListener.OnProcessDoneBuffers
+     * and free the input slot of that request.
+     */
+    public static native void releaseOutputBuffersAsync(int taskId);
+
+    /**
+     * Drop the async requests and pipeline frames submitted with tag, e.g. for
+     * frames the UI no longer shows. Requests not submitted to the NPU yet never
+     * run; the results of those already running are not delivered.
+     * @return requests cancelled, 0 if none is in progress
+     */
+    public static native int cancelAsyncRequest(long tag);
+
+    /**
+     * @return {completed, expired before reaching the NPU, cancelled, failed} async
+     *          requests and pipeline frames
+     */
+    public static native long[] getRequestStatsAsync();
+
+    /**
+     * The async models are reloaded on a new client when the NPU service dies, and
+     * the requests in flight are resubmitted within their deadline or failed.
+     * Listeners still get onServiceDied; a replayed request keeps its task id.
+     * @return {state (0 ready, 1 recovering, 2 lost), deaths, recoveries, failed
+     *          recoveries, last recovery us, max recovery us, requests replayed,
+     *          requests failed}
+     */
+    public static native long[] getServiceRecoveryStatsAsync();
+
+    /**
+     * Start a native preprocess -> inference -> postprocess pipeline for an async
+     * model with a 3 channel float input. Bitmaps are center-cropped, resized and
+     * normalized as (pixel - mean) / std by preprocessThreads workers, run on the
+     * model's async slots, and their results go to listener, tag as given.
+     * @param queueDepth frames waiting before preprocessing, and before submission
+     * @return false if the model is not loaded or already has a pipeline
+     */
+    public static native boolean startPipelineAsync(ModelInfo modelInfo, int preprocessThreads, int queueDepth,
+                                                    float[] mean, float[] std, boolean bgr,
+                                                    ModelManagerListener listener);
+
+    /**
+     * Queue an ARGB_8888 bitmap; its pixels are copied, so it can be reused on return.
+     * Blocks while the first queue is full. A frame past its deadline, or cancelled
+     * by tag, is dropped at the next stage it reaches.
+     * @param timeoutMs deadline from now, 0 for none
+     */
+    public static native boolean submitPipelineAsync(ModelInfo modelInfo, Bitmap bitmap, long tag, int timeoutMs);
+
+    /**
+     * {preprocess queue, submit queue, in flight, postprocess queue, preprocess peak,
+     * submit peak, postprocess peak, completed, dropped}
+     */
+    public static native long[] getPipelineStatsAsync(ModelInfo modelInfo);
+
+    /**
+     * Finish every queued frame, deliver its result and stop the pipeline threads.
+     */
+    public static native void stopPipelineAsync(ModelInfo modelInfo);
+
     public static native ArrayList<ModelInfo> loadModelAsync(ArrayList<ModelInfo> modelInfo);
 
+    /**
+     * loadModelAsync on a native thread, returning at once. The models are loaded
+     * in parallel, so startup takes about as long as the slowest of them.
+     * @return false if the load cannot be started; listener is not called then
+     */
+    public static native boolean loadModelAsyncInBackground(ArrayList<ModelInfo> modelInfo,
+            ModelLoadListener listener);
+
+    /**
+     * Where the startup time of an async model went.
+     * @return {map us, load us, IO dimensions us, tensors us, ready us after the load started},
+     *          null if not loaded. The async models share one load.
+     */
+    public static native long[] getLoadTimesAsync(ModelInfo modelInfo);
+
+    /**
+     * Load models straight from the APK: loadModelSync and loadModelAsync then map
+     * ModelInfo.getOfflineModel() from the assets, with no copy in app storage and
+     * none on the heap, and fall back to getModelPath() for models not in the APK.
+     * Assets are mapped only if stored uncompressed (aaptOptions noCompress "om").
+     * @return false if the asset manager cannot be used
+     */
+    public static native boolean setModelAssets(AssetManager assetManager);
+
+    /**
+     * Warm-up progress of a model loaded with ModelInfo.warmupRuns > 0. Send it
+     * traffic once the state is Constant.WARMUP_READY.
+     * @return {state, runs done, first inference us, mean of the others us}, null if not loaded
+     */
+    public static native long[] getWarmupStateSync(ModelInfo modelInfo);
+
+    public static native long[] getWarmupStateAsync(ModelInfo modelInfo);
+
+    /**
+     * Load the sync models not loaded yet and fill in the dimensions of all of them.
+     * Models already loaded are kept, so models can be added at any time, and sync
+     * inference can run on several threads at once.
+     */
     public static native ArrayList<ModelInfo> loadModelSync(ArrayList<ModelInfo> modelInfo);
 
     /**
-     *
+     * loadModelSync on a native thread, returning at once. Each model is mapped,
+     * loaded and gets its tensors in parallel with the others.
+     * @return false if the load cannot be started; listener is not called then
+     */
+    public static native boolean loadModelSyncInBackground(ArrayList<ModelInfo> modelInfo,
+            ModelLoadListener listener);
+
+    /**
+     * @return {map us, load us, IO dimensions us, tensors us, ready us after the load started},
+     *          null if not loaded
+     */
+    public static native long[] getLoadTimesSync(ModelInfo modelInfo);
+
+    /**
+     * Bound the memory of the loaded sync models. Each model counts its OM file and
+     * its tensors; the least recently used idle models are unloaded to stay under
+     * the budget and loaded back from host memory on their next inference.
+     * @param bytes budget, 0 to keep every model loaded (the default)
+     */
+    public static native void setModelMemoryBudgetSync(long bytes);
+
+    /**
+     * @return {hits, misses, evictions, load failures, models, loaded models, loaded bytes,
+     *          budget bytes, then loads taking < 10, 20, 50, 100, 200, 500, 1000 ms and longer}
+     */
+    public static native long[] getResidencyStatsSync();
+
+    /**
+     * Map a label asset (one label per line) natively. Tables are shared by file name,
+     * so loading the same file again is free.
+     * @return number of labels, -1 on failure
+     */
+    public static native int loadLabelTable(AssetManager mgr, String labelFile);
+
+    /**
+     * Labels of the classes in a top-K result {index0, score0, index1, score1, ...}
+     * from a table loaded with loadLabelTable. Unknown indices give "".
+     */
+    public static native String[] getTopKLabels(String labelFile, float[] topK);
+
+    /**
+     * Read a model bundle (an .omb file made by tools/pack_model_bundle) into modelInfo:
+     * useAIPP, input and output dims, normalization and AIPP parameters, and, if the
+     * bundle has labels, getOnlineModelLabel() set to the bundle itself so that
+     * loadLabelTable and getTopKLabels use them. The bundle is mapped and checked, not
+     * parsed; loadModelSync and loadModelAsync then load the OM file in it and check
+     * the model against its IO dims.
+     * @return false if getOfflineModel() is a bare OM file or an invalid bundle
+     */
+    public static native boolean readModelBundle(ModelInfo modelInfo);
+
+    /**
+     * Size and pin the native task pool that runs preprocessing bands. Async
+     * listeners run on a native thread of their own, one at a time and in
+     * completion order. Only takes effect before the pool is first used.
+     * @param threads  workers, 0 for one per selected core
+     * @param affinity one of Constant.CORES_*
+     * @return false if the pool is already running
+     */
+    public static native boolean configureTaskPool(int threads, int affinity);
+
+    /**
+     * @return {workers, tasks executed, tasks stolen from another worker}
+     */
+    public static native long[] getTaskPoolStats();
+
+    /**
+     * Priority class of the sync requests made from the calling thread, e.g.
+     * Constant.QOS_BACKGROUND on a gallery scan thread.
+     * @param qosClass one of Constant.QOS_*, -1 to use ModelInfo.qosClass
+     */
+    public static native void setThreadQosClass(int qosClass);
+
+    /**
+     * Set how sync requests are dispatched to the NPU. While inFlight is bounded,
+     * interactive requests always go first; normal and background requests share
+     * the rest by weight.
+     * @param inFlight inferences running at once, the others queue by class;
+     *                 Constant.QOS_DEFAULT_IN_FLIGHT until this is called, 1 runs
+     *                 them one at a time in strict priority order and
+     *                 Constant.QOS_IN_FLIGHT_UNBOUNDED holds none back
+     * @return false if a value is out of range
+     */
+    public static native boolean configureQos(int inFlight, int normalWeight, int backgroundWeight);
+
+    /**
+     * @return {requests, mean queueing us, max queueing us} of the interactive,
+     *          normal and background classes, in that order
+     */
+    public static native long[] getQosStats();
+
+    /**
+     * Check a model on this DDK, rebuilding it in place if needed. Verdicts and rebuilt
+     * models are cached by model content and DDK version, so a model checked before
+     * on the same DDK skips both the check and the build.
      * @param offlinemodelpath   /xxx/xxx/xxx/xx.om
      * @return ture : it can run on NPU
      *          false: it should run on CPU
      */
     public static native boolean modelCompatibilityProcessFromFile(String offlinemodelpath);
 
+    /**
+     * Directory of the compiled model cache, e.g. getFilesDir() + "/compiled_models".
+     * @param dir null for a "compiled" directory next to each model
+     */
+    public static native void setCompiledModelCacheDir(String dir);
+
+    /**
+     * Check and, if needed, rebuild a model like modelCompatibilityProcessFromFile, on a
+     * native worker instead of the calling thread. Jobs run in submission order, a few at
+     * a time; each worker reuses its own DDK client across jobs.
+     * @param listener told each stage of the job, Constant.BUILD_*, from the worker
+     * @return id of the job, -1 if it cannot be submitted
+     */
+    public static native int submitModelBuild(String offlinemodelpath, ModelBuildListener listener);
+
+    /**
+     * Number of jobs of submitModelBuild run at once, 2 by default.
+     * @param parallelism 1 to 4
+     * @return false if a job was already submitted or parallelism is out of range
+     */
+    public static native boolean configureModelBuild(int parallelism);
+
+    /**
+     * @return counts of submitModelBuild jobs: queued, running, succeeded and failed
+     */
+    public static native long[] getModelBuildStats();
+
     //public static native boolean modelCompatibilityProcessFromBuffer(byte[] onlinemodelbuffer,byte[] modelparabuffer,String framework,String offlinemodelpath);
 }
@@ -0,0 +1,25 @@
+/*
+*@file ModelManagerBufferListener.java
+*
+* Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+package com.huawei.hiaidemo.utils;
+
+import java.nio.ByteBuffer;
+import java.util.ArrayList;
+
+public interface ModelManagerBufferListener extends ModelManagerListener {
+
+    /**
+     * Called instead of OnProcessDone with direct views of the output tensors, in
+     * native byte order. The request's slot stays busy until
+     * ModelManager.releaseOutputBuffersAsync(taskId); do not touch the buffers after that.
+     */
+    void OnProcessDoneBuffers(int taskId, ArrayList<ByteBuffer> output, float inferencetime);
+
+}
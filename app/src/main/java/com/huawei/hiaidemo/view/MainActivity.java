@@ -53,8 +53,10 @@ public class MainActivity extends AppCompatActivity implements View.OnClickListe
         setContentView(R.layout.activity_main);
         initView();
         initModels();
-        copyModels();
-        loadJNISoProcess();
+        // models are mapped from the APK; copies in app storage are only needed without native code
+        if (!loadJNISoProcess() || !ModelManager.setModelAssets(getAssets())) {
+            copyModels();
+        }
         initSpinner();
     }
 
@@ -129,13 +131,14 @@ public class MainActivity extends AppCompatActivity implements View.OnClickListe
         }
     }
 
-    private void loadJNISoProcess(){
+    private boolean loadJNISoProcess(){
         //load hiaijni.so
         boolean isSoLoadSuccess = ModelManager.loadJNISo();
 
         if (isSoLoadSuccess) {
             Toast.makeText(this, "load libhiai.so success.", Toast.LENGTH_SHORT).show();
         }
+        return isSoLoadSuccess;
     }
 
     protected void initModels(){
@@ -168,6 +171,7 @@ public class MainActivity extends AppCompatActivity implements View.OnClickListe
         model_1.setOfflineModel("mobilenetCaffe.om");
         model_1.setOfflineModelName("mobilenet_v2");
         model_1.setOnlineModelLabel("labels_caffe.txt");
+        model_1.setPostTopK(3);
 
 
 
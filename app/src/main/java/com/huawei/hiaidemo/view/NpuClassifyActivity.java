@@ -207,6 +207,11 @@ public abstract class NpuClassifyActivity extends AppCompatActivity{
 
             Log.d(TAG, String.valueOf(bitmap.getWidth())+" "+String.valueOf(bitmap.getHeight())+" "+String.valueOf(bitmap.getByteCount())+" ");
 
+            if(!selectedModel.getUseAIPP() && runModelOnSourceBitmap(selectedModel, bitmap)){
+                // the input tensor was filled from the decoded image in one pass
+                continue;
+            }
+
             Bitmap rgba = bitmap.copy(Bitmap.Config.ARGB_8888, true);
             initClassifiedImg = Bitmap.createScaledBitmap(rgba, selectedModel.getInput_W(), selectedModel.getInput_H(), true);
 
@@ -390,16 +395,7 @@ public abstract class NpuClassifyActivity extends AppCompatActivity{
 
 
                 initClassifiedImg = Bitmap.createScaledBitmap(rgba, selectedModel.getInput_W(), selectedModel.getInput_H(), true);
-                byte[] inputData = {};
-                if(selectedModel.getUseAIPP()){
-                    inputData = Untils.getPixelsAIPP(selectedModel.getFramework(),initClassifiedImg,selectedModel.getInput_W(),selectedModel.getInput_H());
-                }else {
-                    inputData = Untils.getPixels(selectedModel.getFramework(),initClassifiedImg,selectedModel.getInput_W(),selectedModel.getInput_H());
-                }
-                ArrayList<byte[]> inputDataList = new ArrayList<>();
-                inputDataList.add(inputData);
-                Log.d(TAG,"inputData.length is :"+inputData.length+"");
-                runModel(selectedModel,inputDataList);
+                runModel(selectedModel, initClassifiedImg);
 
                 break;
             case IMAGE_CAPTURE_REQUEST_CODE:
@@ -408,16 +404,7 @@ public abstract class NpuClassifyActivity extends AppCompatActivity{
                 Bitmap imageBitmap = (Bitmap) extras.get("data");
                 Bitmap rgba2 = imageBitmap.copy(Bitmap.Config.ARGB_8888, true);
                 initClassifiedImg = Bitmap.createScaledBitmap(rgba2, selectedModel.getInput_W(), selectedModel.getInput_H(), true);
-                byte[] inputData2 = {};
-                if(selectedModel.getUseAIPP()){
-                    inputData2 = Untils.getPixelsAIPP(selectedModel.getFramework(),initClassifiedImg,selectedModel.getInput_W(),selectedModel.getInput_H());
-                }else {
-                    inputData2 = Untils.getPixels(selectedModel.getFramework(),initClassifiedImg,selectedModel.getInput_W(),selectedModel.getInput_H());
-                }
-                ArrayList<byte[]> inputDataList2 = new ArrayList<>();
-                inputDataList2.add(inputData2);
-                Log.i(TAG,"inputData.length is :"+inputData2.length+"");
-                runModel(selectedModel,inputDataList2);
+                runModel(selectedModel, initClassifiedImg);
                 break;
 
             default:
@@ -488,6 +475,11 @@ public abstract class NpuClassifyActivity extends AppCompatActivity{
 
     protected void preProcess() {
         byte[] labels;
+        if (selectedModel.getPostTopK() > 0 &&
+                ModelManager.loadLabelTable(mgr, selectedModel.getOnlineModelLabel()) > 0) {
+            // labels of top-K results are looked up natively
+            return;
+        }
         try {
             Log.i(TAG, "modelList size: " + modelList.size());
             InputStream assetsInputStream = getAssets().open(modelList.get(0).getOnlineModelLabel());
@@ -508,6 +500,10 @@ public abstract class NpuClassifyActivity extends AppCompatActivity{
 
     }
     protected void postProcess(float[] outputData){
+        if(outputData != null && selectedModel.getPostTopK() > 0){
+            postProcessTopK(outputData);
+            return;
+        }
         if(outputData != null){
             int[] max_index = new int[3];
             double[] max_num = new double[3];
@@ -556,6 +552,56 @@ public abstract class NpuClassifyActivity extends AppCompatActivity{
         }
     }
 
+    /**
+     * Show the {index, score} pairs produced by native top-K post-processing.
+     */
+    private void postProcessTopK(float[] topK){
+        String[] labels = ModelManager.getTopKLabels(selectedModel.getOnlineModelLabel(), topK);
+        String[] lines = new String[3];
+        for (int i = 0; i < lines.length; i++) {
+            int pair = 2 * i;
+            if (labels == null || i >= labels.length) {
+                lines[i] = "";
+                continue;
+            }
+            lines[i] = labels[i] + " - " + topK[pair + 1] * 100 + "%\n";
+        }
+        predictedClass[0] = lines[0];
+        predictedClass[1] = lines[1] + lines[2];
+        predictedClass[2] = "inference time:" + inferenceTime + "ms\n";
+        for(String res : predictedClass) {
+            Log.i(TAG, res);
+        }
+
+        items.add(new ClassifyItemModel(predictedClass[0], predictedClass[1], predictedClass[2], initClassifiedImg));
+        adapter.notifyDataSetChanged();
+    }
+
+    /**
+     * Run a model on a bitmap already scaled to the model input size.
+     * Subclasses may override this to fill the input tensor natively.
+     */
+    protected void runModel(ModelInfo modelInfo, Bitmap bitmap) {
+        byte[] inputData;
+        if(modelInfo.getUseAIPP()){
+            inputData = Untils.getPixelsAIPP(modelInfo.getFramework(),bitmap,modelInfo.getInput_W(),modelInfo.getInput_H());
+        }else {
+            inputData = Untils.getPixels(modelInfo.getFramework(),bitmap,modelInfo.getInput_W(),modelInfo.getInput_H());
+        }
+        ArrayList<byte[]> inputDataList = new ArrayList<>();
+        inputDataList.add(inputData);
+        Log.d(TAG,"inputData.length is :"+inputData.length+"");
+        runModel(modelInfo,inputDataList);
+    }
+
+    /**
+     * Crop, resize and normalize a decoded image straight into the model input, and run it.
+     * @return false if nothing ran and the Java path must be used
+     */
+    protected boolean runModelOnSourceBitmap(ModelInfo modelInfo, Bitmap bitmap) {
+        return false;
+    }
+
     protected abstract void runModel(ModelInfo modelInfo, ArrayList<byte[]> inputDataList);
 
     protected abstract ArrayList<ModelInfo> loadModel(ArrayList<ModelInfo> modelInfo);
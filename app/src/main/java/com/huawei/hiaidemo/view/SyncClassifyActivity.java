@@ -11,6 +11,7 @@
 package com.huawei.hiaidemo.view;
 
 
+import android.graphics.Bitmap;
 import android.os.Bundle;
 import android.util.Log;
 import android.widget.Toast;
@@ -20,14 +21,20 @@ import com.huawei.hiaidemo.utils.ModelManager;
 
 
 import static com.huawei.hiaidemo.utils.Constant.AI_OK;
+import static com.huawei.hiaidemo.utils.Constant.NO_SYNC_TENSORS;
 
 
+import java.nio.ByteBuffer;
+import java.nio.FloatBuffer;
 import java.util.ArrayList;
+import java.util.Arrays;
 
 public class SyncClassifyActivity extends NpuClassifyActivity {
 
     private static final String TAG = SyncClassifyActivity.class.getSimpleName();
 
+    private static final float[] UNIT_STD = {1.f, 1.f, 1.f};
+
     @Override
     protected void onCreate(Bundle savedInstanceState) {
         super.onCreate(savedInstanceState);
@@ -38,25 +45,95 @@ public class SyncClassifyActivity extends NpuClassifyActivity {
     protected void runModel(ModelInfo modelInfo, ArrayList<byte[]> inputData) {
         int timesRan = 200;
         //for(int i=0;i<timesRan;i++){
-            outputDataList = ModelManager.runModelSync(modelInfo, inputData);
+            showOutputs(ModelManager.runModelSync(modelInfo, inputData));
+        //}
+        //Log.d("Testing", String.valueOf(grandTime/timesRan));
+    }
 
-            if (outputDataList == null) {
-                Log.e(TAG, "Sync runModel outputdata is null");
+    private void showOutputs(ArrayList<float[]> outputs) {
+        outputDataList = outputs;
+        if (outputDataList == null) {
+            Log.e(TAG, "Sync runModel outputdata is null");
 
-                return;
-            }
+            return;
+        }
 
-            inferenceTime = ModelManager.GetTimeUseSync();
-            grandTime=grandTime+inferenceTime;
-        //}
-        //Log.d("Testing", String.valueOf(grandTime/timesRan));
+        inferenceTime = ModelManager.GetTimeUseSync();
+        grandTime=grandTime+inferenceTime;
 
         for(float[] outputData : outputDataList){
             Log.i(TAG, "runModel outputdata length : " + outputData.length);
 
             postProcess(outputData);
         }
+    }
 
+    @Override
+    protected void runModel(ModelInfo modelInfo, Bitmap bitmap) {
+        int tensors = ModelManager.acquireTensorsSync(modelInfo);
+        if (tensors == NO_SYNC_TENSORS) {
+            super.runModel(modelInfo, bitmap);
+            return;
+        }
+        boolean filled;
+        try {
+            if (modelInfo.getUseAIPP()) {
+                filled = ModelManager.setAippInputFromBitmapSync(modelInfo, tensors, bitmap, 0,
+                        modelInfo.getAippImageType(), modelInfo.getAippNv21());
+            } else if (modelInfo.getNormalizeBgr() && Arrays.equals(modelInfo.getNormalizeStd(), UNIT_STD)) {
+                float[] mean = modelInfo.getNormalizeMean();
+                filled = ModelManager.setInputFromBitmapSync(modelInfo, tensors, bitmap, 0, mean[0], mean[1], mean[2]);
+            } else {
+                filled = ModelManager.setInputFromBitmapFusedSync(modelInfo, tensors, bitmap, 0,
+                        modelInfo.getNormalizeMean(), modelInfo.getNormalizeStd(), modelInfo.getNormalizeBgr());
+            }
+            if (filled) {
+                // input tensor is filled natively, nothing to copy
+                showOutputs(ModelManager.runModelInPlaceSync(modelInfo, tensors));
+            }
+        } finally {
+            ModelManager.releaseTensorsSync(modelInfo, tensors);
+        }
+        if (!filled) {
+            super.runModel(modelInfo, bitmap);
+        }
+    }
+
+    @Override
+    protected boolean runModelOnSourceBitmap(ModelInfo modelInfo, Bitmap bitmap) {
+        int tensors = ModelManager.acquireTensorsSync(modelInfo);
+        if (tensors == NO_SYNC_TENSORS) {
+            return false;
+        }
+        try {
+            // the input of the Java path: the bitmap stretched to the model input, whose
+            // extractThumbnail is a no-op, so the native crop and resize copy it as is
+            Bitmap scaled = Bitmap.createScaledBitmap(bitmap, modelInfo.getInput_W(), modelInfo.getInput_H(), true);
+            if (!ModelManager.setInputFromBitmapFusedSync(modelInfo, tensors, scaled, 0,
+                    new float[]{0.f, 0.f, 0.f}, new float[]{255.f, 255.f, 255.f}, false)) {
+                return false;
+            }
+            ArrayList<ByteBuffer> inputs = ModelManager.getInputBuffersSync(modelInfo, tensors);
+            if (inputs == null || inputs.isEmpty()) {
+                return false;
+            }
+            swapLastPlanes(inputs.get(0), modelInfo.getInput_W() * modelInfo.getInput_H());
+            initClassifiedImg = scaled;
+            showOutputs(ModelManager.runModelInPlaceSync(modelInfo, tensors));
+            return true;
+        } finally {
+            ModelManager.releaseTensorsSync(modelInfo, tensors);
+        }
+    }
+
+    // R,G,B planes to the R,B,G order bitmapToModelsMatchingByteBuffer writes
+    private static void swapLastPlanes(ByteBuffer input, int planeSize) {
+        FloatBuffer planes = input.asFloatBuffer();
+        for (int i = planeSize; i < 2 * planeSize; ++i) {
+            float g = planes.get(i);
+            planes.put(i, planes.get(i + planeSize));
+            planes.put(i + planeSize, g);
+        }
     }
 
     @Override
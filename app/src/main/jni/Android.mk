@@ -35,7 +35,35 @@ LOCAL_MODULE := hiaijni
 LOCAL_SRC_FILES := \
     classify_sync_jni.cpp \
     classify_async_jni.cpp \
-    buildmodel.cpp
+    buildmodel.cpp \
+    image_preprocess.cpp \
+    preprocess_jni.cpp \
+    cpu_aipp.cpp \
+    cpu_aipp_para.cpp \
+    dynamic_aipp.cpp \
+    jni_common.cpp \
+    postprocess.cpp \
+    label_store.cpp \
+    label_jni.cpp \
+    slot_free_list.cpp \
+    batch_scheduler.cpp \
+    pipeline_executor.cpp \
+    pipeline_jni.cpp \
+    sync_session.cpp \
+    task_pool.cpp \
+    task_pool_jni.cpp \
+    warmup.cpp \
+    model_residency.cpp \
+    qos_scheduler.cpp \
+    qos_jni.cpp \
+    request_tracker.cpp \
+    service_recovery.cpp \
+    model_mapping.cpp \
+    model_mapping_jni.cpp \
+    load_times.cpp \
+    compiled_model_cache.cpp \
+    model_bundle.cpp \
+    model_bundle_jni.cpp
 
 LOCAL_SHARED_LIBRARIES :=  hiai_ir \
                            hiai \
@@ -45,9 +73,11 @@ LOCAL_SHARED_LIBRARIES :=  hiai_ir \
 LOCAL_LDFLAGS := -L$(DDK_LIB_PATH)
 LOCAL_LDLIBS += \
     -llog \
-    -landroid
+    -landroid \
+    -ljnigraphics
 
 CPPFLAGS=-stdlib=libstdc++ LDLIBS=-lstdc++
 LOCAL_CFLAGS += -std=c++14
+LOCAL_ARM_NEON := true
 
 include $(BUILD_SHARED_LIBRARY)
@@ -0,0 +1,85 @@
+/*
+ * @file batch_scheduler.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "batch_scheduler.h"
+
+using namespace std;
+
+BatchScheduler::BatchScheduler(uint32_t maxBatch, chrono::microseconds maxWait, uint32_t stages, RunFunc run)
+    : maxBatch_(maxBatch > 0 ? maxBatch : 1), maxWait_(maxWait), run_(std::move(run)),
+      stages_(stages > 0 ? stages : 1)
+{
+}
+
+int BatchScheduler::Submit(const RowFunc& fill, const RowFunc& scatter)
+{
+    unique_lock<mutex> lock(mutex_);
+    // join the open batch, or open the next free staging set
+    while (open_ < 0) {
+        Stage& next = stages_[nextStage_];
+        if (next.state == STAGE_FREE) {
+            next.state = STAGE_OPEN;
+            next.rows = 0;
+            next.filled = 0;
+            next.scattered = 0;
+            next.deadline = chrono::steady_clock::now() + maxWait_;
+            open_ = (int)nextStage_;
+            nextStage_ = (nextStage_ + 1) % stages_.size();
+            break;
+        }
+        cv_.wait(lock);
+    }
+    uint32_t stageIndex = (uint32_t)open_;
+    Stage& stage = stages_[stageIndex];
+    uint32_t row = stage.rows++;
+    if (stage.rows == maxBatch_) {
+        open_ = -1;
+        cv_.notify_all();
+    }
+
+    lock.unlock();
+    fill(stageIndex, row);
+    lock.lock();
+    stage.filled++;
+    cv_.notify_all();
+
+    if (row == 0) {
+        // the first request closes the batch and runs it
+        cv_.wait_until(lock, stage.deadline, [&stage, this] { return stage.rows == maxBatch_; });
+        if (open_ == (int)stageIndex) {
+            open_ = -1;
+            cv_.notify_all();
+        }
+        cv_.wait(lock, [&stage, this] { return stage.filled == stage.rows && !busy_; });
+        busy_ = true;
+        stage.state = STAGE_RUNNING;
+        lock.unlock();
+        int status = run_(stageIndex, stage.rows);
+        lock.lock();
+        stage.status = status;
+        stage.state = STAGE_DONE;
+        cv_.notify_all();
+    } else {
+        cv_.wait(lock, [&stage] { return stage.state == STAGE_DONE; });
+    }
+
+    int status = stage.status;
+    lock.unlock();
+    if (status == 0) {
+        scatter(stageIndex, row);
+    }
+    lock.lock();
+    if (++stage.scattered == stage.rows) {
+        stage.state = STAGE_FREE;
+        busy_ = false;
+        cv_.notify_all();
+    }
+    return status;
+}
@@ -0,0 +1,86 @@
+/*
+ * @file batch_scheduler.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_BATCH_SCHEDULER_H
+#define HIAI_DEMO_BATCH_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/*
+ * Coalesces concurrent single-image requests into one run of a model compiled
+ * with batch N. The first request of a batch waits up to maxWait for others;
+ * the batch runs as soon as it has maxBatch rows or the wait expires. Each
+ * caller copies its own row in and its own row of the outputs back, on its own
+ * thread.
+ *
+ * Rows are staged in one of several staging sets, so the next batch fills
+ * while the previous one runs. Runs and scatters are serialized because the
+ * model has one set of output tensors.
+ */
+class BatchScheduler {
+public:
+    // write or read row `row` of staging set `stage`
+    using RowFunc = std::function<void(uint32_t stage, uint32_t row)>;
+    // run rows [0, count) of staging set `stage`, return 0 on success
+    using RunFunc = std::function<int(uint32_t stage, uint32_t count)>;
+
+    /*
+    * @param [in] maxBatch rows per run, at most the batch of the model
+    * @param [in] maxWait how long the first request of a batch waits for others
+    * @param [in] stages staging sets, at least 1
+    * @param [in] run runs a batch, called by one thread at a time
+    */
+    BatchScheduler(uint32_t maxBatch, std::chrono::microseconds maxWait, uint32_t stages, RunFunc run);
+
+    BatchScheduler(const BatchScheduler&) = delete;
+    BatchScheduler& operator=(const BatchScheduler&) = delete;
+
+    uint32_t MaxBatch() const { return maxBatch_; }
+
+    /*
+    * @brief Run one image as part of a batch. Blocks until its outputs are scattered.
+    * @param [in] fill copies the input of the caller into a row
+    * @param [in] scatter copies a row of the outputs to the caller, only called on success
+    * @return status of the run of the batch
+    */
+    int Submit(const RowFunc& fill, const RowFunc& scatter);
+
+private:
+    enum StageState { STAGE_FREE, STAGE_OPEN, STAGE_RUNNING, STAGE_DONE };
+
+    struct Stage {
+        StageState state = STAGE_FREE;
+        uint32_t rows = 0;
+        uint32_t filled = 0;
+        uint32_t scattered = 0;
+        int status = 0;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    uint32_t maxBatch_;
+    std::chrono::microseconds maxWait_;
+    RunFunc run_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Stage> stages_;
+    // stage accepting rows, -1 when none is open
+    int open_ = -1;
+    uint32_t nextStage_ = 0;
+    // a batch is running or scattering its outputs
+    bool busy_ = false;
+};
+
+#endif
@@ -13,9 +13,18 @@
 #include <sys/system_properties.h>
 #include <string>
 #include <dlfcn.h>
+#include <unistd.h>
 #include <stdlib.h>
 #include <android/log.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
 #include "HiAiModelManagerService.h"
+#include "compiled_model_cache.h"
+#include "jni_common.h"
 
 static const char* LOG_TAG = "buildmodel";
 #define ALOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
@@ -45,6 +54,34 @@ bool _fileExist(const char* path)
     return true;
 }
 
+/*
+ * Destroys a builder buffer when it goes out of scope, so that no return
+ * path leaks it.
+ */
+class BuilderBuffer {
+public:
+    BuilderBuffer(shared_ptr<AiModelBuilder> builder, MemBuffer* buffer) : builder_(builder), buffer_(buffer) {}
+
+    ~BuilderBuffer()
+    {
+        if (buffer_ != nullptr) {
+            builder_->MemBufferDestroy(buffer_);
+        }
+    }
+
+    MemBuffer* Get() const
+    {
+        return buffer_;
+    }
+
+private:
+    BuilderBuffer(const BuilderBuffer&) = delete;
+    BuilderBuffer& operator=(const BuilderBuffer&) = delete;
+
+    shared_ptr<AiModelBuilder> builder_;
+    MemBuffer* buffer_;
+};
+
 bool _modelCompatibilityProcessFromBuffeOutFile(shared_ptr<AiModelMngerClient> mclientBuild, const char* offlinemodel)
 {
     bool rslt = _fileExist(offlinemodel);
@@ -58,9 +95,9 @@ bool _modelCompatibilityProcessFromBuffeOutFile(shared_ptr<AiModelMngerClient> m
     std::string name = path.substr(pos + 1);
     ALOGE("[HIAI_DEMO_CHECKMODEL_COPM] Model name : %s\n", name.c_str());
     AiModelDescription desc(name, 3, 0, 0, 0);
-    MemBuffer* buffer = NULL;
     shared_ptr<AiModelBuilder> mcbuilder = make_shared<AiModelBuilder>(mclientBuild);
-    buffer = mcbuilder->InputMemBufferCreate(string(offlinemodel));
+    BuilderBuffer modelBuffer(mcbuilder, mcbuilder->InputMemBufferCreate(string(offlinemodel)));
+    MemBuffer* buffer = modelBuffer.Get();
     if (buffer == nullptr) {
         ALOGE("[HIAI_DEMO_CHECKMODEL_COPM] cannot find the model file.");
         return false;
@@ -80,10 +117,8 @@ bool _modelCompatibilityProcessFromBuffeOutFile(shared_ptr<AiModelMngerClient> m
 }
 
 
-RESULT_CODE _buildModel(shared_ptr<AiModelMngerClient> mclientBuild, const char* offlinemodel)
+RESULT_CODE _buildModel(shared_ptr<AiModelMngerClient> mclientBuild, const char* offlinemodel, const string& exportPath)
 {
-    MemBuffer* onlineBuffer = nullptr;
-    MemBuffer* offlineBuffer = nullptr;
     uint32_t offModelSize = 0;
     vector<MemBuffer*> input_membuffer;
     shared_ptr<AiModelBuilder> mcbuilder = make_shared<AiModelBuilder>(mclientBuild);
@@ -92,19 +127,19 @@ RESULT_CODE _buildModel(shared_ptr<AiModelMngerClient> mclientBuild, const char*
         ALOGE("[HIAI_DEMO_BUILDMODEL] offlinemodel is null\n");
         return INVALID_ONLINE_MODEL;
     }
-    onlineBuffer = mcbuilder->ReadBinaryProto(string(offlinemodel));
-    if (onlineBuffer == nullptr) {
+    BuilderBuffer onlineBuffer(mcbuilder, mcbuilder->ReadBinaryProto(string(offlinemodel)));
+    if (onlineBuffer.Get() == nullptr) {
         ALOGE("[HIAI_DEMO_BUILDMODEL] onlineBuffer is null,offlinemodel error %s\n", offlinemodel);
         return INVALID_ONLINE_MODEL;
     }
-    input_membuffer.push_back(onlineBuffer);
-    offlineBuffer = mcbuilder->OutputMemBufferCreate(0, input_membuffer);
-    if (offlineBuffer == nullptr) {
+    input_membuffer.push_back(onlineBuffer.Get());
+    BuilderBuffer offlineBuffer(mcbuilder, mcbuilder->OutputMemBufferCreate(0, input_membuffer));
+    if (offlineBuffer.Get() == nullptr) {
         ALOGE("[HIAI_DEMO_BUILDMODEL] offlineBuffer failed\n");
         return INVALID_OFFLINE_MODEL;
     }
 
-    int ret = mcbuilder->BuildModel(input_membuffer, offlineBuffer, offModelSize);
+    int ret = mcbuilder->BuildModel(input_membuffer, offlineBuffer.Get(), offModelSize);
     if (ret != 0) {
         ALOGE("[HIAI_DEMO_BUILDMODEL] build model Failed! ret=%d\n", ret);
         return BUILD_OFFLINEMODEL_FAILED;
@@ -112,18 +147,150 @@ RESULT_CODE _buildModel(shared_ptr<AiModelMngerClient> mclientBuild, const char*
 
     // Suggest saving the built model to file system and reloading it. You can get
     // the optimization we supply.
-    ret = mcbuilder->MemBufferExportFile(offlineBuffer, offModelSize, string(offlinemodel));
+    ret = mcbuilder->MemBufferExportFile(offlineBuffer.Get(), offModelSize, exportPath);
     if (ret != 0) {
         ALOGE("[HIAI_DEMO_BUILDMODEL] export offline model Failed! ret=%d\n", ret);
         return GENERATE_OFFLINE_MODEL_FAILED;
     }
-    ALOGI("[HIAI_DEMO_BUILDMODEL] build export model path:%s\n", offlinemodel);
-    mcbuilder->MemBufferDestroy(offlineBuffer);
-    mcbuilder->MemBufferDestroy(onlineBuffer);
+    ALOGI("[HIAI_DEMO_BUILDMODEL] build export model path:%s\n", exportPath.c_str());
 
     return BUILD_OFFLINEMODEL_SUCCESS;
 }
 
+/*
+* @brief Check an OM file on this DDK and rebuild it if needed, going through
+*        the compiled model cache: a model seen before on the same DDK version
+*        skips both the check and the build
+* @param [in] onBuild called before a build starts, may be empty
+*/
+RESULT_CODE _checkModelCached(shared_ptr<AiModelMngerClient> mclientBuild, const char* offlinemodel,
+    const string& version, const function<void()>& onBuild)
+{
+    string dir = GetCompiledModelCacheDir();
+    CompiledModelCache cache(dir.empty() ? CompiledModelCache::DefaultDir(offlinemodel) : dir);
+    uint64_t hash = 0;
+    if (!cache.ContentHash(offlinemodel, hash)) {
+        ALOGE("[HIAI_DEMO_COMPATIBILITY_CHECK] cannot read %s\n", offlinemodel);
+        return INVALID_OFFLINE_MODEL;
+    }
+    string compiledPath;
+    switch (cache.Lookup(hash, version, compiledPath)) {
+        case VERDICT_COMPATIBLE:
+            ALOGI("[HIAI_DEMO_COMPATIBILITY_CHECK] cached: compatible");
+            return CHECK_OFFLINEMODEL_COMPATIBILITY_SUCCESS;
+        case VERDICT_BUILT:
+            // e.g. the original model was copied from the assets again
+            ALOGI("[HIAI_DEMO_COMPATIBILITY_CHECK] cached: rebuilt as %s", compiledPath.c_str());
+            return cache.Install(compiledPath, offlinemodel) ? BUILD_OFFLINEMODEL_SUCCESS : GENERATE_OFFLINE_MODEL_FAILED;
+        case VERDICT_FAILED:
+            ALOGI("[HIAI_DEMO_COMPATIBILITY_CHECK] cached: cannot be built on this DDK");
+            return BUILD_OFFLINEMODEL_FAILED;
+        default:
+            break;
+    }
+
+    bool checkret = _modelCompatibilityProcessFromBuffeOutFile(mclientBuild, offlinemodel);
+    ALOGI("[HIAI_DEMO_COMPATIBILITY_CHECK] check result : %d", checkret);
+    if (checkret) {
+        cache.Record(hash, version, VERDICT_COMPATIBLE);
+        return CHECK_OFFLINEMODEL_COMPATIBILITY_SUCCESS;
+    }
+    // built into the cache, then swapped in: the model is never half written
+    string exportPath = cache.TempBuildPath(hash, version);
+    if (exportPath.empty()) {
+        return GENERATE_OFFLINE_MODEL_FAILED;
+    }
+    if (onBuild) {
+        onBuild();
+    }
+    RESULT_CODE res = _buildModel(mclientBuild, offlinemodel, exportPath);
+    ALOGI("[HIAI_DEMO_COMPATIBILITY_CHECK] build offlinemodel result_code : %d", res);
+    if (res == BUILD_OFFLINEMODEL_FAILED) {
+        // not retried until the DDK changes
+        cache.Record(hash, version, VERDICT_FAILED);
+        return res;
+    }
+    if (res != BUILD_OFFLINEMODEL_SUCCESS) {
+        unlink(exportPath.c_str());
+        return res;
+    }
+    if (!cache.StoreBuilt(hash, version, compiledPath) || !cache.Install(compiledPath, offlinemodel)) {
+        return GENERATE_OFFLINE_MODEL_FAILED;
+    }
+    return BUILD_OFFLINEMODEL_SUCCESS;
+}
+
+/*
+* @brief Initialize a build client on first use and reuse it afterwards. A
+*        client is only ever used by one thread at a time: concurrent checks
+*        and builds on one AiModelMngerClient are not known to be safe
+* @param [in,out] client nullptr until the first successful call
+* @param [out] version DDK version, "" if the DDK reports none
+* @return false if the client cannot be initialized; the next call tries again
+*/
+static bool _buildClient(shared_ptr<AiModelMngerClient>& client, string& version)
+{
+    if (client == nullptr) {
+        shared_ptr<AiModelMngerClient> mclientBuild = make_shared<AiModelMngerClient>();
+        if (mclientBuild->Init(NULL) != 0) {
+            ALOGE("[HIAI_DEMO_COMPATIBILITY_CHECK] AiModelMngerClient Init Failed!\n");
+            return false;
+        }
+        client = mclientBuild;
+    }
+    const char* currentversion = client->GetVersion();
+    version = currentversion != nullptr ? currentversion : "";
+    return true;
+}
+
+// used by modelCompatibilityProcessFromFile; each build worker has its own
+static mutex g_buildClientMutex;
+static shared_ptr<AiModelMngerClient> g_buildClient;
+
+static mutex g_modelLocksMutex;
+// one per OM file: two jobs on a file would both rebuild it
+static map<string, shared_ptr<mutex>> g_modelLocks;
+
+static shared_ptr<mutex> _modelLock(const string& offlinemodel)
+{
+    lock_guard<mutex> lock(g_modelLocksMutex);
+    shared_ptr<mutex>& modelLock = g_modelLocks[offlinemodel];
+    if (modelLock == nullptr) {
+        modelLock = make_shared<mutex>();
+    }
+    return modelLock;
+}
+
+/*
+* @brief Check and, if needed, rebuild one model
+* @param [in,out] mclientBuild build client owned by the caller, see _buildClient
+* @param [in] onBuild called before a build starts, may be empty
+* @return true if the model can run on the NPU
+*/
+static bool _processModel(shared_ptr<AiModelMngerClient>& mclientBuild, const string& offlinemodel,
+    const function<void()>& onBuild)
+{
+    ALOGI("[HIAI_DEMO_COMPATIBILITY_CHECK] offlinemodel : %s", offlinemodel.c_str());
+    string version;
+    if (!_buildClient(mclientBuild, version)) {
+        return false;
+    }
+    ALOGI("[HIAI_DEMO_COMPATIBILITY_CHECK] ddk currentversion : %s", version.c_str());
+    RESULT_CODE result_code;
+    if (!version.empty() && version < "100.300.010.010") {
+        result_code = NO_NPU;
+    } else {
+        shared_ptr<mutex> modelLock = _modelLock(offlinemodel);
+        lock_guard<mutex> lock(*modelLock);
+        result_code = _checkModelCached(mclientBuild, offlinemodel.c_str(), version, onBuild);
+        if (result_code != CHECK_OFFLINEMODEL_COMPATIBILITY_SUCCESS && result_code != BUILD_OFFLINEMODEL_SUCCESS) {
+            result_code = BUILD_OFFLINEMODEL_FAILED;
+        }
+    }
+    ALOGI("[HIAI_DEMO_COMPATIBILITY_CHECK] result_code value : %d", result_code);
+    return result_code == CHECK_OFFLINEMODEL_COMPATIBILITY_SUCCESS || result_code == BUILD_OFFLINEMODEL_SUCCESS;
+}
+
 extern "C" JNIEXPORT jboolean JNICALL Java_com_huawei_hiaidemo_utils_ModelManager_modelCompatibilityProcessFromFile(
     JNIEnv* env, jclass type, jstring offlinemodel_)
 {
@@ -132,46 +299,209 @@ extern "C" JNIEXPORT jboolean JNICALL Java_com_huawei_hiaidemo_utils_ModelManage
         return false;
     }
     const char* offlinemodel = env->GetStringUTFChars(offlinemodel_, 0);
-	if(offlinemodel == NULL) {
+    if (offlinemodel == NULL) {
         ALOGI("[HIAI_DEMO_COMPATIBILITY_CHECK] offlinemodel path is null");
         return false;
     }
-    ALOGI("[HIAI_DEMO_COMPATIBILITY_CHECK] offlinemodel : %s", offlinemodel);
+    string path(offlinemodel);
+    env->ReleaseStringUTFChars(offlinemodel_, offlinemodel);
+    lock_guard<mutex> lock(g_buildClientMutex);
+    return _processModel(g_buildClient, path, nullptr);
+}
 
-    shared_ptr<AiModelMngerClient> mclientBuild = make_shared<AiModelMngerClient>();
-    auto ret = mclientBuild->Init(NULL);
-    if (ret) {
-        ALOGE("[HIAI_DEMO_COMPATIBILITY_CHECK] AiModelMngerClient Init Failed!\n");
-        return false;
+/* Same values as Constant.BUILD_* */
+typedef enum {
+    BUILD_CHECKING = 0,
+    BUILD_BUILDING,
+    BUILD_DONE,
+    BUILD_FAILED
+} BUILD_STAGE;
+
+static const uint32_t DEFAULT_BUILD_PARALLELISM = 2;
+static const uint32_t MAX_BUILD_PARALLELISM = 4;
+
+/*
+ * Checks and builds models off the calling thread. Jobs are taken in the
+ * order they are submitted by a fixed number of workers, started with the
+ * first job. Each worker keeps its own build client across its jobs; the
+ * listener of a job is told each stage from the worker running it.
+ */
+class ModelBuildService {
+public:
+    /*
+    * @return false if the workers are already started
+    */
+    bool Configure(uint32_t parallelism)
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!workers_.empty()) {
+            return false;
+        }
+        parallelism_ = parallelism;
+        return true;
     }
 
-    const char* currentversion = mclientBuild->GetVersion();
-    ALOGI("[HIAI_DEMO_COMPATIBILITY_CHECK] ddk currentversion : %s", currentversion);
-    RESULT_CODE result_code;
-    if (currentversion != nullptr && string(currentversion) < "100.300.010.010") {
-        result_code = NO_NPU;
-    } else {
-        bool checkret = _modelCompatibilityProcessFromBuffeOutFile(mclientBuild, offlinemodel);
-        ALOGI("[HIAI_DEMO_COMPATIBILITY_CHECK] check result : %d", checkret);
-        if (checkret) {
-            result_code = CHECK_OFFLINEMODEL_COMPATIBILITY_SUCCESS;
-        } else {
-            int res = _buildModel(mclientBuild, offlinemodel);
-            ALOGI("[HIAI_DEMO_COMPATIBILITY_CHECK] build offlinemodel result_code : %d", res);
-            if (res != 1) {
-                result_code = BUILD_OFFLINEMODEL_FAILED;
-            } else {
-                result_code = BUILD_OFFLINEMODEL_SUCCESS;
+    /*
+    * @param [in] listener global ref, deleted after the last stage is reported
+    * @return id of the job
+    */
+    int32_t Submit(JavaVM* vm, const string& path, jobject listener, jmethodID onProgress)
+    {
+        lock_guard<mutex> lock(mutex_);
+        vm_ = vm;
+        Job job;
+        job.id = nextId_++;
+        job.path = path;
+        job.listener = listener;
+        job.onProgress = onProgress;
+        jobs_.push_back(job);
+        while (workers_.size() < parallelism_) {
+            // never joined, like the service
+            workers_.push_back(thread([this] { WorkerLoop(); }));
+            workers_.back().detach();
+        }
+        ready_.notify_one();
+        return job.id;
+    }
+
+    /* {queued, running, succeeded, failed} */
+    void GetStats(jlong stats[4])
+    {
+        lock_guard<mutex> lock(mutex_);
+        stats[0] = (jlong)jobs_.size();
+        stats[1] = (jlong)running_;
+        stats[2] = (jlong)succeeded_;
+        stats[3] = (jlong)failed_;
+    }
+
+    static ModelBuildService& Shared()
+    {
+        // never deleted: detached workers use it until the process exits
+        static ModelBuildService* service = new ModelBuildService();
+        return *service;
+    }
+
+private:
+    struct Job {
+        int32_t id = 0;
+        string path;
+        jobject listener = nullptr;
+        jmethodID onProgress = nullptr;
+    };
+
+    void WorkerLoop()
+    {
+        shared_ptr<AiModelMngerClient> client;
+        while (true) {
+            Job job;
+            JavaVM* vm = nullptr;
+            {
+                unique_lock<mutex> lock(mutex_);
+                ready_.wait(lock, [this] { return !jobs_.empty(); });
+                job = jobs_.front();
+                jobs_.pop_front();
+                running_++;
+                vm = vm_;
             }
+            JNIEnv* env = GetThreadEnv(vm);
+            Report(env, job, BUILD_CHECKING);
+            bool ok = _processModel(client, job.path, [this, env, &job] { Report(env, job, BUILD_BUILDING); });
+            Report(env, job, ok ? BUILD_DONE : BUILD_FAILED);
+            if (env != nullptr) {
+                env->DeleteGlobalRef(job.listener);
+            }
+            lock_guard<mutex> lock(mutex_);
+            running_--;
+            (ok ? succeeded_ : failed_)++;
+        }
+    }
+
+    void Report(JNIEnv* env, const Job& job, BUILD_STAGE stage)
+    {
+        if (env == nullptr) {
+            return;
+        }
+        jstring path = env->NewStringUTF(job.path.c_str());
+        env->CallVoidMethod(job.listener, job.onProgress, job.id, path, (jint)stage);
+        if (env->ExceptionCheck()) {
+            env->ExceptionDescribe();
+            env->ExceptionClear();
         }
+        env->DeleteLocalRef(path);
     }
 
+    mutex mutex_;
+    condition_variable ready_;
+    deque<Job> jobs_;
+    vector<thread> workers_;
+    uint32_t parallelism_ = DEFAULT_BUILD_PARALLELISM;
+    JavaVM* vm_ = nullptr;
+    int32_t nextId_ = 1;
+    uint32_t running_ = 0;
+    uint64_t succeeded_ = 0;
+    uint64_t failed_ = 0;
+};
+
+extern "C" JNIEXPORT jint JNICALL Java_com_huawei_hiaidemo_utils_ModelManager_submitModelBuild(
+    JNIEnv* env, jclass type, jstring offlinemodel_, jobject listener)
+{
+    if (env == NULL || offlinemodel_ == NULL || listener == NULL) {
+        ALOGE("[HIAI_DEMO_BUILD_SERVICE] submitModelBuild invalid params.");
+        return -1;
+    }
+    jclass listenerClass = env->GetObjectClass(listener);
+    jmethodID onProgress = env->GetMethodID(listenerClass, "onBuildProgress", "(ILjava/lang/String;I)V");
+    JavaVM* vm = NULL;
+    if (onProgress == NULL || env->GetJavaVM(&vm) != JNI_OK) {
+        ALOGE("[HIAI_DEMO_BUILD_SERVICE] can not find onBuildProgress method.");
+        return -1;
+    }
+    const char* offlinemodel = env->GetStringUTFChars(offlinemodel_, 0);
+    if (offlinemodel == NULL) {
+        return -1;
+    }
+    string path(offlinemodel);
     env->ReleaseStringUTFChars(offlinemodel_, offlinemodel);
+    jobject ref = env->NewGlobalRef(listener);
+    if (ref == NULL) {
+        return -1;
+    }
+    return ModelBuildService::Shared().Submit(vm, path, ref, onProgress);
+}
 
-    bool res = false;
-    if (result_code == CHECK_OFFLINEMODEL_COMPATIBILITY_SUCCESS || result_code == BUILD_OFFLINEMODEL_SUCCESS) {
-        res = true;
+extern "C" JNIEXPORT jboolean JNICALL Java_com_huawei_hiaidemo_utils_ModelManager_configureModelBuild(
+    JNIEnv* env, jclass type, jint parallelism)
+{
+    if (parallelism < 1 || parallelism > (jint)MAX_BUILD_PARALLELISM) {
+        ALOGE("[HIAI_DEMO_BUILD_SERVICE] parallelism %d is out of [1, %u].", parallelism, MAX_BUILD_PARALLELISM);
+        return JNI_FALSE;
     }
-    ALOGI("[HIAI_DEMO_COMPATIBILITY_CHECK] result_code value : %d", result_code);
-    return res;
+    return ModelBuildService::Shared().Configure((uint32_t)parallelism) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jlongArray JNICALL Java_com_huawei_hiaidemo_utils_ModelManager_getModelBuildStats(
+    JNIEnv* env, jclass type)
+{
+    jlong values[4];
+    ModelBuildService::Shared().GetStats(values);
+    jlongArray result = env->NewLongArray(4);
+    if (result != NULL) {
+        env->SetLongArrayRegion(result, 0, 4, values);
+    }
+    return result;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_huawei_hiaidemo_utils_ModelManager_setCompiledModelCacheDir(
+    JNIEnv* env, jclass type, jstring dir_)
+{
+    if (env == NULL || dir_ == NULL) {
+        SetCompiledModelCacheDir(string());
+        return;
+    }
+    const char* dir = env->GetStringUTFChars(dir_, 0);
+    if (dir == NULL) {
+        return;
+    }
+    SetCompiledModelCacheDir(dir);
+    env->ReleaseStringUTFChars(dir_, dir);
 }
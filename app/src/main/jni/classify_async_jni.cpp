@@ -13,12 +13,31 @@
 
 #include <memory.h>
 #include "HiAiModelManagerService.h"
+#include "bounded_queue.h"
+#include "classify_async_jni.h"
+#include "jni_common.h"
+#include "model_bundle.h"
+#include "model_residency.h"
+#include "postprocess.h"
+#include "qos_scheduler.h"
+#include "request_tracker.h"
+#include "service_recovery.h"
+#include "slot_free_list.h"
+#include "task_pool.h"
+#include "warmup.h"
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
 #include <android/log.h>
+#include <algorithm>
+#include <atomic>
+#include <climits>
 #include <cstdlib>
 #include <cmath>
+#include <chrono>
+#include <condition_variable>
+#include <set>
 #include <sstream>
+#include <thread>
 #include <unistd.h>
 
 #define LOG_TAG "ASYNC_DDK_MSG"
@@ -28,48 +47,401 @@
 
 using namespace std;
 using namespace hiai;
-static jclass callbacksClass;
-static jobject callbacksInstance;
-JavaVM *jvm;
+// listener of the latest request, told when the NPU service dies
+static jobject callbacksInstance = nullptr;
+// set by loadModelAsync, before any client can report a death or a result
+JavaVM *jvm = nullptr;
+
+// a request in flight
+struct AsyncRequest {
+    int model = 0;
+    uint32_t slot = 0;
+    bool slotReleased = false;
+    chrono::steady_clock::time_point submitTime;
+    // global ref of the listener, deleted once the result is delivered
+    jobject callbacks = nullptr;
+    // callbacks is a ModelManagerBufferListener: outputs are leased, not copied
+    bool useBuffers = false;
+    jlong tag = 0;
+    // set by SubmitAsyncSlot: told of the result instead of delivering it
+    AsyncCompletion onComplete;
+    // deadline and cancellation, nullptr for warm-up requests
+    RequestControlPtr control;
+    // times it was resubmitted after the NPU service died
+    uint32_t replays = 0;
+};
+// task id -> request, from Process until the result is delivered (or the leased
+// outputs are released)
+static map<int32_t, AsyncRequest> map_input_tensor;
+
+// DDK istamps start over with every client, so Java knows a request by a task
+// id of its own, which it keeps when it is replayed on a new client
+static int32_t next_task_id = 1;
+// DdkKey(client generation, istamp) of a request running on the NPU -> task id
+static map<uint64_t, int32_t> ddk_tasks;
+
+// results that arrived before Process returned their istamp to the submitter
+struct EarlyCompletion {
+    int32_t result;
+    chrono::steady_clock::time_point doneTime;
+};
+static map<uint64_t, EarlyCompletion> early_completion;
+// requests of client generations below it have been collected by a replay;
+// a request tracked later on one of them is too late to be replayed
+static uint32_t replayed_generation = 0;
 
-static float time_use;
-struct timeval tpstart, tpend;
+static mutex mutex_map;
 
-static map<int32_t ,vector<shared_ptr<AiTensor>>*> map_input_tensor;
+static uint64_t DdkKey(uint32_t generation, int32_t istamp)
+{
+    return ((uint64_t)generation << 32) | (uint32_t)istamp;
+}
 
-static mutex mutex_map;
-static condition_variable condition_;
+static uint32_t DdkGeneration(uint64_t ddkKey)
+{
+    return (uint32_t)(ddkKey >> 32);
+}
+
+// the client the async models run on; a new generation replaces it after the
+// NPU service dies
+struct AsyncClient {
+    shared_ptr<AiModelMngerClient> client;
+    uint32_t generation = 0;
+};
+static AsyncClient async_client;
+static mutex async_client_mutex;
+// generation of the next client created
+static atomic<uint32_t> async_generations(0);
+
+static AsyncClient CurrentAsyncClient()
+{
+    lock_guard<mutex> lock(async_client_mutex);
+    return async_client;
+}
+
+static ServiceRecovery& AsyncRecovery();
 
 //extern bool g_isAIPP;
 static const int SUCCESS = 0;
 static const int FAILED = -1;
 
 static map<string, int> async_nameToIndex;
+// per model: top-K applied to every output before it is handed to Java
+static vector<PostprocessConfig> async_postprocess;
+
+// an input slot handed to Java by acquireInputSlotAsync and not submitted yet,
+// taken from the free list so no other request uses it
+struct InputReservation {
+    int model = 0;
+    uint32_t slot = 0;
+};
+// by the handle Java passes back, which is never reused while it is reserved
+static map<int32_t, InputReservation> reserved_input;
+static int32_t next_reservation = 1;
+
+// task ids whose output buffers are leased to Java; their slot stays in
+// map_input_tensor until releaseOutputBuffersAsync
+static set<int32_t> leased_output;
+
+// Process timeout of requests without a deadline
+static const uint32_t DEFAULT_PROCESS_TIMEOUT_MS = 300;
+// how long a request without a deadline waits for the service to recover
+static const int NO_DEADLINE_RECOVERY_WAIT_MS = 3000;
+// a request is failed rather than replayed on a third client
+static const uint32_t MAX_REPLAYS = 2;
+// how long a request without a deadline may wait for a slot
+static const int NO_DEADLINE_SLOT_WAIT_HOURS = 24;
+
+static const int DEFAULT_ASYNC_DEPTH = 2;
+static const int MAX_ASYNC_DEPTH = 16;
+
+// one input and output tensor set per request in flight
+struct AsyncSlot {
+    vector<shared_ptr<AiTensor>> inputs;
+    vector<shared_ptr<AiTensor>> outputs;
+};
+
+struct AsyncRing {
+    vector<AsyncSlot> slots;
+    unique_ptr<SlotFreeList> freeSlots;
+};
+
+// per model, created at load time with the depth of the model
+static vector<AsyncRing> async_rings;
+// per model: progress of the warm-up run in the background after load
+static vector<shared_ptr<WarmupTracker>> async_warmup;
+// per model: where its startup time went
+static vector<ModelLoadTimes> async_load_times;
+static const int WARMUP_TIMEOUT_MS = 3000;
+
+static void ReleaseSlot(AsyncRequest& request)
+{
+    if (request.slotReleased) {
+        return;
+    }
+    request.slotReleased = true;
+    if (request.model >= 0 && request.model < (int)async_rings.size()) {
+        async_rings[request.model].freeSlots->Release(request.slot);
+    }
+}
+
+/*
+* @brief Forget a request that was never submitted, or whose result has been
+*        delivered: return its slot and drop its listener. A request that has
+*        no outcome yet counts as failed.
+*/
+static void DropAsyncRequest(JNIEnv *env, AsyncRequest& request)
+{
+    RequestTracker::Shared().Finish(request.control, REQUEST_FAILED);
+    ReleaseSlot(request);
+    if (request.callbacks != nullptr) {
+        env->DeleteGlobalRef(request.callbacks);
+        request.callbacks = nullptr;
+    }
+}
+
+static jobject NewOutputList(JNIEnv *env, const vector<shared_ptr<AiTensor>>& output_tensor,
+    const PostprocessConfig& postprocess)
+{
+    jclass output_list_class = env->FindClass("java/util/ArrayList");
+    jmethodID  output_list_init = env->GetMethodID(output_list_class,"<init>","()V");
+    jobject output_list = env->NewObject(output_list_class,output_list_init,"");
+    jmethodID list_add = env->GetMethodID(output_list_class,"add","(Ljava/lang/Object;)Z");
+    long output_tensor_size = output_tensor.size();
+    for(long j = 0; j < output_tensor_size; j++)
+    {
+        jfloat *outputBuffer = (jfloat *) output_tensor[j]->GetBuffer();
+        auto output_count = output_tensor[j]->GetSize()/sizeof(jfloat);
+        jfloatArray  result;
+        if (postprocess.topK > 0) {
+            vector<float> packed(2 * postprocess.topK);
+            uint32_t packedSize = TopKPacked(outputBuffer, (uint32_t)output_count, postprocess, packed.data());
+            result = env->NewFloatArray(packedSize);
+            env->SetFloatArrayRegion(result,0,packedSize,packed.data());
+        } else {
+            result = env->NewFloatArray(output_count);
+            env->SetFloatArrayRegion(result,0,output_count,outputBuffer);
+        }
+        env->CallBooleanMethod(output_list,list_add,result);
+        env->DeleteLocalRef(result);
+    }
+    env->DeleteLocalRef(output_list_class);
+    return output_list;
+}
+
+/*
+* @brief Hand the result of a request to the listener it was submitted with
+* @param [in] env JNIEnv of the calling thread
+* @param [in] taskId request
+* @param [in] result status reported by the DDK
+* @param [in] doneTime when the DDK reported the result
+*/
+void DeliverAsyncResult(JNIEnv *env, int32_t taskId, int32_t result, chrono::steady_clock::time_point doneTime)
+{
+    std::unique_lock<std::mutex> lock(mutex_map);
+    auto it = map_input_tensor.find(taskId);
+    if (it == map_input_tensor.end()) {
+        LOGE("[HIAI_DEMO_ASYNC] task %d is not in flight.", taskId);
+        return;
+    }
+    AsyncRequest request = it->second;
+    request.onComplete = nullptr;
+    // read once: a Cancel racing with delivery either stops it or comes too late
+    bool cancelled = request.control != nullptr && request.control->Cancelled();
+    bool leaseOutput = (result == 0 && !cancelled && request.useBuffers);
+    if (leaseOutput) {
+        leased_output.insert(taskId);
+    }
+    lock.unlock();
+
+    float time_use = chrono::duration<float, micro>(doneTime - request.submitTime).count();
+    bool delivered = false;
+    if (result != 0) {
+        LOGI("[HIAI_DEMO_ASYNC] AYSNC infrence error is %d.", result);
+    } else if (cancelled) {
+        // too late to save the NPU time, but the listener no longer wants it
+        LOGI("[HIAI_DEMO_ASYNC] result of cancelled request %lld dropped.", (long long)request.tag);
+        RequestTracker::Shared().Finish(request.control, REQUEST_CANCELLED);
+    } else if (env->PushLocalFrame(16) != 0) {
+        LOGE("[HIAI_DEMO_ASYNC] no local refs left to deliver task %d.", taskId);
+        env->ExceptionClear();
+    } else {
+        // the callback thread stays attached, so its local refs are only freed here
+        LOGI("[HIAI_DEMO_ASYNC] AYSNC inference time %f ms, JNI layer onRunDone task: %d", time_use / 1000, taskId);
+        AsyncSlot& tensors = async_rings[request.model].slots[request.slot];
+        jclass callbacksClass = env->GetObjectClass(request.callbacks);
+        if (leaseOutput) {
+            jobject buffer_list = NewTensorBufferList(env, tensors.outputs);
+            jmethodID onBuffersReceived = env->GetMethodID(callbacksClass, "OnProcessDoneBuffers", "(ILjava/util/ArrayList;F)V");
+            if (buffer_list == nullptr || onBuffersReceived == nullptr) {
+                LOGE("[HIAI_DEMO_ASYNC] can not deliver output buffers of task %d.", taskId);
+                env->ExceptionClear();
+            } else {
+                // before the call: a listener releasing the outputs inside it drops the
+                // request, which must not count it as failed
+                RequestTracker::Shared().Finish(request.control, REQUEST_COMPLETED);
+                delivered = true;
+                env->CallVoidMethod(request.callbacks, onBuffersReceived, taskId, buffer_list, (jfloat)time_use);
+            }
+        } else {
+            PostprocessConfig postprocess;
+            if (request.model < (int)async_postprocess.size()) {
+                postprocess = async_postprocess[request.model];
+            }
+            jobject output_list = NewOutputList(env, tensors.outputs, postprocess);
+            // outputs are copied, the slot can take the next request before Java runs
+            lock.lock();
+            auto slotIt = map_input_tensor.find(taskId);
+            if (slotIt != map_input_tensor.end()) {
+                ReleaseSlot(slotIt->second);
+            }
+            lock.unlock();
+            jmethodID onValueReceived = env->GetMethodID(callbacksClass, "OnProcessDone", "(ILjava/util/ArrayList;F)V");
+            if(onValueReceived == nullptr){
+                LOGI("[HIAI_DEMO_ASYNC] jni onValueReceived null");
+                env->ExceptionClear();
+            } else {
+                RequestTracker::Shared().Finish(request.control, REQUEST_COMPLETED);
+                env->CallVoidMethod(request.callbacks, onValueReceived, taskId, output_list, (jfloat)time_use);
+            }
+        }
+        env->PopLocalFrame(nullptr);
+    }
+
+    lock.lock();
+    if (leaseOutput && !delivered) {
+        leaseOutput = false;
+        leased_output.erase(taskId);
+    }
+    it = map_input_tensor.find(taskId);
+    if (it == map_input_tensor.end()) {
+        // the listener already released the leased outputs
+        return;
+    }
+    if (leaseOutput) {
+        env->DeleteGlobalRef(it->second.callbacks);
+        it->second.callbacks = nullptr;
+    } else {
+        DropAsyncRequest(env, it->second);
+        map_input_tensor.erase(it);
+    }
+}
+
+/*
+* @brief Record a submitted request under a new task id, and deliver its
+*        result if the DDK reported it before Process returned
+* @param [in] ddkKey DdkKey of the submission
+* @return task id of the request
+*/
+static int32_t TrackAsyncRequest(JNIEnv *env, uint64_t ddkKey, const AsyncRequest& request)
+{
+    std::unique_lock<std::mutex> lock(mutex_map);
+    int32_t taskId = next_task_id;
+    next_task_id = next_task_id < INT_MAX ? next_task_id + 1 : 1;
+    map_input_tensor[taskId] = request;
+    EarlyCompletion done{FAILED, chrono::steady_clock::now()};
+    if (DdkGeneration(ddkKey) < replayed_generation) {
+        // the client died under the request, and its replay has already run
+        LOGE("[HIAI_DEMO_ASYNC] task %d was submitted to a dead client.", taskId);
+    } else {
+        auto early = early_completion.find(ddkKey);
+        if (early == early_completion.end()) {
+            // on a client that died since, the pending replay picks it up
+            ddk_tasks[ddkKey] = taskId;
+            return taskId;
+        }
+        done = early->second;
+        early_completion.erase(early);
+    }
+    lock.unlock();
+    if (request.onComplete) {
+        request.onComplete(taskId, done.result, done.doneTime);
+        return taskId;
+    }
+    DeliverAsyncResult(env, taskId, done.result, done.doneTime);
+    return taskId;
+}
+
+// results waiting for their listener; past it a stalled listener throttles
+// the DDK thread instead of queueing without bound
+static const size_t DELIVERY_QUEUE_CAPACITY = 256;
+
+struct AsyncDelivery {
+    int32_t taskId = 0;
+    int32_t result = 0;
+    chrono::steady_clock::time_point doneTime;
+};
+
+/*
+* @brief Queue of the thread that runs the Java listeners, started on first use.
+*        Listeners run one at a time and in completion order, as they did on
+*        the DDK thread, on a thread attached once that does nothing else: a
+*        slow listener holds neither the DDK thread nor a worker of the shared
+*        pool that preprocessing needs.
+*/
+static BoundedQueue<AsyncDelivery>& DeliveryQueue()
+{
+    // never deleted, the thread draining it runs until the process exits
+    static BoundedQueue<AsyncDelivery>* queue = [] {
+        BoundedQueue<AsyncDelivery>* created = new BoundedQueue<AsyncDelivery>(DELIVERY_QUEUE_CAPACITY);
+        thread([created] {
+            JNIEnv *env = GetThreadEnv(jvm);
+            AsyncDelivery delivery;
+            while (created->Pop(delivery)) {
+                if (env == nullptr) {
+                    LOGE("[HIAI_DEMO_ASYNC] result of task %d cannot be delivered.", delivery.taskId);
+                    continue;
+                }
+                DeliverAsyncResult(env, delivery.taskId, delivery.result, delivery.doneTime);
+                if (env->ExceptionCheck()) {
+                    // a listener threw: the next ones still run
+                    env->ExceptionDescribe();
+                    env->ExceptionClear();
+                }
+            }
+        }).detach();
+        return created;
+    }();
+    return *queue;
+}
+
+/*
+* @brief Tell a request its result: its onComplete if it has one, otherwise
+*        its listener, from the delivery thread
+*/
+static void CompleteAsyncRequest(int32_t taskId, const AsyncCompletion& onComplete, int32_t result,
+    chrono::steady_clock::time_point doneTime)
+{
+    if (onComplete) {
+        onComplete(taskId, result, doneTime);
+        return;
+    }
+    // building the Java outputs and running the listener are left to the
+    // delivery thread, the DDK thread goes back to reporting completions
+    AsyncDelivery delivery;
+    delivery.taskId = taskId;
+    delivery.result = result;
+    delivery.doneTime = doneTime;
+    DeliveryQueue().Push(delivery);
+}
 
 class JNIListener : public AiModelManagerClientListener
 {
 public:
-    JNIListener(){}
+    explicit JNIListener(uint32_t generation) : generation_(generation) {}
     ~JNIListener(){}
 
     void OnProcessDone(const AiContext &context, int32_t result, const vector<shared_ptr<AiTensor>> &out_data, int32_t istamp);
     void OnServiceDied();
+
+private:
+    // generation of the client the listener was given to
+    uint32_t generation_;
 };
 
 void JNIListener::OnProcessDone(const AiContext &context, int result, const vector<shared_ptr<AiTensor>> &output_tensor, int32_t istamp)
 {
-    std::unique_lock<std::mutex> lock(mutex_map);
-    map_input_tensor.erase(istamp);
-    condition_.notify_all();
-    if (result != 0) {
-        LOGI("[HIAI_DEMO_ASYNC] AYSNC infrence error is %d.", result);
-        return;
-    }
-    gettimeofday(&tpend, nullptr);
-    time_use = 1000000 * (tpend.tv_sec - tpstart.tv_sec) + tpend.tv_usec - tpstart.tv_usec;
-    LOGI("[HIAI_DEMO_ASYNC] AYSNC inference time %f ms, JNI layer onRunDone istamp: %d", time_use / 1000, istamp);
-    JNIEnv *env = nullptr;
-    jvm->AttachCurrentThread(&env, nullptr);
+    chrono::steady_clock::time_point doneTime = chrono::steady_clock::now();
     vector<string> keys;
     ((AiContext)context).GetAllKeys(keys);
     for (auto key : keys)
@@ -77,139 +449,135 @@ void JNIListener::OnProcessDone(const AiContext &context, int result, const vect
         string value = ((AiContext)context).GetPara(key);
         LOGI("[HIAI_DEMO_ASYNC] key: %s, value: %s.", key.c_str(), value.c_str());
     }
-    jclass output_list_class = env->FindClass("java/util/ArrayList");
-    jmethodID  output_list_init = env->GetMethodID(output_list_class,"<init>","()V");
-    jobject output_list = env->NewObject(output_list_class,output_list_init,"");
-    jmethodID list_add = env->GetMethodID(output_list_class,"add","(Ljava/lang/Object;)Z");
-    long output_tensor_size = output_tensor.size();
-    for(long j = 0; j < output_tensor_size; j++)
+    AsyncCompletion onComplete;
+    int32_t taskId = 0;
     {
-        jfloat *outputBuffer = (jfloat *) output_tensor[j]->GetBuffer();
-        auto output_count = output_tensor[j]->GetSize()/sizeof(jfloat);
-        jfloatArray  result = env->NewFloatArray(output_count);
-        jfloat temp[output_count];
-        for(int i =0;i < output_count;i++)
-        {
-            temp[i] = outputBuffer[i];
+        std::unique_lock<std::mutex> lock(mutex_map);
+        uint64_t ddkKey = DdkKey(generation_, istamp);
+        auto it = ddk_tasks.find(ddkKey);
+        if (it == ddk_tasks.end()) {
+            if (generation_ < CurrentAsyncClient().generation) {
+                // a client replaced after the service died; its requests were replayed
+                LOGI("[HIAI_DEMO_ASYNC] istamp %d of a dead client dropped.", istamp);
+                return;
+            }
+            // Process has not returned yet, the submitter delivers the result
+            early_completion[ddkKey] = EarlyCompletion{result, doneTime};
+            return;
+        }
+        taskId = it->second;
+        ddk_tasks.erase(it);
+        auto request = map_input_tensor.find(taskId);
+        if (request != map_input_tensor.end()) {
+            onComplete = request->second.onComplete;
         }
-        env->SetFloatArrayRegion(result,0,output_count,temp);
-        jboolean output_add = env->CallBooleanMethod(output_list,list_add,result);
-    }
-    jfloat infertime = time_use;
-    if(callbacksInstance == nullptr)
-    {
-        return;
-    }
-    jmethodID onValueReceived = env->GetMethodID(callbacksClass, "OnProcessDone", "(ILjava/util/ArrayList;F)V");
-    if(onValueReceived == nullptr){
-        LOGI("[HIAI_DEMO_ASYNC] jni onValueReceived null");
     }
-    env->CallVoidMethod(callbacksInstance, onValueReceived, istamp, output_list, infertime);
+    CompleteAsyncRequest(taskId, onComplete, result, doneTime);
 }
 
 void JNIListener::OnServiceDied()
 {
     LOGE("[HIAI_DEMO_ASYNC] JNI layer OnServiceDied:");
+    if (generation_ < CurrentAsyncClient().generation) {
+        LOGI("[HIAI_DEMO_ASYNC] death of a replaced client ignored.");
+        return;
+    }
+    // the sync models went with the service too, they reload on their next inference
+    ModelResidency::Shared().DropClients();
+    AsyncRecovery().OnServiceDied();
+
+    // the DDK thread stays attached until it exits, as the delivery thread
+    JNIEnv *env = jvm != nullptr ? GetThreadEnv(jvm) : nullptr;
+    if (env == nullptr) {
+        LOGE("[HIAI_DEMO_ASYNC] no JNIEnv, onServiceDied is not reported.");
+        return;
+    }
 
-    JNIEnv *env = nullptr;
-
-    jvm->AttachCurrentThread(&env, nullptr);
-
-    if(callbacksInstance == nullptr)
+    jobject callbacks = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(mutex_map);
+        if (callbacksInstance != nullptr) {
+            callbacks = env->NewLocalRef(callbacksInstance);
+        }
+    }
+    if(callbacks == nullptr)
     {
         return;
     }
     else
     {
-        jmethodID onValueReceived = env->GetMethodID(callbacksClass, "OnServiceDied", "()V");
-        env->CallVoidMethod(callbacksInstance, onValueReceived);
+        jclass callbacksClass = env->GetObjectClass(callbacks);
+        jmethodID onValueReceived = env->GetMethodID(callbacksClass, "onServiceDied", "()V");
+        if (onValueReceived != nullptr) {
+            env->CallVoidMethod(callbacks, onValueReceived);
+        }
+        env->DeleteLocalRef(callbacksClass);
+        env->DeleteLocalRef(callbacks);
     }
 }
 
-static shared_ptr<AiModelMngerClient> mclientAsync = nullptr;
 static vector<vector<TensorDimension>> inputDimension;
 static vector<vector<TensorDimension>> outputDimension;
-static vector<vector<shared_ptr<AiTensor>>> input_tensor1_vec;
-static vector<vector<shared_ptr<AiTensor>>> input_tensor2_vec;
-static vector<vector<shared_ptr<AiTensor>>> output_tensor_vec;
-
-vector<shared_ptr<AiTensor>>* findInputTensor(int vecIdx)
-{
-    vector<shared_ptr<AiTensor>> & input_tensor1 = input_tensor1_vec[vecIdx];
-    vector<shared_ptr<AiTensor>> & input_tensor2 = input_tensor2_vec[vecIdx];
-    std::unique_lock<std::mutex> ulock(mutex_map);
-    while(map_input_tensor.size()==2){
-        condition_.wait_for(ulock,chrono::seconds(1));
-    }
-    if(map_input_tensor.size()==0){
-        return &input_tensor1;
-    }else if(map_input_tensor.size()==1) {
-        map<int32_t, vector<shared_ptr<AiTensor>> *>::iterator ite;
-        ite = map_input_tensor.begin();
-        if (ite->second == &input_tensor1) {
-            return &input_tensor2;
-        } else {
-            return &input_tensor1;
-        }
-    }
-    return nullptr;
+
+// take a free slot of the model, waiting while all of them are in flight
+uint32_t findInputTensor(int vecIdx)
+{
+    uint32_t slot = 0;
+    async_rings[vecIdx].freeSlots->Acquire(slot);
+    return slot;
 }
 
-void AsyncResourceDestroy(shared_ptr<AiModelBuilder>& modelBuilder, vector<MemBuffer*>& memBuffers)
+/*
+* @brief findInputTensor for a tracked request: stops waiting at its deadline
+*        or when it is cancelled, and then finishes it
+* @return false if the request must be dropped
+*/
+static bool FindInputTensorFor(int vecIdx, const RequestControlPtr& control, uint32_t& slot)
 {
-    if (modelBuilder == nullptr) {
-        LOGE("[HIAI_DEMO_ASYNC] modelBuilder is null.");
-        return;
+    RequestTracker& tracker = RequestTracker::Shared();
+    if (!tracker.Admit(control, "the slot wait")) {
+        return false;
     }
-
-    for (auto tmpBuffer : memBuffers) {
-        modelBuilder->MemBufferDestroy(tmpBuffer);
+    chrono::steady_clock::time_point deadline = control->HasDeadline() ? control->Deadline() :
+        chrono::steady_clock::now() + chrono::hours(NO_DEADLINE_SLOT_WAIT_HOURS);
+    if (async_rings[vecIdx].freeSlots->AcquireUntil(slot, deadline, [&control] { return control->Cancelled(); })) {
+        return true;
     }
-    return;
+    if (tracker.Admit(control, "a slot")) {
+        tracker.Finish(control, REQUEST_EXPIRED);
+    }
+    return false;
 }
 
-shared_ptr<JNIListener> listener = make_shared<JNIListener>();
+// serializes loadModelAsync, which may run on a background thread
+static mutex async_load_mutex;
+
+// OM files of the async models, kept mapped to load them again on a new
+// client if the NPU service dies
+static vector<shared_ptr<ModelMapping>> async_models;
+static vector<string> async_names;
+static vector<AiModelDescription_Frequency> async_frequencies;
 
-int LoadASync(vector<string>& names, vector<string>& modelPaths, shared_ptr<AiModelMngerClient>& client)
+/*
+* @brief Load the async models from host memory
+*/
+static int LoadAsyncModels(shared_ptr<AiModelMngerClient>& client)
 {
-    int ret;
     vector<shared_ptr<AiModelDescription>> modelDescs;
-    vector<MemBuffer*> memBuffers;
-    shared_ptr<AiModelBuilder> modelBuilder = make_shared<AiModelBuilder>(client);
-    if (modelBuilder == nullptr) {
-        LOGE("[HIAI_DEMO_ASYNC] creat mcbuilder failed.");
-        return FAILED;
-    }
-
-    for (size_t i = 0; i < modelPaths.size(); ++i){
-        string modelPath = modelPaths[i];
-        string modelName = names[i];
-        async_nameToIndex[modelName] = i;
-
-        // We can achieve the optimization by loading model from OM file.
-        LOGI("[HIAI_DEMO_ASYNC] modelpath is %s\n.", modelPath.c_str());
-        MemBuffer* buffer = modelBuilder->InputMemBufferCreate(modelPath);
-        if (buffer == nullptr)
-        {
-            LOGE("[HIAI_DEMO_ASYNC] cannot find the model file.");
-            return FAILED;
-        }
-        memBuffers.push_back(buffer);
-        string modelNameFull = string(modelName) + string(".om");
-        shared_ptr<AiModelDescription> desc = make_shared<AiModelDescription>(modelNameFull, AiModelDescription_Frequency_HIGH, HIAI_FRAMEWORK_NONE, HIAI_MODELTYPE_ONLINE, AiModelDescription_DeviceType_NPU);
+    for (size_t i = 0; i < async_names.size(); ++i) {
+        string modelNameFull = async_names[i] + string(".om");
+        shared_ptr<AiModelDescription> desc = make_shared<AiModelDescription>(modelNameFull, async_frequencies[i], HIAI_FRAMEWORK_NONE, HIAI_MODELTYPE_ONLINE, AiModelDescription_DeviceType_NPU);
         if (desc == nullptr) {
             LOGE("[HIAI_DEMO_ASYNC] LoadASync: desc make_shared error.");
-            AsyncResourceDestroy(modelBuilder, memBuffers);
             return FAILED;
         }
-        desc->SetModelBuffer(buffer->GetMemBufferData(), buffer->GetMemBufferSize());
+        desc->SetModelBuffer(async_models[i]->Data(), async_models[i]->Size());
 
         LOGE("[HIAI_DEMO_ASYNC] loadModel %s IO Tensor.", desc->GetName().c_str());
         modelDescs.push_back(desc);
     }
 
-    ret = client->Load(modelDescs);
-    AsyncResourceDestroy(modelBuilder, memBuffers);
+    int ret = client->Load(modelDescs);
     if (ret != 0)
     {
         LOGE("[HIAI_DEMO_ASYNC] Model Load Failed.");
@@ -218,123 +586,172 @@ int LoadASync(vector<string>& names, vector<string>& modelPaths, shared_ptr<AiMo
     return SUCCESS;
 }
 
-shared_ptr<AiModelMngerClient> LoadModelASync(vector<string> names, vector<string> modelPaths, vector<bool> Aipps)
+int LoadASync(vector<string>& names, vector<ModelSource>& sources, vector<AiModelDescription_Frequency>& frequencies,
+    shared_ptr<AiModelMngerClient>& client, vector<ModelLoadTimes>& times)
 {
-    shared_ptr<AiModelMngerClient> client_ptr = make_shared<AiModelMngerClient>();
-    if (client_ptr == nullptr) {
+    for (size_t i = 0; i < sources.size(); ++i) {
+        async_nameToIndex[names[i]] = i;
+    }
+    vector<shared_ptr<ModelMapping>> models(sources.size());
+    ParallelFor(TaskPool::Shared(), (uint32_t)sources.size(), 1, [&](uint32_t first, uint32_t last) {
+        for (uint32_t i = first; i < last; ++i) {
+            LOGI("[HIAI_DEMO_ASYNC] modelpath is %s\n.", sources[i].path.c_str());
+            LoadClock::time_point start = LoadClock::now();
+            models[i] = MapModel(sources[i]);
+            times[i].mapUs = MicrosSince(start);
+        }
+    });
+    for (size_t i = 0; i < models.size(); ++i) {
+        if (models[i] == nullptr) {
+            LOGE("[HIAI_DEMO_ASYNC] cannot find the model file of %s.", names[i].c_str());
+            return FAILED;
+        }
+    }
+    async_models.swap(models);
+    async_names = names;
+    async_frequencies = frequencies;
+    // one client: its listener gets the results of every model
+    LoadClock::time_point start = LoadClock::now();
+    int ret = LoadAsyncModels(client);
+    for (auto& t : times) {
+        t.loadUs = MicrosSince(start);
+    }
+    return ret;
+}
+
+/*
+* @brief Client with a listener that knows its generation
+*/
+static shared_ptr<AiModelMngerClient> NewAsyncClient(uint32_t& generation)
+{
+    shared_ptr<AiModelMngerClient> client = make_shared<AiModelMngerClient>();
+    if (client == nullptr) {
         LOGE("[HIAI_DEMO_ASYNC] Model Manager Client make_shared error.");
         return nullptr;
     }
-    int ret = client_ptr->Init(listener);
+    generation = async_generations++;
+    int ret = client->Init(make_shared<JNIListener>(generation));
     if (ret != 0) {
         LOGE("[HIAI_DEMO_ASYNC] Model Manager Init Failed.");
         return nullptr;
     }
+    return client;
+}
+
+static bool CreateAsyncSlot(const string& modelName, const vector<TensorDimension>& inputDims,
+    const vector<TensorDimension>& outputDims, bool isUseAipp, AsyncSlot& slot)
+{
+    for (auto in_dim : inputDims) {
+        shared_ptr<AiTensor> input = make_shared<AiTensor>();
+        int ret;
+        if (isUseAipp) {
+            ret = input->Init(in_dim.GetNumber(), in_dim.GetHeight(), in_dim.GetWidth(), AiTensorImage_YUV420SP_U8);
+        } else {
+            ret = input->Init(&in_dim);
+        }
+        if (ret != 0) {
+            LOGE("[HIAI_DEMO_ASYNC] model %s AiTensor Init failed(input).", modelName.c_str());
+            return false;
+        }
+        slot.inputs.push_back(input);
+    }
+    for (auto out_dim : outputDims) {
+        shared_ptr<AiTensor> output = make_shared<AiTensor>();
+        if (output->Init(&out_dim) != 0) {
+            LOGE("[HIAI_DEMO_ASYNC] model %s AiTensor Init failed(output).", modelName.c_str());
+            return false;
+        }
+        slot.outputs.push_back(output);
+    }
+    return true;
+}
+
+shared_ptr<AiModelMngerClient> LoadModelASync(vector<string> names, vector<ModelSource> sources, vector<bool> Aipps,
+    vector<int> depths, vector<uint32_t> warmupRuns, vector<AiModelDescription_Frequency> frequencies,
+    uint32_t& generation)
+{
+    LoadClock::time_point callStart = LoadClock::now();
+    vector<ModelLoadTimes> times(names.size());
+    shared_ptr<AiModelMngerClient> client_ptr = NewAsyncClient(generation);
+    if (client_ptr == nullptr) {
+        return nullptr;
+    }
 
-    ret = LoadASync(names, modelPaths, client_ptr);
+    int ret = LoadASync(names, sources, frequencies, client_ptr, times);
     if (ret != SUCCESS) {
         LOGE("[HIAI_DEMO_ASYNC] LoadASync Failed.");
         return nullptr;
     }
 
-    inputDimension.clear();
-    outputDimension.clear();
-    input_tensor1_vec.clear();
-    input_tensor2_vec.clear();
-    output_tensor_vec.clear();
-
+    inputDimension.assign(names.size(), vector<TensorDimension>());
+    outputDimension.assign(names.size(), vector<TensorDimension>());
     for (size_t i = 0; i < names.size(); ++i) {
-        string modelName = names[i];
-        bool isUseAipp = Aipps[i];
-        LOGI("[HIAI_DEMO_ASYNC] Get model %s IO Tensor. Use AIPP %d", modelName.c_str(), isUseAipp);
-        vector<TensorDimension> inputDims, outputDims;
-        ret = client_ptr->GetModelIOTensorDim(string(modelName) + string(".om"), inputDims, outputDims);
+        LOGI("[HIAI_DEMO_ASYNC] Get model %s IO Tensor. Use AIPP %d", names[i].c_str(), (int)Aipps[i]);
+        LoadClock::time_point start = LoadClock::now();
+        ret = client_ptr->GetModelIOTensorDim(names[i] + string(".om"), inputDimension[i], outputDimension[i]);
+        times[i].ioUs = MicrosSince(start);
         if (ret != 0) {
             LOGE("[HIAI_DEMO_ASYNC] Get Model IO Tensor Dimension failed,ret is %d.", ret);
             return nullptr;
         }
 
-        if (inputDims.size() == 0) {
+        if (inputDimension[i].size() == 0) {
             LOGE("[HIAI_DEMO_ASYNC] inputDims.size() == 0");
             return nullptr;
         }
-
-        inputDimension.push_back(inputDims);
-        outputDimension.push_back(outputDims);
-        // two identical input tensors for async runmodel
-        vector<shared_ptr<AiTensor>> inputTensors1, inputTensors2, outputTensors;
-        // input 1
-        for (auto in_dim : inputDims) {
-            shared_ptr<AiTensor> input = make_shared<AiTensor>();
-            if (isUseAipp) {
-                ret = input->Init(in_dim.GetNumber(), in_dim.GetHeight(), in_dim.GetWidth(), AiTensorImage_YUV420SP_U8);
-                LOGI("[HIAI_DEMO_ASYNC] model %s uses AIPP(input1).", modelName.c_str());
-            } else {
-                ret = input->Init(&in_dim);
-                LOGI("[HIAI_DEMO_ASYNC] model %s does not use AIPP(input1).", modelName.c_str());
-            }
-            if (ret != 0) {
-                LOGE("[HIAI_DEMO_ASYNC] model %s AiTensor Init failed(input1).", modelName.c_str());
-                return nullptr;
-            }
-            inputTensors1.push_back(input);
-        }
-        input_tensor1_vec.push_back(inputTensors1);
-
-        if (input_tensor1_vec.size() == 0) {
-            LOGE("[HIAI_DEMO_ASYNC] input_tensor1_vec.size() == 0");
+        shared_ptr<ModelBundle> bundle = FindModelBundle(sources[i]);
+        if (bundle != nullptr && !bundle->MatchesIo(inputDimension[i], outputDimension[i])) {
+            LOGE("[HIAI_DEMO_ASYNC] model %s does not match its bundle.", names[i].c_str());
             return nullptr;
         }
-        LOGE("[HIAI_DEMO_ASYNC] input_tensor1_vec.size %zu ", input_tensor1_vec.size());
+    }
 
-        // input 2
-        for (auto in_dim : inputDims) {
-            shared_ptr<AiTensor> input = make_shared<AiTensor>();
-            if (isUseAipp) {
-                ret = input->Init(in_dim.GetNumber(), in_dim.GetHeight(), in_dim.GetWidth(), AiTensorImage_YUV420SP_U8);
-                LOGI("[HIAI_DEMO_ASYNC] model %s uses AIPP(input2).", modelName.c_str());
-            } else {
-                ret = input->Init(&in_dim);
-                LOGI("[HIAI_DEMO_ASYNC] model %s does not use AIPP(input2).", modelName.c_str());
+    // identical input and output tensor sets, one per async request in flight;
+    // the models allocate theirs in parallel
+    vector<AsyncRing> rings(names.size());
+    vector<uint8_t> created(names.size(), 0);
+    ParallelFor(TaskPool::Shared(), (uint32_t)names.size(), 1, [&](uint32_t first, uint32_t last) {
+        for (uint32_t i = first; i < last; ++i) {
+            LoadClock::time_point start = LoadClock::now();
+            rings[i].slots.resize(depths[i]);
+            bool ok = true;
+            for (auto& slot : rings[i].slots) {
+                ok = ok && CreateAsyncSlot(names[i], inputDimension[i], outputDimension[i], Aipps[i], slot);
             }
-            if (ret != 0) {
-                LOGE("[HIAI_DEMO_ASYNC] model %s AiTensor Init failed(input2).", modelName.c_str());
-                return nullptr;
-            }
-            inputTensors2.push_back(input);
-        }
-        input_tensor2_vec.push_back(inputTensors2);
-
-        if (input_tensor2_vec.size() == 0) {
-            LOGE("[HIAI_DEMO_ASYNC] input_tensor2_vec.size() == 0");
-            return nullptr;
+            rings[i].freeSlots.reset(new SlotFreeList((uint32_t)depths[i]));
+            times[i].tensorUs = MicrosSince(start);
+            times[i].readyUs = MicrosSince(callStart);
+            created[i] = ok ? 1 : 0;
         }
-        LOGE("[HIAI_DEMO_ASYNC] input_tensor2_vec.size %zu ", input_tensor2_vec.size());
+    });
+    LogLoadTimes(names, times, MicrosSince(callStart));
 
-        // output
-        for (auto out_dim : outputDims) {
-            shared_ptr<AiTensor> output = make_shared<AiTensor>();
-            ret = output->Init(&out_dim);
-            if (ret != 0) {
-                LOGE("[HIAI_DEMO_ASYNC] model %s AiTensor Init failed(output).", modelName.c_str());
-                return nullptr;
-            }
-            outputTensors.push_back(output);
-        }
-        output_tensor_vec.push_back(outputTensors);
-        // In this demo, model may has many output
-        if (output_tensor_vec.size() == 0) {
-            LOGE("[HIAI_DEMO_ASYNC] output_tensor_vec.size() == 0");
+    {
+        // their slots go with the rings
+        std::unique_lock<std::mutex> lock(mutex_map);
+        reserved_input.clear();
+    }
+    async_rings.clear();
+    async_warmup.clear();
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (!created[i]) {
             return nullptr;
         }
+        async_rings.push_back(std::move(rings[i]));
+        async_warmup.push_back(make_shared<WarmupTracker>(warmupRuns[i]));
+        LOGI("[HIAI_DEMO_ASYNC] model %s keeps up to %d requests in flight.", names[i].c_str(), depths[i]);
     }
+    async_load_times.swap(times);
     return client_ptr;
 }
 
+static void StartAsyncWarmup(const vector<string>& names);
+
 extern "C"
 JNIEXPORT jobject JNICALL
 Java_com_huawei_hiaidemo_utils_ModelManager_loadModelAsync(JNIEnv *env, jclass type,jobject modelInfo){
 
+    env->GetJavaVM(&jvm);
     jclass classList = env->GetObjectClass(modelInfo);
     if(classList == nullptr){
         LOGE("[HIAI_DEMO_ASYNC] can not find List class.");
@@ -344,33 +761,57 @@ Java_com_huawei_hiaidemo_utils_ModelManager_loadModelAsync(JNIEnv *env, jclass t
     jmethodID listSize = env->GetMethodID(classList, "size", "()I");
     int len = static_cast<int>(env->CallIntMethod(modelInfo, listSize));
 
-    vector<string> names, modelPaths;
+    vector<string> names;
+    vector<ModelSource> sources;
     vector<bool> aipps;
+    vector<PostprocessConfig> postprocess;
+    vector<int> depths;
+    vector<uint32_t> warmupRuns;
+    vector<AiModelDescription_Frequency> frequencies;
     for(int i = 0;i < len ;i++){
 
         jobject modelInfoObj = env->CallObjectMethod(modelInfo, listGet, i);
         jclass modelInfoClass = env->GetObjectClass(modelInfoObj);
         jmethodID getOfflineModelName = env->GetMethodID(modelInfoClass,"getOfflineModelName","()Ljava/lang/String;");
-        jmethodID getModelPath = env->GetMethodID(modelInfoClass,"getModelPath","()Ljava/lang/String;");
         jmethodID getUseAIPP = env->GetMethodID(modelInfoClass,"getUseAIPP","()Z");
+        jmethodID getPostTopK = env->GetMethodID(modelInfoClass,"getPostTopK","()I");
+        jmethodID getPostSoftmax = env->GetMethodID(modelInfoClass,"getPostSoftmax","()Z");
+        jmethodID getAsyncDepth = env->GetMethodID(modelInfoClass,"getAsyncDepth","()I");
+        jmethodID getWarmupRuns = env->GetMethodID(modelInfoClass,"getWarmupRuns","()I");
 
         if(getOfflineModelName == nullptr)
         {
             LOGE("[HIAI_DEMO_ASYNC] can not find getOfflineModelName method.");
             return nullptr;
         }
-        if(getModelPath == nullptr){
-            LOGE("[HIAI_DEMO_ASYNC] can not find getModelPath method.");
-            return nullptr;
-        }
         if(getUseAIPP == nullptr){
             LOGE("[HIAI_DEMO_ASYNC] can not find getUseAIPP method.");
             return nullptr;
         }
+        if(getPostTopK == nullptr || getPostSoftmax == nullptr){
+            LOGE("[HIAI_DEMO_ASYNC] can not find getPostTopK or getPostSoftmax method.");
+            return nullptr;
+        }
+        if(getAsyncDepth == nullptr){
+            LOGE("[HIAI_DEMO_ASYNC] can not find getAsyncDepth method.");
+            return nullptr;
+        }
+        if(getWarmupRuns == nullptr){
+            LOGE("[HIAI_DEMO_ASYNC] can not find getWarmupRuns method.");
+            return nullptr;
+        }
+        QosClass qos;
+        if (!GetModelQosClass(env, modelInfoObj, qos)) {
+            return nullptr;
+        }
+        frequencies.push_back(QosFrequency(qos));
+        ModelSource source;
+        if (!GetModelSource(env, modelInfoObj, source)) {
+            return nullptr;
+        }
 
         jboolean useaipp = (jboolean)env->CallBooleanMethod(modelInfoObj,getUseAIPP);
         jstring modelname = (jstring)env->CallObjectMethod(modelInfoObj,getOfflineModelName);
-        jstring modelpath = (jstring)env->CallObjectMethod(modelInfoObj,getModelPath);
         const char* modelName = env->GetStringUTFChars(modelname, 0);
         LOGE("[HIAI_DEMO_ASYNC] modelName is %s .",modelName);
         if(modelName == nullptr)
@@ -378,27 +819,48 @@ Java_com_huawei_hiaidemo_utils_ModelManager_loadModelAsync(JNIEnv *env, jclass t
             LOGE("[HIAI_DEMO_ASYNC] modelName is invalid.");
             return nullptr;
         }
-        const char *modelPath = env->GetStringUTFChars(modelpath, 0);
-        if(modelPath == nullptr)
-        {
-            LOGE("[HIAI_DEMO_ASYNC] modelPath is invalid.");
-            return nullptr;
-        }
         LOGE("[HIAI_DEMO_ASYNC] useaipp is %d.", bool(useaipp==JNI_TRUE));
         aipps.push_back(bool(useaipp==JNI_TRUE));
         names.push_back(string(modelName));
-        modelPaths.push_back(string(modelPath));
+        sources.push_back(source);
+
+        PostprocessConfig config;
+        jint topK = env->CallIntMethod(modelInfoObj, getPostTopK);
+        config.topK = topK > 0 ? (uint32_t)topK : 0;
+        config.softmax = env->CallBooleanMethod(modelInfoObj, getPostSoftmax) == JNI_TRUE;
+        postprocess.push_back(config);
+
+        int depth = env->CallIntMethod(modelInfoObj, getAsyncDepth);
+        if (depth < 1 || depth > MAX_ASYNC_DEPTH) {
+            LOGE("[HIAI_DEMO_ASYNC] async depth %d of %s is out of [1, %d], use %d.", depth, modelName,
+                MAX_ASYNC_DEPTH, DEFAULT_ASYNC_DEPTH);
+            depth = DEFAULT_ASYNC_DEPTH;
+        }
+        depths.push_back(depth);
+
+        jint runs = env->CallIntMethod(modelInfoObj, getWarmupRuns);
+        warmupRuns.push_back(runs > 0 ? (uint32_t)runs : 0);
     }
 
     // load
-    if (!mclientAsync)
+    lock_guard<mutex> loadLock(async_load_mutex);
+    if (CurrentAsyncClient().client == nullptr)
     {
-        mclientAsync = LoadModelASync(names, modelPaths, aipps);
-        if (mclientAsync == nullptr)
+        uint32_t generation = 0;
+        shared_ptr<AiModelMngerClient> client = LoadModelASync(names, sources, aipps, depths, warmupRuns,
+            frequencies, generation);
+        if (client == nullptr)
         {
             LOGE("[HIAI_DEMO_ASYNC] mclientAsync loadModel is nullptr.");
             return nullptr;
         }
+        {
+            lock_guard<mutex> lock(async_client_mutex);
+            async_client.client = client;
+            async_client.generation = generation;
+        }
+        async_postprocess = postprocess;
+        StartAsyncWarmup(names);
     }
 
     // load model
@@ -435,75 +897,350 @@ Java_com_huawei_hiaidemo_utils_ModelManager_loadModelAsync(JNIEnv *env, jclass t
     return modelInfo;
 }
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_com_huawei_hiaidemo_utils_ModelManager_runModelAsync(JNIEnv *env, jclass type, jobject modelInfo, jobject bufList, jobject callbacks)
+/*
+* @brief Attach a listener to a request, and keep it as the OnServiceDied listener
+* @return false if no global ref can be created
+*/
+static bool SetAsyncCallbacks(JNIEnv *env, jobject callbacks, AsyncRequest& request)
 {
-    // check params
-    if(env == nullptr)
+    request.callbacks = env->NewGlobalRef(callbacks);
+    if (request.callbacks == nullptr)
     {
-        LOGE("[HIAI_DEMO_ASYNC] runModelAsync env is null");
-        return;
+        LOGE("[HIAI_DEMO_ASYNC] callbacks NewGlobalRef failed.");
+        return false;
     }
-    jclass ModelInfo = env->GetObjectClass(modelInfo);
-    if(ModelInfo == nullptr)
-    {
-        LOGE("[HIAI_DEMO_ASYNC] can not find ModelInfo class.");
-        return;
+
+    // look the interface up here: FindClass on the DDK callback thread cannot see app classes
+    jclass bufferListenerClass = env->FindClass("com/huawei/hiaidemo/utils/ModelManagerBufferListener");
+    if (bufferListenerClass == nullptr) {
+        env->ExceptionClear();
+        request.useBuffers = false;
+    } else {
+        request.useBuffers = env->IsInstanceOf(callbacks, bufferListenerClass);
+        env->DeleteLocalRef(bufferListenerClass);
     }
 
-    if (bufList == nullptr)
-    {
-        LOGE("[HIAI_DEMO_ASYNC] buf_ is null.");
-        return;
+    std::unique_lock<std::mutex> lock(mutex_map);
+    if (callbacksInstance == nullptr || !env->IsSameObject(callbacksInstance, callbacks)) {
+        if (callbacksInstance != nullptr) {
+            env->DeleteGlobalRef(callbacksInstance);
+        }
+        callbacksInstance = env->NewGlobalRef(callbacks);
     }
+    return true;
+}
 
-    jmethodID getOfflineModelName = env->GetMethodID(ModelInfo,"getOfflineModelName","()Ljava/lang/String;");
-    jmethodID getModelPath = env->GetMethodID(ModelInfo,"getModelPath","()Ljava/lang/String;");
+/*
+* @brief Run the slot of a request on a client
+* @param [out] ddkKey DdkKey of the submission
+*/
+static int ProcessAsync(const AsyncClient& current, const string& modelName, AsyncRequest& request,
+    uint64_t& ddkKey)
+{
+    AsyncSlot& tensors = async_rings[request.model].slots[request.slot];
+    AiContext context;
+    string key = "model_name";
+    string value = modelName;
+    value += ".om";
+    context.AddPara(key, value);
+    LOGI("[HIAI_DEMO_ASYNC] JNI runModel modelname:%s", value.c_str());
 
-    if(getOfflineModelName == nullptr)
+    request.submitTime = chrono::steady_clock::now();
+    uint32_t timeoutMs = request.control != nullptr ?
+        request.control->RemainingMs(DEFAULT_PROCESS_TIMEOUT_MS) : DEFAULT_PROCESS_TIMEOUT_MS;
+    int istamp = 0;
+    int ret = current.client->Process(context, tensors.inputs, tensors.outputs, timeoutMs, istamp);
+    if (ret != 0)
     {
-        LOGE("[HIAI_DEMO_ASYNC] can not find getOfflineModelName method.");
-        return;
-    }
-    if(getModelPath == nullptr){
-        LOGE("[HIAI_DEMO_ASYNC] can not find getModelPath method.");
-        return;
+        LOGE("[HIAI_DEMO_ASYNC] Runmodel Failed! ret=%d.",ret);
+        return FAILED;
     }
 
-    jstring modelname = (jstring)env->CallObjectMethod(modelInfo,getOfflineModelName);
-    jstring modelpath = (jstring)env->CallObjectMethod(modelInfo,getModelPath);
+    LOGE("[HIAI_DEMO_ASYNC] Runmodel Succ! istamp=%d.",istamp);
+    ddkKey = DdkKey(current.generation, istamp);
+    return SUCCESS;
+}
 
-    const char* modelName = env->GetStringUTFChars(modelname, 0);
-    if(modelName == nullptr)
+static int SubmitAsync(const string& modelName, AsyncRequest& request, uint64_t& ddkKey)
+{
+    RequestTracker& tracker = RequestTracker::Shared();
+    chrono::steady_clock::time_point deadline = request.control != nullptr && request.control->HasDeadline() ?
+        request.control->Deadline() : chrono::steady_clock::now() + chrono::milliseconds(NO_DEADLINE_RECOVERY_WAIT_MS);
+    if (!AsyncRecovery().WaitReady(deadline)) {
+        LOGE("[HIAI_DEMO_ASYNC] NPU service unavailable, %s not submitted.", modelName.c_str());
+        // counted as expired if the deadline passed during the wait
+        tracker.Admit(request.control, "the service recovery");
+        return FAILED;
+    }
+    // the last hop: nothing stale or cancelled goes past it
+    if (!tracker.Admit(request.control, "submission")) {
+        return FAILED;
+    }
+    AsyncClient current = CurrentAsyncClient();
+    if (current.client == nullptr) {
+        LOGE("[HIAI_DEMO_ASYNC] mclientAsync is nullptr.");
+        return FAILED;
+    }
+    return ProcessAsync(current, modelName, request, ddkKey);
+}
+
+/*
+* @brief Resubmit the requests lost with a dead client on the current one
+*        while they are within their deadline, and fail the others
+* @param [in] recovered false if no client could be loaded: every request fails
+*/
+static void ReplayAsyncRequests(bool recovered)
+{
+    AsyncClient current = CurrentAsyncClient();
+    vector<int32_t> lost;
     {
-        LOGE("[HIAI_DEMO_ASYNC] modelName is invalid.");
+        std::unique_lock<std::mutex> lock(mutex_map);
+        for (auto it = ddk_tasks.begin(); it != ddk_tasks.end();) {
+            if (!recovered || DdkGeneration(it->first) < current.generation) {
+                lost.push_back(it->second);
+                it = ddk_tasks.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (auto it = early_completion.begin(); it != early_completion.end();) {
+            if (!recovered || DdkGeneration(it->first) < current.generation) {
+                it = early_completion.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        // without a new client the current one is dead too
+        replayed_generation = max(replayed_generation, recovered ? current.generation : current.generation + 1);
+    }
+
+    uint32_t replayed = 0;
+    uint32_t failed = 0;
+    for (int32_t taskId : lost) {
+        AsyncRequest request;
+        {
+            std::unique_lock<std::mutex> lock(mutex_map);
+            auto it = map_input_tensor.find(taskId);
+            if (it == map_input_tensor.end()) {
+                continue;
+            }
+            request = it->second;
+        }
+        uint64_t ddkKey = 0;
+        bool resubmitted = recovered && request.replays < MAX_REPLAYS &&
+            RequestTracker::Shared().Admit(request.control, "replay") &&
+            ProcessAsync(current, async_names[request.model], request, ddkKey) == SUCCESS;
+        if (!resubmitted) {
+            failed++;
+            CompleteAsyncRequest(taskId, request.onComplete, FAILED, chrono::steady_clock::now());
+            continue;
+        }
+        replayed++;
+        EarlyCompletion done;
+        {
+            std::unique_lock<std::mutex> lock(mutex_map);
+            auto it = map_input_tensor.find(taskId);
+            if (it != map_input_tensor.end()) {
+                it->second.replays++;
+                it->second.submitTime = request.submitTime;
+            }
+            auto early = early_completion.find(ddkKey);
+            if (early == early_completion.end()) {
+                ddk_tasks[ddkKey] = taskId;
+                continue;
+            }
+            done = early->second;
+            early_completion.erase(early);
+        }
+        CompleteAsyncRequest(taskId, request.onComplete, done.result, done.doneTime);
+    }
+    LOGI("[HIAI_DEMO_ASYNC] %u requests replayed after the service died, %u failed.", replayed, failed);
+    AsyncRecovery().CountReplayed(replayed, failed);
+}
+
+/*
+* @brief Load the async models on a new client and make it the current one
+*/
+static bool ReloadAsyncModels()
+{
+    uint32_t generation = 0;
+    shared_ptr<AiModelMngerClient> client = NewAsyncClient(generation);
+    if (client == nullptr || LoadAsyncModels(client) != SUCCESS) {
+        return false;
+    }
+    lock_guard<mutex> lock(async_client_mutex);
+    async_client.client = client;
+    async_client.generation = generation;
+    return true;
+}
+
+static ServiceRecovery& AsyncRecovery()
+{
+    // never deleted: the recovery thread may still run while the process exits
+    static ServiceRecovery* recovery = new ServiceRecovery(ReloadAsyncModels, ReplayAsyncRequests);
+    return *recovery;
+}
+
+/*
+* @brief Run one inference of a model on zero inputs, without a listener
+* @param [out] latencyUs from submission to completion
+* @return false if it failed or did not complete in time
+*/
+static bool RunAsyncWarmup(int vecIndex, const string& modelName, int64_t& latencyUs)
+{
+    struct WarmupDone {
+        mutex doneMutex;
+        condition_variable doneCv;
+        bool done = false;
+        int32_t result = 0;
+        chrono::steady_clock::time_point doneTime;
+    };
+    shared_ptr<WarmupDone> done = make_shared<WarmupDone>();
+
+    AsyncRequest request;
+    request.model = vecIndex;
+    request.slot = findInputTensor(vecIndex);
+    ZeroTensors(async_rings[vecIndex].slots[request.slot].inputs);
+    // nothing to deliver: the request is forgotten as soon as it completes,
+    // even if this thread stopped waiting for it
+    request.onComplete = [done](int32_t taskId, int32_t result, chrono::steady_clock::time_point doneTime) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_map);
+            auto it = map_input_tensor.find(taskId);
+            if (it != map_input_tensor.end()) {
+                ReleaseSlot(it->second);
+                map_input_tensor.erase(it);
+            }
+        }
+        lock_guard<mutex> lock(done->doneMutex);
+        done->done = true;
+        done->result = result;
+        done->doneTime = doneTime;
+        done->doneCv.notify_all();
+    };
+
+    uint64_t ddkKey = 0;
+    if (SubmitAsync(modelName, request, ddkKey) != SUCCESS) {
+        ReleaseSlot(request);
+        return false;
+    }
+    TrackAsyncRequest(nullptr, ddkKey, request);
+
+    unique_lock<mutex> lock(done->doneMutex);
+    if (!done->doneCv.wait_for(lock, chrono::milliseconds(WARMUP_TIMEOUT_MS), [&done] { return done->done; })) {
+        LOGE("[HIAI_DEMO_ASYNC] warm-up of model %s timed out.", modelName.c_str());
+        return false;
+    }
+    latencyUs = chrono::duration_cast<chrono::microseconds>(done->doneTime - request.submitTime).count();
+    return done->result == 0;
+}
+
+/*
+* @brief Warm the loaded models up one after the other on a background thread
+*/
+static void StartAsyncWarmup(const vector<string>& names)
+{
+    vector<pair<int, string>> models;
+    for (size_t i = 0; i < names.size() && i < async_warmup.size(); ++i) {
+        if (async_warmup[i]->Runs() > 0) {
+            models.emplace_back((int)i, names[i]);
+        }
+    }
+    if (models.empty()) {
         return;
     }
+    // loadModelAsync returns now; callers poll getWarmupStateAsync
+    thread([models] {
+        for (auto& model : models) {
+            WarmupTracker& warmup = *async_warmup[model.first];
+            warmup.Start();
+            bool ok = true;
+            for (uint32_t run = 0; run < warmup.Runs() && ok; ++run) {
+                int64_t latencyUs = 0;
+                ok = RunAsyncWarmup(model.first, model.second, latencyUs);
+                if (ok) {
+                    warmup.Record(latencyUs);
+                }
+            }
+            WarmupStats stats = warmup.GetStats();
+            LOGI("[HIAI_DEMO_ASYNC] model %s warm-up %s: first inference %lld us, then %lld us.",
+                model.second.c_str(), ok ? "done" : "failed", (long long)stats.coldUs, (long long)stats.warmUs);
+            warmup.Finish(ok);
+        }
+    }).detach();
+}
 
-    int vecIndex = async_nameToIndex[modelName];
+/*
+* @brief Copy byte[] inputs into a free slot of the model and submit them
+* @return task id of the request, FAILED on error
+*/
+static int RunModelAsync(JNIEnv *env, jobject modelInfo, jobject bufList, jobject callbacks, jlong tag,
+    jint timeoutMs)
+{
+    // check params
+    if(env == nullptr)
+    {
+        LOGE("[HIAI_DEMO_ASYNC] runModelAsync env is null");
+        return FAILED;
+    }
+    jclass ModelInfo = env->GetObjectClass(modelInfo);
+    if(ModelInfo == nullptr)
+    {
+        LOGE("[HIAI_DEMO_ASYNC] can not find ModelInfo class.");
+        return FAILED;
+    }
 
-    const char *modelPath = env->GetStringUTFChars(modelpath, 0);
-    if(modelPath == nullptr)
+    if (bufList == nullptr || callbacks == nullptr)
     {
-        LOGE("[HIAI_DEMO_ASYNC] modelPath is invalid.");
-        return;
+        LOGE("[HIAI_DEMO_ASYNC] buf_ or callbacks is null.");
+        return FAILED;
+    }
+
+    jmethodID getOfflineModelName = env->GetMethodID(ModelInfo,"getOfflineModelName","()Ljava/lang/String;");
+
+    if(getOfflineModelName == nullptr)
+    {
+        LOGE("[HIAI_DEMO_ASYNC] can not find getOfflineModelName method.");
+        return FAILED;
+    }
+
+    jstring modelname = (jstring)env->CallObjectMethod(modelInfo,getOfflineModelName);
+
+    const char* modelNameChars = env->GetStringUTFChars(modelname, 0);
+    if(modelNameChars == nullptr)
+    {
+        LOGE("[HIAI_DEMO_ASYNC] modelName is invalid.");
+        return FAILED;
+    }
+    string modelName(modelNameChars);
+    env->ReleaseStringUTFChars(modelname, modelNameChars);
+
+    // load
+    if (CurrentAsyncClient().client == nullptr)
+    {
+        LOGE("[HIAI_DEMO_ASYNC] mclientAsync is nullptr.");
+        return FAILED;
     }
+    auto modelIt = async_nameToIndex.find(modelName);
+    if (modelIt == async_nameToIndex.end()) {
+        LOGE("[HIAI_DEMO_ASYNC] model %s is not loaded.", modelName.c_str());
+        return FAILED;
+    }
+    int vecIndex = modelIt->second;
 
     // buf_list
     jclass classList = env->GetObjectClass(bufList);
     if(classList == nullptr){
         LOGE("[HIAI_DEMO_ASYNC] can not find List class.");
+        return FAILED;
     }
     // method in class
     jmethodID listGet = env->GetMethodID(classList, "get", "(I)Ljava/lang/Object;");
     jmethodID listSize = env->GetMethodID(classList, "size", "()I");
 
-    if(listGet == nullptr){
-        LOGE("[HIAI_DEMO_ASYNC] can not find get method.");
-    }
-    if(listSize == nullptr){
-        LOGE("[HIAI_DEMO_ASYNC] can not find size method.");
+    if(listGet == nullptr || listSize == nullptr){
+        LOGE("[HIAI_DEMO_ASYNC] can not find get or size method.");
+        return FAILED;
     }
 
     int listLength = static_cast<int>(env->CallIntMethod(bufList, listSize));
@@ -512,31 +1249,23 @@ Java_com_huawei_hiaidemo_utils_ModelManager_runModelAsync(JNIEnv *env, jclass ty
         LOGE("[HIAI_DEMO_ASYNC] input data length is %d .",listLength);
     }
 
-    callbacksInstance = env->NewGlobalRef(callbacks);
-    jclass objClass = env->GetObjectClass(callbacks);
-    if (!objClass)
-    {
-        LOGE("[HIAI_DEMO_ASYNC] objClass is nullptr.");
-        return;
-    }
-    env->GetJavaVM(&jvm);
-    callbacksClass = reinterpret_cast<jclass>(env->NewGlobalRef(objClass));
-    env->DeleteLocalRef(objClass);
-
-    // load
-    if (!mclientAsync)
-    {
-        LOGE("[HIAI_DEMO_ASYNC] mclientAsync is nullptr.");
-        return;
-    }
-
-    env->ReleaseStringUTFChars(modelpath, modelPath);
-
     //run
     LOGI("[HIAI_DEMO_ASYNC] INPUT NCHW : %d %d %d %d." , inputDimension[0][0].GetNumber(), inputDimension[0][0].GetChannel(), inputDimension[0][0].GetHeight(), inputDimension[0][0].GetWidth());
     LOGI("[HIAI_DEMO_ASYNC] OUTPUT NCHW : %d %d %d %d." , outputDimension[0][0].GetNumber(), outputDimension[0][0].GetChannel(), outputDimension[0][0].GetHeight(), outputDimension[0][0].GetWidth());
 
-    auto input_tensor0 = findInputTensor(vecIndex);
+    AsyncRequest request;
+    request.model = vecIndex;
+    request.tag = tag;
+    request.control = RequestTracker::Shared().Begin(tag, timeoutMs > 0 ? (uint32_t)timeoutMs : 0);
+    if (!FindInputTensorFor(vecIndex, request.control, request.slot)) {
+        return FAILED;
+    }
+    vector<shared_ptr<AiTensor>>& input_tensor0 = async_rings[vecIndex].slots[request.slot].inputs;
+    if (listLength > (int)input_tensor0.size()) {
+        LOGE("[HIAI_DEMO_ASYNC] %d inputs given, model has %zu.", listLength, input_tensor0.size());
+        DropAsyncRequest(env, request);
+        return FAILED;
+    }
 
     for(int i = 0;i < listLength;i++){
 
@@ -544,45 +1273,379 @@ Java_com_huawei_hiaidemo_utils_ModelManager_runModelAsync(JNIEnv *env, jclass ty
         if (buf_ == nullptr)
         {
             LOGE("[HIAI_DEMO_ASYNC] buf_ is nullptr.");
-            return;
+            DropAsyncRequest(env, request);
+            return FAILED;
         }
         jbyte *dataBuff = nullptr;
         int databuffsize = 0;
         dataBuff = env->GetByteArrayElements(buf_, nullptr);
         databuffsize = env->GetArrayLength(buf_);
 
-        if(((*input_tensor0)[i]->GetSize() != databuffsize))
+        if((input_tensor0[i]->GetSize() != databuffsize))
         {
-            LOGE("[HIAI_DEMO_ASYNC] input->GetSize(%d) != databuffsize(%d) ",(*input_tensor0)[i]->GetSize(),databuffsize);
-            return ;
+            LOGE("[HIAI_DEMO_ASYNC] input->GetSize(%d) != databuffsize(%d) ",input_tensor0[i]->GetSize(),databuffsize);
+            env->ReleaseByteArrayElements(buf_, dataBuff, JNI_ABORT);
+            DropAsyncRequest(env, request);
+            return FAILED;
         }
-        memmove((*input_tensor0)[i]->GetBuffer(), dataBuff, (size_t)databuffsize);
-        env->ReleaseByteArrayElements(buf_, dataBuff, 0);
+        memmove(input_tensor0[i]->GetBuffer(), dataBuff, (size_t)databuffsize);
+        env->ReleaseByteArrayElements(buf_, dataBuff, JNI_ABORT);
+        env->DeleteLocalRef(buf_);
     }
 
-    AiContext context;
-    string key = "model_name";
-    string value = modelName;
-    value += ".om";
-    context.AddPara(key, value);
-    LOGI("[HIAI_DEMO_ASYNC] JNI runModel modelname:%s", value.c_str());
+    if (!SetAsyncCallbacks(env, callbacks, request)) {
+        DropAsyncRequest(env, request);
+        return FAILED;
+    }
 
-    int istamp = 0;
-    gettimeofday(&tpstart, nullptr);
-    int ret = mclientAsync->Process(context, *input_tensor0, output_tensor_vec[vecIndex], 300, istamp);
-    if (ret != 0)
+    uint64_t ddkKey = 0;
+    if (SubmitAsync(modelName, request, ddkKey) != SUCCESS) {
+        DropAsyncRequest(env, request);
+        return FAILED;
+    }
+    return TrackAsyncRequest(env, ddkKey, request);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_runModelAsync(JNIEnv *env, jclass type, jobject modelInfo, jobject bufList, jobject callbacks)
+{
+    RunModelAsync(env, modelInfo, bufList, callbacks, 0, 0);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_runModelAsyncTagged(JNIEnv *env, jclass type, jobject modelInfo,
+    jobject bufList, jlong tag, jint timeoutMs, jobject callbacks)
+{
+    return RunModelAsync(env, modelInfo, bufList, callbacks, tag, timeoutMs);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_getAsyncTaskTag(JNIEnv *env, jclass type, jint taskId)
+{
+    std::unique_lock<std::mutex> lock(mutex_map);
+    auto it = map_input_tensor.find(taskId);
+    if (it == map_input_tensor.end()) {
+        LOGE("[HIAI_DEMO_ASYNC] task %d is not in flight.", taskId);
+        return 0;
+    }
+    return it->second.tag;
+}
+
+static int FindAsyncModel(JNIEnv *env, jobject modelInfo, string& modelName)
+{
+    if (!GetModelName(env, modelInfo, modelName)) {
+        return FAILED;
+    }
+    auto it = async_nameToIndex.find(modelName);
+    if (it == async_nameToIndex.end()) {
+        LOGE("[HIAI_DEMO_ASYNC] model %s is not loaded.", modelName.c_str());
+        return FAILED;
+    }
+    return it->second;
+}
+
+/*
+* @brief Take a reservation of acquireInputSlotAsync out of reserved_input
+* @return false if reservation is not reserved, e.g. already submitted or released
+*/
+static bool TakeInputReservation(int32_t reservation, InputReservation& taken)
+{
+    std::unique_lock<std::mutex> lock(mutex_map);
+    auto it = reserved_input.find(reservation);
+    if (it == reserved_input.end()) {
+        LOGE("[HIAI_DEMO_ASYNC] input slot %d is not reserved, call acquireInputSlotAsync first.", reservation);
+        return false;
+    }
+    taken = it->second;
+    reserved_input.erase(it);
+    return true;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_acquireInputSlotAsync(JNIEnv *env, jclass type, jobject modelInfo)
+{
+    if (env == nullptr || modelInfo == nullptr) {
+        LOGE("[HIAI_DEMO_ASYNC] acquireInputSlotAsync invalid params.");
+        return FAILED;
+    }
+    string modelName;
+    int vecIndex = FindAsyncModel(env, modelInfo, modelName);
+    if (vecIndex == FAILED) {
+        return FAILED;
+    }
+    InputReservation reservation;
+    reservation.model = vecIndex;
+    reservation.slot = findInputTensor(vecIndex);
+    std::unique_lock<std::mutex> lock(mutex_map);
+    int32_t handle = next_reservation;
+    do {
+        handle = handle < INT_MAX ? handle + 1 : 1;
+    } while (reserved_input.count(handle) > 0);
+    next_reservation = handle;
+    reserved_input[handle] = reservation;
+    return handle;
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_getInputBuffersAsync(JNIEnv *env, jclass type, jint reservation)
+{
+    if (env == nullptr) {
+        LOGE("[HIAI_DEMO_ASYNC] getInputBuffersAsync invalid params.");
+        return nullptr;
+    }
+    InputReservation reserved;
     {
-        LOGE("[HIAI_DEMO_ASYNC] Runmodel Failed! ret=%d.",ret);
-        return ;
+        std::unique_lock<std::mutex> lock(mutex_map);
+        auto it = reserved_input.find(reservation);
+        if (it == reserved_input.end()) {
+            LOGE("[HIAI_DEMO_ASYNC] input slot %d is not reserved, call acquireInputSlotAsync first.", reservation);
+            return nullptr;
+        }
+        reserved = it->second;
     }
+    return NewTensorBufferList(env, async_rings[reserved.model].slots[reserved.slot].inputs);
+}
 
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_releaseInputSlotAsync(JNIEnv *env, jclass type, jint reservation)
+{
+    InputReservation reserved;
+    if (TakeInputReservation(reservation, reserved)) {
+        async_rings[reserved.model].freeSlots->Release(reserved.slot);
+    }
+}
 
-    LOGE("[HIAI_DEMO_ASYNC] Runmodel Succ! istamp=%d.",istamp);
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_runModelInPlaceAsync(JNIEnv *env, jclass type, jobject modelInfo,
+    jint reservation, jlong tag, jint timeoutMs, jobject callbacks)
+{
+    if (env == nullptr || modelInfo == nullptr || callbacks == nullptr) {
+        LOGE("[HIAI_DEMO_ASYNC] runModelInPlaceAsync invalid params.");
+        return FAILED;
+    }
+    string modelName;
+    int vecIndex = FindAsyncModel(env, modelInfo, modelName);
+    if (vecIndex == FAILED) {
+        return FAILED;
+    }
+    InputReservation reserved;
+    if (!TakeInputReservation(reservation, reserved)) {
+        return FAILED;
+    }
+
+    AsyncRequest request;
+    request.model = reserved.model;
+    request.slot = reserved.slot;
+    request.tag = tag;
+    request.control = RequestTracker::Shared().Begin(tag, timeoutMs > 0 ? (uint32_t)timeoutMs : 0);
+    // from here on the slot goes back to the free list with the request
+    if (reserved.model != vecIndex) {
+        LOGE("[HIAI_DEMO_ASYNC] input slot %d is not one of model %s.", reservation, modelName.c_str());
+        DropAsyncRequest(env, request);
+        return FAILED;
+    }
+    if (CurrentAsyncClient().client == nullptr) {
+        LOGE("[HIAI_DEMO_ASYNC] mclientAsync is nullptr.");
+        DropAsyncRequest(env, request);
+        return FAILED;
+    }
+    if (!SetAsyncCallbacks(env, callbacks, request)) {
+        DropAsyncRequest(env, request);
+        return FAILED;
+    }
 
+    uint64_t ddkKey = 0;
+    if (SubmitAsync(modelName, request, ddkKey) != SUCCESS) {
+        DropAsyncRequest(env, request);
+        return FAILED;
+    }
+    return TrackAsyncRequest(env, ddkKey, request);
+}
 
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_releaseOutputBuffersAsync(JNIEnv *env, jclass type, jint taskId)
+{
     std::unique_lock<std::mutex> lock(mutex_map);
-    map_input_tensor.insert(pair<int32_t,vector<shared_ptr<AiTensor>>*>(istamp, input_tensor0));
-    condition_.notify_all();
+    if (leased_output.erase(taskId) == 0) {
+        LOGE("[HIAI_DEMO_ASYNC] outputs of task %d are not leased.", taskId);
+        return;
+    }
+    auto it = map_input_tensor.find(taskId);
+    if (it != map_input_tensor.end()) {
+        DropAsyncRequest(env, it->second);
+        map_input_tensor.erase(it);
+    }
+}
+
+int FindAsyncModelIndex(const string& modelName)
+{
+    auto it = async_nameToIndex.find(modelName);
+    if (it == async_nameToIndex.end() || it->second >= (int)async_rings.size()) {
+        return FAILED;
+    }
+    return it->second;
+}
+
+uint32_t GetAsyncDepth(int vecIndex)
+{
+    return async_rings[vecIndex].freeSlots->Depth();
+}
+
+bool GetAsyncInputDim(int vecIndex, uint32_t inputIndex, TensorDimension& dim)
+{
+    if (vecIndex < 0 || vecIndex >= (int)inputDimension.size() || inputIndex >= inputDimension[vecIndex].size()) {
+        return false;
+    }
+    dim = inputDimension[vecIndex][inputIndex];
+    return true;
+}
+
+uint32_t AcquireAsyncSlot(int vecIndex)
+{
+    return findInputTensor(vecIndex);
+}
+
+bool AcquireAsyncSlotFor(int vecIndex, const RequestControlPtr& control, uint32_t& slot)
+{
+    return FindInputTensorFor(vecIndex, control, slot);
+}
+
+vector<shared_ptr<AiTensor>>& GetAsyncSlotInputs(int vecIndex, uint32_t slot)
+{
+    return async_rings[vecIndex].slots[slot].inputs;
+}
+
+void ReleaseAsyncSlot(int vecIndex, uint32_t slot)
+{
+    async_rings[vecIndex].freeSlots->Release(slot);
+}
+
+int SubmitAsyncSlot(JNIEnv *env, int vecIndex, uint32_t slot, jobject callbacks, jlong tag,
+    const RequestControlPtr& control, const AsyncCompletion& onComplete)
+{
+    AsyncRequest request;
+    request.model = vecIndex;
+    request.slot = slot;
+    request.tag = tag;
+    request.control = control;
+    request.onComplete = onComplete;
+    string modelName;
+    for (auto& entry : async_nameToIndex) {
+        if (entry.second == vecIndex) {
+            modelName = entry.first;
+        }
+    }
+    if (modelName.empty() || CurrentAsyncClient().client == nullptr || !SetAsyncCallbacks(env, callbacks, request)) {
+        DropAsyncRequest(env, request);
+        return FAILED;
+    }
+
+    uint64_t ddkKey = 0;
+    if (SubmitAsync(modelName, request, ddkKey) != SUCCESS) {
+        DropAsyncRequest(env, request);
+        return FAILED;
+    }
+    return TrackAsyncRequest(env, ddkKey, request);
+}
 
-    env->ReleaseStringUTFChars(modelname, modelName);
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_getWarmupStateAsync(JNIEnv *env, jclass type, jobject modelInfo)
+{
+    string modelName;
+    if (env == nullptr || modelInfo == nullptr || !GetModelName(env, modelInfo, modelName)) {
+        LOGE("[HIAI_DEMO_ASYNC] getWarmupStateAsync invalid params.");
+        return nullptr;
+    }
+    int vecIndex = FindAsyncModelIndex(modelName);
+    if (vecIndex == FAILED || vecIndex >= (int)async_warmup.size()) {
+        LOGE("[HIAI_DEMO_ASYNC] model %s is not loaded.", modelName.c_str());
+        return nullptr;
+    }
+    return NewWarmupStatsArray(env, async_warmup[vecIndex]->GetStats());
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_loadModelAsyncInBackground(JNIEnv *env, jclass type, jobject modelInfo,
+    jobject listener)
+{
+    if (env == nullptr || modelInfo == nullptr || listener == nullptr) {
+        LOGE("[HIAI_DEMO_ASYNC] loadModelAsyncInBackground invalid params.");
+        return JNI_FALSE;
+    }
+    return LoadModelsInBackground(env, modelInfo, listener, Java_com_huawei_hiaidemo_utils_ModelManager_loadModelAsync)
+        ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_getLoadTimesAsync(JNIEnv *env, jclass type, jobject modelInfo)
+{
+    string modelName;
+    if (env == nullptr || modelInfo == nullptr || !GetModelName(env, modelInfo, modelName)) {
+        LOGE("[HIAI_DEMO_ASYNC] getLoadTimesAsync invalid params.");
+        return nullptr;
+    }
+    int vecIndex = FindAsyncModelIndex(modelName);
+    if (vecIndex == FAILED || vecIndex >= (int)async_load_times.size()) {
+        LOGE("[HIAI_DEMO_ASYNC] model %s is not loaded.", modelName.c_str());
+        return nullptr;
+    }
+    return NewLoadTimesArray(env, async_load_times[vecIndex]);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_cancelAsyncRequest(JNIEnv *env, jclass type, jlong tag)
+{
+    uint32_t cancelled = RequestTracker::Shared().Cancel(tag);
+    if (cancelled > 0) {
+        // requests waiting for a slot give up now
+        for (auto& ring : async_rings) {
+            ring.freeSlots->WakeWaiters();
+        }
+    }
+    return (jint)cancelled;
+}
+
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_getRequestStatsAsync(JNIEnv *env, jclass type)
+{
+    RequestStats stats = RequestTracker::Shared().GetStats();
+    jlong values[REQUEST_OUTCOMES];
+    for (uint32_t i = 0; i < REQUEST_OUTCOMES; ++i) {
+        values[i] = (jlong)stats.outcomes[i];
+    }
+    jlongArray result = env->NewLongArray(REQUEST_OUTCOMES);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, REQUEST_OUTCOMES, values);
+    }
+    return result;
+}
+
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_getServiceRecoveryStatsAsync(JNIEnv *env, jclass type)
+{
+    RecoveryStats stats = AsyncRecovery().GetStats();
+    const jsize count = 8;
+    jlong values[count] = {
+        (jlong)stats.state, (jlong)stats.deaths, (jlong)stats.recoveries, (jlong)stats.failedRecoveries,
+        (jlong)stats.lastRecoveryUs, (jlong)stats.maxRecoveryUs, (jlong)stats.replayed, (jlong)stats.failedFast
+    };
+    jlongArray result = env->NewLongArray(count);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, count, values);
+    }
+    return result;
 }
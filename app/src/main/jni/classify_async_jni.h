@@ -0,0 +1,91 @@
+/*
+ * @file classify_async_jni.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_CLASSIFY_ASYNC_JNI_H
+#define HIAI_DEMO_CLASSIFY_ASYNC_JNI_H
+
+#include <jni.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "HiAiModelManagerService.h"
+#include "request_tracker.h"
+
+/*
+ * Native access to the models loaded by loadModelAsync, for code that fills
+ * input slots itself instead of going through runModelAsync.
+ */
+
+// result of a request submitted with SubmitAsyncSlot: task id, DDK status, completion time
+using AsyncCompletion = std::function<void(int32_t taskId, int32_t result,
+    std::chrono::steady_clock::time_point doneTime)>;
+
+/*
+* @brief Index of a model loaded by loadModelAsync
+* @param [in] modelName offline model name (without ".om")
+* @return -1 if the model is not loaded
+*/
+int FindAsyncModelIndex(const std::string& modelName);
+
+/*
+* @brief Requests of a model that can be in flight at once, its number of slots
+*/
+uint32_t GetAsyncDepth(int vecIndex);
+
+/*
+* @brief Dimension of an input of a model
+* @return false if the model or input does not exist
+*/
+bool GetAsyncInputDim(int vecIndex, uint32_t inputIndex, hiai::TensorDimension& dim);
+
+/*
+* @brief Take a free slot of a model, waiting while every slot is in flight
+*/
+uint32_t AcquireAsyncSlot(int vecIndex);
+
+/*
+* @brief AcquireAsyncSlot for a tracked request, giving up at its deadline or
+*        when it is cancelled
+* @return false if the request was finished as expired or cancelled
+*/
+bool AcquireAsyncSlotFor(int vecIndex, const RequestControlPtr& control, uint32_t& slot);
+
+/*
+* @brief Input tensors of a slot taken with AcquireAsyncSlot
+*/
+std::vector<std::shared_ptr<hiai::AiTensor>>& GetAsyncSlotInputs(int vecIndex, uint32_t slot);
+
+/*
+* @brief Return a slot that will not be submitted
+*/
+void ReleaseAsyncSlot(int vecIndex, uint32_t slot);
+
+/*
+* @brief Submit the inputs of a slot. The result is not delivered to callbacks
+*        right away: onComplete is told, and the caller delivers it later with
+*        DeliverAsyncResult, on a thread of its choice.
+* @param [in] callbacks ModelManagerListener the result is delivered to
+* @param [in] tag returned by ModelManager.getAsyncTaskTag
+* @param [in] control deadline and cancellation, checked before Process; may be nullptr
+* @param [in] onComplete called once, on the DDK callback thread or on this thread
+* @return task id of the request, -1 on failure (the slot is then released)
+*/
+int SubmitAsyncSlot(JNIEnv *env, int vecIndex, uint32_t slot, jobject callbacks, jlong tag,
+    const RequestControlPtr& control, const AsyncCompletion& onComplete);
+
+/*
+* @brief Hand a result reported through AsyncCompletion to its listener and
+*        free its slot
+*/
+void DeliverAsyncResult(JNIEnv *env, int32_t taskId, int32_t result, std::chrono::steady_clock::time_point doneTime);
+
+#endif
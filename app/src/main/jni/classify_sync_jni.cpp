@@ -13,6 +13,14 @@
 
 #include <memory.h>
 #include "HiAiModelManagerService.h"
+#include "batch_scheduler.h"
+#include "classify_sync_jni.h"
+#include "dynamic_aipp.h"
+#include "jni_common.h"
+#include "model_bundle.h"
+#include "model_residency.h"
+#include "postprocess.h"
+#include "sync_session.h"
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
 #include <android/log.h>
@@ -24,6 +32,10 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <cmath>
 
 #define LOG_TAG "SYNC_DDK_MSG"
@@ -34,172 +46,191 @@
 using namespace std;
 using namespace hiai;
 
-static shared_ptr<AiModelMngerClient> g_clientSync = nullptr;
-static vector<vector<TensorDimension>> inputDimension;
-static vector<vector<TensorDimension>> outputDimension;
-static vector<vector<shared_ptr<AiTensor>>> input_tensor;
-
-static vector<vector<shared_ptr<AiTensor>>> output_tensor;
-
-static map<string, int> sync_nameToIndex;
-static long time_use_sync = 0;
+// serializes loadModelSync; inference only goes through the session registry
+static mutex sync_load_mutex;
 
 static const int SUCCESS = 0;
 static const int FAILED = -1;
 
-void ResourceDestroy(shared_ptr<AiModelBuilder>& modelBuilder, vector<MemBuffer*>& memBuffers)
+// Add the models to the residency manager and register a session for each of
+// them. Every model has a client of its own, so they are mapped, loaded and get
+// their tensors in parallel, each on a thread of its own: a DDK load blocks for
+// up to seconds and would hold a worker of the shared pool meanwhile. If any
+// model fails, the residency entries of the call are removed again.
+static bool LoadModelSync(vector<string> names, vector<ModelSource> sources, const vector<SyncModelConfig>& configs)
 {
-    if (modelBuilder == nullptr) {
-        LOGE("[HIAI_DEMO_SYNC] modelBuilder is null.");
-        return;
+    ModelResidency& residency = ModelResidency::Shared();
+    LoadClock::time_point callStart = LoadClock::now();
+    vector<shared_ptr<SyncSession>> sessions(configs.size());
+    vector<ModelLoadTimes> times(configs.size());
+    auto loadModel = [&](size_t i) {
+        const SyncModelConfig& config = configs[i];
+        LOGI("[HIAI_DEMO_SYNC] modelpath is %s\n.", sources[i].path.c_str());
+        LoadClock::time_point start = LoadClock::now();
+        shared_ptr<ModelMapping> model = MapModel(sources[i]);
+        times[i].mapUs = MicrosSince(start);
+        if (!residency.Add(names[i], model, QosFrequency(config.qos))) {
+            LOGE("[HIAI_DEMO_SYNC] cannot map the model file of %s.", names[i].c_str());
+            return;
+        }
+        LOGI("[HIAI_DEMO_SYNC] Get model %s IO Tensor. Use AIPP %d", config.name.c_str(), config.useAipp);
+        sessions[i] = SyncSession::Create(config, times[i]);
+        shared_ptr<ModelBundle> bundle = FindModelBundle(sources[i]);
+        if (sessions[i] != nullptr && bundle != nullptr &&
+            !bundle->MatchesIo(sessions[i]->InputDims(), sessions[i]->OutputDims())) {
+            LOGE("[HIAI_DEMO_SYNC] model %s does not match its bundle.", names[i].c_str());
+            sessions[i] = nullptr;
+        }
+        times[i].readyUs = MicrosSince(callStart);
+    };
+    if (configs.empty()) {
+        return true;
     }
-
-    for (auto tmpBuffer : memBuffers) {
-        modelBuilder->MemBufferDestroy(tmpBuffer);
+    vector<thread> loaders;
+    for (size_t i = 1; i < configs.size(); ++i) {
+        loaders.emplace_back(loadModel, i);
+    }
+    loadModel(0);
+    for (auto& loader : loaders) {
+        loader.join();
+    }
+    LogLoadTimes(names, times, MicrosSince(callStart));
+    if (find(sessions.begin(), sessions.end(), nullptr) != sessions.end()) {
+        // none of these models has a session: nobody else runs them
+        sessions.clear();
+        for (auto& name : names) {
+            residency.Remove(name);
+        }
+        return false;
     }
-    return;
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        sessions[i]->SetLoadTimes(times[i]);
+    }
+    // the models of one call become visible together
+    bool warmup = false;
+    for (auto& session : sessions) {
+        AddSyncSession(session);
+        warmup = warmup || session->Warmup().Runs() > 0;
+    }
+    if (warmup) {
+        // loadModelSync returns now; callers poll getWarmupStateSync
+        thread([sessions] {
+            SetThreadQosClass(QOS_BACKGROUND);
+            for (auto& session : sessions) {
+                session->RunWarmup();
+            }
+        }).detach();
+    }
+    return true;
 }
 
-int LoadSync(vector<string>& names, vector<string>& modelPaths, shared_ptr<AiModelMngerClient>& client)
-{
-    int ret;
-    vector<shared_ptr<AiModelDescription>> modelDescs;
-    vector<MemBuffer*> memBuffers;
-    shared_ptr<AiModelBuilder> modelBuilder = make_shared<AiModelBuilder>(client);
-    if (modelBuilder == nullptr) {
-        LOGI("[HIAI_DEMO_SYNC] creat modelBuilder failed.");
-        return FAILED;
-    }
-
-    for (size_t i = 0; i < modelPaths.size(); ++i){
-        string modelPath = modelPaths[i];
-        string modelName = names[i];
-        sync_nameToIndex[modelName] = i;
-
-        // We can achieve the optimization by loading model from OM file.
-        LOGI("[HIAI_DEMO_SYNC] modelpath is %s\n.", modelPath.c_str());
-        MemBuffer* buffer = modelBuilder->InputMemBufferCreate(modelPath);
-        if (buffer == nullptr) {
-            LOGE("[HIAI_DEMO_SYNC] cannot find the model file.");
-            return FAILED;
-        }
-        memBuffers.push_back(buffer);
-
-        string modelNameFull = string(modelName) + string(".om");
-        shared_ptr<AiModelDescription> desc = make_shared<AiModelDescription>(modelNameFull, AiModelDescription_Frequency_HIGH, HIAI_FRAMEWORK_NONE, HIAI_MODELTYPE_ONLINE, AiModelDescription_DeviceType_NPU);
-        if (desc == nullptr) {
-            LOGE("[HIAI_DEMO_SYNC] LoadModelSync: desc make_shared error.");
-            ResourceDestroy(modelBuilder, memBuffers);
-            return FAILED;
+// A tensor set checked out for one call that copies its outputs to Java,
+// returned to the pool when the call returns
+class CallTensors {
+public:
+    explicit CallTensors(SyncSession& session) : session_(session), handle_(session.CheckOutTensors())
+    {
+    }
+
+    ~CallTensors()
+    {
+        if (handle_ != NO_SYNC_TENSORS) {
+            session_.ReturnTensors(handle_);
         }
-        desc->SetModelBuffer(buffer->GetMemBufferData(), buffer->GetMemBufferSize());
+    }
 
-        LOGE("[HIAI_DEMO_SYNC] loadModel %s IO Tensor.", desc->GetName().c_str());
-        modelDescs.push_back(desc);
+    // nullptr if no set came free
+    SyncTensorSet* Get()
+    {
+        return handle_ != NO_SYNC_TENSORS ? session_.TensorsOf(handle_) : nullptr;
     }
 
-    ret = client->Load(modelDescs);
-    ResourceDestroy(modelBuilder, memBuffers);
-    if (ret != 0) {
-        LOGE("[HIAI_DEMO_SYNC] Model Load Failed.");
-        return FAILED;
+private:
+    SyncSession& session_;
+    int32_t handle_;
+};
+
+// the set Java checked out under handle, with an error if it is not
+static SyncTensorSet* TensorsOfCaller(SyncSession& session, int32_t handle)
+{
+    SyncTensorSet* tensors = session.TensorsOf(handle);
+    if (tensors == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] tensor set %d of model %s is not checked out, call acquireTensorsSync first.",
+            handle, session.Name().c_str());
     }
-    return SUCCESS;
+    return tensors;
 }
 
-shared_ptr<AiModelMngerClient> LoadModelSync(vector<string> names, vector<string> modelPaths, vector<bool> Aipps)
+shared_ptr<AiTensor> GetSyncInputTensor(const string& modelName, int32_t tensors, uint32_t inputIndex,
+    TensorDimension& dim)
 {
-    shared_ptr<AiModelMngerClient> clientSync = make_shared<AiModelMngerClient>();
-    if (clientSync == nullptr) {
-        LOGE("[HIAI_DEMO_SYNC] Model Manager Client make_shared error.");
+    shared_ptr<SyncSession> session = FindSyncSession(modelName);
+    if (session == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] model %s is not loaded.", modelName.c_str());
         return nullptr;
     }
-
-    int ret = clientSync->Init(nullptr);
-    if (ret != 0) {
-        LOGE("[HIAI_DEMO_SYNC] Model Manager Init Failed.");
+    if (inputIndex >= session->InputDims().size()) {
+        LOGE("[HIAI_DEMO_SYNC] model %s has no input %u.", modelName.c_str(), inputIndex);
         return nullptr;
     }
-
-    ret = LoadSync(names, modelPaths, clientSync);
-    if (ret != SUCCESS) {
-        LOGE("[HIAI_DEMO_ASYNC] LoadSync Failed.");
+    SyncTensorSet* set = TensorsOfCaller(*session, tensors);
+    if (set == nullptr) {
         return nullptr;
     }
+    dim = session->InputDims()[inputIndex];
+    return set->inputs[inputIndex];
+}
 
-    inputDimension.clear();
-    outputDimension.clear();
-    input_tensor.clear();
-    output_tensor.clear();
-
-    for (size_t i = 0; i < names.size(); ++i) {
-        string modelName = names[i];
-        bool isUseAipp = Aipps[i];
-        LOGI("[HIAI_DEMO_SYNC] Get model %s IO Tensor. Use AIPP %d", modelName.c_str(), isUseAipp);
-        vector<TensorDimension> inputDims, outputDims;
-        ret = clientSync->GetModelIOTensorDim(string(modelName) + string(".om"), inputDims, outputDims);
-        if (ret != 0) {
-            LOGE("[HIAI_DEMO_SYNC] Get Model IO Tensor Dimension failed,ret is %d.", ret);
-            return nullptr;
-        }
-
-        if (inputDims.size() == 0) {
-            LOGE("[HIAI_DEMO_SYNC] inputDims.size() == 0");
-            return nullptr;
-        }
-
-        inputDimension.push_back(inputDims);
-        outputDimension.push_back(outputDims);
-
-        vector<shared_ptr<AiTensor>> inputTensors, outputTensors;
-        for (auto in_dim : inputDims) {
-            shared_ptr<AiTensor> input = make_shared<AiTensor>();
-            if (isUseAipp) {
-                ret = input->Init(in_dim.GetNumber(), in_dim.GetHeight(), in_dim.GetWidth(), AiTensorImage_YUV420SP_U8);
-                LOGI("[HIAI_DEMO_SYNC] model %s uses AIPP(input).", modelName.c_str());
-            } else {
-                ret = input->Init(&in_dim);
-                LOGI("[HIAI_DEMO_SYNC] model %s does not use AIPP(input).", modelName.c_str());
-            }
-            if (ret != 0) {
-                LOGE("[HIAI_DEMO_SYNC] model %s AiTensor Init failed(input).", modelName.c_str());
-                return nullptr;
-            }
-            inputTensors.push_back(input);
-        }
-        input_tensor.push_back(inputTensors);
-
-        if (input_tensor.size() == 0) {
-            LOGE("[HIAI_DEMO_SYNC] input_tensor.size() == 0");
-            return nullptr;
-        }
+// one output as float[], reduced to top-K when the model asks for it
+static jfloatArray NewSyncOutputArray(JNIEnv *env, const SyncSession& session, const float* outputBuffer,
+    uint32_t outputsize)
+{
+    jfloatArray  result;
+    const PostprocessConfig& postprocess = session.Postprocess();
+    if (postprocess.topK > 0) {
+        vector<float> packed(2 * postprocess.topK);
+        uint32_t packedSize = TopKPacked(outputBuffer, outputsize, postprocess, packed.data());
+        result = env->NewFloatArray(packedSize);
+        env->SetFloatArrayRegion(result,0,packedSize,packed.data());
+    } else {
+        result = env->NewFloatArray(outputsize);
+        env->SetFloatArrayRegion(result,0,outputsize,outputBuffer);
+    }
+    return result;
+}
 
-        for (auto out_dim : outputDims) {
-            shared_ptr<AiTensor> output = make_shared<AiTensor>();
-            ret = output->Init(&out_dim);
-            if (ret != 0) {
-                LOGE("[HIAI_DEMO_SYNC] model %s AiTensor Init failed(output).", modelName.c_str());
-                return nullptr;
-            }
-            outputTensors.push_back(output);
-        }
+static jobject ProcessSync(JNIEnv *env, SyncSession& session, vector<shared_ptr<AiTensor>>& inputs,
+    SyncTensorSet& tensors)
+{
+    if (session.Run(inputs, tensors) != SUCCESS) {
+        return nullptr;
+    }
 
-        output_tensor.push_back(outputTensors);
+    // output_tensor
+    jclass output_list_class = env->FindClass("java/util/ArrayList");
+    jmethodID  output_list_init = env->GetMethodID(output_list_class,"<init>","()V");
+    jmethodID list_add = env->GetMethodID(output_list_class,"add","(Ljava/lang/Object;)Z");
+    jobject output_list = env->NewObject(output_list_class,output_list_init,"");
 
-        if (output_tensor.size() == 0) {
-            LOGE("[HIAI_DEMO_SYNC] output_tensor.size() == 0");
-            return nullptr;
-        }
+    const vector<TensorDimension>& outputDims = session.OutputDims();
+    long output_tensor_size = tensors.outputs.size();
+    LOGI("[HIAI_DEMO_SYNC] output_tensor_size is %ld .",output_tensor_size);
+    for(long j = 0; j < output_tensor_size; j++){
+        float *outputBuffer = (float *)tensors.outputs[j]->GetBuffer();
+        int outputsize = outputDims[j].GetNumber() * outputDims[j].GetChannel() * outputDims[j].GetHeight() * outputDims[j].GetWidth();
+        jfloatArray result = NewSyncOutputArray(env, session, outputBuffer, (uint32_t)outputsize);
+        jboolean output_add = env->CallBooleanMethod(output_list,list_add,result);
+        env->DeleteLocalRef(result);
+        LOGI("[HIAI_DEMO_SYNC] output_add result  is %d .",output_add);
     }
-
-    return clientSync;
+    return output_list;
 }
 
 extern "C"
 JNIEXPORT jlong JNICALL
 Java_com_huawei_hiaidemo_utils_ModelManager_GetTimeUseSync(JNIEnv *env, jclass type)
 {
-    return time_use_sync;
+    return GetLastSyncInferenceMs();
 }
 
 extern "C"
@@ -215,32 +246,47 @@ Java_com_huawei_hiaidemo_utils_ModelManager_loadModelSync(JNIEnv *env, jclass ty
     jmethodID listSize = env->GetMethodID(classList, "size", "()I");
     int len = static_cast<int>(env->CallIntMethod(modelInfo, listSize));
 
-    vector<string> names, modelPaths;
-    vector<bool> aipps;
+    vector<string> names;
+    vector<ModelSource> sources;
+    vector<SyncModelConfig> configs;
     for(int i = 0;i < len ;i++){
         jobject modelInfoObj = env->CallObjectMethod(modelInfo, listGet, i);
         jclass modelInfoClass = env->GetObjectClass(modelInfoObj);
         jmethodID getOfflineModelName = env->GetMethodID(modelInfoClass,"getOfflineModelName","()Ljava/lang/String;");
-        jmethodID getModelPath = env->GetMethodID(modelInfoClass,"getModelPath","()Ljava/lang/String;");
         jmethodID getUseAIPP = env->GetMethodID(modelInfoClass,"getUseAIPP","()Z");
+        jmethodID getPostTopK = env->GetMethodID(modelInfoClass,"getPostTopK","()I");
+        jmethodID getPostSoftmax = env->GetMethodID(modelInfoClass,"getPostSoftmax","()Z");
+        jmethodID getBatchWaitUs = env->GetMethodID(modelInfoClass,"getBatchWaitUs","()I");
+        jmethodID getWarmupRuns = env->GetMethodID(modelInfoClass,"getWarmupRuns","()I");
 
         if(getOfflineModelName == nullptr)
         {
             LOGE("[HIAI_DEMO_SYNC] can not find getOfflineModelName method.");
             return nullptr;
         }
-        if(getModelPath == nullptr){
-            LOGE("[HIAI_DEMO_SYNC] can not find getModelPath method.");
-            return nullptr;
-        }
         if(getUseAIPP == nullptr){
             LOGE("[HIAI_DEMO_SYNC] can not find getUseAIPP method.");
             return nullptr;
         }
+        if(getPostTopK == nullptr || getPostSoftmax == nullptr){
+            LOGE("[HIAI_DEMO_SYNC] can not find getPostTopK or getPostSoftmax method.");
+            return nullptr;
+        }
+        if(getBatchWaitUs == nullptr){
+            LOGE("[HIAI_DEMO_SYNC] can not find getBatchWaitUs method.");
+            return nullptr;
+        }
+        if(getWarmupRuns == nullptr){
+            LOGE("[HIAI_DEMO_SYNC] can not find getWarmupRuns method.");
+            return nullptr;
+        }
 
+        ModelSource source;
+        if (!GetModelSource(env, modelInfoObj, source)) {
+            return nullptr;
+        }
         jboolean useaipp = (jboolean)env->CallBooleanMethod(modelInfoObj,getUseAIPP);
         jstring modelname = (jstring)env->CallObjectMethod(modelInfoObj,getOfflineModelName);
-        jstring modelpath = (jstring)env->CallObjectMethod(modelInfoObj,getModelPath);
         const char* modelName = env->GetStringUTFChars(modelname, 0);
         LOGE("[HIAI_DEMO_SYNC] modelName is %s .",modelName);
         if(modelName == nullptr)
@@ -248,46 +294,74 @@ Java_com_huawei_hiaidemo_utils_ModelManager_loadModelSync(JNIEnv *env, jclass ty
             LOGE("[HIAI_DEMO_SYNC] modelName is invalid.");
             return nullptr;
         }
-        const char *modelPath = env->GetStringUTFChars(modelpath, 0);
-        if(modelPath == nullptr)
-        {
-            LOGE("[HIAI_DEMO_SYNC] modelPath is invalid.");
+        LOGE("[HIAI_DEMO_SYNC] useaipp is %d.", bool(useaipp==JNI_TRUE));
+
+        SyncModelConfig config;
+        config.name = string(modelName);
+        config.useAipp = bool(useaipp==JNI_TRUE);
+        jint topK = env->CallIntMethod(modelInfoObj, getPostTopK);
+        config.postprocess.topK = topK > 0 ? (uint32_t)topK : 0;
+        config.postprocess.softmax = env->CallBooleanMethod(modelInfoObj, getPostSoftmax) == JNI_TRUE;
+        jint batchWaitUs = env->CallIntMethod(modelInfoObj, getBatchWaitUs);
+        config.batchWaitUs = batchWaitUs > 0 ? batchWaitUs : 0;
+        jint warmupRuns = env->CallIntMethod(modelInfoObj, getWarmupRuns);
+        config.warmupRuns = warmupRuns > 0 ? (uint32_t)warmupRuns : 0;
+        if (!GetModelQosClass(env, modelInfoObj, config.qos)) {
+            env->ReleaseStringUTFChars(modelname, modelName);
             return nullptr;
         }
-        LOGE("[HIAI_DEMO_SYNC] useaipp is %d.", bool(useaipp==JNI_TRUE));
-        aipps.push_back(bool(useaipp==JNI_TRUE));
-        names.push_back(string(modelName));
-        modelPaths.push_back(string(modelPath));
+        env->ReleaseStringUTFChars(modelname, modelName);
+
+        // models loaded by an earlier call keep their session, the others are added
+        if (FindSyncSession(config.name) != nullptr) {
+            continue;
+        }
+        names.push_back(config.name);
+        sources.push_back(source);
+        configs.push_back(config);
     }
 
     // load
-    if (!g_clientSync)
     {
-        g_clientSync = LoadModelSync(names, modelPaths, aipps);
-        if (g_clientSync == nullptr)
-        {
-            LOGE("[HIAI_DEMO_SYNC] g_clientSync loadModel is nullptr.");
+        lock_guard<mutex> lock(sync_load_mutex);
+        // drop what another thread loaded while this one read the list
+        for (size_t i = configs.size(); i-- > 0;) {
+            if (FindSyncSession(configs[i].name) != nullptr) {
+                names.erase(names.begin() + i);
+                sources.erase(sources.begin() + i);
+                configs.erase(configs.begin() + i);
+            }
+        }
+        if (!configs.empty() && !LoadModelSync(names, sources, configs)) {
+            LOGE("[HIAI_DEMO_SYNC] loadModel failed.");
             return nullptr;
         }
     }
 
-    // load model
-    LOGI("[HIAI_DEMO_SYNC] sync load model INPUT NCHW : %d %d %d %d." , inputDimension[0][0].GetNumber(), inputDimension[0][0].GetChannel(), inputDimension[0][0].GetHeight(), inputDimension[0][0].GetWidth());
-    LOGI("[HIAI_DEMO_SYNC] sync load model OUTPUT NCHW : %d %d %d %d." , outputDimension[0][0].GetNumber(), outputDimension[0][0].GetChannel(), outputDimension[0][0].GetHeight(), outputDimension[0][0].GetWidth());
-
     for(int i = 0;i < len ;i++){
         jobject modelInfoObj = env->CallObjectMethod(modelInfo, listGet, i);
+        string modelName;
+        if (!GetModelName(env, modelInfoObj, modelName)) {
+            return nullptr;
+        }
+        shared_ptr<SyncSession> session = FindSyncSession(modelName);
+        if (session == nullptr) {
+            LOGE("[HIAI_DEMO_SYNC] model %s is not loaded.", modelName.c_str());
+            return nullptr;
+        }
+        const vector<TensorDimension>& inputDimension = session->InputDims();
+        const vector<TensorDimension>& outputDimension = session->OutputDims();
         jclass modelInfoClass = env->GetObjectClass(modelInfoObj);
         jfieldID input_n_id = env->GetFieldID(modelInfoClass,"input_N","I");
         jfieldID input_c_id = env->GetFieldID(modelInfoClass,"input_C","I");
         jfieldID input_h_id = env->GetFieldID(modelInfoClass,"input_H","I");
         jfieldID input_w_id = env->GetFieldID(modelInfoClass,"input_W","I");
         jfieldID input_Number = env->GetFieldID(modelInfoClass,"input_Number","I");
-        env->SetIntField(modelInfoObj,input_n_id,inputDimension[i][0].GetNumber());
-        env->SetIntField(modelInfoObj,input_c_id,inputDimension[i][0].GetChannel());
-        env->SetIntField(modelInfoObj,input_h_id,inputDimension[i][0].GetHeight());
-        env->SetIntField(modelInfoObj,input_w_id,inputDimension[i][0].GetWidth());
-        env->SetIntField(modelInfoObj,input_Number,inputDimension[i].size());
+        env->SetIntField(modelInfoObj,input_n_id,inputDimension[0].GetNumber());
+        env->SetIntField(modelInfoObj,input_c_id,inputDimension[0].GetChannel());
+        env->SetIntField(modelInfoObj,input_h_id,inputDimension[0].GetHeight());
+        env->SetIntField(modelInfoObj,input_w_id,inputDimension[0].GetWidth());
+        env->SetIntField(modelInfoObj,input_Number,inputDimension.size());
 
         jfieldID output_n_id = env->GetFieldID(modelInfoClass,"output_N","I");
         jfieldID output_c_id = env->GetFieldID(modelInfoClass,"output_C","I");
@@ -295,11 +369,11 @@ Java_com_huawei_hiaidemo_utils_ModelManager_loadModelSync(JNIEnv *env, jclass ty
         jfieldID output_w_id = env->GetFieldID(modelInfoClass,"output_W","I");
         jfieldID output_Number = env->GetFieldID(modelInfoClass,"output_Number","I");
 
-        env->SetIntField(modelInfoObj,output_n_id,outputDimension[i][0].GetNumber());
-        env->SetIntField(modelInfoObj,output_c_id,outputDimension[i][0].GetChannel());
-        env->SetIntField(modelInfoObj,output_h_id,outputDimension[i][0].GetHeight());
-        env->SetIntField(modelInfoObj,output_w_id,outputDimension[i][0].GetWidth());
-        env->SetIntField(modelInfoObj,output_Number,outputDimension[i].size());
+        env->SetIntField(modelInfoObj,output_n_id,outputDimension[0].GetNumber());
+        env->SetIntField(modelInfoObj,output_c_id,outputDimension[0].GetChannel());
+        env->SetIntField(modelInfoObj,output_h_id,outputDimension[0].GetHeight());
+        env->SetIntField(modelInfoObj,output_w_id,outputDimension[0].GetWidth());
+        env->SetIntField(modelInfoObj,output_Number,outputDimension.size());
     }
 
     return modelInfo;
@@ -351,12 +425,25 @@ Java_com_huawei_hiaidemo_utils_ModelManager_runModelSync(JNIEnv *env, jclass typ
         return nullptr;
     }
 
-    int vecIndex = sync_nameToIndex[modelName];
+    shared_ptr<SyncSession> session = FindSyncSession(modelName);
+    if (session == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] model %s is not loaded.", modelName);
+        env->ReleaseStringUTFChars(modelname, modelName);
+        return nullptr;
+    }
+    CallTensors callTensors(*session);
+    SyncTensorSet* tensors = callTensors.Get();
+    if (tensors == nullptr) {
+        env->ReleaseStringUTFChars(modelname, modelName);
+        return nullptr;
+    }
+    vector<shared_ptr<AiTensor>>& input_tensor = tensors->inputs;
 
     const char *modelPath = env->GetStringUTFChars(modelpath, 0);
     if(modelPath == nullptr)
     {
         LOGE("[HIAI_DEMO_SYNC] modelPath is invalid.");
+        env->ReleaseStringUTFChars(modelname, modelName);
         return nullptr;
     }
     // buf_list
@@ -373,17 +460,12 @@ Java_com_huawei_hiaidemo_utils_ModelManager_runModelSync(JNIEnv *env, jclass typ
         LOGE("[HIAI_DEMO_SYNC] can not find size method.");
     }
     int len = static_cast<int>(env->CallIntMethod(bufList, listSize));
-
-    // load
-    if (!g_clientSync)
-    {
-        LOGE("[HIAI_DEMO_SYNC] Model Manager Client is nullptr.");
-    }
     env->ReleaseStringUTFChars(modelpath, modelPath);
-
-    // run
-    LOGI("[HIAI_DEMO_SYNC] INPUT NCHW : %d %d %d %d." , inputDimension[0][0].GetNumber(), inputDimension[0][0].GetChannel(), inputDimension[0][0].GetHeight(), inputDimension[0][0].GetWidth());
-    LOGI("[HIAI_DEMO_SYNC] OUTPUT NCHW : %d %d %d %d." , outputDimension[0][0].GetNumber(), outputDimension[0][0].GetChannel(), outputDimension[0][0].GetHeight(), outputDimension[0][0].GetWidth());
+    if (len > (int)input_tensor.size()) {
+        LOGE("[HIAI_DEMO_SYNC] model %s has %zu inputs.", modelName, input_tensor.size());
+        env->ReleaseStringUTFChars(modelname, modelName);
+        return nullptr;
+    }
 
     for(int i = 0;i < len ;i++){
         jbyteArray buf_ = (jbyteArray)(env->CallObjectMethod(bufList, listGet, i));
@@ -391,63 +473,431 @@ Java_com_huawei_hiaidemo_utils_ModelManager_runModelSync(JNIEnv *env, jclass typ
         int dataBuffSize = 0;
         dataBuff = env->GetByteArrayElements(buf_, nullptr);
         dataBuffSize = env->GetArrayLength(buf_);
-        if(input_tensor[vecIndex][i]->GetSize() != dataBuffSize)
+        if(input_tensor[i]->GetSize() != dataBuffSize)
         {
-            LOGE("[HIAI_DEMO_SYNC] input->GetSize(%d) != dataBuffSize(%d) ",input_tensor[vecIndex][i]->GetSize(),dataBuffSize);
+            LOGE("[HIAI_DEMO_SYNC] input->GetSize(%d) != dataBuffSize(%d) ",input_tensor[i]->GetSize(),dataBuffSize);
+            env->ReleaseByteArrayElements(buf_, dataBuff, JNI_ABORT);
+            env->ReleaseStringUTFChars(modelname, modelName);
             return nullptr;
         }
-        memmove(input_tensor[vecIndex][i]->GetBuffer(), dataBuff, (size_t)dataBuffSize);
-        env->ReleaseByteArrayElements(buf_, dataBuff, 0);
+        memmove(input_tensor[i]->GetBuffer(), dataBuff, (size_t)dataBuffSize);
+        // only read: no copy back into the Java array
+        env->ReleaseByteArrayElements(buf_, dataBuff, JNI_ABORT);
     }
 
+    jobject output_list = ProcessSync(env, *session, input_tensor, *tensors);
+    env->ReleaseStringUTFChars(modelname, modelName);
+    return output_list;
+}
 
-    AiContext context;
-    string key = "model_name";
-    string value = modelName;
-    value += ".om";
-    context.AddPara(key, value);
+static shared_ptr<SyncSession> FindSyncModel(JNIEnv *env, jobject modelInfo)
+{
+    string modelName;
+    if (!GetModelName(env, modelInfo, modelName)) {
+        return nullptr;
+    }
+    shared_ptr<SyncSession> session = FindSyncSession(modelName);
+    if (session == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] model %s is not loaded.", modelName.c_str());
+    }
+    return session;
+}
 
-    LOGI("[HIAI_DEMO_SYNC] runModel modelname:%s", modelName);
+static bool GetAippRequest(JNIEnv *env, jint frameW, jint frameH, jintArray crop, jint imageType, jboolean nv21,
+    jfloatArray mean, jfloatArray varReci, DynamicAippRequest& request)
+{
+    if (frameW <= 0 || frameH <= 0 || imageType < JPEG || imageType > BT_709_NARROW) {
+        LOGE("[HIAI_DEMO_SYNC] frame %dx%d or imageType %d is invalid.", frameW, frameH, imageType);
+        return false;
+    }
+    request.frameW = (uint32_t)frameW;
+    request.frameH = (uint32_t)frameH;
+    request.imageType = static_cast<ImageType>(imageType);
+    request.nv21 = (nv21 == JNI_TRUE);
+    if (crop != nullptr) {
+        if (env->GetArrayLength(crop) != 4) {
+            LOGE("[HIAI_DEMO_SYNC] crop must be {x, y, width, height}.");
+            return false;
+        }
+        jint rect[4];
+        env->GetIntArrayRegion(crop, 0, 4, rect);
+        if (rect[0] < 0 || rect[1] < 0 || rect[2] <= 0 || rect[3] <= 0) {
+            LOGE("[HIAI_DEMO_SYNC] crop is invalid.");
+            return false;
+        }
+        request.crop.switch_ = true;
+        request.crop.cropStartPosW = (uint32_t)rect[0];
+        request.crop.cropStartPosH = (uint32_t)rect[1];
+        request.crop.cropSizeW = (uint32_t)rect[2];
+        request.crop.cropSizeH = (uint32_t)rect[3];
+    }
+    if (mean != nullptr) {
+        if (env->GetArrayLength(mean) != 3) {
+            LOGE("[HIAI_DEMO_SYNC] mean must have 3 values.");
+            return false;
+        }
+        env->GetFloatArrayRegion(mean, 0, 3, request.mean);
+    }
+    if (varReci != nullptr) {
+        if (env->GetArrayLength(varReci) != 3) {
+            LOGE("[HIAI_DEMO_SYNC] varReci must have 3 values.");
+            return false;
+        }
+        env->GetFloatArrayRegion(varReci, 0, 3, request.varReci);
+    }
+    return true;
+}
 
-    // before process
-    struct timeval tpstart, tpend;
-    gettimeofday(&tpstart, nullptr);
-    int istamp;
-    int ret = g_clientSync->Process(context, input_tensor[vecIndex], output_tensor[vecIndex], 1000, istamp);
-    if (ret) {
-        LOGE("[HIAI_DEMO_SYNC] Runmodel Failed!, ret=%d\n", ret);
+// Copy the frame into the frame tensor of the caller, re-created when the camera size changes
+static shared_ptr<AiTensor> FillAippFrame(JNIEnv *env, SyncTensorSet& tensors, jbyteArray frame, uint32_t frameW,
+    uint32_t frameH)
+{
+    shared_ptr<AiTensor>& tensor = tensors.aippFrame;
+    uint32_t frameSize = frameW * frameH * 3 / 2;
+    if (tensor == nullptr || tensor->GetSize() != frameSize) {
+        tensor = make_shared<AiTensor>();
+        if (tensor->Init(1, frameH, frameW, AiTensorImage_YUV420SP_U8) != AI_SUCCESS) {
+            LOGE("[HIAI_DEMO_SYNC] frame AiTensor Init failed.");
+            tensor = nullptr;
+            return nullptr;
+        }
+    }
+    env->GetByteArrayRegion(frame, 0, (jsize)frameSize, static_cast<jbyte*>(tensor->GetBuffer()));
+    return tensor;
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_runModelAippSync(JNIEnv *env, jclass type, jobject modelInfo,
+    jbyteArray frame, jint frameW, jint frameH, jintArray crop, jint imageType, jboolean nv21,
+    jfloatArray mean, jfloatArray varReci)
+{
+    if (env == nullptr || modelInfo == nullptr || frame == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] runModelAippSync invalid params.");
         return nullptr;
     }
 
-    // after process
-    gettimeofday(&tpend, nullptr);
-    float time_use = 1000000 * (tpend.tv_sec - tpstart.tv_sec) + tpend.tv_usec - tpstart.tv_usec;
+    DynamicAippRequest request;
+    if (!GetAippRequest(env, frameW, frameH, crop, imageType, nv21, mean, varReci, request)) {
+        return nullptr;
+    }
+    if ((uint32_t)env->GetArrayLength(frame) < request.frameW * request.frameH * 3 / 2) {
+        LOGE("[HIAI_DEMO_SYNC] frame is smaller than %dx%d YUV420SP.", frameW, frameH);
+        return nullptr;
+    }
 
-    time_use_sync =  time_use / 1000;
+    shared_ptr<SyncSession> session = FindSyncModel(env, modelInfo);
+    if (session == nullptr) {
+        return nullptr;
+    }
+    const string& modelName = session->Name();
+    if (session->InputDims().size() != 1) {
+        LOGE("[HIAI_DEMO_SYNC] model %s must have a single image input.", modelName.c_str());
+        return nullptr;
+    }
+    CallTensors callTensors(*session);
+    SyncTensorSet* tensors = callTensors.Get();
+    if (tensors == nullptr) {
+        return nullptr;
+    }
 
-    LOGE("[HIAI_DEMO_SYNC] inference time %f ms.\n", time_use / 1000);
+    const TensorDimension& dim = session->InputDims()[0];
+    CpuAippConfig config;
+    if (BuildDynamicAippConfig(request, dim.GetWidth(), dim.GetHeight(), config) != AI_SUCCESS) {
+        LOGE("[HIAI_DEMO_SYNC] AIPP request does not fit frame %dx%d.", frameW, frameH);
+        return nullptr;
+    }
 
-    // output_tensor
-    jclass output_list_class = env->FindClass("java/util/ArrayList");
-    jmethodID  output_list_init = env->GetMethodID(output_list_class,"<init>","()V");
-    jmethodID list_add = env->GetMethodID(output_list_class,"add","(Ljava/lang/Object;)Z");
-    jobject output_list = env->NewObject(output_list_class,output_list_init,"");
+    if (session->DynamicAipp()) {
+        shared_ptr<AiTensor> frameTensor = FillAippFrame(env, *tensors, frame, request.frameW, request.frameH);
+        if (frameTensor == nullptr) {
+            return nullptr;
+        }
+        shared_ptr<AippTensor> aippTensor = CreateDynamicAippTensor(frameTensor, config, request.imageType, 0);
+        if (aippTensor == nullptr) {
+            return nullptr;
+        }
+        vector<shared_ptr<AiTensor>> inputs;
+        inputs.push_back(aippTensor);
+        return ProcessSync(env, *session, inputs, *tensors);
+    }
 
-    long output_tensor_size = output_tensor[vecIndex].size();
-    LOGI("[HIAI_DEMO_SYNC] output_tensor_size is %ld .",output_tensor_size);
-    for(long j = 0; j < output_tensor_size; j++){
-        float *outputBuffer = (float *)output_tensor[vecIndex][j]->GetBuffer();
-        int outputsize = outputDimension[vecIndex][j].GetNumber() * outputDimension[vecIndex][j].GetChannel() * outputDimension[vecIndex][j].GetHeight() * outputDimension[vecIndex][j].GetWidth();
-        jfloatArray  result = env->NewFloatArray(outputsize);
-        jfloat temp[outputsize];
-        for(int i =0;i < outputsize;i++)
-        {
-            temp[i] = outputBuffer[i];
+    // no dynamic AIPP on this DDK or model: run the same parameters on the CPU
+    // into a float input
+    shared_ptr<AiTensor> input = tensors->inputs[0];
+    uint32_t outputSize = 3 * dim.GetWidth() * dim.GetHeight() * sizeof(float);
+    if (dim.GetChannel() != 3 || input->GetSize() != outputSize) {
+        LOGE("[HIAI_DEMO_SYNC] model %s has neither dynamic AIPP nor a float input.", modelName.c_str());
+        return nullptr;
+    }
+    jbyte* frameData = env->GetByteArrayElements(frame, nullptr);
+    AIStatus ret = RunCpuAipp(config, reinterpret_cast<const uint8_t*>(frameData), CpuAippInputImageSize(config),
+        static_cast<float*>(input->GetBuffer()), outputSize);
+    env->ReleaseByteArrayElements(frame, frameData, JNI_ABORT);
+    if (ret != AI_SUCCESS) {
+        LOGE("[HIAI_DEMO_SYNC] RunCpuAipp failed, ret=%d.", ret);
+        return nullptr;
+    }
+    return ProcessSync(env, *session, tensors->inputs, *tensors);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_acquireTensorsSync(JNIEnv *env, jclass type, jobject modelInfo)
+{
+    if (env == nullptr || modelInfo == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] acquireTensorsSync invalid params.");
+        return NO_SYNC_TENSORS;
+    }
+    shared_ptr<SyncSession> session = FindSyncModel(env, modelInfo);
+    return session != nullptr ? session->CheckOutTensors() : NO_SYNC_TENSORS;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_releaseTensorsSync(JNIEnv *env, jclass type, jobject modelInfo,
+    jint tensors)
+{
+    if (env == nullptr || modelInfo == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] releaseTensorsSync invalid params.");
+        return;
+    }
+    shared_ptr<SyncSession> session = FindSyncModel(env, modelInfo);
+    if (session != nullptr && !session->ReturnTensors(tensors)) {
+        LOGE("[HIAI_DEMO_SYNC] tensor set %d of model %s is not checked out.", tensors, session->Name().c_str());
+    }
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_getInputBuffersSync(JNIEnv *env, jclass type, jobject modelInfo,
+    jint tensors)
+{
+    if (env == nullptr || modelInfo == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] getInputBuffersSync invalid params.");
+        return nullptr;
+    }
+    shared_ptr<SyncSession> session = FindSyncModel(env, modelInfo);
+    SyncTensorSet* set = session != nullptr ? TensorsOfCaller(*session, tensors) : nullptr;
+    if (set == nullptr) {
+        return nullptr;
+    }
+    return NewTensorBufferList(env, set->inputs);
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_runModelInPlaceSync(JNIEnv *env, jclass type, jobject modelInfo,
+    jint tensors)
+{
+    if (env == nullptr || modelInfo == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] runModelInPlaceSync invalid params.");
+        return nullptr;
+    }
+    shared_ptr<SyncSession> session = FindSyncModel(env, modelInfo);
+    SyncTensorSet* set = session != nullptr ? TensorsOfCaller(*session, tensors) : nullptr;
+    if (set == nullptr) {
+        return nullptr;
+    }
+    return ProcessSync(env, *session, set->inputs, *set);
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_runModelBuffersSync(JNIEnv *env, jclass type, jobject modelInfo,
+    jint tensors)
+{
+    if (env == nullptr || modelInfo == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] runModelBuffersSync invalid params.");
+        return JNI_FALSE;
+    }
+    shared_ptr<SyncSession> session = FindSyncModel(env, modelInfo);
+    SyncTensorSet* set = session != nullptr ? TensorsOfCaller(*session, tensors) : nullptr;
+    if (set == nullptr) {
+        return JNI_FALSE;
+    }
+    return session->Run(set->inputs, *set) == SUCCESS ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_leaseOutputBuffersSync(JNIEnv *env, jclass type, jobject modelInfo,
+    jint tensors)
+{
+    if (env == nullptr || modelInfo == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] leaseOutputBuffersSync invalid params.");
+        return nullptr;
+    }
+    shared_ptr<SyncSession> session = FindSyncModel(env, modelInfo);
+    SyncTensorSet* set = session != nullptr ? TensorsOfCaller(*session, tensors) : nullptr;
+    if (set == nullptr) {
+        return nullptr;
+    }
+    jobject buffers = NewTensorBufferList(env, set->outputs);
+    if (buffers != nullptr) {
+        session->LeaseOutputs(*set);
+    }
+    return buffers;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_releaseOutputBuffersSync(JNIEnv *env, jclass type, jobject modelInfo,
+    jint tensors)
+{
+    if (env == nullptr || modelInfo == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] releaseOutputBuffersSync invalid params.");
+        return;
+    }
+    shared_ptr<SyncSession> session = FindSyncModel(env, modelInfo);
+    SyncTensorSet* set = session != nullptr ? TensorsOfCaller(*session, tensors) : nullptr;
+    if (set != nullptr && !session->ReleaseOutputs(*set)) {
+        LOGE("[HIAI_DEMO_SYNC] outputs of tensor set %d of model %s are not leased.", tensors,
+            session->Name().c_str());
+    }
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_runModelBatchedSync(JNIEnv *env, jclass type, jobject modelInfo,
+    jobject bufList)
+{
+    if (env == nullptr || modelInfo == nullptr || bufList == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] runModelBatchedSync invalid params.");
+        return nullptr;
+    }
+    shared_ptr<SyncSession> session = FindSyncModel(env, modelInfo);
+    if (session == nullptr) {
+        return nullptr;
+    }
+    BatchScheduler* scheduler = session->Batch();
+    if (scheduler == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] model %s is not compiled with batch > 1, use runModelSync.", session->Name().c_str());
+        return nullptr;
+    }
+
+    jclass classList = env->GetObjectClass(bufList);
+    jmethodID listGet = env->GetMethodID(classList, "get", "(I)Ljava/lang/Object;");
+    jmethodID listSize = env->GetMethodID(classList, "size", "()I");
+    if (listGet == nullptr || listSize == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] can not find get or size method.");
+        return nullptr;
+    }
+    size_t inputCount = session->InputDims().size();
+    if ((size_t)env->CallIntMethod(bufList, listSize) != inputCount) {
+        LOGE("[HIAI_DEMO_SYNC] model %s needs %zu inputs.", session->Name().c_str(), inputCount);
+        return nullptr;
+    }
+
+    // one image is one row of every input and output tensor
+    uint32_t batch = session->InputDims()[0].GetNumber();
+    vector<jbyteArray> images(inputCount);
+    vector<uint32_t> inputRowSize(inputCount);
+    for (size_t i = 0; i < inputCount; ++i) {
+        images[i] = (jbyteArray)env->CallObjectMethod(bufList, listGet, (jint)i);
+        inputRowSize[i] = session->BatchInputs(0)[i]->GetSize() / batch;
+        if (images[i] == nullptr || (uint32_t)env->GetArrayLength(images[i]) != inputRowSize[i]) {
+            LOGE("[HIAI_DEMO_SYNC] input %zu of one image must have %u bytes.", i, inputRowSize[i]);
+            return nullptr;
         }
-        env->SetFloatArrayRegion(result,0,outputsize,temp);
-        jboolean output_add = env->CallBooleanMethod(output_list,list_add,result);
-        LOGI("[HIAI_DEMO_SYNC] output_add result  is %d .",output_add);
     }
-    env->ReleaseStringUTFChars(modelname, modelName);
+
+    vector<shared_ptr<AiTensor>>& outputs = session->BatchOutputs().outputs;
+    vector<vector<float>> results(outputs.size());
+    int ret = scheduler->Submit(
+        [&](uint32_t stage, uint32_t row) {
+            for (size_t i = 0; i < inputCount; ++i) {
+                jbyte* dst = static_cast<jbyte*>(session->BatchInputs(stage)[i]->GetBuffer()) + row * inputRowSize[i];
+                env->GetByteArrayRegion(images[i], 0, inputRowSize[i], dst);
+            }
+        },
+        [&](uint32_t stage, uint32_t row) {
+            for (size_t j = 0; j < outputs.size(); ++j) {
+                uint32_t rowCount = outputs[j]->GetSize() / sizeof(float) / batch;
+                const float* src = static_cast<const float*>(outputs[j]->GetBuffer()) + row * rowCount;
+                results[j].assign(src, src + rowCount);
+            }
+        });
+    if (ret != SUCCESS) {
+        return nullptr;
+    }
+
+    jclass output_list_class = env->FindClass("java/util/ArrayList");
+    jmethodID output_list_init = env->GetMethodID(output_list_class, "<init>", "()V");
+    jmethodID list_add = env->GetMethodID(output_list_class, "add", "(Ljava/lang/Object;)Z");
+    jobject output_list = env->NewObject(output_list_class, output_list_init);
+    for (size_t j = 0; j < results.size(); ++j) {
+        jfloatArray result = NewSyncOutputArray(env, *session, results[j].data(), (uint32_t)results[j].size());
+        env->CallBooleanMethod(output_list, list_add, result);
+        env->DeleteLocalRef(result);
+    }
     return output_list;
 }
+
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_getWarmupStateSync(JNIEnv *env, jclass type, jobject modelInfo)
+{
+    if (env == nullptr || modelInfo == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] getWarmupStateSync invalid params.");
+        return nullptr;
+    }
+    shared_ptr<SyncSession> session = FindSyncModel(env, modelInfo);
+    if (session == nullptr) {
+        return nullptr;
+    }
+    return NewWarmupStatsArray(env, session->Warmup().GetStats());
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_loadModelSyncInBackground(JNIEnv *env, jclass type, jobject modelInfo,
+    jobject listener)
+{
+    if (env == nullptr || modelInfo == nullptr || listener == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] loadModelSyncInBackground invalid params.");
+        return JNI_FALSE;
+    }
+    return LoadModelsInBackground(env, modelInfo, listener, Java_com_huawei_hiaidemo_utils_ModelManager_loadModelSync)
+        ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_getLoadTimesSync(JNIEnv *env, jclass type, jobject modelInfo)
+{
+    if (env == nullptr || modelInfo == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] getLoadTimesSync invalid params.");
+        return nullptr;
+    }
+    shared_ptr<SyncSession> session = FindSyncModel(env, modelInfo);
+    if (session == nullptr) {
+        return nullptr;
+    }
+    return NewLoadTimesArray(env, session->LoadTimes());
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_setModelMemoryBudgetSync(JNIEnv *env, jclass type, jlong bytes)
+{
+    ModelResidency::Shared().SetBudget(bytes > 0 ? (uint64_t)bytes : 0);
+}
+
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_getResidencyStatsSync(JNIEnv *env, jclass type)
+{
+    ResidencyStats stats = ModelResidency::Shared().GetStats();
+    vector<jlong> values = { (jlong)stats.hits, (jlong)stats.misses, (jlong)stats.evictions,
+        (jlong)stats.loadFailures, (jlong)stats.models, (jlong)stats.residentModels, (jlong)stats.residentBytes,
+        (jlong)stats.budgetBytes };
+    for (uint32_t i = 0; i < RESIDENCY_LOAD_BUCKETS; ++i) {
+        values.push_back((jlong)stats.loadHistogram[i]);
+    }
+    jlongArray result = env->NewLongArray((jsize)values.size());
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, (jsize)values.size(), values.data());
+    }
+    return result;
+}
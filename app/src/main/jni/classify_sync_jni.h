@@ -0,0 +1,30 @@
+/*
+ * @file classify_sync_jni.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_CLASSIFY_SYNC_JNI_H
+#define HIAI_DEMO_CLASSIFY_SYNC_JNI_H
+
+#include <memory>
+#include <string>
+#include "HiAiModelManagerService.h"
+
+/*
+* @brief Look up an input tensor of a model loaded by loadModelSync, so that
+*        native preprocessing can fill it in place before runModelInPlaceSync.
+* @param [in] modelName offline model name (without ".om")
+* @param [in] tensors handle of a tensor set from acquireTensorsSync
+* @param [in] inputIndex index of the model input
+* @param [out] dim dimension reported by GetModelIOTensorDim for this input
+* @return the input tensor, nullptr if the model, the set or the input does not exist
+*/
+std::shared_ptr<hiai::AiTensor> GetSyncInputTensor(const std::string& modelName, int32_t tensors,
+    uint32_t inputIndex, hiai::TensorDimension& dim);
+
+#endif
@@ -0,0 +1,314 @@
+/*
+ * @file compiled_model_cache.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "compiled_model_cache.h"
+#include "model_mapping.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <android/log.h>
+
+#define LOG_TAG "MODEL_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+static const char* VERDICT_NAMES[] = { "none", "compatible", "built", "failed" };
+static const size_t COPY_CHUNK = 1 << 20;
+
+static mutex g_cacheDirMutex;
+static string g_cacheDir;
+
+static uint64_t Rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t Mix(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+// 64-bit word at a time, MurmurHash3 style; the size is part of the hash
+static uint64_t HashBytes(const void* data, size_t size)
+{
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ size;
+    size_t words = size / 8;
+    for (size_t i = 0; i < words; ++i) {
+        uint64_t k;
+        memcpy(&k, bytes + i * 8, 8);
+        h ^= Rotl(k * c1, 31) * c2;
+        h = Rotl(h, 27) * 5 + 0x52dce729;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, bytes + words * 8, size % 8);
+    h ^= Rotl(tail * c1, 31) * c2;
+    return Mix(h);
+}
+
+static string Hex(uint64_t value)
+{
+    char text[17];
+    snprintf(text, sizeof(text), "%016" PRIx64, value);
+    return text;
+}
+
+static bool ReadText(const string& path, string& content)
+{
+    FILE* file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return false;
+    }
+    char buffer[256];
+    size_t n = fread(buffer, 1, sizeof(buffer) - 1, file);
+    fclose(file);
+    content.assign(buffer, n);
+    return true;
+}
+
+CompiledModelCache::CompiledModelCache(const string& dir) : dir_(dir)
+{
+}
+
+bool CompiledModelCache::MakeDir()
+{
+    if (mkdir(dir_.c_str(), 0700) != 0 && errno != EEXIST) {
+        LOGE("[HIAI_DEMO_MODEL] cannot create the compiled model cache %s.", dir_.c_str());
+        return false;
+    }
+    return true;
+}
+
+string CompiledModelCache::EntryName(uint64_t hash, const string& version) const
+{
+    // the version goes into a file name
+    string name = Hex(hash) + "-";
+    for (char c : version) {
+        bool plain = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '.';
+        name += plain ? c : '_';
+    }
+    return name;
+}
+
+string CompiledModelCache::StampPath(const string& path) const
+{
+    return dir_ + "/stamp-" + Hex(HashBytes(path.data(), path.size()));
+}
+
+bool CompiledModelCache::WriteAtomic(const string& path, const string& content)
+{
+    string temp = path + ".tmp";
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        LOGE("[HIAI_DEMO_MODEL] cannot write %s.", temp.c_str());
+        return false;
+    }
+    bool ok = write(fd, content.data(), content.size()) == (ssize_t)content.size() && fsync(fd) == 0;
+    close(fd);
+    if (!ok || rename(temp.c_str(), path.c_str()) != 0) {
+        LOGE("[HIAI_DEMO_MODEL] cannot replace %s.", path.c_str());
+        unlink(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CompiledModelCache::WriteStamp(const string& path, uint64_t hash)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !MakeDir()) {
+        return false;
+    }
+    char stamp[128];
+    snprintf(stamp, sizeof(stamp), "%lld %lld %ld %s\n", (long long)st.st_size, (long long)st.st_mtim.tv_sec,
+        (long)st.st_mtim.tv_nsec, Hex(hash).c_str());
+    return WriteAtomic(StampPath(path), stamp);
+}
+
+bool CompiledModelCache::ContentHash(const string& path, uint64_t& hash)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    string stamp;
+    if (ReadText(StampPath(path), stamp)) {
+        long long size = 0;
+        long long sec = 0;
+        long nsec = 0;
+        uint64_t stamped = 0;
+        if (sscanf(stamp.c_str(), "%lld %lld %ld %" SCNx64, &size, &sec, &nsec, &stamped) == 4 &&
+            size == (long long)st.st_size && sec == (long long)st.st_mtim.tv_sec && nsec == (long)st.st_mtim.tv_nsec) {
+            hash = stamped;
+            return true;
+        }
+    }
+    shared_ptr<ModelMapping> mapping = ModelMapping::MapFile(path);
+    if (mapping == nullptr) {
+        return false;
+    }
+    hash = HashBytes(mapping->Data(), mapping->Size());
+    WriteStamp(path, hash);
+    return true;
+}
+
+CompileVerdict CompiledModelCache::Lookup(uint64_t hash, const string& version, string& compiledPath) const
+{
+    string entry = dir_ + "/" + EntryName(hash, version);
+    string text;
+    if (!ReadText(entry + ".verdict", text)) {
+        return VERDICT_NONE;
+    }
+    for (int verdict = VERDICT_COMPATIBLE; verdict <= VERDICT_FAILED; ++verdict) {
+        if (text.compare(0, strlen(VERDICT_NAMES[verdict]), VERDICT_NAMES[verdict]) != 0) {
+            continue;
+        }
+        if (verdict == VERDICT_BUILT) {
+            compiledPath = entry + ".om";
+            if (access(compiledPath.c_str(), R_OK) != 0) {
+                return VERDICT_NONE;
+            }
+        }
+        return static_cast<CompileVerdict>(verdict);
+    }
+    return VERDICT_NONE;
+}
+
+void CompiledModelCache::DropOtherVersions(uint64_t hash, const string& version)
+{
+    DIR* dir = opendir(dir_.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    string model = Hex(hash) + "-";
+    string current = EntryName(hash, version) + ".";
+    vector<string> stale;
+    while (struct dirent* file = readdir(dir)) {
+        string name = file->d_name;
+        if (name.compare(0, model.size(), model) == 0 && name.compare(0, current.size(), current) != 0) {
+            stale.push_back(name);
+        }
+    }
+    closedir(dir);
+    for (auto& name : stale) {
+        LOGI("[HIAI_DEMO_MODEL] drop %s, compiled for another DDK.", name.c_str());
+        unlink((dir_ + "/" + name).c_str());
+    }
+}
+
+bool CompiledModelCache::Record(uint64_t hash, const string& version, CompileVerdict verdict)
+{
+    if (verdict == VERDICT_NONE || verdict == VERDICT_BUILT || !MakeDir()) {
+        return false;
+    }
+    DropOtherVersions(hash, version);
+    return WriteAtomic(dir_ + "/" + EntryName(hash, version) + ".verdict", string(VERDICT_NAMES[verdict]) + "\n");
+}
+
+string CompiledModelCache::TempBuildPath(uint64_t hash, const string& version)
+{
+    if (!MakeDir()) {
+        return string();
+    }
+    return dir_ + "/" + EntryName(hash, version) + ".om.tmp";
+}
+
+bool CompiledModelCache::StoreBuilt(uint64_t hash, const string& version, string& compiledPath)
+{
+    string entry = dir_ + "/" + EntryName(hash, version);
+    DropOtherVersions(hash, version);
+    string temp = entry + ".om.tmp";
+    int fd = open(temp.c_str(), O_RDONLY | O_CLOEXEC);
+    bool synced = fd >= 0 && fsync(fd) == 0;
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (!synced || rename(temp.c_str(), (entry + ".om").c_str()) != 0) {
+        LOGE("[HIAI_DEMO_MODEL] cannot store the rebuilt model %s.", entry.c_str());
+        unlink(temp.c_str());
+        return false;
+    }
+    compiledPath = entry + ".om";
+    // the verdict goes last: a model without one is rebuilt
+    uint64_t compiledHash = 0;
+    if (ContentHash(compiledPath, compiledHash)) {
+        Record(compiledHash, version, VERDICT_COMPATIBLE);
+    }
+    return WriteAtomic(entry + ".verdict", string(VERDICT_NAMES[VERDICT_BUILT]) + "\n");
+}
+
+bool CompiledModelCache::Install(const string& compiledPath, const string& target)
+{
+    uint64_t hash = 0;
+    if (!ContentHash(compiledPath, hash)) {
+        return false;
+    }
+    string temp = target + ".tmp";
+    unlink(temp.c_str());
+    // a copy, not a hard link: the Java asset copy truncates target in place
+    int in = open(compiledPath.c_str(), O_RDONLY | O_CLOEXEC);
+    int out = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    bool ok = in >= 0 && out >= 0;
+    vector<char> chunk(COPY_CHUNK);
+    ssize_t n = 0;
+    while (ok && (n = read(in, chunk.data(), chunk.size())) > 0) {
+        ok = write(out, chunk.data(), (size_t)n) == n;
+    }
+    ok = ok && n == 0 && fsync(out) == 0;
+    if (in >= 0) {
+        close(in);
+    }
+    if (out >= 0) {
+        close(out);
+    }
+    if (!ok || rename(temp.c_str(), target.c_str()) != 0) {
+        LOGE("[HIAI_DEMO_MODEL] cannot install the rebuilt model at %s.", target.c_str());
+        unlink(temp.c_str());
+        return false;
+    }
+    WriteStamp(target, hash);
+    return true;
+}
+
+string CompiledModelCache::DefaultDir(const string& modelPath)
+{
+    size_t slash = modelPath.rfind('/');
+    return (slash == string::npos ? string(".") : modelPath.substr(0, slash)) + "/compiled";
+}
+
+void SetCompiledModelCacheDir(const string& dir)
+{
+    lock_guard<mutex> lock(g_cacheDirMutex);
+    g_cacheDir = dir;
+}
+
+string GetCompiledModelCacheDir()
+{
+    lock_guard<mutex> lock(g_cacheDirMutex);
+    return g_cacheDir;
+}
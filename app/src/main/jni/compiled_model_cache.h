@@ -0,0 +1,102 @@
+/*
+ * @file compiled_model_cache.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_COMPILED_MODEL_CACHE_H
+#define HIAI_DEMO_COMPILED_MODEL_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+/* What modelCompatibilityProcessFromFile found for an OM file on a DDK version */
+enum CompileVerdict {
+    VERDICT_NONE = 0,
+    // runs on this DDK as it is
+    VERDICT_COMPATIBLE = 1,
+    // rebuilt, the compiled model is in the cache
+    VERDICT_BUILT = 2,
+    // neither compatible nor buildable on this DDK
+    VERDICT_FAILED = 3,
+};
+
+/*
+ * On-disk cache of compatibility verdicts and rebuilt models, keyed by the
+ * content hash of an OM file and the DDK version string. A DDK upgrade misses
+ * every entry of the old version; an entry of the old version is removed when
+ * its model is seen again. Files are written under a temporary name and
+ * renamed into place, so a crash never leaves a torn model or verdict.
+ *
+ * Hashing a model reads all of it, so the hash of a file is also remembered
+ * with its size and modification time: a warm launch finds its verdict with a
+ * stat and a small read.
+ */
+class CompiledModelCache {
+public:
+    /* @param [in] dir cache directory, created on first write */
+    explicit CompiledModelCache(const std::string& dir);
+
+    /*
+    * @brief Content hash of a file, read from its stamp when the file has not
+    *        changed since, computed (and stamped) otherwise
+    * @return false if the file cannot be read
+    */
+    bool ContentHash(const std::string& path, uint64_t& hash);
+
+    /*
+    * @param [out] compiledPath the rebuilt model, for VERDICT_BUILT
+    */
+    CompileVerdict Lookup(uint64_t hash, const std::string& version, std::string& compiledPath) const;
+
+    /*
+    * @brief Record a verdict other than VERDICT_BUILT, dropping the entries of
+    *        the same model on other DDK versions
+    */
+    bool Record(uint64_t hash, const std::string& version, CompileVerdict verdict);
+
+    /*
+    * @brief Where BuildModel exports the rebuilt model before StoreBuilt
+    * @return empty if the cache directory cannot be created
+    */
+    std::string TempBuildPath(uint64_t hash, const std::string& version);
+
+    /*
+    * @brief Move a rebuilt model exported to TempBuildPath into the cache and
+    *        record VERDICT_BUILT; the rebuilt model itself is recorded compatible
+    * @param [out] compiledPath the model in the cache
+    */
+    bool StoreBuilt(uint64_t hash, const std::string& version, std::string& compiledPath);
+
+    /*
+    * @brief Atomically replace target with a copy of a cached model, and stamp
+    *        target with its hash
+    */
+    bool Install(const std::string& compiledPath, const std::string& target);
+
+    /* Cache directory used when none is set: "compiled" next to the model */
+    static std::string DefaultDir(const std::string& modelPath);
+
+private:
+    bool MakeDir();
+    std::string EntryName(uint64_t hash, const std::string& version) const;
+    std::string StampPath(const std::string& path) const;
+    bool WriteStamp(const std::string& path, uint64_t hash);
+    void DropOtherVersions(uint64_t hash, const std::string& version);
+    bool WriteAtomic(const std::string& path, const std::string& content);
+
+    std::string dir_;
+};
+
+/*
+* @brief Cache directory of modelCompatibilityProcessFromFile, empty for
+*        CompiledModelCache::DefaultDir
+*/
+void SetCompiledModelCacheDir(const std::string& dir);
+std::string GetCompiledModelCacheDir();
+
+#endif
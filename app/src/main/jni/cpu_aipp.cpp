@@ -0,0 +1,411 @@
+/*
+ * @file cpu_aipp.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+// The engine only uses the plain structs of HiAiAippPara.h and no DDK symbol,
+// so it also builds and runs on a Linux host.
+
+#include "cpu_aipp.h"
+
+#include <algorithm>
+#include "image_preprocess.h"
+#include "task_pool.h"
+
+using namespace std;
+using namespace hiai;
+
+static bool IsYuvFormat(AiTensorImage_Format format)
+{
+    return format == AiTensorImage_YUV420SP_U8 || format == AiTensorImage_YUV400_U8 ||
+        format == AiTensorImage_YUYV_U8 || format == AiTensorImage_YUV422SP_U8 ||
+        format == AiTensorImage_AYUV444_U8 || format == AiTensorImage_YUV444SP_U8 ||
+        format == AiTensorImage_YVU444SP_U8;
+}
+
+static uint32_t OutputChannels(AiTensorImage_Format format)
+{
+    return format == AiTensorImage_YUV400_U8 ? 1 : 3;
+}
+
+uint32_t CpuAippInputImageSize(const CpuAippConfig& config)
+{
+    const uint32_t pixels = config.inputShape.srcImageSizeW * config.inputShape.srcImageSizeH;
+    switch (config.inputFormat) {
+        case AiTensorImage_YUV420SP_U8:
+            return pixels * 3 / 2;
+        case AiTensorImage_XRGB8888_U8:
+        case AiTensorImage_ARGB8888_U8:
+        case AiTensorImage_AYUV444_U8:
+            return pixels * 4;
+        case AiTensorImage_YUV400_U8:
+            return pixels;
+        case AiTensorImage_YUYV_U8:
+        case AiTensorImage_YUV422SP_U8:
+            return pixels * 2;
+        case AiTensorImage_RGB888_U8:
+        case AiTensorImage_BGR888_U8:
+        case AiTensorImage_YUV444SP_U8:
+        case AiTensorImage_YVU444SP_U8:
+            return pixels * 3;
+        default:
+            return 0;
+    }
+}
+
+// Resolved geometry and normalization of one batch
+struct BatchPlan {
+    const uint8_t* image;
+    uint32_t cropX;
+    uint32_t cropY;
+    uint32_t cropW;
+    uint32_t cropH;
+    uint32_t innerW;
+    uint32_t innerH;
+    uint32_t padTop;
+    uint32_t padLeft;
+    bool resize;
+    vector<AxisTap> xs;
+    vector<AxisTap> ys;
+    float mean[3];
+    float scale[3];
+    float* output;
+};
+
+static bool PlanBatch(const CpuAippConfig& config, const CpuAippBatchConfig& batch, BatchPlan& plan,
+    uint32_t& outW, uint32_t& outH)
+{
+    const uint32_t srcW = config.inputShape.srcImageSizeW;
+    const uint32_t srcH = config.inputShape.srcImageSizeH;
+    if (batch.crop.switch_) {
+        if (batch.crop.cropSizeW == 0 || batch.crop.cropSizeH == 0 ||
+            batch.crop.cropStartPosW + batch.crop.cropSizeW > srcW ||
+            batch.crop.cropStartPosH + batch.crop.cropSizeH > srcH) {
+            return false;
+        }
+        plan.cropX = batch.crop.cropStartPosW;
+        plan.cropY = batch.crop.cropStartPosH;
+        plan.cropW = batch.crop.cropSizeW;
+        plan.cropH = batch.crop.cropSizeH;
+    } else {
+        plan.cropX = 0;
+        plan.cropY = 0;
+        plan.cropW = srcW;
+        plan.cropH = srcH;
+    }
+
+    plan.resize = batch.resize.switch_;
+    if (plan.resize) {
+        if (batch.resize.resizeOutputSizeW == 0 || batch.resize.resizeOutputSizeH == 0) {
+            return false;
+        }
+        plan.innerW = batch.resize.resizeOutputSizeW;
+        plan.innerH = batch.resize.resizeOutputSizeH;
+        BuildAxis(plan.cropW, 0.0f, static_cast<float>(plan.cropW), plan.innerW, plan.xs);
+        BuildAxis(plan.cropH, 0.0f, static_cast<float>(plan.cropH), plan.innerH, plan.ys);
+    } else {
+        plan.innerW = plan.cropW;
+        plan.innerH = plan.cropH;
+    }
+
+    plan.padTop = 0;
+    plan.padLeft = 0;
+    outW = plan.innerW;
+    outH = plan.innerH;
+    if (batch.padding.switch_) {
+        plan.padTop = batch.padding.paddingSizeTop;
+        plan.padLeft = batch.padding.paddingSizeLeft;
+        outW += batch.padding.paddingSizeLeft + batch.padding.paddingSizeRight;
+        outH += batch.padding.paddingSizeTop + batch.padding.paddingSizeBottom;
+    }
+
+    // DTC: out = (pixel - mean - min) * varReci
+    const AippDtcPara& dtc = batch.dtc;
+    plan.mean[0] = dtc.pixelMeanChn0 + dtc.pixelMinChn0;
+    plan.mean[1] = dtc.pixelMeanChn1 + dtc.pixelMinChn1;
+    plan.mean[2] = dtc.pixelMeanChn2 + dtc.pixelMinChn2;
+    plan.scale[0] = dtc.pixelVarReciChn0;
+    plan.scale[1] = dtc.pixelVarReciChn1;
+    plan.scale[2] = dtc.pixelVarReciChn2;
+    return true;
+}
+
+AIStatus CpuAippOutputShape(const CpuAippConfig& config, CpuAippShape& shape)
+{
+    if (config.batches.empty() || CpuAippInputImageSize(config) == 0) {
+        return AI_INVALID_PARA;
+    }
+    uint32_t outW = 0;
+    uint32_t outH = 0;
+    for (size_t b = 0; b < config.batches.size(); ++b) {
+        BatchPlan plan;
+        uint32_t w, h;
+        if (!PlanBatch(config, config.batches[b], plan, w, h)) {
+            return AI_INVALID_PARA;
+        }
+        if (b > 0 && (w != outW || h != outH)) {
+            return AI_INVALID_PARA;
+        }
+        outW = w;
+        outH = h;
+    }
+    shape.number = static_cast<uint32_t>(config.batches.size());
+    shape.channel = OutputChannels(config.inputFormat);
+    shape.height = outH;
+    shape.width = outW;
+    return AI_SUCCESS;
+}
+
+// Read pixels [x0, x0 + count) of source row y as three channels in memory
+// order, after channel swap and CSC, into float planes.
+class RowReader {
+public:
+    explicit RowReader(const CpuAippConfig& config) : config_(config) {}
+
+    void Read(const uint8_t* image, uint32_t y, uint32_t x0, uint32_t count, float* planes, uint32_t planeStride);
+
+private:
+    void Fetch(const uint8_t* image, uint32_t y, uint32_t x, int c[3]) const;
+
+    const CpuAippConfig& config_;
+};
+
+void RowReader::Fetch(const uint8_t* image, uint32_t y, uint32_t x, int c[3]) const
+{
+    const uint32_t w = config_.inputShape.srcImageSizeW;
+    const uint32_t h = config_.inputShape.srcImageSizeH;
+    const bool axSwap = config_.channelSwap.axSwapSwitch;
+    const uint8_t* px = nullptr;
+    switch (config_.inputFormat) {
+        case AiTensorImage_YUV420SP_U8: {
+            const uint8_t* uv = image + w * h + (y / 2) * w + (x & ~1u);
+            c[0] = image[y * w + x];
+            c[1] = uv[0];
+            c[2] = uv[1];
+            return;
+        }
+        case AiTensorImage_YUV422SP_U8: {
+            const uint8_t* uv = image + w * h + y * w + (x & ~1u);
+            c[0] = image[y * w + x];
+            c[1] = uv[0];
+            c[2] = uv[1];
+            return;
+        }
+        case AiTensorImage_YUV444SP_U8:
+        case AiTensorImage_YVU444SP_U8: {
+            const uint8_t* uv = image + w * h + (y * w + x) * 2;
+            c[0] = image[y * w + x];
+            c[1] = uv[0];
+            c[2] = uv[1];
+            return;
+        }
+        case AiTensorImage_YUYV_U8: {
+            const uint8_t* pair = image + y * w * 2 + (x & ~1u) * 2;
+            c[0] = pair[(x & 1u) * 2];
+            c[1] = pair[1];
+            c[2] = pair[3];
+            return;
+        }
+        case AiTensorImage_YUV400_U8:
+            c[0] = image[y * w + x];
+            c[1] = 0;
+            c[2] = 0;
+            return;
+        case AiTensorImage_XRGB8888_U8:
+        case AiTensorImage_ARGB8888_U8:
+        case AiTensorImage_AYUV444_U8:
+            // the alpha byte leads unless axSwap moved it to the end
+            px = image + (y * w + x) * 4 + (axSwap ? 0 : 1);
+            break;
+        default:
+            px = image + (y * w + x) * 3;
+            break;
+    }
+    c[0] = px[0];
+    c[1] = px[1];
+    c[2] = px[2];
+}
+
+void RowReader::Read(const uint8_t* image, uint32_t y, uint32_t x0, uint32_t count, float* planes,
+    uint32_t planeStride)
+{
+    const AippCscPara& csc = config_.csc;
+    const bool yuv = IsYuvFormat(config_.inputFormat);
+    const bool gray = config_.inputFormat == AiTensorImage_YUV400_U8;
+    const bool swap = config_.channelSwap.rbuvSwapSwitch && !gray;
+    float* p0 = planes;
+    float* p1 = planes + planeStride;
+    float* p2 = planes + 2 * planeStride;
+    for (uint32_t i = 0; i < count; ++i) {
+        int c[3];
+        Fetch(image, y, x0 + i, c);
+        if (swap) {
+            // R<->B for RGB images, U<->V for YUV images
+            if (yuv) {
+                std::swap(c[1], c[2]);
+            } else {
+                std::swap(c[0], c[2]);
+            }
+        }
+        if (gray) {
+            p0[i] = static_cast<float>(c[0]);
+            continue;
+        }
+        if (csc.switch_) {
+            const int v0 = c[0] - csc.inputBias0;
+            const int v1 = c[1] - csc.inputBias1;
+            const int v2 = c[2] - csc.inputBias2;
+            int o0 = ((csc.matrixR0C0 * v0 + csc.matrixR0C1 * v1 + csc.matrixR0C2 * v2) >> 8) + csc.outputBias0;
+            int o1 = ((csc.matrixR1C0 * v0 + csc.matrixR1C1 * v1 + csc.matrixR1C2 * v2) >> 8) + csc.outputBias1;
+            int o2 = ((csc.matrixR2C0 * v0 + csc.matrixR2C1 * v1 + csc.matrixR2C2 * v2) >> 8) + csc.outputBias2;
+            c[0] = std::min(std::max(o0, 0), 255);
+            c[1] = std::min(std::max(o1, 0), 255);
+            c[2] = std::min(std::max(o2, 0), 255);
+        }
+        p0[i] = static_cast<float>(c[0]);
+        p1[i] = static_cast<float>(c[1]);
+        p2[i] = static_cast<float>(c[2]);
+    }
+}
+
+// Processes a contiguous range of output rows of one batch, keeping the two
+// source rows of the previous output row around for the next one.
+class RowWorker {
+public:
+    RowWorker(const CpuAippConfig& config, uint32_t channels, uint32_t outW, uint32_t outH)
+        : reader_(config), channels_(channels), outW_(outW), outH_(outH) {}
+
+    void Run(const BatchPlan& plan, uint32_t rowBegin, uint32_t rowEnd);
+
+private:
+    void LoadRow(const BatchPlan& plan, uint32_t cropRow, float* dst);
+
+    RowReader reader_;
+    uint32_t channels_;
+    uint32_t outW_;
+    uint32_t outH_;
+    vector<float> source_;
+    vector<float> rows_;
+};
+
+void RowWorker::LoadRow(const BatchPlan& plan, uint32_t cropRow, float* dst)
+{
+    if (!plan.resize) {
+        reader_.Read(plan.image, plan.cropY + cropRow, plan.cropX, plan.cropW, dst, plan.innerW);
+        return;
+    }
+    reader_.Read(plan.image, plan.cropY + cropRow, plan.cropX, plan.cropW, source_.data(), plan.cropW);
+    for (uint32_t c = 0; c < channels_; ++c) {
+        const float* src = source_.data() + c * plan.cropW;
+        float* out = dst + c * plan.innerW;
+        for (uint32_t x = 0; x < plan.innerW; ++x) {
+            const AxisTap& tap = plan.xs[x];
+            out[x] = src[tap.i0] + tap.w * (src[tap.i1] - src[tap.i0]);
+        }
+    }
+}
+
+void RowWorker::Run(const BatchPlan& plan, uint32_t rowBegin, uint32_t rowEnd)
+{
+    source_.resize(3 * plan.cropW);
+    rows_.resize(6 * plan.innerW);
+    float* top = rows_.data();
+    float* bottom = top + 3 * plan.innerW;
+    int64_t topIndex = -1;
+    int64_t bottomIndex = -1;
+
+    const uint32_t planeSize = outW_ * outH_;
+    for (uint32_t y = rowBegin; y < rowEnd; ++y) {
+        if (y < plan.padTop || y >= plan.padTop + plan.innerH) {
+            for (uint32_t c = 0; c < channels_; ++c) {
+                std::fill_n(plan.output + c * planeSize + y * outW_, outW_, 0.0f);
+            }
+            continue;
+        }
+        const uint32_t iy = y - plan.padTop;
+        uint32_t i0 = iy;
+        uint32_t i1 = iy;
+        float wy = 0.0f;
+        if (plan.resize) {
+            i0 = plan.ys[iy].i0;
+            i1 = plan.ys[iy].i1;
+            wy = plan.ys[iy].w;
+        }
+        if (topIndex != i0) {
+            if (bottomIndex == i0) {
+                std::swap(top, bottom);
+                std::swap(topIndex, bottomIndex);
+            } else {
+                LoadRow(plan, i0, top);
+                topIndex = i0;
+            }
+        }
+        if (bottomIndex != i1) {
+            LoadRow(plan, i1, bottom);
+            bottomIndex = i1;
+        }
+        for (uint32_t c = 0; c < channels_; ++c) {
+            float* out = plan.output + c * planeSize + y * outW_;
+            std::fill_n(out, plan.padLeft, 0.0f);
+            BlendRowsNormalize(top + c * plan.innerW, bottom + c * plan.innerW, wy, plan.mean[c], plan.scale[c],
+                out + plan.padLeft, plan.innerW);
+            std::fill(out + plan.padLeft + plan.innerW, out + outW_, 0.0f);
+        }
+    }
+}
+
+AIStatus RunCpuAipp(const CpuAippConfig& config, const uint8_t* input, uint32_t inputSize,
+    float* output, uint32_t outputSize, uint32_t threadCount)
+{
+    if (input == nullptr || output == nullptr) {
+        return AI_INVALID_POINTER;
+    }
+    CpuAippShape shape;
+    if (CpuAippOutputShape(config, shape) != AI_SUCCESS) {
+        return AI_INVALID_PARA;
+    }
+    const uint32_t batchCount = shape.number;
+    const uint32_t channels = shape.channel;
+    const uint32_t outH = shape.height;
+    const uint32_t outW = shape.width;
+    const uint32_t imageSize = CpuAippInputImageSize(config);
+    if (static_cast<uint64_t>(imageSize) * batchCount > inputSize ||
+        static_cast<uint64_t>(batchCount) * channels * outH * outW * sizeof(float) > outputSize) {
+        return AI_INVALID_PARA;
+    }
+
+    vector<BatchPlan> plans(batchCount);
+    for (uint32_t b = 0; b < batchCount; ++b) {
+        uint32_t w, h;
+        PlanBatch(config, config.batches[b], plans[b], w, h);
+        plans[b].image = input + static_cast<size_t>(b) * imageSize;
+        plans[b].output = output + static_cast<size_t>(b) * channels * outH * outW;
+    }
+
+    // split all (batch, row) pairs into contiguous chunks over the shared pool
+    const uint32_t totalRows = batchCount * outH;
+    const uint32_t minRowsPerChunk = 16;
+
+    auto runChunk = [&](uint32_t first, uint32_t last) {
+        RowWorker worker(config, channels, outW, outH);
+        while (first < last) {
+            const uint32_t b = first / outH;
+            const uint32_t rowBegin = first % outH;
+            const uint32_t rowEnd = std::min(outH, rowBegin + (last - first));
+            worker.Run(plans[b], rowBegin, rowEnd);
+            first += rowEnd - rowBegin;
+        }
+    };
+
+    if (threadCount == 1) {
+        runChunk(0, totalRows);
+    } else {
+        ParallelFor(TaskPool::Shared(), totalRows, minRowsPerChunk, runChunk, threadCount);
+    }
+    return AI_SUCCESS;
+}
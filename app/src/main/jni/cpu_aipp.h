@@ -0,0 +1,91 @@
+/*
+ * @file cpu_aipp.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_CPU_AIPP_H
+#define HIAI_DEMO_CPU_AIPP_H
+
+#include <cstdint>
+#include <vector>
+#include "HiAiAippPara.h"
+
+/* AIPP parameters that can differ per batch */
+struct CpuAippBatchConfig {
+    hiai::AippCropPara crop;
+    hiai::AippResizePara resize;
+    hiai::AippPaddingPara padding;
+    hiai::AippDtcPara dtc;
+};
+
+/*
+ * Plain copy of an AippPara. Unlike AippPara it does not need libhiai, so the
+ * same preprocessing definition can run on the NPU, on the CPU, or on a host.
+ */
+struct CpuAippConfig {
+    hiai::AippInputShape inputShape;
+    hiai::AiTensorImage_Format inputFormat = hiai::AiTensorImage_YUV420SP_U8;
+    hiai::AippCscPara csc;
+    hiai::AippChannelSwapPara channelSwap;
+    std::vector<CpuAippBatchConfig> batches;
+};
+
+/*
+* @brief Copy the configuration of a DDK AippPara
+* @param [in] para AIPP parameters, e.g. from GetModelAippPara
+* @param [out] config plain configuration
+* @return AIStatus::AI_SUCCESS on success, AI_INVALID_PARA otherwise
+*/
+hiai::AIStatus CpuAippConfigFromPara(hiai::AippPara& para, CpuAippConfig& config);
+
+/*
+* @brief Write a configuration into a DDK AippPara, for dynamic AIPP on the NPU.
+*        CSC is not copied, the caller sets it with AippPara::SetCscPara.
+* @param [in] config plain configuration
+* @param [out] para AippPara, already Init()ed with config.batches.size()
+* @return AIStatus::AI_SUCCESS on success, the failing setter status otherwise
+*/
+hiai::AIStatus CpuAippConfigToPara(const CpuAippConfig& config, hiai::AippPara& para);
+
+/*
+* @brief Size in bytes of one input image of the configured format and shape
+* @return 0 if the format is not supported
+*/
+uint32_t CpuAippInputImageSize(const CpuAippConfig& config);
+
+/* NCHW shape of the AIPP output. TensorDimension is not used as it lives in libhiai. */
+struct CpuAippShape {
+    uint32_t number = 0;
+    uint32_t channel = 0;
+    uint32_t height = 0;
+    uint32_t width = 0;
+};
+
+/*
+* @brief Output shape produced by the configuration. All batches must
+*        produce the same channel, height and width.
+* @return AIStatus::AI_SUCCESS on success, AI_INVALID_PARA otherwise
+*/
+hiai::AIStatus CpuAippOutputShape(const CpuAippConfig& config, CpuAippShape& shape);
+
+/*
+* @brief Run crop, channel swap, CSC, resize, DTC and padding on the CPU, in
+*        the order the NPU AIPP applies them, producing float NCHW output.
+* @param [in] config AIPP configuration
+* @param [in] input batches.size() images of CpuAippInputImageSize bytes
+* @param [in] inputSize size of input in bytes
+* @param [out] output tensor of CpuAippOutputShape
+* @param [in] outputSize size of output in bytes
+* @param [in] threadCount threads processing rows at once, on the shared task pool;
+*                         0 uses every worker, 1 runs on the calling thread only
+* @return AIStatus::AI_SUCCESS on success, AI_INVALID_PARA or AI_INVALID_POINTER otherwise
+*/
+hiai::AIStatus RunCpuAipp(const CpuAippConfig& config, const uint8_t* input, uint32_t inputSize,
+    float* output, uint32_t outputSize, uint32_t threadCount = 0);
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * @file cpu_aipp_para.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+// Conversions between CpuAippConfig and the DDK AippPara. Kept apart from
+// cpu_aipp.cpp because these are the only parts that need libhiai.
+
+#include "cpu_aipp.h"
+
+using namespace hiai;
+
+AIStatus CpuAippConfigFromPara(AippPara& para, CpuAippConfig& config)
+{
+    uint32_t batchCount = para.GetBatchCount();
+    if (batchCount == 0) {
+        return AI_INVALID_PARA;
+    }
+    config.inputShape = para.GetInputShape();
+    config.inputFormat = para.GetInputFormat();
+    config.csc = para.GetCscPara();
+    config.channelSwap = para.GetChannelSwapPara();
+    config.batches.resize(batchCount);
+    for (uint32_t i = 0; i < batchCount; ++i) {
+        config.batches[i].crop = para.GetCropPara(i);
+        config.batches[i].resize = para.GetResizePara(i);
+        config.batches[i].padding = para.GetPaddingPara(i);
+        config.batches[i].dtc = para.GetDtcPara(i);
+    }
+    return AI_SUCCESS;
+}
+
+AIStatus CpuAippConfigToPara(const CpuAippConfig& config, AippPara& para)
+{
+    if (para.GetBatchCount() != config.batches.size()) {
+        return AI_INVALID_PARA;
+    }
+    AIStatus ret = para.SetInputShape(config.inputShape);
+    if (ret != AI_SUCCESS) {
+        return ret;
+    }
+    ret = para.SetInputFormat(config.inputFormat);
+    if (ret != AI_SUCCESS) {
+        return ret;
+    }
+    ret = para.SetChannelSwapPara(config.channelSwap);
+    if (ret != AI_SUCCESS) {
+        return ret;
+    }
+    // CSC is not copied: AippPara only accepts it as SetCscPara(targetFormat,
+    // imageType) and fills the matrix itself.
+    for (uint32_t i = 0; i < config.batches.size(); ++i) {
+        const CpuAippBatchConfig& batch = config.batches[i];
+        if (batch.crop.switch_ && (ret = para.SetCropPara(i, batch.crop)) != AI_SUCCESS) {
+            return ret;
+        }
+        if (batch.resize.switch_ && (ret = para.SetResizePara(i, batch.resize)) != AI_SUCCESS) {
+            return ret;
+        }
+        if (batch.padding.switch_ && (ret = para.SetPaddingPara(i, batch.padding)) != AI_SUCCESS) {
+            return ret;
+        }
+        if ((ret = para.SetDtcPara(i, batch.dtc)) != AI_SUCCESS) {
+            return ret;
+        }
+    }
+    return AI_SUCCESS;
+}
@@ -0,0 +1,156 @@
+/*
+ * @file dynamic_aipp.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "dynamic_aipp.h"
+
+#include <cmath>
+#include <vector>
+#include <android/log.h>
+
+#define LOG_TAG "AIPP_DDK_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+using namespace hiai;
+
+bool IsDynamicAippSupported(AiModelMngerClient& client)
+{
+    const char* version = client.GetVersion();
+    if (version == nullptr) {
+        LOGE("[HIAI_DEMO_AIPP] GetVersion failed.");
+        return false;
+    }
+    LOGI("[HIAI_DEMO_AIPP] ddk version : %s", version);
+    return string(version) >= AIPP_BASE_VERSION;
+}
+
+bool HasModelAippPara(AiModelMngerClient& client, const string& modelName, uint32_t inputIndex)
+{
+    vector<shared_ptr<AippPara>> aippParas;
+    AIStatus ret = client.GetModelAippPara(modelName, inputIndex, aippParas);
+    if (ret != AI_SUCCESS) {
+        LOGE("[HIAI_DEMO_AIPP] GetModelAippPara %s input %u failed, ret=%d.", modelName.c_str(), inputIndex, ret);
+        return false;
+    }
+    return !aippParas.empty();
+}
+
+// YUV to RGB888 with 8 fractional bits, rows R, G, B; the same matrices the
+// DDK picks in SetCscPara(AiTensorImage_RGB888_U8, imageType).
+static void SetYuvToRgbCsc(ImageType imageType, AippCscPara& csc)
+{
+    csc.switch_ = true;
+    csc.inputBias0 = 16;
+    csc.inputBias1 = 128;
+    csc.inputBias2 = 128;
+    switch (imageType) {
+        case JPEG:
+        case BT_601_FULL:
+            csc.inputBias0 = 0;
+            csc.matrixR0C0 = 256; csc.matrixR0C1 = 0; csc.matrixR0C2 = 359;
+            csc.matrixR1C0 = 256; csc.matrixR1C1 = -88; csc.matrixR1C2 = -183;
+            csc.matrixR2C0 = 256; csc.matrixR2C1 = 454; csc.matrixR2C2 = 0;
+            break;
+        case BT_709_NARROW:
+            csc.matrixR0C0 = 298; csc.matrixR0C1 = 0; csc.matrixR0C2 = 460;
+            csc.matrixR1C0 = 298; csc.matrixR1C1 = -55; csc.matrixR1C2 = -137;
+            csc.matrixR2C0 = 298; csc.matrixR2C1 = 541; csc.matrixR2C2 = 0;
+            break;
+        default:
+            csc.matrixR0C0 = 298; csc.matrixR0C1 = 0; csc.matrixR0C2 = 409;
+            csc.matrixR1C0 = 298; csc.matrixR1C1 = -100; csc.matrixR1C2 = -208;
+            csc.matrixR2C0 = 298; csc.matrixR2C1 = 516; csc.matrixR2C2 = 0;
+            break;
+    }
+}
+
+AIStatus BuildDynamicAippConfig(const DynamicAippRequest& request, uint32_t dstW, uint32_t dstH,
+    CpuAippConfig& config)
+{
+    if (request.frameW == 0 || request.frameH == 0 || (request.frameW & 1) != 0 || (request.frameH & 1) != 0 ||
+        dstW == 0 || dstH == 0) {
+        return AI_INVALID_PARA;
+    }
+    config.inputShape.srcImageSizeW = request.frameW;
+    config.inputShape.srcImageSizeH = request.frameH;
+    config.inputFormat = AiTensorImage_YUV420SP_U8;
+    config.csc = AippCscPara();
+    SetYuvToRgbCsc(request.imageType, config.csc);
+    config.channelSwap = AippChannelSwapPara();
+    config.channelSwap.rbuvSwapSwitch = request.nv21;
+
+    CpuAippBatchConfig batch;
+    uint32_t cropW = request.frameW;
+    uint32_t cropH = request.frameH;
+    if (request.crop.switch_) {
+        // YUV420SP crops start on even pixels
+        batch.crop = request.crop;
+        batch.crop.cropStartPosW &= ~1u;
+        batch.crop.cropStartPosH &= ~1u;
+        if (batch.crop.cropSizeW == 0 || batch.crop.cropSizeH == 0 ||
+            batch.crop.cropStartPosW + batch.crop.cropSizeW > request.frameW ||
+            batch.crop.cropStartPosH + batch.crop.cropSizeH > request.frameH) {
+            return AI_INVALID_PARA;
+        }
+        cropW = batch.crop.cropSizeW;
+        cropH = batch.crop.cropSizeH;
+    }
+    if (cropW != dstW || cropH != dstH) {
+        batch.resize.switch_ = true;
+        batch.resize.resizeOutputSizeW = dstW;
+        batch.resize.resizeOutputSizeH = dstH;
+    }
+
+    // the DTC mean is an integer, the fraction goes to the min
+    const float* mean = request.mean;
+    batch.dtc.pixelMeanChn0 = static_cast<int16_t>(lround(mean[0]));
+    batch.dtc.pixelMeanChn1 = static_cast<int16_t>(lround(mean[1]));
+    batch.dtc.pixelMeanChn2 = static_cast<int16_t>(lround(mean[2]));
+    batch.dtc.pixelMinChn0 = mean[0] - batch.dtc.pixelMeanChn0;
+    batch.dtc.pixelMinChn1 = mean[1] - batch.dtc.pixelMeanChn1;
+    batch.dtc.pixelMinChn2 = mean[2] - batch.dtc.pixelMeanChn2;
+    batch.dtc.pixelVarReciChn0 = request.varReci[0];
+    batch.dtc.pixelVarReciChn1 = request.varReci[1];
+    batch.dtc.pixelVarReciChn2 = request.varReci[2];
+
+    config.batches.assign(1, batch);
+    return AI_SUCCESS;
+}
+
+shared_ptr<AippTensor> CreateDynamicAippTensor(shared_ptr<AiTensor> frame, const CpuAippConfig& config,
+    ImageType imageType, uint32_t inputIndex)
+{
+    shared_ptr<AippPara> para = make_shared<AippPara>();
+    AIStatus ret = para->Init(static_cast<uint32_t>(config.batches.size()));
+    if (ret != AI_SUCCESS) {
+        LOGE("[HIAI_DEMO_AIPP] AippPara Init failed, ret=%d.", ret);
+        return nullptr;
+    }
+    ret = para->SetInputIndex(inputIndex);
+    if (ret != AI_SUCCESS) {
+        LOGE("[HIAI_DEMO_AIPP] SetInputIndex failed, ret=%d.", ret);
+        return nullptr;
+    }
+    ret = CpuAippConfigToPara(config, *para);
+    if (ret != AI_SUCCESS) {
+        LOGE("[HIAI_DEMO_AIPP] set AIPP parameters failed, ret=%d.", ret);
+        return nullptr;
+    }
+    ret = para->SetCscPara(AiTensorImage_RGB888_U8, imageType);
+    if (ret != AI_SUCCESS) {
+        LOGE("[HIAI_DEMO_AIPP] SetCscPara failed, ret=%d.", ret);
+        return nullptr;
+    }
+    vector<shared_ptr<AippPara>> paras;
+    paras.push_back(para);
+    return make_shared<AippTensor>(frame, paras);
+}
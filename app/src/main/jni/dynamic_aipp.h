@@ -0,0 +1,66 @@
+/*
+ * @file dynamic_aipp.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_DYNAMIC_AIPP_H
+#define HIAI_DEMO_DYNAMIC_AIPP_H
+
+#include <memory>
+#include <string>
+#include "HiAiModelManagerService.h"
+#include "cpu_aipp.h"
+
+/* Preprocessing of one YUV420SP camera frame into an RGB model input */
+struct DynamicAippRequest {
+    uint32_t frameW = 0;
+    uint32_t frameH = 0;
+    hiai::AippCropPara crop;    // switch_ off: use the whole frame
+    hiai::ImageType imageType = hiai::BT_601_NARROW;
+    bool nv21 = false;
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    float varReci[3] = { 1.0f, 1.0f, 1.0f };
+};
+
+/*
+* @brief Check that the DDK is new enough (AIPP_BASE_VERSION) for AippTensor
+* @param [in] client initialized model manager client
+* @return true if dynamic AIPP can be used
+*/
+bool IsDynamicAippSupported(hiai::AiModelMngerClient& client);
+
+/*
+* @brief Check that an input of a loaded model is configured for AIPP
+* @param [in] client client the model is loaded into
+* @param [in] modelName model name including ".om"
+* @param [in] inputIndex model input
+* @return true if GetModelAippPara reports AIPP parameters for the input
+*/
+bool HasModelAippPara(hiai::AiModelMngerClient& client, const std::string& modelName, uint32_t inputIndex);
+
+/*
+* @brief Map a request onto a dstW x dstH model input: crop, resize and DTC,
+*        with the CSC filled for the CPU engine (YUV to RGB888).
+* @return AIStatus::AI_SUCCESS on success, AI_INVALID_PARA otherwise
+*/
+hiai::AIStatus BuildDynamicAippConfig(const DynamicAippRequest& request, uint32_t dstW, uint32_t dstH,
+    CpuAippConfig& config);
+
+/*
+* @brief Wrap a YUV420SP frame tensor with per-request AIPP parameters, so the
+*        NPU does crop, CSC, resize and DTC.
+* @param [in] frame tensor holding the camera frame
+* @param [in] config configuration from BuildDynamicAippConfig
+* @param [in] imageType colour matrix used for SetCscPara
+* @param [in] inputIndex model input the parameters apply to
+* @return the AippTensor, nullptr if a parameter is rejected by the DDK
+*/
+std::shared_ptr<hiai::AippTensor> CreateDynamicAippTensor(std::shared_ptr<hiai::AiTensor> frame,
+    const CpuAippConfig& config, hiai::ImageType imageType, uint32_t inputIndex);
+
+#endif
@@ -0,0 +1,454 @@
+/*
+ * @file image_preprocess.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "image_preprocess.h"
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HIAI_DEMO_NEON
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define HIAI_DEMO_AVX2
+#define HIAI_DEMO_SSE2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define HIAI_DEMO_SSE2
+#endif
+
+static inline void PackRowRef(const uint8_t* src, uint32_t width, const float mean[3],
+    float* bDst, float* gDst, float* rDst)
+{
+    for (uint32_t x = 0; x < width; ++x) {
+        const uint8_t* px = src + x * 4;
+        bDst[x] = static_cast<float>(px[2]) - mean[0];
+        gDst[x] = static_cast<float>(px[1]) - mean[1];
+        rDst[x] = static_cast<float>(px[0]) - mean[2];
+    }
+}
+
+void PackRgbaToBgrPlanesRef(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t stride,
+    const float mean[3], float* dst)
+{
+    const uint32_t planeSize = width * height;
+    for (uint32_t y = 0; y < height; ++y) {
+        float* bDst = dst + y * width;
+        PackRowRef(rgba + y * stride, width, mean, bDst, bDst + planeSize, bDst + 2 * planeSize);
+    }
+}
+
+static void PackRow(const uint8_t* src, uint32_t width, const float mean[3],
+    float* bDst, float* gDst, float* rDst)
+{
+    uint32_t x = 0;
+#if defined(HIAI_DEMO_NEON)
+    const float32x4_t bMean = vdupq_n_f32(mean[0]);
+    const float32x4_t gMean = vdupq_n_f32(mean[1]);
+    const float32x4_t rMean = vdupq_n_f32(mean[2]);
+    for (; x + 8 <= width; x += 8) {
+        uint8x8x4_t px = vld4_u8(src + x * 4);
+        uint16x8_t r = vmovl_u8(px.val[0]);
+        uint16x8_t g = vmovl_u8(px.val[1]);
+        uint16x8_t b = vmovl_u8(px.val[2]);
+        vst1q_f32(bDst + x, vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(b))), bMean));
+        vst1q_f32(bDst + x + 4, vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(b))), bMean));
+        vst1q_f32(gDst + x, vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(g))), gMean));
+        vst1q_f32(gDst + x + 4, vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(g))), gMean));
+        vst1q_f32(rDst + x, vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(r))), rMean));
+        vst1q_f32(rDst + x + 4, vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(r))), rMean));
+    }
+#elif defined(HIAI_DEMO_AVX2)
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    const __m256 bMean = _mm256_set1_ps(mean[0]);
+    const __m256 gMean = _mm256_set1_ps(mean[1]);
+    const __m256 rMean = _mm256_set1_ps(mean[2]);
+    for (; x + 8 <= width; x += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+        __m256i r = _mm256_and_si256(px, mask);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi32(px, 8), mask);
+        __m256i b = _mm256_and_si256(_mm256_srli_epi32(px, 16), mask);
+        _mm256_storeu_ps(bDst + x, _mm256_sub_ps(_mm256_cvtepi32_ps(b), bMean));
+        _mm256_storeu_ps(gDst + x, _mm256_sub_ps(_mm256_cvtepi32_ps(g), gMean));
+        _mm256_storeu_ps(rDst + x, _mm256_sub_ps(_mm256_cvtepi32_ps(r), rMean));
+    }
+#elif defined(HIAI_DEMO_SSE2)
+    const __m128i mask = _mm_set1_epi32(0xff);
+    const __m128 bMean = _mm_set1_ps(mean[0]);
+    const __m128 gMean = _mm_set1_ps(mean[1]);
+    const __m128 rMean = _mm_set1_ps(mean[2]);
+    for (; x + 4 <= width; x += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+        __m128i r = _mm_and_si128(px, mask);
+        __m128i g = _mm_and_si128(_mm_srli_epi32(px, 8), mask);
+        __m128i b = _mm_and_si128(_mm_srli_epi32(px, 16), mask);
+        _mm_storeu_ps(bDst + x, _mm_sub_ps(_mm_cvtepi32_ps(b), bMean));
+        _mm_storeu_ps(gDst + x, _mm_sub_ps(_mm_cvtepi32_ps(g), gMean));
+        _mm_storeu_ps(rDst + x, _mm_sub_ps(_mm_cvtepi32_ps(r), rMean));
+    }
+#endif
+    // tail (and the whole row on targets without SIMD)
+    PackRowRef(src + x * 4, width - x, mean, bDst + x, gDst + x, rDst + x);
+}
+
+void PackRgbaToBgrPlanes(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t stride,
+    const float mean[3], float* dst)
+{
+    PackRgbaToBgrPlanesRows(rgba, width, height, stride, mean, 0, height, dst);
+}
+
+void PackRgbaToBgrPlanesRows(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t stride,
+    const float mean[3], uint32_t rowBegin, uint32_t rowEnd, float* dst)
+{
+    const uint32_t planeSize = width * height;
+    for (uint32_t y = rowBegin; y < rowEnd; ++y) {
+        float* bDst = dst + y * width;
+        PackRow(rgba + y * stride, width, mean, bDst, bDst + planeSize, bDst + 2 * planeSize);
+    }
+}
+
+// Integer RGB->YUV matrices. Y = ((yr*R + yg*G + yb*B + 128) >> 8) + yOff and
+// U/V = ((c0*R + c1*G + c2*B + rounding) >> cShift) + 128. Every partial sum
+// fits in 16 bits, so the SIMD paths can work on int16 lanes.
+struct YuvCoeff {
+    int16_t yr, yg, yb, yOff;
+    int16_t ur, ug, ub;
+    int16_t vr, vg, vb;
+    int16_t cShift;
+};
+
+// BT.601 narrow range, same numbers as Untils.encodeYUV420SP
+static const YuvCoeff BT601_NARROW_COEFF = { 66, 129, 25, 16, -38, -74, 112, 112, -94, -18, 8 };
+// BT.601 full range, chroma in 1/128 steps to stay within int16
+static const YuvCoeff BT601_FULL_COEFF = { 77, 150, 29, 0, -22, -42, 64, 64, -54, -10, 7 };
+static const YuvCoeff BT709_NARROW_COEFF = { 47, 157, 16, 16, -26, -86, 112, 112, -102, -10, 8 };
+
+static const YuvCoeff& GetYuvCoeff(hiai::ImageType type)
+{
+    switch (type) {
+        case hiai::BT_601_NARROW:
+            return BT601_NARROW_COEFF;
+        case hiai::BT_709_NARROW:
+            return BT709_NARROW_COEFF;
+        case hiai::BT_601_FULL:
+        case hiai::JPEG:
+        default:
+            return BT601_FULL_COEFF;
+    }
+}
+
+static inline uint8_t ClampU8(int v)
+{
+    return static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static inline void YuvRowRef(const uint8_t* src, uint32_t width, const YuvCoeff& k, bool nv21,
+    uint8_t* yDst, uint8_t* uvDst)
+{
+    const int rnd = 1 << (k.cShift - 1);
+    for (uint32_t x = 0; x < width; ++x) {
+        const int r = src[x * 4];
+        const int g = src[x * 4 + 1];
+        const int b = src[x * 4 + 2];
+        yDst[x] = ClampU8(((k.yr * r + k.yg * g + k.yb * b + 128) >> 8) + k.yOff);
+        if (uvDst != nullptr && (x & 1) == 0) {
+            uint8_t u = ClampU8(((k.ur * r + k.ug * g + k.ub * b + rnd) >> k.cShift) + 128);
+            uint8_t v = ClampU8(((k.vr * r + k.vg * g + k.vb * b + rnd) >> k.cShift) + 128);
+            uvDst[x] = nv21 ? v : u;
+            uvDst[x + 1] = nv21 ? u : v;
+        }
+    }
+}
+
+void RgbaToYuv420spRef(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t stride,
+    hiai::ImageType type, bool nv21, uint8_t* dst)
+{
+    const YuvCoeff& k = GetYuvCoeff(type);
+    uint8_t* uvPlane = dst + width * height;
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t* uvDst = (y & 1) == 0 ? uvPlane + (y / 2) * width : nullptr;
+        YuvRowRef(rgba + y * stride, width, k, nv21, dst + y * width, uvDst);
+    }
+}
+
+static void YuvRow(const uint8_t* src, uint32_t width, const YuvCoeff& k, bool nv21,
+    uint8_t* yDst, uint8_t* uvDst)
+{
+    uint32_t x = 0;
+    const int16_t rnd = static_cast<int16_t>(1 << (k.cShift - 1));
+#if defined(HIAI_DEMO_NEON)
+    const int16x8_t cShift = vdupq_n_s16(static_cast<int16_t>(-k.cShift));
+    for (; x + 8 <= width; x += 8) {
+        uint8x8x4_t px = vld4_u8(src + x * 4);
+        uint16x8_t r = vmovl_u8(px.val[0]);
+        uint16x8_t g = vmovl_u8(px.val[1]);
+        uint16x8_t b = vmovl_u8(px.val[2]);
+        uint16x8_t yv = vmulq_n_u16(r, k.yr);
+        yv = vmlaq_n_u16(yv, g, k.yg);
+        yv = vmlaq_n_u16(yv, b, k.yb);
+        yv = vshrq_n_u16(vaddq_u16(yv, vdupq_n_u16(128)), 8);
+        yv = vaddq_u16(yv, vdupq_n_u16(k.yOff));
+        vst1_u8(yDst + x, vqmovn_u16(yv));
+        if (uvDst == nullptr) {
+            continue;
+        }
+        int16x8_t rs = vreinterpretq_s16_u16(r);
+        int16x8_t gs = vreinterpretq_s16_u16(g);
+        int16x8_t bs = vreinterpretq_s16_u16(b);
+        int16x8_t u = vmlaq_n_s16(vmlaq_n_s16(vmulq_n_s16(rs, k.ur), gs, k.ug), bs, k.ub);
+        int16x8_t v = vmlaq_n_s16(vmlaq_n_s16(vmulq_n_s16(rs, k.vr), gs, k.vg), bs, k.vb);
+        u = vaddq_s16(vshlq_s16(vaddq_s16(u, vdupq_n_s16(rnd)), cShift), vdupq_n_s16(128));
+        v = vaddq_s16(vshlq_s16(vaddq_s16(v, vdupq_n_s16(rnd)), cShift), vdupq_n_s16(128));
+        // keep the even lanes: low half of each 32-bit word takes the first
+        // chroma sample, high half the second
+        int16x8_t first = nv21 ? v : u;
+        int16x8_t second = nv21 ? u : v;
+        uint32x4_t uv = vsliq_n_u32(vreinterpretq_u32_s16(first), vreinterpretq_u32_s16(second), 16);
+        vst1_u8(uvDst + x, vqmovun_s16(vreinterpretq_s16_u32(uv)));
+    }
+#elif defined(HIAI_DEMO_SSE2)
+    const __m128i mask = _mm_set1_epi32(0xff);
+    const __m128i lowHalf = _mm_set1_epi32(0xffff);
+    const __m128i cShift = _mm_cvtsi32_si128(k.cShift);
+    for (; x + 8 <= width; x += 8) {
+        __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+        __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4 + 16));
+        __m128i r = _mm_packs_epi32(_mm_and_si128(p0, mask), _mm_and_si128(p1, mask));
+        __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), mask),
+            _mm_and_si128(_mm_srli_epi32(p1, 8), mask));
+        __m128i b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), mask),
+            _mm_and_si128(_mm_srli_epi32(p1, 16), mask));
+        __m128i yv = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(k.yr)), _mm_mullo_epi16(g, _mm_set1_epi16(k.yg)));
+        yv = _mm_add_epi16(yv, _mm_mullo_epi16(b, _mm_set1_epi16(k.yb)));
+        yv = _mm_srli_epi16(_mm_add_epi16(yv, _mm_set1_epi16(128)), 8);
+        yv = _mm_add_epi16(yv, _mm_set1_epi16(k.yOff));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(yDst + x), _mm_packus_epi16(yv, yv));
+        if (uvDst == nullptr) {
+            continue;
+        }
+        __m128i u = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(k.ur)), _mm_mullo_epi16(g, _mm_set1_epi16(k.ug)));
+        u = _mm_add_epi16(u, _mm_mullo_epi16(b, _mm_set1_epi16(k.ub)));
+        __m128i v = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(k.vr)), _mm_mullo_epi16(g, _mm_set1_epi16(k.vg)));
+        v = _mm_add_epi16(v, _mm_mullo_epi16(b, _mm_set1_epi16(k.vb)));
+        u = _mm_add_epi16(_mm_sra_epi16(_mm_add_epi16(u, _mm_set1_epi16(rnd)), cShift), _mm_set1_epi16(128));
+        v = _mm_add_epi16(_mm_sra_epi16(_mm_add_epi16(v, _mm_set1_epi16(rnd)), cShift), _mm_set1_epi16(128));
+        __m128i first = nv21 ? v : u;
+        __m128i second = nv21 ? u : v;
+        __m128i uv = _mm_or_si128(_mm_and_si128(first, lowHalf), _mm_slli_epi32(second, 16));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(uvDst + x), _mm_packus_epi16(uv, uv));
+    }
+#endif
+    YuvRowRef(src + x * 4, width - x, k, nv21, yDst + x, uvDst == nullptr ? nullptr : uvDst + x);
+}
+
+void RgbaToYuv420sp(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t stride,
+    hiai::ImageType type, bool nv21, uint8_t* dst)
+{
+    RgbaToYuv420spRows(rgba, width, height, stride, type, nv21, 0, height, dst);
+}
+
+void RgbaToYuv420spRows(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t stride,
+    hiai::ImageType type, bool nv21, uint32_t rowBegin, uint32_t rowEnd, uint8_t* dst)
+{
+    const YuvCoeff& k = GetYuvCoeff(type);
+    uint8_t* uvPlane = dst + width * height;
+    for (uint32_t y = rowBegin; y < rowEnd; ++y) {
+        uint8_t* uvDst = (y & 1) == 0 ? uvPlane + (y / 2) * width : nullptr;
+        YuvRow(rgba + y * stride, width, k, nv21, dst + y * width, uvDst);
+    }
+}
+
+void BlendRowsNormalize(const float* r0, const float* r1, float wy, float mean, float scale,
+    float* dst, uint32_t count)
+{
+    uint32_t i = 0;
+#if defined(HIAI_DEMO_NEON)
+    const float32x4_t vMean = vdupq_n_f32(mean);
+    const float32x4_t vScale = vdupq_n_f32(scale);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t a = vld1q_f32(r0 + i);
+        float32x4_t d = vsubq_f32(vld1q_f32(r1 + i), a);
+        float32x4_t v = vaddq_f32(a, vmulq_n_f32(d, wy));
+        vst1q_f32(dst + i, vmulq_f32(vsubq_f32(v, vMean), vScale));
+    }
+#elif defined(HIAI_DEMO_AVX2)
+    const __m256 vWy = _mm256_set1_ps(wy);
+    const __m256 vMean = _mm256_set1_ps(mean);
+    const __m256 vScale = _mm256_set1_ps(scale);
+    for (; i + 8 <= count; i += 8) {
+        __m256 a = _mm256_loadu_ps(r0 + i);
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(r1 + i), a);
+        __m256 v = _mm256_add_ps(a, _mm256_mul_ps(d, vWy));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_sub_ps(v, vMean), vScale));
+    }
+#elif defined(HIAI_DEMO_SSE2)
+    const __m128 vWy = _mm_set1_ps(wy);
+    const __m128 vMean = _mm_set1_ps(mean);
+    const __m128 vScale = _mm_set1_ps(scale);
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(r0 + i);
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(r1 + i), a);
+        __m128 v = _mm_add_ps(a, _mm_mul_ps(d, vWy));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_sub_ps(v, vMean), vScale));
+    }
+#endif
+    for (; i < count; ++i) {
+        float v = r0[i] + wy * (r1[i] - r0[i]);
+        dst[i] = (v - mean) * scale;
+    }
+}
+
+void BuildAxis(uint32_t srcLen, float cropStart, float cropLen, uint32_t dstLen, std::vector<AxisTap>& taps)
+{
+    taps.resize(dstLen);
+    const float ratio = cropLen / dstLen;
+    for (uint32_t d = 0; d < dstLen; ++d) {
+        float f = (d + 0.5f) * ratio - 0.5f + cropStart;
+        if (f < 0.0f) {
+            f = 0.0f;
+        }
+        uint32_t i0 = static_cast<uint32_t>(f);
+        float w = f - i0;
+        if (i0 >= srcLen - 1) {
+            i0 = srcLen - 1;
+            w = 0.0f;
+        }
+        taps[d].i0 = i0;
+        taps[d].i1 = i0 + 1 < srcLen ? i0 + 1 : i0;
+        taps[d].w = w;
+    }
+}
+
+// Center crop with the aspect ratio of the destination, as ThumbnailUtils.extractThumbnail does.
+static void CenterCrop(uint32_t srcW, uint32_t srcH, uint32_t dstW, uint32_t dstH,
+    float& cropX, float& cropY, float& cropW, float& cropH)
+{
+    if (static_cast<uint64_t>(srcW) * dstH > static_cast<uint64_t>(srcH) * dstW) {
+        cropH = static_cast<float>(srcH);
+        cropW = cropH * dstW / dstH;
+    } else {
+        cropW = static_cast<float>(srcW);
+        cropH = cropW * dstH / dstW;
+    }
+    cropX = (srcW - cropW) * 0.5f;
+    cropY = (srcH - cropH) * 0.5f;
+}
+
+static inline void PlaneChannels(bool bgr, uint32_t channels[3])
+{
+    channels[0] = bgr ? 2 : 0;
+    channels[1] = 1;
+    channels[2] = bgr ? 0 : 2;
+}
+
+// Horizontal pass of one source row into three float rows, one per output plane.
+static void ResizeRowHorizontal(const uint8_t* row, const std::vector<AxisTap>& xs, const uint32_t channels[3],
+    float* out)
+{
+    const uint32_t dstW = static_cast<uint32_t>(xs.size());
+    for (uint32_t p = 0; p < 3; ++p) {
+        const uint8_t* src = row + channels[p];
+        float* dst = out + p * dstW;
+        for (uint32_t x = 0; x < dstW; ++x) {
+            float a = src[xs[x].i0 * 4];
+            float b = src[xs[x].i1 * 4];
+            dst[x] = a + xs[x].w * (b - a);
+        }
+    }
+}
+
+void CropResizeNormalize(const uint8_t* rgba, uint32_t srcW, uint32_t srcH, uint32_t stride,
+    uint32_t dstW, uint32_t dstH, const NormalizeSpec& spec, float* dst)
+{
+    CropResizeNormalizeRows(rgba, srcW, srcH, stride, dstW, dstH, spec, 0, dstH, dst);
+}
+
+void CropResizeNormalizeRows(const uint8_t* rgba, uint32_t srcW, uint32_t srcH, uint32_t stride,
+    uint32_t dstW, uint32_t dstH, const NormalizeSpec& spec, uint32_t rowBegin, uint32_t rowEnd, float* dst)
+{
+    float cropX, cropY, cropW, cropH;
+    CenterCrop(srcW, srcH, dstW, dstH, cropX, cropY, cropW, cropH);
+    std::vector<AxisTap> xs, ys;
+    BuildAxis(srcW, cropX, cropW, dstW, xs);
+    BuildAxis(srcH, cropY, cropH, dstH, ys);
+    uint32_t channels[3];
+    PlaneChannels(spec.bgr, channels);
+
+    // two horizontally resized source rows, reused while consecutive output
+    // rows sample the same source rows
+    std::vector<float> rowBuffer(6 * dstW);
+    float* top = rowBuffer.data();
+    float* bottom = top + 3 * dstW;
+    int64_t topIndex = -1;
+    int64_t bottomIndex = -1;
+
+    const uint32_t planeSize = dstW * dstH;
+    for (uint32_t y = rowBegin; y < rowEnd; ++y) {
+        const AxisTap& tap = ys[y];
+        if (topIndex != tap.i0) {
+            if (bottomIndex == tap.i0) {
+                std::swap(top, bottom);
+                std::swap(topIndex, bottomIndex);
+            } else {
+                ResizeRowHorizontal(rgba + tap.i0 * stride, xs, channels, top);
+                topIndex = tap.i0;
+            }
+        }
+        if (bottomIndex != tap.i1) {
+            ResizeRowHorizontal(rgba + tap.i1 * stride, xs, channels, bottom);
+            bottomIndex = tap.i1;
+        }
+        for (uint32_t p = 0; p < 3; ++p) {
+            BlendRowsNormalize(top + p * dstW, bottom + p * dstW, tap.w, spec.mean[p], spec.scale[p],
+                dst + p * planeSize + y * dstW, dstW);
+        }
+    }
+}
+
+void CropResizeNormalizeRef(const uint8_t* rgba, uint32_t srcW, uint32_t srcH, uint32_t stride,
+    uint32_t dstW, uint32_t dstH, const NormalizeSpec& spec, float* dst)
+{
+    float cropX, cropY, cropW, cropH;
+    CenterCrop(srcW, srcH, dstW, dstH, cropX, cropY, cropW, cropH);
+    std::vector<AxisTap> xs, ys;
+    BuildAxis(srcW, cropX, cropW, dstW, xs);
+    BuildAxis(srcH, cropY, cropH, dstH, ys);
+    uint32_t channels[3];
+    PlaneChannels(spec.bgr, channels);
+
+    // pass 1: bilinear resize into an interleaved float image
+    std::vector<float> resized(3 * dstW * dstH);
+    for (uint32_t y = 0; y < dstH; ++y) {
+        const uint8_t* row0 = rgba + ys[y].i0 * stride;
+        const uint8_t* row1 = rgba + ys[y].i1 * stride;
+        for (uint32_t x = 0; x < dstW; ++x) {
+            for (uint32_t p = 0; p < 3; ++p) {
+                const uint32_t c = channels[p];
+                float a0 = row0[xs[x].i0 * 4 + c];
+                float a1 = row0[xs[x].i1 * 4 + c];
+                float b0 = row1[xs[x].i0 * 4 + c];
+                float b1 = row1[xs[x].i1 * 4 + c];
+                float h0 = a0 + xs[x].w * (a1 - a0);
+                float h1 = b0 + xs[x].w * (b1 - b0);
+                resized[(y * dstW + x) * 3 + p] = h0 + ys[y].w * (h1 - h0);
+            }
+        }
+    }
+
+    // pass 2: normalize into planes
+    const uint32_t planeSize = dstW * dstH;
+    for (uint32_t i = 0; i < planeSize; ++i) {
+        for (uint32_t p = 0; p < 3; ++p) {
+            dst[p * planeSize + i] = (resized[i * 3 + p] - spec.mean[p]) * spec.scale[p];
+        }
+    }
+}
@@ -0,0 +1,134 @@
+/*
+ * @file image_preprocess.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_IMAGE_PREPROCESS_H
+#define HIAI_DEMO_IMAGE_PREPROCESS_H
+
+#include <cstdint>
+#include <vector>
+#include "HiAiAippPara.h"
+
+/*
+* @brief Pack RGBA_8888 pixels (Android ARGB_8888 bitmap memory layout) into
+*        mean-subtracted float B/G/R planes (NCHW, N=1). Scalar reference.
+* @param [in] rgba    first pixel of the image
+* @param [in] width   image width in pixels
+* @param [in] height  image height in pixels
+* @param [in] stride  bytes between two rows of rgba
+* @param [in] mean    mean of the B, G and R channel, in that order
+* @param [out] dst    3 * width * height floats, B plane first
+*/
+void PackRgbaToBgrPlanesRef(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t stride,
+    const float mean[3], float* dst);
+
+/*
+* @brief Same as PackRgbaToBgrPlanesRef, vectorized with NEON on ARM and
+*        SSE2/AVX2 on x86. The result is bit-exact with the reference.
+*/
+void PackRgbaToBgrPlanes(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t stride,
+    const float mean[3], float* dst);
+
+/*
+* @brief PackRgbaToBgrPlanes for rows [rowBegin, rowEnd) only, so that bands
+*        of one image can be packed in parallel. dst is the whole tensor.
+*/
+void PackRgbaToBgrPlanesRows(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t stride,
+    const float mean[3], uint32_t rowBegin, uint32_t rowEnd, float* dst);
+
+/*
+* @brief Convert RGBA_8888 pixels to YUV420SP (NV12, or NV21 when nv21 is set)
+*        for an AIPP input tensor. Chroma is taken from the top-left pixel of
+*        every 2x2 block, as Untils.encodeYUV420SP does. Scalar reference.
+* @param [in] rgba    first pixel of the image
+* @param [in] width   image width in pixels, must be even
+* @param [in] height  image height in pixels, must be even
+* @param [in] stride  bytes between two rows of rgba
+* @param [in] type    colour matrix and range: BT_601_NARROW, BT_709_NARROW,
+*                     BT_601_FULL (JPEG is full range BT.601 as well)
+* @param [in] nv21    store V before U in the chroma plane
+* @param [out] dst    width * height * 3 / 2 bytes, Y plane then UV plane
+*/
+void RgbaToYuv420spRef(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t stride,
+    hiai::ImageType type, bool nv21, uint8_t* dst);
+
+/*
+* @brief Same as RgbaToYuv420spRef, vectorized with NEON on ARM and SSE2 on
+*        x86. The result is bit-exact with the reference.
+*/
+void RgbaToYuv420sp(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t stride,
+    hiai::ImageType type, bool nv21, uint8_t* dst);
+
+/*
+* @brief RgbaToYuv420sp for rows [rowBegin, rowEnd) only; rowBegin must be
+*        even, as a chroma row is written with the even luma row above it
+*/
+void RgbaToYuv420spRows(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t stride,
+    hiai::ImageType type, bool nv21, uint32_t rowBegin, uint32_t rowEnd, uint8_t* dst);
+
+/* Per-plane normalization: out = (pixel - mean[c]) * scale[c], planes in R,G,B
+ * order, or B,G,R when bgr is set. scale is the reciprocal of the std. */
+struct NormalizeSpec {
+    float mean[3];
+    float scale[3];
+    bool bgr;
+};
+
+/* One bilinear tap along an axis: sample = s[i0] + w * (s[i1] - s[i0]) */
+struct AxisTap {
+    uint32_t i0;
+    uint32_t i1;
+    float w;
+};
+
+/*
+* @brief Map dstLen output samples onto [cropStart, cropStart + cropLen) of a
+*        source axis of srcLen pixels, with pixel centers aligned.
+*/
+void BuildAxis(uint32_t srcLen, float cropStart, float cropLen, uint32_t dstLen, std::vector<AxisTap>& taps);
+
+/*
+* @brief Vertically blend two float rows and normalize them:
+*        dst[i] = (r0[i] + wy * (r1[i] - r0[i]) - mean) * scale
+*/
+void BlendRowsNormalize(const float* r0, const float* r1, float wy, float mean, float scale,
+    float* dst, uint32_t count);
+
+/*
+* @brief Center-crop an RGBA_8888 image to the aspect ratio of the destination,
+*        bilinear-resize it and write normalized float planes, in one pass over
+*        the source and without intermediate images.
+* @param [in] rgba    first pixel of the source image
+* @param [in] srcW    source width in pixels
+* @param [in] srcH    source height in pixels
+* @param [in] stride  bytes between two rows of rgba
+* @param [in] dstW    width of the model input
+* @param [in] dstH    height of the model input
+* @param [in] spec    normalization and plane order
+* @param [out] dst    3 * dstW * dstH floats
+*/
+void CropResizeNormalize(const uint8_t* rgba, uint32_t srcW, uint32_t srcH, uint32_t stride,
+    uint32_t dstW, uint32_t dstH, const NormalizeSpec& spec, float* dst);
+
+/*
+* @brief CropResizeNormalize for output rows [rowBegin, rowEnd) of every plane
+*        only. dst is the whole tensor.
+*/
+void CropResizeNormalizeRows(const uint8_t* rgba, uint32_t srcW, uint32_t srcH, uint32_t stride,
+    uint32_t dstW, uint32_t dstH, const NormalizeSpec& spec, uint32_t rowBegin, uint32_t rowEnd, float* dst);
+
+/*
+* @brief Multi-pass reference of CropResizeNormalize: crop copy, resize into an
+*        interleaved float image, then normalize. Results match within float
+*        rounding.
+*/
+void CropResizeNormalizeRef(const uint8_t* rgba, uint32_t srcW, uint32_t srcH, uint32_t stride,
+    uint32_t dstW, uint32_t dstH, const NormalizeSpec& spec, float* dst);
+
+#endif
@@ -0,0 +1,219 @@
+/*
+ * @file jni_common.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "jni_common.h"
+
+#include <pthread.h>
+#include <thread>
+#include <android/log.h>
+
+#define LOG_TAG "JNI_DDK_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+using namespace hiai;
+
+bool GetModelName(JNIEnv *env, jobject modelInfo, string& name)
+{
+    jclass ModelInfo = env->GetObjectClass(modelInfo);
+    if (ModelInfo == nullptr) {
+        LOGE("[HIAI_DEMO_JNI] can not find ModelInfo class.");
+        return false;
+    }
+    jmethodID getOfflineModelName = env->GetMethodID(ModelInfo, "getOfflineModelName", "()Ljava/lang/String;");
+    if (getOfflineModelName == nullptr) {
+        LOGE("[HIAI_DEMO_JNI] can not find getOfflineModelName method.");
+        return false;
+    }
+    jstring modelname = (jstring)env->CallObjectMethod(modelInfo, getOfflineModelName);
+    if (modelname == nullptr) {
+        LOGE("[HIAI_DEMO_JNI] modelName is null.");
+        return false;
+    }
+    const char* modelName = env->GetStringUTFChars(modelname, 0);
+    if (modelName == nullptr) {
+        LOGE("[HIAI_DEMO_JNI] modelName is invalid.");
+        return false;
+    }
+    name = modelName;
+    env->ReleaseStringUTFChars(modelname, modelName);
+    env->DeleteLocalRef(modelname);
+    return true;
+}
+
+static bool CallStringMethod(JNIEnv *env, jobject object, jclass objectClass, const char* method, string& value)
+{
+    jmethodID getter = env->GetMethodID(objectClass, method, "()Ljava/lang/String;");
+    if (getter == nullptr) {
+        LOGE("[HIAI_DEMO_JNI] can not find %s method.", method);
+        return false;
+    }
+    jstring str = (jstring)env->CallObjectMethod(object, getter);
+    const char* chars = str != nullptr ? env->GetStringUTFChars(str, 0) : nullptr;
+    if (chars == nullptr) {
+        LOGE("[HIAI_DEMO_JNI] %s returned an invalid string.", method);
+        return false;
+    }
+    value = chars;
+    env->ReleaseStringUTFChars(str, chars);
+    env->DeleteLocalRef(str);
+    return true;
+}
+
+bool GetModelSource(JNIEnv *env, jobject modelInfo, ModelSource& source)
+{
+    jclass ModelInfo = env->GetObjectClass(modelInfo);
+    if (ModelInfo == nullptr) {
+        LOGE("[HIAI_DEMO_JNI] can not find ModelInfo class.");
+        return false;
+    }
+    return CallStringMethod(env, modelInfo, ModelInfo, "getOfflineModel", source.asset) &&
+        CallStringMethod(env, modelInfo, ModelInfo, "getModelPath", source.path);
+}
+
+bool GetModelQosClass(JNIEnv *env, jobject modelInfo, QosClass& qos)
+{
+    jclass ModelInfo = env->GetObjectClass(modelInfo);
+    jmethodID getQosClass = ModelInfo != nullptr ? env->GetMethodID(ModelInfo, "getQosClass", "()I") : nullptr;
+    if (getQosClass == nullptr) {
+        LOGE("[HIAI_DEMO_JNI] can not find getQosClass method.");
+        return false;
+    }
+    jint value = env->CallIntMethod(modelInfo, getQosClass);
+    if (value < QOS_INTERACTIVE || value > QOS_BACKGROUND) {
+        LOGE("[HIAI_DEMO_JNI] qos class %d is invalid.", value);
+        return false;
+    }
+    qos = static_cast<QosClass>(value);
+    return true;
+}
+
+jobject NewTensorBufferList(JNIEnv *env, const vector<shared_ptr<AiTensor>>& tensors)
+{
+    jclass listClass = env->FindClass("java/util/ArrayList");
+    jclass bufferClass = env->FindClass("java/nio/ByteBuffer");
+    jclass orderClass = env->FindClass("java/nio/ByteOrder");
+    if (listClass == nullptr || bufferClass == nullptr || orderClass == nullptr) {
+        LOGE("[HIAI_DEMO_JNI] can not find ArrayList, ByteBuffer or ByteOrder class.");
+        return nullptr;
+    }
+    jmethodID listInit = env->GetMethodID(listClass, "<init>", "()V");
+    jmethodID listAdd = env->GetMethodID(listClass, "add", "(Ljava/lang/Object;)Z");
+    jmethodID order = env->GetMethodID(bufferClass, "order", "(Ljava/nio/ByteOrder;)Ljava/nio/ByteBuffer;");
+    jmethodID nativeOrder = env->GetStaticMethodID(orderClass, "nativeOrder", "()Ljava/nio/ByteOrder;");
+    if (listInit == nullptr || listAdd == nullptr || order == nullptr || nativeOrder == nullptr) {
+        LOGE("[HIAI_DEMO_JNI] can not find ArrayList or ByteBuffer methods.");
+        return nullptr;
+    }
+
+    jobject byteOrder = env->CallStaticObjectMethod(orderClass, nativeOrder);
+    jobject list = env->NewObject(listClass, listInit);
+    for (auto& tensor : tensors) {
+        jobject buffer = env->NewDirectByteBuffer(tensor->GetBuffer(), tensor->GetSize());
+        if (buffer == nullptr) {
+            LOGE("[HIAI_DEMO_JNI] NewDirectByteBuffer failed.");
+            return nullptr;
+        }
+        jobject ordered = env->CallObjectMethod(buffer, order, byteOrder);
+        env->CallBooleanMethod(list, listAdd, ordered);
+        env->DeleteLocalRef(ordered);
+        env->DeleteLocalRef(buffer);
+    }
+    env->DeleteLocalRef(byteOrder);
+    return list;
+}
+
+static pthread_key_t attached_thread_key;
+static pthread_once_t attached_thread_once = PTHREAD_ONCE_INIT;
+
+static void DetachAttachedThread(void* vm)
+{
+    static_cast<JavaVM*>(vm)->DetachCurrentThread();
+}
+
+static void CreateAttachedThreadKey()
+{
+    pthread_key_create(&attached_thread_key, DetachAttachedThread);
+}
+
+JNIEnv* GetThreadEnv(JavaVM *vm)
+{
+    JNIEnv* env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) == JNI_OK) {
+        return env;
+    }
+    if (vm->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+        LOGE("[HIAI_DEMO_JNI] AttachCurrentThread failed.");
+        return nullptr;
+    }
+    pthread_once(&attached_thread_once, CreateAttachedThreadKey);
+    pthread_setspecific(attached_thread_key, vm);
+    return env;
+}
+
+jlongArray NewWarmupStatsArray(JNIEnv *env, const WarmupStats& stats)
+{
+    jlong values[] = { (jlong)stats.state, (jlong)stats.runs, (jlong)stats.coldUs, (jlong)stats.warmUs };
+    jlongArray result = env->NewLongArray(4);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, 4, values);
+    }
+    return result;
+}
+
+jlongArray NewLoadTimesArray(JNIEnv *env, const ModelLoadTimes& times)
+{
+    jlong values[] = { (jlong)times.mapUs, (jlong)times.loadUs, (jlong)times.ioUs, (jlong)times.tensorUs,
+        (jlong)times.readyUs };
+    jlongArray result = env->NewLongArray(5);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, 5, values);
+    }
+    return result;
+}
+
+bool LoadModelsInBackground(JNIEnv *env, jobject modelInfo, jobject listener, LoadModelsFunction load)
+{
+    jclass listenerClass = env->GetObjectClass(listener);
+    jmethodID onLoaded = env->GetMethodID(listenerClass, "onModelsLoaded", "(Ljava/util/ArrayList;)V");
+    if (onLoaded == nullptr) {
+        LOGE("[HIAI_DEMO_JNI] can not find onModelsLoaded method.");
+        return false;
+    }
+    JavaVM* vm = nullptr;
+    if (env->GetJavaVM(&vm) != JNI_OK) {
+        return false;
+    }
+    jobject list = env->NewGlobalRef(modelInfo);
+    jobject callback = env->NewGlobalRef(listener);
+    if (list == nullptr || callback == nullptr) {
+        LOGE("[HIAI_DEMO_JNI] NewGlobalRef failed.");
+        return false;
+    }
+    // a thread of its own: a load holds it for as long as the NPU takes
+    thread([vm, list, callback, onLoaded, load] {
+        JNIEnv* env = GetThreadEnv(vm);
+        if (env == nullptr) {
+            return;
+        }
+        jobject loaded = load(env, nullptr, list);
+        if (env->ExceptionCheck()) {
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+            loaded = nullptr;
+        }
+        env->CallVoidMethod(callback, onLoaded, loaded);
+        env->DeleteGlobalRef(list);
+        env->DeleteGlobalRef(callback);
+    }).detach();
+    return true;
+}
@@ -0,0 +1,84 @@
+/*
+ * @file jni_common.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_JNI_COMMON_H
+#define HIAI_DEMO_JNI_COMMON_H
+
+#include <jni.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "HiAiModelManagerService.h"
+#include "load_times.h"
+#include "model_mapping.h"
+#include "qos_scheduler.h"
+#include "warmup.h"
+
+/*
+* @brief Read ModelInfo.getOfflineModelName()
+* @param [in] modelInfo com.huawei.hiaidemo.bean.ModelInfo object
+* @param [out] name offline model name (without ".om")
+* @return false if the method is missing or the name is invalid
+*/
+bool GetModelName(JNIEnv *env, jobject modelInfo, std::string& name);
+
+/*
+* @brief Read ModelInfo.getOfflineModel() and getModelPath()
+* @param [out] source APK asset and app storage file of the OM file
+* @return false if a method is missing or a string is invalid
+*/
+bool GetModelSource(JNIEnv *env, jobject modelInfo, ModelSource& source);
+
+/*
+* @brief Read ModelInfo.getQosClass()
+* @param [out] qos priority class of the model
+* @return false if the method is missing or the class is invalid
+*/
+bool GetModelQosClass(JNIEnv *env, jobject modelInfo, QosClass& qos);
+
+/*
+* @brief Wrap tensor buffers into direct ByteBuffers in native byte order,
+*        without copying. The buffers stay valid while the tensors live.
+* @param [in] tensors tensors to expose
+* @return java.util.ArrayList<ByteBuffer>, nullptr on failure
+*/
+jobject NewTensorBufferList(JNIEnv *env, const std::vector<std::shared_ptr<hiai::AiTensor>>& tensors);
+
+/*
+* @brief JNIEnv of the calling thread, attaching it to the VM if needed. A
+*        thread attached here is detached when it exits, so native worker
+*        threads can call Java without tracking their own attachment.
+* @return nullptr if the thread cannot be attached
+*/
+JNIEnv* GetThreadEnv(JavaVM *vm);
+
+/*
+* @brief Warm-up progress of a model as long[] {state, runs, coldUs, warmUs},
+*        state being one of Constant.WARMUP_*
+*/
+jlongArray NewWarmupStatsArray(JNIEnv *env, const WarmupStats& stats);
+
+/*
+* @brief Load times of a model as long[] {mapUs, loadUs, ioUs, tensorUs, readyUs}
+*/
+jlongArray NewLoadTimesArray(JNIEnv *env, const ModelLoadTimes& times);
+
+/* loadModelSync or loadModelAsync */
+using LoadModelsFunction = jobject (*)(JNIEnv *env, jclass type, jobject modelInfo);
+
+/*
+* @brief Run a blocking load function on a thread of its own, then pass what
+*        it returned to listener.onModelsLoaded(ArrayList<ModelInfo>)
+* @param [in] listener com.huawei.hiaidemo.utils.ModelLoadListener
+* @return false if the load cannot be started
+*/
+bool LoadModelsInBackground(JNIEnv *env, jobject modelInfo, jobject listener, LoadModelsFunction load);
+
+#endif
@@ -0,0 +1,103 @@
+/*
+ * @file label_jni.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include <jni.h>
+#include <string>
+
+#include <android/asset_manager_jni.h>
+#include <android/log.h>
+#include "label_store.h"
+#include "model_bundle.h"
+
+#define LOG_TAG "LABEL_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+// bundle read by readModelBundle under this name, if it has labels
+static shared_ptr<ModelBundle> FindBundleLabels(const string& fileName)
+{
+    shared_ptr<ModelBundle> bundle = FindModelBundle(ModelSource{ fileName, fileName });
+    return bundle != nullptr && bundle->LabelCount() > 0 ? bundle : nullptr;
+}
+
+static bool GetString(JNIEnv *env, jstring str, string& out)
+{
+    if (str == nullptr) {
+        return false;
+    }
+    const char* chars = env->GetStringUTFChars(str, 0);
+    if (chars == nullptr) {
+        return false;
+    }
+    out = chars;
+    env->ReleaseStringUTFChars(str, chars);
+    return true;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_loadLabelTable(JNIEnv *env, jclass type, jobject assetManager,
+    jstring labelFile)
+{
+    string fileName;
+    if (env == nullptr || assetManager == nullptr || !GetString(env, labelFile, fileName)) {
+        LOGE("[HIAI_DEMO_LABEL] loadLabelTable invalid params.");
+        return -1;
+    }
+    shared_ptr<ModelBundle> bundle = FindBundleLabels(fileName);
+    if (bundle != nullptr) {
+        return (jint)bundle->LabelCount();
+    }
+    shared_ptr<LabelTable> table = LabelTable::Open(AAssetManager_fromJava(env, assetManager), fileName);
+    return table == nullptr ? -1 : (jint)table->Size();
+}
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_getTopKLabels(JNIEnv *env, jclass type, jstring labelFile,
+    jfloatArray topK)
+{
+    string fileName;
+    if (env == nullptr || topK == nullptr || !GetString(env, labelFile, fileName)) {
+        LOGE("[HIAI_DEMO_LABEL] getTopKLabels invalid params.");
+        return nullptr;
+    }
+    shared_ptr<LabelTable> table = LabelTable::Find(fileName);
+    shared_ptr<ModelBundle> bundle = table == nullptr ? FindBundleLabels(fileName) : nullptr;
+    if (table == nullptr && bundle == nullptr) {
+        LOGE("[HIAI_DEMO_LABEL] label table %s is not loaded.", fileName.c_str());
+        return nullptr;
+    }
+
+    jsize count = env->GetArrayLength(topK) / 2;
+    jclass stringClass = env->FindClass("java/lang/String");
+    jobjectArray labels = env->NewObjectArray(count, stringClass, nullptr);
+    if (labels == nullptr) {
+        return nullptr;
+    }
+    jfloat* pairs = env->GetFloatArrayElements(topK, nullptr);
+    string label;
+    for (jsize i = 0; i < count; ++i) {
+        size_t length = 0;
+        const char* text = nullptr;
+        if (pairs[2 * i] >= 0.0f) {
+            size_t index = static_cast<size_t>(pairs[2 * i]);
+            text = table != nullptr ? table->Get(index, length) : bundle->Label(index, length);
+        }
+        label.assign(text == nullptr ? "" : text, length);
+        jstring str = env->NewStringUTF(label.c_str());
+        env->SetObjectArrayElement(labels, i, str);
+        env->DeleteLocalRef(str);
+    }
+    env->ReleaseFloatArrayElements(topK, pairs, JNI_ABORT);
+    return labels;
+}
@@ -0,0 +1,104 @@
+/*
+ * @file label_store.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "label_store.h"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <android/log.h>
+
+#define LOG_TAG "LABEL_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+static mutex g_labelMutex;
+static map<string, shared_ptr<LabelTable>> g_labelTables;
+
+LabelTable::~LabelTable()
+{
+    if (asset_ != nullptr) {
+        AAsset_close(asset_);
+    }
+}
+
+shared_ptr<LabelTable> LabelTable::Open(AAssetManager* mgr, const string& fileName)
+{
+    std::lock_guard<std::mutex> lock(g_labelMutex);
+    auto it = g_labelTables.find(fileName);
+    if (it != g_labelTables.end()) {
+        return it->second;
+    }
+    if (mgr == nullptr) {
+        LOGE("[HIAI_DEMO_LABEL] AAssetManager is null.");
+        return nullptr;
+    }
+
+    AAsset* asset = AAssetManager_open(mgr, fileName.c_str(), AASSET_MODE_BUFFER);
+    if (asset == nullptr) {
+        LOGE("[HIAI_DEMO_LABEL] can not open asset %s.", fileName.c_str());
+        return nullptr;
+    }
+    shared_ptr<LabelTable> table(new LabelTable());
+    table->asset_ = asset;
+    table->data_ = static_cast<const char*>(AAsset_getBuffer(asset));
+    table->size_ = static_cast<size_t>(AAsset_getLength(asset));
+    if (table->data_ == nullptr) {
+        LOGE("[HIAI_DEMO_LABEL] AAsset_getBuffer %s failed.", fileName.c_str());
+        return nullptr;
+    }
+    if (AAsset_isAllocated(asset)) {
+        // compressed in the APK: inflated into the heap instead of mapped
+        LOGI("[HIAI_DEMO_LABEL] asset %s is compressed, store it uncompressed to map it.", fileName.c_str());
+    }
+    table->BuildIndex();
+    LOGI("[HIAI_DEMO_LABEL] %s: %zu labels.", fileName.c_str(), table->Size());
+    g_labelTables[fileName] = table;
+    return table;
+}
+
+shared_ptr<LabelTable> LabelTable::Find(const string& fileName)
+{
+    std::lock_guard<std::mutex> lock(g_labelMutex);
+    auto it = g_labelTables.find(fileName);
+    return it == g_labelTables.end() ? nullptr : it->second;
+}
+
+void LabelTable::BuildIndex()
+{
+    const char* p = data_;
+    const char* end = data_ + size_;
+    while (p < end) {
+        offsets_.push_back(static_cast<uint32_t>(p - data_));
+        const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (eol == nullptr) {
+            break;
+        }
+        p = eol + 1;
+    }
+}
+
+const char* LabelTable::Get(size_t index, size_t& length) const
+{
+    if (index >= offsets_.size()) {
+        length = 0;
+        return nullptr;
+    }
+    const char* begin = data_ + offsets_[index];
+    const char* end = (index + 1 < offsets_.size()) ? data_ + offsets_[index + 1] : data_ + size_;
+    while (end > begin && (end[-1] == '\n' || end[-1] == '\r')) {
+        --end;
+    }
+    length = end - begin;
+    return begin;
+}
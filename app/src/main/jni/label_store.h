@@ -0,0 +1,66 @@
+/*
+ * @file label_store.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_LABEL_STORE_H
+#define HIAI_DEMO_LABEL_STORE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <android/asset_manager.h>
+
+/*
+ * One label per line of an APK asset. The asset is opened in buffer mode, so
+ * an uncompressed asset is used straight from the mapped APK; only the line
+ * offsets are built, once.
+ */
+class LabelTable {
+public:
+    ~LabelTable();
+
+    LabelTable(const LabelTable&) = delete;
+    LabelTable& operator=(const LabelTable&) = delete;
+
+    /*
+    * @brief Open a label asset, or return the table already opened for it, so
+    *        models sharing a label file share one table
+    * @param [in] mgr asset manager of the APK
+    * @param [in] fileName asset path, e.g. "labels_caffe.txt"
+    * @return the table, nullptr if the asset can not be opened
+    */
+    static std::shared_ptr<LabelTable> Open(AAssetManager* mgr, const std::string& fileName);
+
+    /*
+    * @brief Table opened before with Open
+    * @return nullptr if fileName was never opened
+    */
+    static std::shared_ptr<LabelTable> Find(const std::string& fileName);
+
+    size_t Size() const { return offsets_.size(); }
+
+    /*
+    * @brief Label of a class, without the line break
+    * @param [out] length bytes of the label, not 0-terminated
+    * @return first byte of the label, nullptr if index is out of range
+    */
+    const char* Get(size_t index, size_t& length) const;
+
+private:
+    LabelTable() = default;
+    void BuildIndex();
+
+    AAsset* asset_ = nullptr;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<uint32_t> offsets_;
+};
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ * @file load_times.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "load_times.h"
+#include <android/log.h>
+
+#define LOG_TAG "MODEL_MSG"
+
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+void LogLoadTimes(const vector<string>& names, const vector<ModelLoadTimes>& times, int64_t callUs)
+{
+    int64_t serialUs = 0;
+    for (size_t i = 0; i < names.size() && i < times.size(); ++i) {
+        const ModelLoadTimes& t = times[i];
+        LOGI("[HIAI_DEMO_MODEL] %s: map %lld us, load %lld us, io dims %lld us, tensors %lld us, ready after %lld us.",
+            names[i].c_str(), (long long)t.mapUs, (long long)t.loadUs, (long long)t.ioUs, (long long)t.tensorUs,
+            (long long)t.readyUs);
+        serialUs += t.mapUs + t.loadUs + t.ioUs + t.tensorUs;
+    }
+    LOGI("[HIAI_DEMO_MODEL] %zu models ready in %lld us, %lld us one after the other.", names.size(),
+        (long long)callUs, (long long)serialUs);
+}
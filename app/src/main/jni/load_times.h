@@ -0,0 +1,51 @@
+/*
+ * @file load_times.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_LOAD_TIMES_H
+#define HIAI_DEMO_LOAD_TIMES_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Where the startup time of one model went, in us. Models of one load call
+ * are loaded in parallel, so the call takes about the largest readyUs rather
+ * than the sum of the others.
+ */
+struct ModelLoadTimes {
+    // mapping its OM file
+    int64_t mapUs = 0;
+    // AiModelMngerClient::Load; the async models share one Load call
+    int64_t loadUs = 0;
+    // GetModelIOTensorDim
+    int64_t ioUs = 0;
+    // AiTensor::Init of the tensors created at load time
+    int64_t tensorUs = 0;
+    // from the start of the load call until the model was ready
+    int64_t readyUs = 0;
+};
+
+using LoadClock = std::chrono::steady_clock;
+
+inline int64_t MicrosSince(LoadClock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(LoadClock::now() - start).count();
+}
+
+/*
+* @brief Log the breakdown of every model of a load call, and the call time
+*        next to the sum of the model times
+* @param [in] callUs duration of the whole load call
+*/
+void LogLoadTimes(const std::vector<std::string>& names, const std::vector<ModelLoadTimes>& times, int64_t callUs);
+
+#endif
@@ -0,0 +1,216 @@
+/*
+ * @file model_bundle.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "model_bundle.h"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <android/log.h>
+
+#define LOG_TAG "MODEL_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+using namespace hiai;
+
+static mutex g_bundleMutex;
+static map<string, shared_ptr<ModelBundle>> g_bundles;
+
+bool ModelBundle::IsBundle(const ModelMapping& file)
+{
+    uint32_t magic = 0;
+    if (file.Size() < sizeof(magic)) {
+        return false;
+    }
+    memcpy(&magic, file.Data(), sizeof(magic));
+    return magic == BUNDLE_MAGIC;
+}
+
+shared_ptr<ModelBundle> ModelBundle::Open(const shared_ptr<ModelMapping>& file)
+{
+    shared_ptr<ModelBundle> bundle(new ModelBundle());
+    bundle->file_ = file;
+    return file != nullptr && bundle->Validate() ? bundle : nullptr;
+}
+
+bool ModelBundle::Validate()
+{
+    const uint8_t* data = static_cast<const uint8_t*>(file_->Data());
+    uint64_t size = file_->Size();
+    // every field is read in place
+    if (reinterpret_cast<uintptr_t>(data) % sizeof(uint32_t) != 0) {
+        LOGE("[HIAI_DEMO_MODEL] bundle is not 4-byte aligned, store it uncompressed.");
+        return false;
+    }
+    header_ = reinterpret_cast<const BundleHeader*>(data);
+    if (size < sizeof(BundleHeader) || header_->magic != BUNDLE_MAGIC) {
+        LOGE("[HIAI_DEMO_MODEL] not a model bundle.");
+        return false;
+    }
+    if (header_->version != BUNDLE_VERSION || header_->headerSize != sizeof(BundleHeader)) {
+        LOGE("[HIAI_DEMO_MODEL] bundle version %u is not supported.", header_->version);
+        return false;
+    }
+    uint64_t tableEnd = sizeof(BundleHeader) + (uint64_t)sizeof(BundleSection) * header_->sectionCount;
+    if (header_->fileSize != size || header_->sectionCount > BUNDLE_MAX_SECTIONS || tableEnd > size) {
+        LOGE("[HIAI_DEMO_MODEL] bundle is truncated or its section table is invalid.");
+        return false;
+    }
+    const BundleSection* sections = reinterpret_cast<const BundleSection*>(data + sizeof(BundleHeader));
+    for (uint32_t i = 0; i < header_->sectionCount; ++i) {
+        const BundleSection& section = sections[i];
+        uint32_t align = section.type == BUNDLE_SECTION_MODEL ? BUNDLE_MODEL_ALIGN : BUNDLE_SECTION_ALIGN;
+        if (section.offset < tableEnd || section.offset % align != 0 || (uint64_t)section.offset + section.size > size) {
+            LOGE("[HIAI_DEMO_MODEL] bundle section %u is out of bounds.", i);
+            return false;
+        }
+        const uint8_t* start = data + section.offset;
+        bool unique = true;
+        switch (section.type) {
+            case BUNDLE_SECTION_MODEL:
+                unique = model_ == nullptr;
+                model_ = &section;
+                break;
+            case BUNDLE_SECTION_LABELS:
+                unique = labels_ == nullptr;
+                labels_ = reinterpret_cast<const BundleLabels*>(start);
+                if (section.size < BundleLabelsSize(0, 0) ||
+                    (section.size - BundleLabelsSize(0, 0)) / sizeof(uint32_t) < labels_->count) {
+                    LOGE("[HIAI_DEMO_MODEL] bundle label table is truncated.");
+                    return false;
+                }
+                labelText_ = reinterpret_cast<const char*>(labels_->offsets + labels_->count + 1);
+                for (uint32_t l = 0; l < labels_->count; ++l) {
+                    if (labels_->offsets[l] > labels_->offsets[l + 1]) {
+                        LOGE("[HIAI_DEMO_MODEL] bundle label %u is invalid.", l);
+                        return false;
+                    }
+                }
+                if (labels_->offsets[0] != 0 ||
+                    labels_->offsets[labels_->count] != section.size - BundleLabelsSize(labels_->count, 0)) {
+                    LOGE("[HIAI_DEMO_MODEL] bundle label text is invalid.");
+                    return false;
+                }
+                break;
+            case BUNDLE_SECTION_PREPROCESS:
+                unique = preprocess_ == nullptr;
+                preprocess_ = reinterpret_cast<const BundlePreprocess*>(start);
+                if (section.size != sizeof(BundlePreprocess) || preprocess_->channelOrder > BUNDLE_CHANNELS_BGR ||
+                    preprocess_->layout > BUNDLE_LAYOUT_NHWC || preprocess_->aippImageType > BT_709_NARROW ||
+                    !(preprocess_->std[0] > 0.0f && preprocess_->std[1] > 0.0f && preprocess_->std[2] > 0.0f)) {
+                    LOGE("[HIAI_DEMO_MODEL] bundle preprocessing is invalid.");
+                    return false;
+                }
+                break;
+            case BUNDLE_SECTION_IO_DIMS:
+                unique = ioDims_ == nullptr;
+                ioDims_ = reinterpret_cast<const BundleIoDims*>(start);
+                if (section.size < BundleIoDimsSize(0, 0) || ioDims_->inputCount > BUNDLE_MAX_TENSORS ||
+                    ioDims_->outputCount > BUNDLE_MAX_TENSORS ||
+                    section.size != BundleIoDimsSize(ioDims_->inputCount, ioDims_->outputCount)) {
+                    LOGE("[HIAI_DEMO_MODEL] bundle IO dims are invalid.");
+                    return false;
+                }
+                break;
+            default:
+                // sections of later versions are skipped
+                break;
+        }
+        if (!unique) {
+            LOGE("[HIAI_DEMO_MODEL] bundle section type %u is repeated.", section.type);
+            return false;
+        }
+    }
+    if (model_ == nullptr || model_->size == 0) {
+        LOGE("[HIAI_DEMO_MODEL] bundle has no model.");
+        return false;
+    }
+    if (BundleMetaChecksum(data) != header_->checksum) {
+        LOGE("[HIAI_DEMO_MODEL] bundle checksum mismatch.");
+        return false;
+    }
+    return true;
+}
+
+shared_ptr<ModelMapping> ModelBundle::Model() const
+{
+    return ModelMapping::Slice(file_, model_->offset, model_->size);
+}
+
+const char* ModelBundle::Label(size_t index, size_t& length) const
+{
+    if (index >= LabelCount()) {
+        return nullptr;
+    }
+    length = labels_->offsets[index + 1] - labels_->offsets[index];
+    return labelText_ + labels_->offsets[index];
+}
+
+NormalizeSpec ModelBundle::Normalize() const
+{
+    NormalizeSpec spec = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f }, true };
+    if (preprocess_ != nullptr) {
+        for (int c = 0; c < 3; ++c) {
+            spec.mean[c] = preprocess_->mean[c];
+            spec.scale[c] = 1.0f / preprocess_->std[c];
+        }
+        spec.bgr = preprocess_->channelOrder == BUNDLE_CHANNELS_BGR;
+    }
+    return spec;
+}
+
+static bool SameDims(const BundleDims& expected, const TensorDimension& actual)
+{
+    return expected.n == actual.GetNumber() && expected.c == actual.GetChannel() && expected.h == actual.GetHeight() &&
+        expected.w == actual.GetWidth();
+}
+
+bool ModelBundle::MatchesIo(const vector<TensorDimension>& inputs, const vector<TensorDimension>& outputs) const
+{
+    if (ioDims_ == nullptr) {
+        return true;
+    }
+    if (inputs.size() != ioDims_->inputCount || outputs.size() != ioDims_->outputCount) {
+        LOGE("[HIAI_DEMO_MODEL] bundle expects %u inputs and %u outputs, the model has %zu and %zu.",
+            ioDims_->inputCount, ioDims_->outputCount, inputs.size(), outputs.size());
+        return false;
+    }
+    for (size_t i = 0; i < inputs.size() + outputs.size(); ++i) {
+        const TensorDimension& actual = i < inputs.size() ? inputs[i] : outputs[i - inputs.size()];
+        if (!SameDims(ioDims_->dims[i], actual)) {
+            const BundleDims& expected = ioDims_->dims[i];
+            LOGE("[HIAI_DEMO_MODEL] bundle expects %ux%ux%ux%u for tensor %zu, the model has %ux%ux%ux%u.",
+                expected.n, expected.c, expected.h, expected.w, i, actual.GetNumber(), actual.GetChannel(),
+                actual.GetHeight(), actual.GetWidth());
+            return false;
+        }
+    }
+    return true;
+}
+
+shared_ptr<ModelBundle> FindModelBundle(const ModelSource& source)
+{
+    lock_guard<mutex> lock(g_bundleMutex);
+    for (const string* key : { &source.asset, &source.path }) {
+        auto it = key->empty() ? g_bundles.end() : g_bundles.find(*key);
+        if (it != g_bundles.end()) {
+            return it->second;
+        }
+    }
+    return nullptr;
+}
+
+void AddModelBundle(const string& key, const shared_ptr<ModelBundle>& bundle)
+{
+    lock_guard<mutex> lock(g_bundleMutex);
+    g_bundles[key] = bundle;
+}
@@ -0,0 +1,94 @@
+/*
+ * @file model_bundle.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_MODEL_BUNDLE_H
+#define HIAI_DEMO_MODEL_BUNDLE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "HiAiModelManagerService.h"
+#include "image_preprocess.h"
+#include "model_bundle_format.h"
+#include "model_mapping.h"
+
+/*
+ * A model bundle (model_bundle_format.h) validated in its mapping: the OM
+ * file, its labels, its preprocessing and its expected IO dims. Open checks
+ * every offset once; the accessors then point into the mapping, so nothing is
+ * parsed into copies and nothing but the bundle itself is allocated.
+ */
+class ModelBundle {
+public:
+    ModelBundle(const ModelBundle&) = delete;
+    ModelBundle& operator=(const ModelBundle&) = delete;
+
+    /* @return true if file starts like a bundle, not like a bare OM file */
+    static bool IsBundle(const ModelMapping& file);
+
+    /*
+    * @param [in] file mapping of the whole bundle, kept while the bundle lives
+    * @return nullptr if the bundle is invalid
+    */
+    static std::shared_ptr<ModelBundle> Open(const std::shared_ptr<ModelMapping>& file);
+
+    /* The OM file, as a mapping of its own for ModelResidency and SetModelBuffer */
+    std::shared_ptr<ModelMapping> Model() const;
+
+    /* 0 if the bundle has no label table */
+    uint32_t LabelCount() const { return labels_ == nullptr ? 0 : labels_->count; }
+
+    /*
+    * @param [out] length bytes of the label, not 0-terminated
+    * @return first byte of the label, nullptr if index is out of range
+    */
+    const char* Label(size_t index, size_t& length) const;
+
+    /* nullptr if the bundle has no preprocessing */
+    const BundlePreprocess* Preprocess() const { return preprocess_; }
+
+    /* CPU normalization of the preprocessing; none (zero mean, unit scale, BGR) without one */
+    NormalizeSpec Normalize() const;
+
+    /* nullptr if the bundle has no IO dims */
+    const BundleIoDims* IoDims() const { return ioDims_; }
+
+    /*
+    * @brief Compare the dims the DDK reports for the loaded model with the
+    *        expected ones
+    * @return true if they match or the bundle expects none
+    */
+    bool MatchesIo(const std::vector<hiai::TensorDimension>& inputs,
+        const std::vector<hiai::TensorDimension>& outputs) const;
+
+private:
+    ModelBundle() = default;
+    bool Validate();
+
+    std::shared_ptr<ModelMapping> file_;
+    const BundleHeader* header_ = nullptr;
+    const BundleSection* model_ = nullptr;
+    const BundleLabels* labels_ = nullptr;
+    const char* labelText_ = nullptr;
+    const BundlePreprocess* preprocess_ = nullptr;
+    const BundleIoDims* ioDims_ = nullptr;
+};
+
+/*
+* @brief Bundle MapModel found at source, by its asset or else its file
+* @return nullptr if the model of source is a bare OM file or is not mapped yet
+*/
+std::shared_ptr<ModelBundle> FindModelBundle(const ModelSource& source);
+
+/* Make a bundle mapped from key (asset path or file) visible to FindModelBundle */
+void AddModelBundle(const std::string& key, const std::shared_ptr<ModelBundle>& bundle);
+
+#endif
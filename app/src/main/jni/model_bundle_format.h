@@ -0,0 +1,175 @@
+/*
+ * @file model_bundle_format.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_MODEL_BUNDLE_FORMAT_H
+#define HIAI_DEMO_MODEL_BUNDLE_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * On-disk layout of a model bundle, shared by the app and the host packer
+ * (tools/pack_model_bundle.cpp), so it includes nothing of Android or the DDK.
+ *
+ * A bundle is a header, a table of sections, then the sections. Every field
+ * is a little-endian 32-bit word, so the file is read in place from a mapping
+ * aligned to 4 bytes, which is what aapt gives an uncompressed asset. Sections
+ * start on BUNDLE_SECTION_ALIGN, the model on BUNDLE_MODEL_ALIGN.
+ *
+ *   header | section table | preprocess | io dims | labels | ... | model
+ */
+
+// "HBND"
+static const uint32_t BUNDLE_MAGIC = 0x444e4248;
+static const uint32_t BUNDLE_VERSION = 1;
+static const uint32_t BUNDLE_MAX_SECTIONS = 16;
+static const uint32_t BUNDLE_MAX_TENSORS = 16;
+static const uint32_t BUNDLE_SECTION_ALIGN = 64;
+static const uint32_t BUNDLE_MODEL_ALIGN = 4096;
+
+struct BundleHeader {
+    uint32_t magic;
+    uint32_t version;
+    // sizeof(BundleHeader), the section table follows
+    uint32_t headerSize;
+    uint32_t sectionCount;
+    uint32_t fileSize;
+    // BundleMetaChecksum: everything but the model, which the DDK checks on load
+    uint32_t checksum;
+    uint32_t reserved[2];
+};
+
+enum BundleSectionType {
+    // the OM file as it is
+    BUNDLE_SECTION_MODEL = 1,
+    // BundleLabels, one label per class
+    BUNDLE_SECTION_LABELS = 2,
+    // BundlePreprocess
+    BUNDLE_SECTION_PREPROCESS = 3,
+    // BundleIoDims
+    BUNDLE_SECTION_IO_DIMS = 4,
+};
+
+struct BundleSection {
+    uint32_t type;
+    // from the start of the file
+    uint32_t offset;
+    uint32_t size;
+    uint32_t reserved;
+};
+
+/*
+ * Label table: count, count + 1 offsets into the text that follows them, then
+ * the text. Label i is text[offsets[i], offsets[i + 1]), not 0-terminated.
+ */
+struct BundleLabels {
+    uint32_t count;
+    uint32_t offsets[1];
+};
+
+enum BundleChannelOrder {
+    BUNDLE_CHANNELS_RGB = 0,
+    BUNDLE_CHANNELS_BGR = 1,
+};
+
+enum BundleLayout {
+    BUNDLE_LAYOUT_NCHW = 0,
+    BUNDLE_LAYOUT_NHWC = 1,
+};
+
+/*
+ * How an image becomes the model input. Without AIPP the app normalizes on the
+ * CPU: out = (pixel - mean[c]) / std[c], channels in channelOrder. With AIPP
+ * the input is a YUV420SP frame and the aipp* fields are the parameters of
+ * HiAiAippPara.h: colour matrix, crop and DTC.
+ */
+struct BundlePreprocess {
+    float mean[3];
+    float std[3];
+    // BundleChannelOrder
+    uint32_t channelOrder;
+    // BundleLayout
+    uint32_t layout;
+
+    uint32_t useAipp;
+    // hiai::ImageType
+    uint32_t aippImageType;
+    // V before U in the chroma plane
+    uint32_t aippNv21;
+    uint32_t aippCropSwitch;
+    uint32_t aippCropX;
+    uint32_t aippCropY;
+    uint32_t aippCropW;
+    uint32_t aippCropH;
+    float aippDtcMean[3];
+    float aippDtcVarReci[3];
+    uint32_t reserved[4];
+};
+
+struct BundleDims {
+    uint32_t n;
+    uint32_t c;
+    uint32_t h;
+    uint32_t w;
+};
+
+/* Expected dims of the model, inputs first */
+struct BundleIoDims {
+    uint32_t inputCount;
+    uint32_t outputCount;
+    BundleDims dims[1];
+};
+
+static_assert(sizeof(BundleHeader) == 32, "BundleHeader is part of the file format");
+static_assert(sizeof(BundleSection) == 16, "BundleSection is part of the file format");
+static_assert(sizeof(BundlePreprocess) == 104, "BundlePreprocess is part of the file format");
+static_assert(sizeof(BundleDims) == 16, "BundleDims is part of the file format");
+
+inline size_t BundleLabelsSize(uint32_t count, uint32_t textSize)
+{
+    return sizeof(uint32_t) * (2 + (size_t)count) + textSize;
+}
+
+inline size_t BundleIoDimsSize(uint32_t inputCount, uint32_t outputCount)
+{
+    return 2 * sizeof(uint32_t) + sizeof(BundleDims) * ((size_t)inputCount + outputCount);
+}
+
+inline uint32_t BundleFnv1a(const uint8_t* data, size_t size, uint32_t hash)
+{
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/*
+* @brief Checksum of a bundle whose header and sections are in bounds: the
+*        header but its checksum, the section table and every section but the
+*        model
+*/
+inline uint32_t BundleMetaChecksum(const uint8_t* file)
+{
+    const BundleHeader* header = reinterpret_cast<const BundleHeader*>(file);
+    const BundleSection* sections = reinterpret_cast<const BundleSection*>(file + header->headerSize);
+    uint32_t hash = 2166136261u;
+    hash = BundleFnv1a(file, offsetof(BundleHeader, checksum), hash);
+    hash = BundleFnv1a(file + offsetof(BundleHeader, reserved), header->headerSize - offsetof(BundleHeader, reserved),
+        hash);
+    hash = BundleFnv1a(file + header->headerSize, sizeof(BundleSection) * header->sectionCount, hash);
+    for (uint32_t i = 0; i < header->sectionCount; ++i) {
+        if (sections[i].type != BUNDLE_SECTION_MODEL) {
+            hash = BundleFnv1a(file + sections[i].offset, sections[i].size, hash);
+        }
+    }
+    return hash;
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * @file model_bundle_jni.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include <jni.h>
+
+#include <android/log.h>
+#include "jni_common.h"
+#include "model_bundle.h"
+
+#define LOG_TAG "MODEL_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+static void SetDims(JNIEnv *env, jobject modelInfo, jclass modelInfoClass, const char* prefix, const BundleDims& dims,
+    uint32_t count)
+{
+    const char* names[] = { "_N", "_C", "_H", "_W", "_Number" };
+    const uint32_t values[] = { dims.n, dims.c, dims.h, dims.w, count };
+    for (int i = 0; i < 5; ++i) {
+        jfieldID field = env->GetFieldID(modelInfoClass, (string(prefix) + names[i]).c_str(), "I");
+        env->SetIntField(modelInfo, field, (jint)values[i]);
+    }
+}
+
+static void SetFloats(JNIEnv *env, jobject modelInfo, jclass modelInfoClass, const char* name, const float* values)
+{
+    jfloatArray array = env->NewFloatArray(3);
+    env->SetFloatArrayRegion(array, 0, 3, values);
+    env->SetObjectField(modelInfo, env->GetFieldID(modelInfoClass, name, "[F"), array);
+    env->DeleteLocalRef(array);
+}
+
+static void SetPreprocess(JNIEnv *env, jobject modelInfo, jclass modelInfoClass, const BundlePreprocess& pre)
+{
+    SetFloats(env, modelInfo, modelInfoClass, "normalizeMean", pre.mean);
+    SetFloats(env, modelInfo, modelInfoClass, "normalizeStd", pre.std);
+    env->SetBooleanField(modelInfo, env->GetFieldID(modelInfoClass, "normalizeBgr", "Z"),
+        pre.channelOrder == BUNDLE_CHANNELS_BGR);
+
+    env->SetBooleanField(modelInfo, env->GetFieldID(modelInfoClass, "useAIPP", "Z"), pre.useAipp != 0);
+    env->SetIntField(modelInfo, env->GetFieldID(modelInfoClass, "aippImageType", "I"), (jint)pre.aippImageType);
+    env->SetBooleanField(modelInfo, env->GetFieldID(modelInfoClass, "aippNv21", "Z"), pre.aippNv21 != 0);
+    if (pre.aippCropSwitch != 0) {
+        const jint rect[] = { (jint)pre.aippCropX, (jint)pre.aippCropY, (jint)pre.aippCropW, (jint)pre.aippCropH };
+        jintArray crop = env->NewIntArray(4);
+        env->SetIntArrayRegion(crop, 0, 4, rect);
+        env->SetObjectField(modelInfo, env->GetFieldID(modelInfoClass, "aippCrop", "[I"), crop);
+        env->DeleteLocalRef(crop);
+    }
+    SetFloats(env, modelInfo, modelInfoClass, "aippMean", pre.aippDtcMean);
+    SetFloats(env, modelInfo, modelInfoClass, "aippVarReci", pre.aippDtcVarReci);
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_readModelBundle(JNIEnv *env, jclass type, jobject modelInfo)
+{
+    ModelSource source;
+    if (env == nullptr || modelInfo == nullptr || !GetModelSource(env, modelInfo, source)) {
+        LOGE("[HIAI_DEMO_MODEL] readModelBundle invalid params.");
+        return JNI_FALSE;
+    }
+    // adds the bundle for FindModelBundle, which the load finds again
+    if (MapModel(source) == nullptr) {
+        return JNI_FALSE;
+    }
+    // the name the bundle was mapped under, its asset first
+    string name = source.asset;
+    shared_ptr<ModelBundle> bundle = FindModelBundle(ModelSource{ source.asset, "" });
+    if (bundle == nullptr) {
+        name = source.path;
+        bundle = FindModelBundle(ModelSource{ "", source.path });
+    }
+    if (bundle == nullptr) {
+        LOGE("[HIAI_DEMO_MODEL] %s is not a model bundle.", source.path.c_str());
+        return JNI_FALSE;
+    }
+
+    jclass modelInfoClass = env->GetObjectClass(modelInfo);
+    const BundleIoDims* io = bundle->IoDims();
+    if (io != nullptr && io->inputCount > 0 && io->outputCount > 0) {
+        SetDims(env, modelInfo, modelInfoClass, "input", io->dims[0], io->inputCount);
+        SetDims(env, modelInfo, modelInfoClass, "output", io->dims[io->inputCount], io->outputCount);
+    }
+    if (bundle->Preprocess() != nullptr) {
+        SetPreprocess(env, modelInfo, modelInfoClass, *bundle->Preprocess());
+    }
+    if (bundle->LabelCount() > 0) {
+        jstring label = env->NewStringUTF(name.c_str());
+        env->SetObjectField(modelInfo, env->GetFieldID(modelInfoClass, "onlineModelLabel", "Ljava/lang/String;"),
+            label);
+        env->DeleteLocalRef(label);
+    }
+    return env->ExceptionCheck() ? JNI_FALSE : JNI_TRUE;
+}
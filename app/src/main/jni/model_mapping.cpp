@@ -0,0 +1,163 @@
+/*
+ * @file model_mapping.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "model_mapping.h"
+#include "model_bundle.h"
+
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <android/log.h>
+
+#define LOG_TAG "MODEL_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+static mutex g_assetMutex;
+static AAssetManager* g_assetManager = nullptr;
+
+ModelMapping::~ModelMapping()
+{
+    if (mapBase_ != nullptr) {
+        munmap(mapBase_, mapLength_);
+    }
+    if (asset_ != nullptr) {
+        AAsset_close(asset_);
+    }
+}
+
+bool ModelMapping::Map(int fd, int64_t offset, int64_t length)
+{
+    if (length <= 0 || length > (int64_t)UINT32_MAX) {
+        LOGE("[HIAI_DEMO_MODEL] model size %lld is not supported.", (long long)length);
+        return false;
+    }
+    // mmap offsets are page aligned, an asset starts anywhere in the APK
+    int64_t pageSize = sysconf(_SC_PAGESIZE);
+    int64_t skip = offset % pageSize;
+    void* base = mmap(nullptr, (size_t)(length + skip), PROT_READ, MAP_PRIVATE, fd, (off_t)(offset - skip));
+    if (base == MAP_FAILED) {
+        LOGE("[HIAI_DEMO_MODEL] mmap failed.");
+        return false;
+    }
+    // Load reads the whole model at once: start reading ahead now
+    madvise(base, (size_t)(length + skip), MADV_WILLNEED);
+    mapBase_ = base;
+    mapLength_ = (size_t)(length + skip);
+    data_ = static_cast<const uint8_t*>(base) + skip;
+    size_ = (uint32_t)length;
+    return true;
+}
+
+shared_ptr<ModelMapping> ModelMapping::MapFile(const string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("[HIAI_DEMO_MODEL] cannot open the model file %s.", path.c_str());
+        return nullptr;
+    }
+    shared_ptr<ModelMapping> mapping(new ModelMapping());
+    struct stat st;
+    // the mapping outlives the descriptor
+    bool ok = fstat(fd, &st) == 0 && mapping->Map(fd, 0, (int64_t)st.st_size);
+    close(fd);
+    return ok ? mapping : nullptr;
+}
+
+shared_ptr<ModelMapping> ModelMapping::MapAsset(AAssetManager* mgr, const string& fileName)
+{
+    AAsset* asset = AAssetManager_open(mgr, fileName.c_str(), AASSET_MODE_BUFFER);
+    if (asset == nullptr) {
+        return nullptr;
+    }
+    shared_ptr<ModelMapping> mapping(new ModelMapping());
+    off64_t start = 0;
+    off64_t length = 0;
+    int fd = AAsset_openFileDescriptor64(asset, &start, &length);
+    if (fd >= 0) {
+        // stored uncompressed: map its bytes straight from the APK
+        bool ok = mapping->Map(fd, (int64_t)start, (int64_t)length);
+        close(fd);
+        AAsset_close(asset);
+        return ok ? mapping : nullptr;
+    }
+    LOGI("[HIAI_DEMO_MODEL] asset %s is compressed, it is inflated on the heap.", fileName.c_str());
+    mapping->asset_ = asset;
+    mapping->data_ = AAsset_getBuffer(asset);
+    off64_t size = AAsset_getLength64(asset);
+    if (mapping->data_ == nullptr || size <= 0 || size > (off64_t)UINT32_MAX) {
+        LOGE("[HIAI_DEMO_MODEL] AAsset_getBuffer %s failed.", fileName.c_str());
+        return nullptr;
+    }
+    mapping->size_ = (uint32_t)size;
+    return mapping;
+}
+
+shared_ptr<ModelMapping> ModelMapping::Slice(const shared_ptr<ModelMapping>& whole, uint32_t offset, uint32_t size)
+{
+    if (whole == nullptr || size == 0 || offset > whole->size_ || size > whole->size_ - offset) {
+        return nullptr;
+    }
+    shared_ptr<ModelMapping> slice(new ModelMapping());
+    slice->whole_ = whole;
+    slice->data_ = static_cast<const uint8_t*>(whole->data_) + offset;
+    slice->size_ = size;
+    return slice;
+}
+
+// the OM file of a bundle, the file itself otherwise
+static shared_ptr<ModelMapping> OpenBundle(const string& key, const shared_ptr<ModelMapping>& file)
+{
+    if (!ModelBundle::IsBundle(*file)) {
+        return file;
+    }
+    shared_ptr<ModelBundle> bundle = ModelBundle::Open(file);
+    if (bundle == nullptr) {
+        LOGE("[HIAI_DEMO_MODEL] model bundle %s is invalid.", key.c_str());
+        return nullptr;
+    }
+    AddModelBundle(key, bundle);
+    LOGI("[HIAI_DEMO_MODEL] bundle %s: %u labels.", key.c_str(), bundle->LabelCount());
+    return bundle->Model();
+}
+
+void SetModelAssetManager(AAssetManager* mgr)
+{
+    lock_guard<mutex> lock(g_assetMutex);
+    g_assetManager = mgr;
+}
+
+shared_ptr<ModelMapping> MapModel(const ModelSource& source)
+{
+    AAssetManager* mgr = nullptr;
+    {
+        lock_guard<mutex> lock(g_assetMutex);
+        mgr = g_assetManager;
+    }
+    if (mgr != nullptr && !source.asset.empty()) {
+        shared_ptr<ModelMapping> mapping = ModelMapping::MapAsset(mgr, source.asset);
+        if (mapping != nullptr) {
+            LOGI("[HIAI_DEMO_MODEL] asset %s: %u bytes%s.", source.asset.c_str(), mapping->Size(),
+                mapping->Mapped() ? " mapped from the APK" : "");
+            return OpenBundle(source.asset, mapping);
+        }
+    }
+    shared_ptr<ModelMapping> mapping = ModelMapping::MapFile(source.path);
+    if (mapping != nullptr) {
+        LOGI("[HIAI_DEMO_MODEL] file %s: %u bytes mapped.", source.path.c_str(), mapping->Size());
+        return OpenBundle(source.path, mapping);
+    }
+    return nullptr;
+}
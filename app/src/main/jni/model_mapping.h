@@ -0,0 +1,92 @@
+/*
+ * @file model_mapping.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_MODEL_MAPPING_H
+#define HIAI_DEMO_MODEL_MAPPING_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <android/asset_manager.h>
+
+/* Where the OM file of a model is */
+struct ModelSource {
+    // asset path in the APK, e.g. "mobilenetCaffe.om"; empty for a file only
+    std::string asset;
+    // file in app storage, used when the asset cannot be opened
+    std::string path;
+};
+
+/*
+ * Read-only view of an OM file, handed to AiModelDescription::SetModelBuffer.
+ * Files and uncompressed APK assets are memory-mapped: the model is neither
+ * copied into app storage nor read onto the heap, and its pages belong to the
+ * page cache, which can drop them under memory pressure. A compressed asset
+ * falls back to the buffer the asset manager inflates.
+ */
+class ModelMapping {
+public:
+    ~ModelMapping();
+
+    ModelMapping(const ModelMapping&) = delete;
+    ModelMapping& operator=(const ModelMapping&) = delete;
+
+    /*
+    * @return nullptr if the file cannot be mapped or is empty
+    */
+    static std::shared_ptr<ModelMapping> MapFile(const std::string& path);
+
+    /*
+    * @param [in] fileName asset path, e.g. "mobilenetCaffe.om"
+    * @return nullptr if the asset cannot be opened
+    */
+    static std::shared_ptr<ModelMapping> MapAsset(AAssetManager* mgr, const std::string& fileName);
+
+    /*
+    * @brief Part of a mapping, which keeps the whole of it alive, e.g. the model
+    *        of a bundle
+    * @return nullptr if the range is not inside whole
+    */
+    static std::shared_ptr<ModelMapping> Slice(const std::shared_ptr<ModelMapping>& whole, uint32_t offset,
+        uint32_t size);
+
+    const void* Data() const { return data_; }
+    uint32_t Size() const { return size_; }
+    // false for a compressed asset inflated on the heap
+    bool Mapped() const { return whole_ != nullptr ? whole_->Mapped() : mapBase_ != nullptr; }
+
+private:
+    ModelMapping() = default;
+    bool Map(int fd, int64_t offset, int64_t length);
+
+    void* mapBase_ = nullptr;
+    size_t mapLength_ = 0;
+    // kept open while its buffer is used, for a compressed asset
+    AAsset* asset_ = nullptr;
+    // set for a Slice
+    std::shared_ptr<ModelMapping> whole_;
+    const void* data_ = nullptr;
+    uint32_t size_ = 0;
+};
+
+/*
+* @brief Asset manager the OM assets are mapped from, nullptr to use files only
+*/
+void SetModelAssetManager(AAssetManager* mgr);
+
+/*
+* @brief Map the OM file of a model: its asset if the asset manager has it,
+*        its file otherwise. For a model bundle (model_bundle.h) the OM file in
+*        it is returned and the bundle is added for FindModelBundle.
+* @return nullptr if neither can be mapped or the bundle is invalid
+*/
+std::shared_ptr<ModelMapping> MapModel(const ModelSource& source);
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * @file model_mapping_jni.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include <jni.h>
+
+#include <android/asset_manager_jni.h>
+#include <android/log.h>
+#include "model_mapping.h"
+
+#define LOG_TAG "MODEL_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_setModelAssets(JNIEnv *env, jclass type, jobject assetManager)
+{
+    if (env == nullptr || assetManager == nullptr) {
+        LOGE("[HIAI_DEMO_MODEL] setModelAssets invalid params.");
+        return JNI_FALSE;
+    }
+    AAssetManager* mgr = AAssetManager_fromJava(env, assetManager);
+    if (mgr == nullptr) {
+        LOGE("[HIAI_DEMO_MODEL] AAssetManager_fromJava failed.");
+        return JNI_FALSE;
+    }
+    // never deleted: the native manager lives as long as the Java one, and
+    // compressed assets opened from it stay in use while their model is loaded
+    if (env->NewGlobalRef(assetManager) == nullptr) {
+        return JNI_FALSE;
+    }
+    SetModelAssetManager(mgr);
+    return JNI_TRUE;
+}
@@ -0,0 +1,259 @@
+/*
+ * @file model_residency.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "model_residency.h"
+#include <chrono>
+#include <android/log.h>
+
+#define LOG_TAG "SYNC_DDK_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+using namespace hiai;
+
+static const int64_t LOAD_BUCKET_MS[RESIDENCY_LOAD_BUCKETS - 1] = { 10, 20, 50, 100, 200, 500, 1000 };
+
+bool ModelResidency::Add(const string& name, const shared_ptr<ModelMapping>& model,
+    AiModelDescription_Frequency frequency)
+{
+    if (model == nullptr) {
+        return false;
+    }
+    lock_guard<mutex> lock(mutex_);
+    if (Find(name) != nullptr) {
+        return true;
+    }
+    unique_ptr<Entry> entry(new Entry());
+    entry->name = name;
+    entry->model = model;
+    entry->frequency = frequency;
+    entries_.emplace(name, std::move(entry));
+    return true;
+}
+
+ModelResidency::Entry* ModelResidency::Find(const string& name) const
+{
+    auto it = entries_.find(name);
+    return it == entries_.end() ? nullptr : it->second.get();
+}
+
+shared_ptr<AiModelMngerClient> ModelResidency::Acquire(const string& name)
+{
+    unique_lock<mutex> lock(mutex_);
+    Entry* entry = Find(name);
+    if (entry == nullptr) {
+        LOGE("[HIAI_DEMO_SYNC] model %s is not registered.", name.c_str());
+        return nullptr;
+    }
+    // another thread loading the same model: wait for it instead of loading twice
+    loaded_.wait(lock, [entry] { return !entry->loading; });
+    if (entry->client != nullptr) {
+        hits_++;
+        entry->pins++;
+        lru_.splice(lru_.begin(), lru_, entry->lru);
+        return entry->client;
+    }
+
+    misses_++;
+    entry->loading = true;
+    uint64_t bytes = entry->model->Size() + entry->tensorBytes;
+    vector<shared_ptr<AiModelMngerClient>> evicted;
+    EvictFor(bytes, evicted);
+    entry->charged = bytes;
+    residentBytes_ += bytes;
+    lock.unlock();
+
+    // free the NPU memory before asking for more
+    Unload(evicted);
+    auto start = chrono::steady_clock::now();
+    shared_ptr<AiModelMngerClient> client = Load(*entry);
+    int64_t loadMs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+
+    lock.lock();
+    entry->loading = false;
+    loaded_.notify_all();
+    if (client == nullptr) {
+        residentBytes_ -= entry->charged;
+        entry->charged = 0;
+        loadFailures_++;
+        return nullptr;
+    }
+    uint32_t bucket = 0;
+    while (bucket < RESIDENCY_LOAD_BUCKETS - 1 && loadMs >= LOAD_BUCKET_MS[bucket]) {
+        bucket++;
+    }
+    loadHistogram_[bucket]++;
+    entry->client = client;
+    entry->pins++;
+    lru_.push_front(entry);
+    entry->lru = lru_.begin();
+    LOGI("[HIAI_DEMO_SYNC] model %s loaded in %lld ms, %llu bytes resident.", name.c_str(), (long long)loadMs,
+        (unsigned long long)residentBytes_);
+    return client;
+}
+
+void ModelResidency::Release(const string& name)
+{
+    lock_guard<mutex> lock(mutex_);
+    Entry* entry = Find(name);
+    if (entry != nullptr && entry->pins > 0) {
+        entry->pins--;
+    }
+}
+
+bool ModelResidency::Remove(const string& name)
+{
+    vector<shared_ptr<AiModelMngerClient>> evicted;
+    {
+        unique_lock<mutex> lock(mutex_);
+        Entry* entry = Find(name);
+        if (entry == nullptr) {
+            return false;
+        }
+        loaded_.wait(lock, [entry] { return !entry->loading; });
+        if (entry->pins > 0) {
+            LOGE("[HIAI_DEMO_SYNC] model %s is in use, it stays registered.", name.c_str());
+            return false;
+        }
+        if (entry->client != nullptr) {
+            evicted.push_back(std::move(entry->client));
+            residentBytes_ -= entry->charged;
+            lru_.erase(entry->lru);
+        }
+        entries_.erase(name);
+    }
+    Unload(evicted);
+    return true;
+}
+
+void ModelResidency::AddTensorBytes(const string& name, uint64_t bytes)
+{
+    lock_guard<mutex> lock(mutex_);
+    Entry* entry = Find(name);
+    if (entry == nullptr) {
+        return;
+    }
+    entry->tensorBytes += bytes;
+    if (entry->charged > 0) {
+        // made up for by the next load that needs room
+        entry->charged += bytes;
+        residentBytes_ += bytes;
+    }
+}
+
+void ModelResidency::SetBudget(uint64_t bytes)
+{
+    vector<shared_ptr<AiModelMngerClient>> evicted;
+    {
+        lock_guard<mutex> lock(mutex_);
+        budgetBytes_ = bytes;
+        EvictFor(0, evicted);
+    }
+    Unload(evicted);
+}
+
+void ModelResidency::EvictFor(uint64_t bytes, vector<shared_ptr<AiModelMngerClient>>& evicted)
+{
+    if (budgetBytes_ == 0) {
+        return;
+    }
+    auto it = lru_.end();
+    while (residentBytes_ + bytes > budgetBytes_ && it != lru_.begin()) {
+        --it;
+        Entry* victim = *it;
+        if (victim->pins > 0) {
+            continue;
+        }
+        LOGI("[HIAI_DEMO_SYNC] evict model %s, %llu bytes.", victim->name.c_str(),
+            (unsigned long long)victim->charged);
+        evicted.push_back(std::move(victim->client));
+        victim->client = nullptr;
+        residentBytes_ -= victim->charged;
+        victim->charged = 0;
+        evictions_++;
+        it = lru_.erase(it);
+    }
+    if (residentBytes_ + bytes > budgetBytes_) {
+        LOGI("[HIAI_DEMO_SYNC] models in use need %llu bytes, over the budget of %llu.",
+            (unsigned long long)(residentBytes_ + bytes), (unsigned long long)budgetBytes_);
+    }
+}
+
+shared_ptr<AiModelMngerClient> ModelResidency::Load(const Entry& entry)
+{
+    shared_ptr<AiModelMngerClient> client = make_shared<AiModelMngerClient>();
+    if (client->Init(nullptr) != 0) {
+        LOGE("[HIAI_DEMO_SYNC] Model Manager Init Failed.");
+        return nullptr;
+    }
+    shared_ptr<AiModelDescription> desc = make_shared<AiModelDescription>(entry.name + ".om", entry.frequency,
+        HIAI_FRAMEWORK_NONE, HIAI_MODELTYPE_ONLINE, AiModelDescription_DeviceType_NPU);
+    desc->SetModelBuffer(entry.model->Data(), entry.model->Size());
+    vector<shared_ptr<AiModelDescription>> modelDescs;
+    modelDescs.push_back(desc);
+    int ret = client->Load(modelDescs);
+    if (ret != 0) {
+        LOGE("[HIAI_DEMO_SYNC] Model %s Load Failed, ret=%d.", entry.name.c_str(), ret);
+        return nullptr;
+    }
+    return client;
+}
+
+void ModelResidency::Unload(vector<shared_ptr<AiModelMngerClient>>& evicted)
+{
+    for (auto& client : evicted) {
+        int ret = client->UnLoadModel();
+        if (ret != 0) {
+            LOGE("[HIAI_DEMO_SYNC] UnLoadModel failed, ret=%d.", ret);
+        }
+    }
+    evicted.clear();
+}
+
+void ModelResidency::DropClients()
+{
+    lock_guard<mutex> lock(mutex_);
+    for (Entry* entry : lru_) {
+        // no UnLoadModel: the models went with the service. Sessions running
+        // on a client keep their own reference to it until Release.
+        entry->client = nullptr;
+        residentBytes_ -= entry->charged;
+        entry->charged = 0;
+    }
+    LOGI("[HIAI_DEMO_SYNC] %zu models dropped, they are reloaded on their next inference.", lru_.size());
+    lru_.clear();
+}
+
+ResidencyStats ModelResidency::GetStats() const
+{
+    lock_guard<mutex> lock(mutex_);
+    ResidencyStats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.evictions = evictions_;
+    stats.loadFailures = loadFailures_;
+    stats.models = (uint32_t)entries_.size();
+    stats.residentModels = (uint32_t)lru_.size();
+    stats.residentBytes = residentBytes_;
+    stats.budgetBytes = budgetBytes_;
+    for (uint32_t i = 0; i < RESIDENCY_LOAD_BUCKETS; ++i) {
+        stats.loadHistogram[i] = loadHistogram_[i];
+    }
+    return stats;
+}
+
+ModelResidency& ModelResidency::Shared()
+{
+    // never deleted: sessions may still release models while the process exits
+    static ModelResidency* residency = new ModelResidency();
+    return *residency;
+}
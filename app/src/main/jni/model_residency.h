@@ -0,0 +1,142 @@
+/*
+ * @file model_residency.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_MODEL_RESIDENCY_H
+#define HIAI_DEMO_MODEL_RESIDENCY_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "HiAiModelManagerService.h"
+#include "model_mapping.h"
+
+// load times are counted in buckets up to 10, 20, 50, 100, 200, 500, 1000 ms and above
+static const uint32_t RESIDENCY_LOAD_BUCKETS = 8;
+
+struct ResidencyStats {
+    // Acquire calls that found the model loaded, or had to load it
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t loadFailures = 0;
+    uint32_t models = 0;
+    uint32_t residentModels = 0;
+    uint64_t residentBytes = 0;
+    // 0 when models are never evicted
+    uint64_t budgetBytes = 0;
+    uint64_t loadHistogram[RESIDENCY_LOAD_BUCKETS] = {};
+};
+
+/*
+ * Keeps the models registered with it loaded on the NPU within a memory
+ * budget. Every model gets a client of its own, as UnLoadModel drops all the
+ * models of a client, and its OM file stays mapped so that a model evicted
+ * to make room is reloaded without opening it again.
+ *
+ * The footprint of a model is the size of its OM file plus the tensors its
+ * users report; the least recently used models nobody is running are
+ * unloaded while a load would go over the budget. When every loaded model is
+ * in use the load goes ahead over budget rather than failing the inference.
+ */
+class ModelResidency {
+public:
+    ModelResidency() = default;
+
+    ModelResidency(const ModelResidency&) = delete;
+    ModelResidency& operator=(const ModelResidency&) = delete;
+
+    /*
+    * @brief Register a model, it is loaded by the first Acquire
+    * @param [in] model its OM file, see MapModel
+    * @param [in] frequency NPU frequency the model is loaded with
+    * @return false if model is nullptr; true if the model is already registered
+    */
+    bool Add(const std::string& name, const std::shared_ptr<ModelMapping>& model,
+        hiai::AiModelDescription_Frequency frequency);
+
+    /*
+    * @brief Client with the model loaded, loading it first if it was evicted.
+    *        The model is not evicted until the matching Release.
+    * @return nullptr if the model is not registered or cannot be loaded
+    */
+    std::shared_ptr<hiai::AiModelMngerClient> Acquire(const std::string& name);
+
+    void Release(const std::string& name);
+
+    /*
+    * @brief Unregister a model nobody runs, unloading it if it is loaded
+    * @return false if the model is not registered or is in use
+    */
+    bool Remove(const std::string& name);
+
+    /*
+    * @brief Count more tensor memory against the footprint of a model
+    */
+    void AddTensorBytes(const std::string& name, uint64_t bytes);
+
+    /*
+    * @brief Set the budget, unloading idle models until it is met
+    * @param [in] bytes 0 to never evict
+    */
+    void SetBudget(uint64_t bytes);
+
+    /*
+    * @brief Forget the clients of every loaded model, e.g. after the NPU service
+    *        died; the next Acquire of a model reloads it from host memory
+    */
+    void DropClients();
+
+    ResidencyStats GetStats() const;
+
+    /* Residency of the models loaded by loadModelSync */
+    static ModelResidency& Shared();
+
+private:
+    struct Entry {
+        std::string name;
+        std::shared_ptr<ModelMapping> model;
+        hiai::AiModelDescription_Frequency frequency = hiai::AiModelDescription_Frequency_HIGH;
+        uint64_t tensorBytes = 0;
+        // bytes counted in residentBytes_, while loaded or loading
+        uint64_t charged = 0;
+        std::shared_ptr<hiai::AiModelMngerClient> client;
+        bool loading = false;
+        uint32_t pins = 0;
+        // position in lru_ while loaded
+        std::list<Entry*>::iterator lru;
+    };
+
+    Entry* Find(const std::string& name) const;
+    // move out the clients of idle models until bytes more fit, unloaded by the caller
+    void EvictFor(uint64_t bytes, std::vector<std::shared_ptr<hiai::AiModelMngerClient>>& evicted);
+    static std::shared_ptr<hiai::AiModelMngerClient> Load(const Entry& entry);
+    static void Unload(std::vector<std::shared_ptr<hiai::AiModelMngerClient>>& evicted);
+
+    mutable std::mutex mutex_;
+    std::condition_variable loaded_;
+    std::map<std::string, std::unique_ptr<Entry>> entries_;
+    // loaded models, most recently used first
+    std::list<Entry*> lru_;
+    uint64_t budgetBytes_ = 0;
+    uint64_t residentBytes_ = 0;
+
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+    uint64_t loadFailures_ = 0;
+    uint64_t loadHistogram_[RESIDENCY_LOAD_BUCKETS] = {};
+};
+
+#endif
@@ -0,0 +1,149 @@
+/*
+ * @file pipeline_executor.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "pipeline_executor.h"
+
+using namespace std;
+
+PipelineExecutor::PipelineExecutor(const PipelineConfig& config, const PipelineStages& stages)
+    : config_(config), stages_(stages),
+      preprocessQueue_(config.queueDepth), submitQueue_(config.queueDepth),
+      // every in-flight job fits, so a completion never blocks the thread reporting it
+      postprocessQueue_(config.maxInFlight > 0 ? config.maxInFlight : 1),
+      completed_(0), dropped_(0)
+{
+    if (config_.preprocessThreads == 0) {
+        config_.preprocessThreads = 1;
+    }
+    if (config_.maxInFlight == 0) {
+        config_.maxInFlight = 1;
+    }
+    for (uint32_t i = 0; i < config_.preprocessThreads; ++i) {
+        preprocessThreads_.emplace_back(&PipelineExecutor::PreprocessLoop, this);
+    }
+    submitThread_ = thread(&PipelineExecutor::SubmitLoop, this);
+    postprocessThread_ = thread(&PipelineExecutor::PostprocessLoop, this);
+}
+
+PipelineExecutor::~PipelineExecutor()
+{
+    Stop();
+}
+
+bool PipelineExecutor::Push(const PipelineJobPtr& job)
+{
+    if (job == nullptr) {
+        return false;
+    }
+    return preprocessQueue_.Push(job);
+}
+
+void PipelineExecutor::Stop()
+{
+    lock_guard<mutex> stopLock(stopMutex_);
+    if (stopped_) {
+        return;
+    }
+    stopped_ = true;
+
+    // each stage drains its queue before the next one is closed
+    preprocessQueue_.Close();
+    for (auto& worker : preprocessThreads_) {
+        worker.join();
+    }
+    submitQueue_.Close();
+    submitThread_.join();
+    {
+        unique_lock<mutex> lock(inFlightMutex_);
+        inFlightCv_.wait(lock, [this] { return inFlight_ == 0; });
+    }
+    postprocessQueue_.Close();
+    postprocessThread_.join();
+}
+
+PipelineStats PipelineExecutor::GetStats() const
+{
+    PipelineStats stats;
+    stats.preprocessQueue = (uint32_t)preprocessQueue_.Size();
+    stats.submitQueue = (uint32_t)submitQueue_.Size();
+    stats.postprocessQueue = (uint32_t)postprocessQueue_.Size();
+    stats.preprocessQueuePeak = (uint32_t)preprocessQueue_.Peak();
+    stats.submitQueuePeak = (uint32_t)submitQueue_.Peak();
+    stats.postprocessQueuePeak = (uint32_t)postprocessQueue_.Peak();
+    {
+        lock_guard<mutex> lock(inFlightMutex_);
+        stats.inFlight = inFlight_;
+    }
+    stats.completed = completed_.load();
+    stats.dropped = dropped_.load();
+    return stats;
+}
+
+void PipelineExecutor::Drop(PipelineJob& job)
+{
+    if (stages_.discard) {
+        stages_.discard(job);
+    }
+    dropped_++;
+}
+
+void PipelineExecutor::PreprocessLoop()
+{
+    PipelineJobPtr job;
+    while (preprocessQueue_.Pop(job)) {
+        if (!stages_.preprocess(*job) || !submitQueue_.Push(job)) {
+            Drop(*job);
+        }
+        job.reset();
+    }
+    if (stages_.threadExit) {
+        stages_.threadExit();
+    }
+}
+
+void PipelineExecutor::SubmitLoop()
+{
+    PipelineJobPtr job;
+    while (submitQueue_.Pop(job)) {
+        {
+            unique_lock<mutex> lock(inFlightMutex_);
+            inFlightCv_.wait(lock, [this] { return inFlight_ < config_.maxInFlight; });
+            inFlight_++;
+        }
+        PipelineJobPtr submitted = job;
+        bool ok = stages_.submit(job, [this, submitted] { postprocessQueue_.Push(submitted); });
+        if (!ok) {
+            Drop(*job);
+            lock_guard<mutex> lock(inFlightMutex_);
+            inFlight_--;
+            inFlightCv_.notify_all();
+        }
+        job.reset();
+    }
+    if (stages_.threadExit) {
+        stages_.threadExit();
+    }
+}
+
+void PipelineExecutor::PostprocessLoop()
+{
+    PipelineJobPtr job;
+    while (postprocessQueue_.Pop(job)) {
+        stages_.postprocess(*job);
+        job.reset();
+        completed_++;
+        lock_guard<mutex> lock(inFlightMutex_);
+        inFlight_--;
+        inFlightCv_.notify_all();
+    }
+    if (stages_.threadExit) {
+        stages_.threadExit();
+    }
+}
@@ -0,0 +1,122 @@
+/*
+ * @file pipeline_executor.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_PIPELINE_EXECUTOR_H
+#define HIAI_DEMO_PIPELINE_EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "bounded_queue.h"
+
+/* One frame travelling through the pipeline; stages keep their state in a subclass */
+class PipelineJob {
+public:
+    virtual ~PipelineJob() = default;
+};
+
+using PipelineJobPtr = std::shared_ptr<PipelineJob>;
+
+struct PipelineStages {
+    // CPU work on the worker pool; false drops the job
+    std::function<bool(PipelineJob&)> preprocess;
+    // start inference and return; done() must be called exactly once, from
+    // any thread, when the result is ready. false drops the job.
+    std::function<bool(const PipelineJobPtr&, std::function<void()> done)> submit;
+    // runs on the post-processing thread, once per submitted job
+    std::function<void(PipelineJob&)> postprocess;
+    // a job that will not reach postprocess, to release what it holds
+    std::function<void(PipelineJob&)> discard;
+    // called by every stage thread before it exits, optional
+    std::function<void()> threadExit;
+};
+
+struct PipelineConfig {
+    uint32_t preprocessThreads = 2;
+    // jobs waiting for preprocessing, and preprocessed jobs waiting for submission
+    uint32_t queueDepth = 2;
+    // jobs submitted and not post-processed yet
+    uint32_t maxInFlight = 2;
+};
+
+/* Queue depths now and at their peak, to see which stage limits the frame rate */
+struct PipelineStats {
+    uint32_t preprocessQueue = 0;
+    uint32_t submitQueue = 0;
+    uint32_t inFlight = 0;
+    uint32_t postprocessQueue = 0;
+    uint32_t preprocessQueuePeak = 0;
+    uint32_t submitQueuePeak = 0;
+    uint32_t postprocessQueuePeak = 0;
+    uint64_t completed = 0;
+    uint64_t dropped = 0;
+};
+
+/*
+ * preprocess (worker pool) -> submit (one thread) -> postprocess (one thread),
+ * with bounded queues in between. Each stage works on a different frame, so
+ * the frame rate approaches that of the slowest stage instead of the sum of
+ * all of them. Push blocks while the first queue is full, and every stage
+ * blocks on the next, so a slow accelerator or listener throttles the producer.
+ */
+class PipelineExecutor {
+public:
+    PipelineExecutor(const PipelineConfig& config, const PipelineStages& stages);
+    ~PipelineExecutor();
+
+    PipelineExecutor(const PipelineExecutor&) = delete;
+    PipelineExecutor& operator=(const PipelineExecutor&) = delete;
+
+    /*
+    * @brief Queue a frame, waiting while the first queue is full
+    * @return false if the pipeline is stopped
+    */
+    bool Push(const PipelineJobPtr& job);
+
+    /*
+    * @brief Finish every queued and in-flight job, then join the stage threads
+    */
+    void Stop();
+
+    PipelineStats GetStats() const;
+
+private:
+    void PreprocessLoop();
+    void SubmitLoop();
+    void PostprocessLoop();
+    void Drop(PipelineJob& job);
+
+    PipelineConfig config_;
+    PipelineStages stages_;
+
+    BoundedQueue<PipelineJobPtr> preprocessQueue_;
+    BoundedQueue<PipelineJobPtr> submitQueue_;
+    BoundedQueue<PipelineJobPtr> postprocessQueue_;
+
+    mutable std::mutex inFlightMutex_;
+    std::condition_variable inFlightCv_;
+    uint32_t inFlight_ = 0;
+
+    std::atomic<uint64_t> completed_;
+    std::atomic<uint64_t> dropped_;
+
+    std::vector<std::thread> preprocessThreads_;
+    std::thread submitThread_;
+    std::thread postprocessThread_;
+    std::mutex stopMutex_;
+    bool stopped_ = false;
+};
+
+#endif
@@ -0,0 +1,310 @@
+/*
+ * @file pipeline_jni.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include <jni.h>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <android/bitmap.h>
+#include <android/log.h>
+#include "HiAiModelManagerService.h"
+#include "classify_async_jni.h"
+#include "image_preprocess.h"
+#include "jni_common.h"
+#include "pipeline_executor.h"
+#include "request_tracker.h"
+#include "task_pool.h"
+
+#define LOG_TAG "PIPELINE_DDK_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+using namespace hiai;
+
+// one bitmap on its way through the pipeline
+struct FrameJob : public PipelineJob {
+    vector<uint8_t> pixels;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t stride = 0;
+    jlong tag = 0;
+    RequestControlPtr control;
+    uint32_t slot = 0;
+    bool hasSlot = false;
+    int32_t taskId = 0;
+    int32_t result = 0;
+    chrono::steady_clock::time_point doneTime;
+};
+
+struct ModelPipeline {
+    int vecIndex = 0;
+    NormalizeSpec spec;
+    // global ref of the ModelManagerListener results go to
+    jobject listener = nullptr;
+    unique_ptr<PipelineExecutor> executor;
+};
+
+static JavaVM* g_pipelineVm = nullptr;
+// output rows of a frame resized by one task of the shared pool
+static const uint32_t PREPROCESS_ROWS_PER_TASK = 16;
+static mutex g_pipelineMutex;
+static map<int, shared_ptr<ModelPipeline>> g_pipelines;
+
+static JNIEnv* AttachPipelineThread()
+{
+    JNIEnv* env = nullptr;
+    if (g_pipelineVm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        g_pipelineVm->AttachCurrentThread(&env, nullptr);
+    }
+    return env;
+}
+
+static void DetachPipelineThread()
+{
+    JNIEnv* env = nullptr;
+    if (g_pipelineVm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) == JNI_OK) {
+        g_pipelineVm->DetachCurrentThread();
+    }
+}
+
+static bool PreprocessFrame(ModelPipeline& pipeline, FrameJob& job)
+{
+    TensorDimension dim;
+    if (!GetAsyncInputDim(pipeline.vecIndex, 0, dim)) {
+        return false;
+    }
+    // a frame that is stale or discarded by now is not worth resizing
+    if (!RequestTracker::Shared().Admit(job.control, "preprocessing") ||
+        !AcquireAsyncSlotFor(pipeline.vecIndex, job.control, job.slot)) {
+        return false;
+    }
+    job.hasSlot = true;
+    shared_ptr<AiTensor>& input = GetAsyncSlotInputs(pipeline.vecIndex, job.slot)[0];
+    // bands of the frame go to idle workers of the shared pool; the slot wait
+    // above stays on this thread, pool tasks must not block
+    ParallelFor(TaskPool::Shared(), dim.GetHeight(), PREPROCESS_ROWS_PER_TASK, [&](uint32_t first, uint32_t last) {
+        CropResizeNormalizeRows(job.pixels.data(), job.width, job.height, job.stride,
+            dim.GetWidth(), dim.GetHeight(), pipeline.spec, first, last, static_cast<float*>(input->GetBuffer()));
+    });
+    // the frame is in the slot now, do not keep a second copy while it waits
+    vector<uint8_t>().swap(job.pixels);
+    return true;
+}
+
+static PipelineStages MakePipelineStages(ModelPipeline* pipeline)
+{
+    PipelineStages stages;
+    stages.preprocess = [pipeline](PipelineJob& job) {
+        return PreprocessFrame(*pipeline, static_cast<FrameJob&>(job));
+    };
+    stages.submit = [pipeline](const PipelineJobPtr& job, function<void()> done) {
+        FrameJob* frame = static_cast<FrameJob*>(job.get());
+        JNIEnv* env = AttachPipelineThread();
+        int taskId = SubmitAsyncSlot(env, pipeline->vecIndex, frame->slot, pipeline->listener, frame->tag,
+            frame->control, [frame, done](int32_t taskId, int32_t result, chrono::steady_clock::time_point doneTime) {
+                frame->taskId = taskId;
+                frame->result = result;
+                frame->doneTime = doneTime;
+                done();
+            });
+        if (taskId < 0) {
+            // SubmitAsyncSlot released the slot
+            frame->hasSlot = false;
+            return false;
+        }
+        return true;
+    };
+    stages.postprocess = [](PipelineJob& job) {
+        FrameJob& frame = static_cast<FrameJob&>(job);
+        DeliverAsyncResult(AttachPipelineThread(), frame.taskId, frame.result, frame.doneTime);
+        frame.hasSlot = false;
+    };
+    stages.discard = [pipeline](PipelineJob& job) {
+        FrameJob& frame = static_cast<FrameJob&>(job);
+        // no-op if a hop already dropped it as expired or cancelled
+        RequestTracker::Shared().Finish(frame.control, REQUEST_FAILED);
+        if (frame.hasSlot) {
+            ReleaseAsyncSlot(pipeline->vecIndex, frame.slot);
+            frame.hasSlot = false;
+        }
+    };
+    stages.threadExit = DetachPipelineThread;
+    return stages;
+}
+
+static shared_ptr<ModelPipeline> FindPipeline(JNIEnv *env, jobject modelInfo)
+{
+    string modelName;
+    if (!GetModelName(env, modelInfo, modelName)) {
+        return nullptr;
+    }
+    int vecIndex = FindAsyncModelIndex(modelName);
+    std::lock_guard<std::mutex> lock(g_pipelineMutex);
+    auto it = g_pipelines.find(vecIndex);
+    if (vecIndex < 0 || it == g_pipelines.end()) {
+        LOGE("[HIAI_DEMO_PIPELINE] model %s has no pipeline.", modelName.c_str());
+        return nullptr;
+    }
+    return it->second;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_startPipelineAsync(JNIEnv *env, jclass type, jobject modelInfo,
+    jint preprocessThreads, jint queueDepth, jfloatArray mean, jfloatArray std, jboolean bgr, jobject listener)
+{
+    if (env == nullptr || modelInfo == nullptr || mean == nullptr || std == nullptr || listener == nullptr) {
+        LOGE("[HIAI_DEMO_PIPELINE] startPipelineAsync invalid params.");
+        return JNI_FALSE;
+    }
+    if (env->GetArrayLength(mean) != 3 || env->GetArrayLength(std) != 3) {
+        LOGE("[HIAI_DEMO_PIPELINE] mean and std must have 3 values.");
+        return JNI_FALSE;
+    }
+    string modelName;
+    if (!GetModelName(env, modelInfo, modelName)) {
+        return JNI_FALSE;
+    }
+    int vecIndex = FindAsyncModelIndex(modelName);
+    if (vecIndex < 0) {
+        LOGE("[HIAI_DEMO_PIPELINE] model %s is not loaded by loadModelAsync.", modelName.c_str());
+        return JNI_FALSE;
+    }
+    TensorDimension dim;
+    if (!GetAsyncInputDim(vecIndex, 0, dim) || dim.GetChannel() != 3 ||
+        GetAsyncSlotInputs(vecIndex, 0)[0]->GetSize() != 3 * dim.GetWidth() * dim.GetHeight() * sizeof(float)) {
+        LOGE("[HIAI_DEMO_PIPELINE] input of model %s is not 3 channel float32.", modelName.c_str());
+        return JNI_FALSE;
+    }
+
+    shared_ptr<ModelPipeline> pipeline = make_shared<ModelPipeline>();
+    pipeline->vecIndex = vecIndex;
+    float stdValue[3];
+    env->GetFloatArrayRegion(mean, 0, 3, pipeline->spec.mean);
+    env->GetFloatArrayRegion(std, 0, 3, stdValue);
+    for (int i = 0; i < 3; ++i) {
+        if (stdValue[i] == 0.0f) {
+            LOGE("[HIAI_DEMO_PIPELINE] std[%d] is 0.", i);
+            return JNI_FALSE;
+        }
+        pipeline->spec.scale[i] = 1.0f / stdValue[i];
+    }
+    pipeline->spec.bgr = (bgr == JNI_TRUE);
+
+    std::lock_guard<std::mutex> lock(g_pipelineMutex);
+    if (g_pipelines.count(vecIndex) != 0) {
+        LOGE("[HIAI_DEMO_PIPELINE] model %s already has a pipeline.", modelName.c_str());
+        return JNI_FALSE;
+    }
+    env->GetJavaVM(&g_pipelineVm);
+    pipeline->listener = env->NewGlobalRef(listener);
+
+    PipelineConfig config;
+    config.preprocessThreads = preprocessThreads > 0 ? (uint32_t)preprocessThreads : 1;
+    config.queueDepth = queueDepth > 0 ? (uint32_t)queueDepth : 1;
+    config.maxInFlight = GetAsyncDepth(vecIndex);
+    pipeline->executor.reset(new PipelineExecutor(config, MakePipelineStages(pipeline.get())));
+    g_pipelines[vecIndex] = pipeline;
+    LOGI("[HIAI_DEMO_PIPELINE] model %s pipeline: %u preprocess threads, queue depth %u, %u in flight.",
+        modelName.c_str(), config.preprocessThreads, config.queueDepth, config.maxInFlight);
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_submitPipelineAsync(JNIEnv *env, jclass type, jobject modelInfo,
+    jobject bitmap, jlong tag, jint timeoutMs)
+{
+    if (env == nullptr || modelInfo == nullptr || bitmap == nullptr) {
+        LOGE("[HIAI_DEMO_PIPELINE] submitPipelineAsync invalid params.");
+        return JNI_FALSE;
+    }
+    shared_ptr<ModelPipeline> pipeline = FindPipeline(env, modelInfo);
+    if (pipeline == nullptr) {
+        return JNI_FALSE;
+    }
+
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        LOGE("[HIAI_DEMO_PIPELINE] AndroidBitmap_getInfo failed.");
+        return JNI_FALSE;
+    }
+    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888 || info.width == 0 || info.height == 0) {
+        LOGE("[HIAI_DEMO_PIPELINE] bitmap format %d is not ARGB_8888.", info.format);
+        return JNI_FALSE;
+    }
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || pixels == nullptr) {
+        LOGE("[HIAI_DEMO_PIPELINE] AndroidBitmap_lockPixels failed.");
+        return JNI_FALSE;
+    }
+    // the bitmap may be reused by the caller as soon as this returns
+    shared_ptr<FrameJob> job = make_shared<FrameJob>();
+    job->width = info.width;
+    job->height = info.height;
+    job->stride = info.width * 4;
+    job->tag = tag;
+    job->control = RequestTracker::Shared().Begin(tag, timeoutMs > 0 ? (uint32_t)timeoutMs : 0);
+    job->pixels.resize((size_t)job->stride * info.height);
+    for (uint32_t y = 0; y < info.height; ++y) {
+        memcpy(job->pixels.data() + (size_t)y * job->stride, static_cast<uint8_t*>(pixels) + (size_t)y * info.stride,
+            job->stride);
+    }
+    AndroidBitmap_unlockPixels(env, bitmap);
+
+    if (!pipeline->executor->Push(job)) {
+        RequestTracker::Shared().Finish(job->control, REQUEST_FAILED);
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_getPipelineStatsAsync(JNIEnv *env, jclass type, jobject modelInfo)
+{
+    shared_ptr<ModelPipeline> pipeline = FindPipeline(env, modelInfo);
+    if (pipeline == nullptr) {
+        return nullptr;
+    }
+    PipelineStats stats = pipeline->executor->GetStats();
+    const jlong values[] = {
+        stats.preprocessQueue, stats.submitQueue, stats.inFlight, stats.postprocessQueue,
+        stats.preprocessQueuePeak, stats.submitQueuePeak, stats.postprocessQueuePeak,
+        (jlong)stats.completed, (jlong)stats.dropped
+    };
+    const jsize count = sizeof(values) / sizeof(values[0]);
+    jlongArray result = env->NewLongArray(count);
+    env->SetLongArrayRegion(result, 0, count, values);
+    return result;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_stopPipelineAsync(JNIEnv *env, jclass type, jobject modelInfo)
+{
+    shared_ptr<ModelPipeline> pipeline = FindPipeline(env, modelInfo);
+    if (pipeline == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_pipelineMutex);
+        g_pipelines.erase(pipeline->vecIndex);
+    }
+    // finishes every queued frame; the listener gets all their results
+    pipeline->executor->Stop();
+    env->DeleteGlobalRef(pipeline->listener);
+    pipeline->listener = nullptr;
+}
@@ -0,0 +1,296 @@
+/*
+ * @file postprocess.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "postprocess.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HIAI_DEMO_NEON
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define HIAI_DEMO_AVX2
+#define HIAI_DEMO_SSE2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define HIAI_DEMO_SSE2
+#endif
+
+using namespace std;
+
+// K above this is served by the reference, the insertion list would dominate
+static const uint32_t MAX_FAST_K = 64;
+
+uint32_t TopKRef(const float* scores, uint32_t count, uint32_t k, bool softmax, uint32_t* indices, float* values)
+{
+    k = std::min(k, count);
+    if (k == 0) {
+        return 0;
+    }
+    vector<uint32_t> order(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        order[i] = i;
+    }
+    std::partial_sort(order.begin(), order.begin() + k, order.end(), [scores](uint32_t a, uint32_t b) {
+        return scores[a] > scores[b] || (scores[a] == scores[b] && a < b);
+    });
+    float sum = 1.0f;
+    const float maxScore = scores[order[0]];
+    if (softmax) {
+        sum = 0.0f;
+        for (uint32_t i = 0; i < count; ++i) {
+            sum += std::exp(scores[i] - maxScore);
+        }
+    }
+    for (uint32_t i = 0; i < k; ++i) {
+        indices[i] = order[i];
+        values[i] = softmax ? std::exp(scores[order[i]] - maxScore) / sum : scores[order[i]];
+    }
+    return k;
+}
+
+// Insert a score beating values[k - 1] into the descending list; equal
+// scores keep the earlier index first.
+static inline void Insert(float score, uint32_t index, uint32_t k, uint32_t* indices, float* values)
+{
+    uint32_t pos = k - 1;
+    while (pos > 0 && values[pos - 1] < score) {
+        values[pos] = values[pos - 1];
+        indices[pos] = indices[pos - 1];
+        --pos;
+    }
+    values[pos] = score;
+    indices[pos] = index;
+}
+
+static inline void ScanScalar(const float* scores, uint32_t begin, uint32_t end, uint32_t k,
+    uint32_t* indices, float* values)
+{
+    for (uint32_t i = begin; i < end; ++i) {
+        if (scores[i] > values[k - 1]) {
+            Insert(scores[i], i, k, indices, values);
+        }
+    }
+}
+
+// exp(x) for x <= 0: x = n * ln2 + r, a degree 5 polynomial for exp(r) on
+// [-ln2/2, ln2/2] and 2^n through the exponent bits. The SIMD versions below
+// use the same constants.
+static const float EXP_MIN = -87.0f;
+static const float EXP_LOG2E = 1.44269504f;
+static const float EXP_LN2_HI = 0.693359375f;
+static const float EXP_LN2_LO = -2.12194440e-4f;
+static const float EXP_P0 = 1.9875691500e-4f;
+static const float EXP_P1 = 1.3981999507e-3f;
+static const float EXP_P2 = 8.3334519073e-3f;
+static const float EXP_P3 = 4.1665795894e-2f;
+static const float EXP_P4 = 1.6666665459e-1f;
+static const float EXP_P5 = 5.0000001201e-1f;
+
+static inline float ExpNonPositive(float x)
+{
+    x = std::max(x, EXP_MIN);
+    const float n = std::floor(x * EXP_LOG2E + 0.5f);
+    const float r = x - n * EXP_LN2_HI - n * EXP_LN2_LO;
+    float p = EXP_P0;
+    p = p * r + EXP_P1;
+    p = p * r + EXP_P2;
+    p = p * r + EXP_P3;
+    p = p * r + EXP_P4;
+    p = p * r + EXP_P5;
+    p = p * r * r + r + 1.0f;
+    int32_t bits = (static_cast<int32_t>(n) + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+#if defined(HIAI_DEMO_NEON)
+static inline float32x4_t ExpNonPositive4(float32x4_t x)
+{
+    x = vmaxq_f32(x, vdupq_n_f32(EXP_MIN));
+    float32x4_t fx = vmlaq_f32(vdupq_n_f32(0.5f), x, vdupq_n_f32(EXP_LOG2E));
+    // floor: truncation rounds negative values up
+    float32x4_t t = vcvtq_f32_s32(vcvtq_s32_f32(fx));
+    uint32x4_t up = vcgtq_f32(t, fx);
+    float32x4_t n = vsubq_f32(t, vreinterpretq_f32_u32(vandq_u32(up, vreinterpretq_u32_f32(vdupq_n_f32(1.0f)))));
+    float32x4_t r = vmlsq_f32(x, n, vdupq_n_f32(EXP_LN2_HI));
+    r = vmlsq_f32(r, n, vdupq_n_f32(EXP_LN2_LO));
+    float32x4_t p = vdupq_n_f32(EXP_P0);
+    p = vmlaq_f32(vdupq_n_f32(EXP_P1), p, r);
+    p = vmlaq_f32(vdupq_n_f32(EXP_P2), p, r);
+    p = vmlaq_f32(vdupq_n_f32(EXP_P3), p, r);
+    p = vmlaq_f32(vdupq_n_f32(EXP_P4), p, r);
+    p = vmlaq_f32(vdupq_n_f32(EXP_P5), p, r);
+    p = vaddq_f32(vmlaq_f32(r, p, vmulq_f32(r, r)), vdupq_n_f32(1.0f));
+    int32x4_t bits = vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127)), 23);
+    return vmulq_f32(p, vreinterpretq_f32_s32(bits));
+}
+#elif defined(HIAI_DEMO_AVX2)
+static inline __m256 ExpNonPositive8(__m256 x)
+{
+    x = _mm256_max_ps(x, _mm256_set1_ps(EXP_MIN));
+    __m256 n = _mm256_floor_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(EXP_LOG2E)), _mm256_set1_ps(0.5f)));
+    __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(EXP_LN2_HI)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(n, _mm256_set1_ps(EXP_LN2_LO)));
+    __m256 p = _mm256_set1_ps(EXP_P0);
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(EXP_P1));
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(EXP_P2));
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(EXP_P3));
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(EXP_P4));
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(EXP_P5));
+    p = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p, _mm256_mul_ps(r, r)), r), _mm256_set1_ps(1.0f));
+    __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(bits));
+}
+#elif defined(HIAI_DEMO_SSE2)
+static inline __m128 ExpNonPositive4(__m128 x)
+{
+    x = _mm_max_ps(x, _mm_set1_ps(EXP_MIN));
+    __m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(EXP_LOG2E)), _mm_set1_ps(0.5f));
+    // floor: truncation rounds negative values up
+    __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+    __m128 n = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, fx), _mm_set1_ps(1.0f)));
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(EXP_LN2_HI)));
+    r = _mm_sub_ps(r, _mm_mul_ps(n, _mm_set1_ps(EXP_LN2_LO)));
+    __m128 p = _mm_set1_ps(EXP_P0);
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(EXP_P1));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(EXP_P2));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(EXP_P3));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(EXP_P4));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(EXP_P5));
+    p = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p, _mm_mul_ps(r, r)), r), _mm_set1_ps(1.0f));
+    __m128i bits = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(p, _mm_castsi128_ps(bits));
+}
+#endif
+
+static float ExpSum(const float* scores, uint32_t count, float maxScore)
+{
+    uint32_t i = 0;
+    float sum = 0.0f;
+#if defined(HIAI_DEMO_NEON)
+    const float32x4_t maxVec = vdupq_n_f32(maxScore);
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; i + 4 <= count; i += 4) {
+        acc = vaddq_f32(acc, ExpNonPositive4(vsubq_f32(vld1q_f32(scores + i), maxVec)));
+    }
+    float32x2_t half = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    sum = vget_lane_f32(vpadd_f32(half, half), 0);
+#elif defined(HIAI_DEMO_AVX2)
+    const __m256 maxVec = _mm256_set1_ps(maxScore);
+    __m256 acc = _mm256_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        acc = _mm256_add_ps(acc, ExpNonPositive8(_mm256_sub_ps(_mm256_loadu_ps(scores + i), maxVec)));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, acc);
+    for (float lane : lanes) {
+        sum += lane;
+    }
+#elif defined(HIAI_DEMO_SSE2)
+    const __m128 maxVec = _mm_set1_ps(maxScore);
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm_add_ps(acc, ExpNonPositive4(_mm_sub_ps(_mm_loadu_ps(scores + i), maxVec)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    for (float lane : lanes) {
+        sum += lane;
+    }
+#endif
+    for (; i < count; ++i) {
+        sum += ExpNonPositive(scores[i] - maxScore);
+    }
+    return sum;
+}
+
+uint32_t TopK(const float* scores, uint32_t count, uint32_t k, bool softmax, uint32_t* indices, float* values)
+{
+    k = std::min(k, count);
+    if (k == 0) {
+        return 0;
+    }
+    if (k > MAX_FAST_K) {
+        return TopKRef(scores, count, k, softmax, indices, values);
+    }
+
+    // seed with the first k scores
+    for (uint32_t i = 0; i < k; ++i) {
+        values[i] = -INFINITY;
+        indices[i] = 0;
+    }
+    for (uint32_t i = 0; i < k; ++i) {
+        Insert(scores[i], i, k, indices, values);
+    }
+
+    uint32_t i = k;
+#if defined(HIAI_DEMO_NEON)
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t gt = vcgtq_f32(vld1q_f32(scores + i), vdupq_n_f32(values[k - 1]));
+        uint32x2_t any = vorr_u32(vget_low_u32(gt), vget_high_u32(gt));
+        if (vget_lane_u32(vpmax_u32(any, any), 0) != 0) {
+            ScanScalar(scores, i, i + 4, k, indices, values);
+        }
+    }
+#elif defined(HIAI_DEMO_AVX2)
+    for (; i + 8 <= count; i += 8) {
+        __m256 gt = _mm256_cmp_ps(_mm256_loadu_ps(scores + i), _mm256_set1_ps(values[k - 1]), _CMP_GT_OQ);
+        if (_mm256_movemask_ps(gt) != 0) {
+            ScanScalar(scores, i, i + 8, k, indices, values);
+        }
+    }
+#elif defined(HIAI_DEMO_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128 gt = _mm_cmpgt_ps(_mm_loadu_ps(scores + i), _mm_set1_ps(values[k - 1]));
+        if (_mm_movemask_ps(gt) != 0) {
+            ScanScalar(scores, i, i + 4, k, indices, values);
+        }
+    }
+#endif
+    // tail (and everything on targets without SIMD)
+    ScanScalar(scores, i, count, k, indices, values);
+
+    if (softmax) {
+        const float maxScore = values[0];
+        const float sum = ExpSum(scores, count, maxScore);
+        for (uint32_t j = 0; j < k; ++j) {
+            values[j] = ExpNonPositive(values[j] - maxScore) / sum;
+        }
+    }
+    return k;
+}
+
+uint32_t TopKPacked(const float* scores, uint32_t count, const PostprocessConfig& config, float* packed)
+{
+    uint32_t indices[MAX_FAST_K];
+    float values[MAX_FAST_K];
+    vector<uint32_t> indexVec;
+    vector<float> valueVec;
+    uint32_t* indexOut = indices;
+    float* valueOut = values;
+    if (config.topK > MAX_FAST_K) {
+        indexVec.resize(config.topK);
+        valueVec.resize(config.topK);
+        indexOut = indexVec.data();
+        valueOut = valueVec.data();
+    }
+    uint32_t n = TopK(scores, count, config.topK, config.softmax, indexOut, valueOut);
+    for (uint32_t i = 0; i < n; ++i) {
+        packed[2 * i] = static_cast<float>(indexOut[i]);
+        packed[2 * i + 1] = valueOut[i];
+    }
+    return 2 * n;
+}
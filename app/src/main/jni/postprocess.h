@@ -0,0 +1,51 @@
+/*
+ * @file postprocess.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_POSTPROCESS_H
+#define HIAI_DEMO_POSTPROCESS_H
+
+#include <cstdint>
+
+/* Post-processing attached to a loaded model. topK 0 returns the raw output. */
+struct PostprocessConfig {
+    uint32_t topK = 0;
+    bool softmax = false;
+};
+
+/*
+* @brief Top-K of a score vector, highest first, ties by lower index.
+*        Scalar reference built on std::partial_sort.
+* @param [in] scores  count scores
+* @param [in] count   number of classes
+* @param [in] k       results wanted, clamped to count
+* @param [in] softmax report softmax probabilities instead of raw scores
+* @param [out] indices min(k, count) class indices
+* @param [out] values  min(k, count) scores or probabilities
+* @return number of results written
+*/
+uint32_t TopKRef(const float* scores, uint32_t count, uint32_t k, bool softmax, uint32_t* indices, float* values);
+
+/*
+* @brief Same as TopKRef in one vectorized pass: a block of scores is only
+*        looked at one by one when one of them beats the current K-th score.
+*        With softmax a second pass sums exp(score - max); nothing is written
+*        back, so the probabilities match TopKRef within float rounding.
+*/
+uint32_t TopK(const float* scores, uint32_t count, uint32_t k, bool softmax, uint32_t* indices, float* values);
+
+/*
+* @brief Run TopK and pack the result as {index0, value0, index1, value1, ...}
+*        for a single float[] handed to Java. Indices are exact up to 2^24 classes.
+* @param [out] packed 2 * min(config.topK, count) floats
+* @return number of floats written
+*/
+uint32_t TopKPacked(const float* scores, uint32_t count, const PostprocessConfig& config, float* packed);
+
+#endif
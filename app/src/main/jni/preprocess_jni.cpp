@@ -0,0 +1,217 @@
+/*
+ * @file preprocess_jni.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include <jni.h>
+#include <string>
+
+#include <android/bitmap.h>
+#include <android/log.h>
+#include "HiAiModelManagerService.h"
+#include "classify_sync_jni.h"
+#include "image_preprocess.h"
+#include "jni_common.h"
+#include "task_pool.h"
+
+#define LOG_TAG "PREPROCESS_DDK_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+using namespace hiai;
+
+// rows of one image packed by a task of the shared pool
+static const uint32_t ROWS_PER_TASK = 16;
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_setInputFromBitmapSync(JNIEnv *env, jclass type, jobject modelInfo,
+    jint tensors, jobject bitmap, jint inputIndex, jfloat meanB, jfloat meanG, jfloat meanR)
+{
+    if (env == nullptr || modelInfo == nullptr || bitmap == nullptr) {
+        LOGE("[HIAI_DEMO_PREPROCESS] setInputFromBitmapSync invalid params.");
+        return JNI_FALSE;
+    }
+
+    string modelName;
+    if (!GetModelName(env, modelInfo, modelName)) {
+        return JNI_FALSE;
+    }
+
+    TensorDimension dim;
+    shared_ptr<AiTensor> input = GetSyncInputTensor(modelName, tensors, (uint32_t)inputIndex, dim);
+    if (input == nullptr) {
+        return JNI_FALSE;
+    }
+
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        LOGE("[HIAI_DEMO_PREPROCESS] AndroidBitmap_getInfo failed.");
+        return JNI_FALSE;
+    }
+    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        LOGE("[HIAI_DEMO_PREPROCESS] bitmap format %d is not ARGB_8888.", info.format);
+        return JNI_FALSE;
+    }
+    if (dim.GetChannel() != 3 || info.width != dim.GetWidth() || info.height != dim.GetHeight()) {
+        LOGE("[HIAI_DEMO_PREPROCESS] bitmap %ux%u does not match input CHW %u %u %u.",
+            info.width, info.height, dim.GetChannel(), dim.GetHeight(), dim.GetWidth());
+        return JNI_FALSE;
+    }
+    uint32_t needSize = 3 * info.width * info.height * sizeof(float);
+    if (input->GetSize() != needSize) {
+        LOGE("[HIAI_DEMO_PREPROCESS] input->GetSize(%u) != %u, input is not float32.", input->GetSize(), needSize);
+        return JNI_FALSE;
+    }
+
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || pixels == nullptr) {
+        LOGE("[HIAI_DEMO_PREPROCESS] AndroidBitmap_lockPixels failed.");
+        return JNI_FALSE;
+    }
+    const float mean[3] = { meanB, meanG, meanR };
+    ParallelFor(TaskPool::Shared(), info.height, ROWS_PER_TASK, [&](uint32_t first, uint32_t last) {
+        PackRgbaToBgrPlanesRows(static_cast<const uint8_t*>(pixels), info.width, info.height, info.stride, mean,
+            first, last, static_cast<float*>(input->GetBuffer()));
+    });
+    AndroidBitmap_unlockPixels(env, bitmap);
+
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_setAippInputFromBitmapSync(JNIEnv *env, jclass type, jobject modelInfo,
+    jint tensors, jobject bitmap, jint inputIndex, jint imageType, jboolean nv21)
+{
+    if (env == nullptr || modelInfo == nullptr || bitmap == nullptr) {
+        LOGE("[HIAI_DEMO_PREPROCESS] setAippInputFromBitmapSync invalid params.");
+        return JNI_FALSE;
+    }
+    if (imageType < JPEG || imageType > BT_709_NARROW) {
+        LOGE("[HIAI_DEMO_PREPROCESS] imageType %d is invalid.", imageType);
+        return JNI_FALSE;
+    }
+
+    string modelName;
+    if (!GetModelName(env, modelInfo, modelName)) {
+        return JNI_FALSE;
+    }
+
+    TensorDimension dim;
+    shared_ptr<AiTensor> input = GetSyncInputTensor(modelName, tensors, (uint32_t)inputIndex, dim);
+    if (input == nullptr) {
+        return JNI_FALSE;
+    }
+
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        LOGE("[HIAI_DEMO_PREPROCESS] AndroidBitmap_getInfo failed.");
+        return JNI_FALSE;
+    }
+    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        LOGE("[HIAI_DEMO_PREPROCESS] bitmap format %d is not ARGB_8888.", info.format);
+        return JNI_FALSE;
+    }
+    if ((info.width & 1) != 0 || (info.height & 1) != 0 ||
+        info.width != dim.GetWidth() || info.height != dim.GetHeight()) {
+        LOGE("[HIAI_DEMO_PREPROCESS] bitmap %ux%u does not match AIPP input HW %u %u.",
+            info.width, info.height, dim.GetHeight(), dim.GetWidth());
+        return JNI_FALSE;
+    }
+    uint32_t needSize = info.width * info.height * 3 / 2;
+    if (input->GetSize() != needSize) {
+        LOGE("[HIAI_DEMO_PREPROCESS] input->GetSize(%u) != %u, input is not YUV420SP.", input->GetSize(), needSize);
+        return JNI_FALSE;
+    }
+
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || pixels == nullptr) {
+        LOGE("[HIAI_DEMO_PREPROCESS] AndroidBitmap_lockPixels failed.");
+        return JNI_FALSE;
+    }
+    // split on row pairs, a chroma row goes with the two luma rows it covers
+    ParallelFor(TaskPool::Shared(), info.height / 2, ROWS_PER_TASK / 2, [&](uint32_t first, uint32_t last) {
+        RgbaToYuv420spRows(static_cast<const uint8_t*>(pixels), info.width, info.height, info.stride,
+            static_cast<ImageType>(imageType), nv21 == JNI_TRUE, 2 * first, 2 * last,
+            static_cast<uint8_t*>(input->GetBuffer()));
+    });
+    AndroidBitmap_unlockPixels(env, bitmap);
+
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_setInputFromBitmapFusedSync(JNIEnv *env, jclass type, jobject modelInfo,
+    jint tensors, jobject bitmap, jint inputIndex, jfloatArray mean, jfloatArray std, jboolean bgr)
+{
+    if (env == nullptr || modelInfo == nullptr || bitmap == nullptr || mean == nullptr || std == nullptr) {
+        LOGE("[HIAI_DEMO_PREPROCESS] setInputFromBitmapFusedSync invalid params.");
+        return JNI_FALSE;
+    }
+    if (env->GetArrayLength(mean) != 3 || env->GetArrayLength(std) != 3) {
+        LOGE("[HIAI_DEMO_PREPROCESS] mean and std must have 3 values.");
+        return JNI_FALSE;
+    }
+
+    NormalizeSpec spec;
+    float stdValue[3];
+    env->GetFloatArrayRegion(mean, 0, 3, spec.mean);
+    env->GetFloatArrayRegion(std, 0, 3, stdValue);
+    for (int i = 0; i < 3; ++i) {
+        if (stdValue[i] == 0.0f) {
+            LOGE("[HIAI_DEMO_PREPROCESS] std[%d] is 0.", i);
+            return JNI_FALSE;
+        }
+        spec.scale[i] = 1.0f / stdValue[i];
+    }
+    spec.bgr = (bgr == JNI_TRUE);
+
+    string modelName;
+    if (!GetModelName(env, modelInfo, modelName)) {
+        return JNI_FALSE;
+    }
+
+    TensorDimension dim;
+    shared_ptr<AiTensor> input = GetSyncInputTensor(modelName, tensors, (uint32_t)inputIndex, dim);
+    if (input == nullptr) {
+        return JNI_FALSE;
+    }
+    uint32_t needSize = 3 * dim.GetWidth() * dim.GetHeight() * sizeof(float);
+    if (dim.GetChannel() != 3 || input->GetSize() != needSize) {
+        LOGE("[HIAI_DEMO_PREPROCESS] input->GetSize(%u) != %u, input is not 3 channel float32.",
+            input->GetSize(), needSize);
+        return JNI_FALSE;
+    }
+
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        LOGE("[HIAI_DEMO_PREPROCESS] AndroidBitmap_getInfo failed.");
+        return JNI_FALSE;
+    }
+    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888 || info.width == 0 || info.height == 0) {
+        LOGE("[HIAI_DEMO_PREPROCESS] bitmap format %d is not ARGB_8888.", info.format);
+        return JNI_FALSE;
+    }
+
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || pixels == nullptr) {
+        LOGE("[HIAI_DEMO_PREPROCESS] AndroidBitmap_lockPixels failed.");
+        return JNI_FALSE;
+    }
+    ParallelFor(TaskPool::Shared(), dim.GetHeight(), ROWS_PER_TASK, [&](uint32_t first, uint32_t last) {
+        CropResizeNormalizeRows(static_cast<const uint8_t*>(pixels), info.width, info.height, info.stride,
+            dim.GetWidth(), dim.GetHeight(), spec, first, last, static_cast<float*>(input->GetBuffer()));
+    });
+    AndroidBitmap_unlockPixels(env, bitmap);
+
+    return JNI_TRUE;
+}
@@ -0,0 +1,65 @@
+/*
+ * @file qos_jni.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include <jni.h>
+
+#include <android/log.h>
+#include "qos_scheduler.h"
+
+#define LOG_TAG "SYNC_DDK_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_setThreadQosClass(JNIEnv *env, jclass type, jint qosClass)
+{
+    if (qosClass < -1 || qosClass > QOS_BACKGROUND) {
+        LOGE("[HIAI_DEMO_SYNC] qos class %d is invalid.", qosClass);
+        return;
+    }
+    SetThreadQosClass(qosClass);
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_configureQos(JNIEnv *env, jclass type, jint inFlight,
+    jint normalWeight, jint backgroundWeight)
+{
+    // inFlight 0 is QOS_IN_FLIGHT_UNBOUNDED
+    if (inFlight < 0 || normalWeight < 1 || backgroundWeight < 1) {
+        LOGE("[HIAI_DEMO_SYNC] configureQos invalid params.");
+        return JNI_FALSE;
+    }
+    QosConfig config;
+    config.inFlight = (uint32_t)inFlight;
+    config.normalWeight = (uint32_t)normalWeight;
+    config.backgroundWeight = (uint32_t)backgroundWeight;
+    QosScheduler::Shared().Configure(config);
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_getQosStats(JNIEnv *env, jclass type)
+{
+    jlong values[3 * QOS_CLASSES];
+    for (uint32_t qos = 0; qos < QOS_CLASSES; ++qos) {
+        QosClassStats stats = QosScheduler::Shared().GetStats(static_cast<QosClass>(qos));
+        values[3 * qos] = (jlong)stats.dispatched;
+        values[3 * qos + 1] = (jlong)stats.meanWaitUs;
+        values[3 * qos + 2] = (jlong)stats.maxWaitUs;
+    }
+    jlongArray result = env->NewLongArray(3 * QOS_CLASSES);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, 3 * QOS_CLASSES, values);
+    }
+    return result;
+}
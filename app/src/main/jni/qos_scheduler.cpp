@@ -0,0 +1,149 @@
+/*
+ * @file qos_scheduler.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "qos_scheduler.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+using namespace hiai;
+
+// -1: requests of the thread take the class of their model
+static thread_local int t_qos = -1;
+
+QosScheduler::QosScheduler(const QosConfig& config)
+{
+    Configure(config);
+}
+
+void QosScheduler::Enter(QosClass qos)
+{
+    auto start = chrono::steady_clock::now();
+    unique_lock<mutex> lock(mutex_);
+    bool queued = false;
+    for (auto& queue : queues_) {
+        queued = queued || !queue.empty();
+    }
+    if (queued || Full()) {
+        // a request never passes one queued before it
+        Waiter waiter;
+        queues_[qos].push_back(&waiter);
+        waiter.cv.wait(lock, [&waiter] { return waiter.granted; });
+    } else {
+        running_++;
+    }
+    uint64_t waitUs = (uint64_t)chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now() - start).count();
+    dispatched_[qos]++;
+    waitTotalUs_[qos] += waitUs;
+    waitMaxUs_[qos] = max(waitMaxUs_[qos], waitUs);
+}
+
+void QosScheduler::Leave()
+{
+    lock_guard<mutex> lock(mutex_);
+    if (running_ > 0) {
+        running_--;
+    }
+    Dispatch();
+}
+
+void QosScheduler::Configure(const QosConfig& config)
+{
+    lock_guard<mutex> lock(mutex_);
+    config_ = config;
+    config_.normalWeight = max(config_.normalWeight, 1u);
+    config_.backgroundWeight = max(config_.backgroundWeight, 1u);
+    Dispatch();
+}
+
+int QosScheduler::NextClass()
+{
+    if (!queues_[QOS_INTERACTIVE].empty()) {
+        return QOS_INTERACTIVE;
+    }
+    const uint32_t weights[QOS_CLASSES] = { 0, config_.normalWeight, config_.backgroundWeight };
+    int64_t total = 0;
+    int best = -1;
+    for (int qos = QOS_NORMAL; qos <= QOS_BACKGROUND; ++qos) {
+        if (queues_[qos].empty()) {
+            continue;
+        }
+        credit_[qos] += weights[qos];
+        total += weights[qos];
+        if (best < 0 || credit_[qos] > credit_[best]) {
+            best = qos;
+        }
+    }
+    if (best >= 0) {
+        credit_[best] -= total;
+    }
+    return best;
+}
+
+bool QosScheduler::Full() const
+{
+    return config_.inFlight != QOS_IN_FLIGHT_UNBOUNDED && running_ >= config_.inFlight;
+}
+
+void QosScheduler::Dispatch()
+{
+    while (!Full()) {
+        int qos = NextClass();
+        if (qos < 0) {
+            return;
+        }
+        Waiter* waiter = queues_[qos].front();
+        queues_[qos].pop_front();
+        running_++;
+        // the waiter cannot return before this lock is released
+        waiter->granted = true;
+        waiter->cv.notify_one();
+    }
+}
+
+QosClassStats QosScheduler::GetStats(QosClass qos) const
+{
+    lock_guard<mutex> lock(mutex_);
+    QosClassStats stats;
+    stats.dispatched = dispatched_[qos];
+    stats.meanWaitUs = dispatched_[qos] > 0 ? waitTotalUs_[qos] / dispatched_[qos] : 0;
+    stats.maxWaitUs = waitMaxUs_[qos];
+    return stats;
+}
+
+QosScheduler& QosScheduler::Shared()
+{
+    // never deleted: sessions may still run while the process exits
+    static QosScheduler* scheduler = new QosScheduler(QosConfig());
+    return *scheduler;
+}
+
+void SetThreadQosClass(int qos)
+{
+    t_qos = qos;
+}
+
+QosClass RequestQosClass(QosClass modelQos)
+{
+    return t_qos < 0 ? modelQos : static_cast<QosClass>(t_qos);
+}
+
+AiModelDescription_Frequency QosFrequency(QosClass qos)
+{
+    switch (qos) {
+        case QOS_INTERACTIVE:
+            return AiModelDescription_Frequency_HIGH;
+        case QOS_NORMAL:
+            return AiModelDescription_Frequency_MEDIUM;
+        default:
+            return AiModelDescription_Frequency_LOW;
+    }
+}
@@ -0,0 +1,118 @@
+/*
+ * @file qos_scheduler.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_QOS_SCHEDULER_H
+#define HIAI_DEMO_QOS_SCHEDULER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include "HiAiModelManagerService.h"
+
+/* Same values as Constant.QOS_* */
+enum QosClass {
+    // the user waits for the result, e.g. the camera preview
+    QOS_INTERACTIVE = 0,
+    QOS_NORMAL = 1,
+    // bulk work nobody watches, e.g. a gallery scan or a warm-up
+    QOS_BACKGROUND = 2,
+};
+
+static const uint32_t QOS_CLASSES = 3;
+
+// inFlight of a QosConfig that never holds a Process call back, as Constant.QOS_IN_FLIGHT_UNBOUNDED
+static const uint32_t QOS_IN_FLIGHT_UNBOUNDED = 0;
+// inFlight of the default QosConfig, as Constant.QOS_DEFAULT_IN_FLIGHT
+static const uint32_t QOS_DEFAULT_IN_FLIGHT = 2;
+
+struct QosConfig {
+    // Process calls running at once; requests over it wait in their class queue.
+    // Two by default, so that the calls of two models still overlap on the DDK
+    // while an interactive request waits behind at most two running calls; 1 for
+    // strict order, QOS_IN_FLIGHT_UNBOUNDED to never queue.
+    uint32_t inFlight = QOS_DEFAULT_IN_FLIGHT;
+    // interactive requests always go first; normal and background ones share
+    // the rest in this ratio, so background work still progresses
+    uint32_t normalWeight = 4;
+    uint32_t backgroundWeight = 1;
+};
+
+struct QosClassStats {
+    uint64_t dispatched = 0;
+    // time spent queued before Process
+    uint64_t meanWaitUs = 0;
+    uint64_t maxWaitUs = 0;
+};
+
+/*
+ * Orders the Process calls of the sync models by priority class. A request
+ * calls Enter before Process and Leave after it; while inFlight requests are
+ * running, the others queue per class, FIFO within a class. With inFlight
+ * unbounded nothing queues and Enter only counts the request.
+ */
+class QosScheduler {
+public:
+    explicit QosScheduler(const QosConfig& config);
+
+    QosScheduler(const QosScheduler&) = delete;
+    QosScheduler& operator=(const QosScheduler&) = delete;
+
+    /*
+    * @brief Block until a request of class qos may call Process
+    */
+    void Enter(QosClass qos);
+    void Leave();
+
+    void Configure(const QosConfig& config);
+    QosClassStats GetStats(QosClass qos) const;
+
+    /* Scheduler of the sync sessions */
+    static QosScheduler& Shared();
+
+private:
+    struct Waiter {
+        std::condition_variable cv;
+        bool granted = false;
+    };
+
+    // grant the slots free to the waiters next in line
+    void Dispatch();
+    bool Full() const;
+    int NextClass();
+
+    mutable std::mutex mutex_;
+    QosConfig config_;
+    uint32_t running_ = 0;
+    std::deque<Waiter*> queues_[QOS_CLASSES];
+    // smooth weighted round robin credit of the normal and background queues
+    int64_t credit_[QOS_CLASSES] = {};
+
+    uint64_t dispatched_[QOS_CLASSES] = {};
+    uint64_t waitTotalUs_[QOS_CLASSES] = {};
+    uint64_t waitMaxUs_[QOS_CLASSES] = {};
+};
+
+/*
+* @brief Class of the sync requests of the calling thread
+* @param [in] qos a QosClass, or -1 to use the class of the model
+*/
+void SetThreadQosClass(int qos);
+
+/* Class of a request of the calling thread on a model of class modelQos */
+QosClass RequestQosClass(QosClass modelQos);
+
+/*
+* @brief Load frequency of a model of class qos: the NPU clocks for interactive
+*        models, a lower one for the others
+*/
+hiai::AiModelDescription_Frequency QosFrequency(QosClass qos);
+
+#endif
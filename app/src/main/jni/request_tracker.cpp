@@ -0,0 +1,120 @@
+/*
+ * @file request_tracker.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "request_tracker.h"
+#include <android/log.h>
+
+#define LOG_TAG "ASYNC_DDK_MSG"
+
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+RequestControl::RequestControl(int64_t tag, uint32_t timeoutMs)
+    : tag_(tag), hasDeadline_(timeoutMs > 0), deadline_(Clock::now() + chrono::milliseconds(timeoutMs)),
+      cancelled_(false), finished_(false)
+{
+}
+
+uint32_t RequestControl::RemainingMs(uint32_t fallbackMs) const
+{
+    if (!hasDeadline_) {
+        return fallbackMs;
+    }
+    int64_t left = chrono::duration_cast<chrono::milliseconds>(deadline_ - Clock::now()).count();
+    // Admit has just passed, never hand Process a timeout of 0
+    return left > 1 ? (uint32_t)left : 1;
+}
+
+RequestControlPtr RequestTracker::Begin(int64_t tag, uint32_t timeoutMs)
+{
+    RequestControlPtr control = make_shared<RequestControl>(tag, timeoutMs);
+    if (tag != 0) {
+        lock_guard<mutex> lock(mutex_);
+        live_.emplace(tag, control);
+    }
+    return control;
+}
+
+bool RequestTracker::Admit(const RequestControlPtr& control, const char* hop)
+{
+    if (control == nullptr) {
+        return true;
+    }
+    if (control->Cancelled()) {
+        LOGI("[HIAI_DEMO_ASYNC] request %lld cancelled before %s.", (long long)control->Tag(), hop);
+        Finish(control, REQUEST_CANCELLED);
+        return false;
+    }
+    if (control->Expired()) {
+        LOGI("[HIAI_DEMO_ASYNC] request %lld expired before %s.", (long long)control->Tag(), hop);
+        Finish(control, REQUEST_EXPIRED);
+        return false;
+    }
+    return true;
+}
+
+void RequestTracker::Finish(const RequestControlPtr& control, RequestOutcome outcome)
+{
+    if (control == nullptr || control->finished_.exchange(true)) {
+        return;
+    }
+    lock_guard<mutex> lock(mutex_);
+    outcomes_[outcome]++;
+    if (control->Tag() == 0) {
+        return;
+    }
+    auto range = live_.equal_range(control->Tag());
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.lock() == control) {
+            live_.erase(it);
+            break;
+        }
+    }
+}
+
+uint32_t RequestTracker::Cancel(int64_t tag)
+{
+    if (tag == 0) {
+        return 0;
+    }
+    lock_guard<mutex> lock(mutex_);
+    uint32_t count = 0;
+    auto range = live_.equal_range(tag);
+    for (auto it = range.first; it != range.second;) {
+        RequestControlPtr control = it->second.lock();
+        if (control == nullptr) {
+            // dropped without Finish, e.g. on a JNI error path
+            it = live_.erase(it);
+            continue;
+        }
+        control->cancelled_ = true;
+        count++;
+        ++it;
+    }
+    return count;
+}
+
+RequestStats RequestTracker::GetStats() const
+{
+    lock_guard<mutex> lock(mutex_);
+    RequestStats stats;
+    for (uint32_t i = 0; i < REQUEST_OUTCOMES; ++i) {
+        stats.outcomes[i] = outcomes_[i];
+    }
+    return stats;
+}
+
+RequestTracker& RequestTracker::Shared()
+{
+    // never deleted: DDK callbacks may still finish requests while the process exits
+    static RequestTracker* tracker = new RequestTracker();
+    return *tracker;
+}
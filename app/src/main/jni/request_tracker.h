@@ -0,0 +1,121 @@
+/*
+ * @file request_tracker.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_REQUEST_TRACKER_H
+#define HIAI_DEMO_REQUEST_TRACKER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+enum RequestOutcome {
+    // the result was delivered
+    REQUEST_COMPLETED = 0,
+    // the deadline passed before the request reached the accelerator
+    REQUEST_EXPIRED = 1,
+    // cancelled by tag; dropped before submission, or its result discarded
+    REQUEST_CANCELLED = 2,
+    REQUEST_FAILED = 3,
+};
+
+static const uint32_t REQUEST_OUTCOMES = 4;
+
+struct RequestStats {
+    uint64_t outcomes[REQUEST_OUTCOMES] = {};
+};
+
+/* Deadline and cancellation state of one request, checked at each queue hop */
+class RequestControl {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    RequestControl(int64_t tag, uint32_t timeoutMs);
+
+    int64_t Tag() const { return tag_; }
+    bool HasDeadline() const { return hasDeadline_; }
+    Clock::time_point Deadline() const { return deadline_; }
+
+    bool Cancelled() const { return cancelled_.load(); }
+    bool Expired() const { return hasDeadline_ && Clock::now() >= deadline_; }
+
+    /*
+    * @brief Time left before the deadline, for the timeout of Process
+    * @param [in] fallbackMs returned when the request has no deadline
+    */
+    uint32_t RemainingMs(uint32_t fallbackMs) const;
+
+private:
+    friend class RequestTracker;
+
+    int64_t tag_;
+    bool hasDeadline_;
+    Clock::time_point deadline_;
+    std::atomic<bool> cancelled_;
+    std::atomic<bool> finished_;
+};
+
+using RequestControlPtr = std::shared_ptr<RequestControl>;
+
+/*
+ * Requests between their submission by Java and the delivery of their result.
+ * Each stage calls Admit before handing a request on, so that a request whose
+ * deadline passed, or whose frame the UI discarded, is dropped before it costs
+ * accelerator time. Every request ends with exactly one counted outcome.
+ */
+class RequestTracker {
+public:
+    RequestTracker() = default;
+
+    RequestTracker(const RequestTracker&) = delete;
+    RequestTracker& operator=(const RequestTracker&) = delete;
+
+    /*
+    * @brief Start tracking a request
+    * @param [in] tag caller id used by Cancel, 0 if the request cannot be cancelled
+    * @param [in] timeoutMs deadline from now, 0 for none
+    */
+    RequestControlPtr Begin(int64_t tag, uint32_t timeoutMs);
+
+    /*
+    * @brief Check a request at a queue hop; a request that must be dropped is
+    *        finished as expired or cancelled
+    * @param [in] hop stage name, for the log
+    * @return false if the caller must drop the request
+    */
+    bool Admit(const RequestControlPtr& control, const char* hop);
+
+    /*
+    * @brief Count the outcome of a request and forget it. Only the first call
+    *        for a request counts.
+    */
+    void Finish(const RequestControlPtr& control, RequestOutcome outcome);
+
+    /*
+    * @brief Cancel every live request of a tag
+    * @return number of requests cancelled
+    */
+    uint32_t Cancel(int64_t tag);
+
+    RequestStats GetStats() const;
+
+    /* Tracker of the async requests and pipeline frames */
+    static RequestTracker& Shared();
+
+private:
+    mutable std::mutex mutex_;
+    // requests with a tag, until they finish
+    std::multimap<int64_t, std::weak_ptr<RequestControl>> live_;
+    uint64_t outcomes_[REQUEST_OUTCOMES] = {};
+};
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * @file service_recovery.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "service_recovery.h"
+#include <algorithm>
+#include <thread>
+#include <android/log.h>
+
+#define LOG_TAG "ASYNC_DDK_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+static const uint32_t RECOVERY_ATTEMPTS = 5;
+// doubled after each failed attempt: 50, 100, 200, 400 ms
+static const uint32_t RECOVERY_BACKOFF_MS = 50;
+
+ServiceRecovery::ServiceRecovery(const Reload& reload, const Replay& replay) : reload_(reload), replay_(replay)
+{
+}
+
+void ServiceRecovery::OnServiceDied()
+{
+    lock_guard<mutex> lock(mutex_);
+    stats_.deaths++;
+    if (state_ == SERVICE_RECOVERING) {
+        diedAgain_ = true;
+        return;
+    }
+    state_ = SERVICE_RECOVERING;
+    diedAgain_ = false;
+    // not on the DDK thread that reported the death: loading takes a while
+    Clock::time_point diedTime = Clock::now();
+    thread([this, diedTime] { Recover(diedTime); }).detach();
+}
+
+bool ServiceRecovery::ReloadWithBackoff()
+{
+    uint32_t backoffMs = RECOVERY_BACKOFF_MS;
+    for (uint32_t attempt = 0; attempt < RECOVERY_ATTEMPTS; ++attempt) {
+        if (attempt > 0) {
+            this_thread::sleep_for(chrono::milliseconds(backoffMs));
+            backoffMs *= 2;
+        }
+        {
+            lock_guard<mutex> lock(mutex_);
+            diedAgain_ = false;
+        }
+        bool recovered = reload_();
+        LOGI("[HIAI_DEMO_ASYNC] reload attempt %u after the service died %s.", attempt + 1,
+            recovered ? "succeeded" : "failed");
+        if (recovered) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ServiceRecovery::Recover(Clock::time_point diedTime)
+{
+    for (;;) {
+        bool recovered = ReloadWithBackoff();
+        if (recovered) {
+            lock_guard<mutex> lock(mutex_);
+            // the new client died before it was used: load on another one
+            if (diedAgain_) {
+                continue;
+            }
+        }
+
+        // replayed requests go before the ones waiting in WaitReady
+        replay_(recovered);
+
+        int64_t recoveryUs = chrono::duration_cast<chrono::microseconds>(Clock::now() - diedTime).count();
+        lock_guard<mutex> lock(mutex_);
+        if (recovered && diedAgain_) {
+            // the client died under the replay: what it took is lost with it, replay again on another one
+            LOGI("[HIAI_DEMO_ASYNC] service died again during the replay, reloading.");
+            continue;
+        }
+        if (recovered) {
+            state_ = SERVICE_READY;
+            stats_.recoveries++;
+            stats_.lastRecoveryUs = recoveryUs;
+            stats_.maxRecoveryUs = max(stats_.maxRecoveryUs, recoveryUs);
+            LOGI("[HIAI_DEMO_ASYNC] service recovered in %lld us.", (long long)recoveryUs);
+        } else {
+            state_ = SERVICE_LOST;
+            stats_.failedRecoveries++;
+            LOGE("[HIAI_DEMO_ASYNC] service lost, the models could not be reloaded.");
+        }
+        ready_.notify_all();
+        return;
+    }
+}
+
+bool ServiceRecovery::WaitReady(Clock::time_point deadline)
+{
+    unique_lock<mutex> lock(mutex_);
+    ready_.wait_until(lock, deadline, [this] { return state_ != SERVICE_RECOVERING; });
+    return state_ == SERVICE_READY;
+}
+
+void ServiceRecovery::CountReplayed(uint32_t replayed, uint32_t failed)
+{
+    lock_guard<mutex> lock(mutex_);
+    stats_.replayed += replayed;
+    stats_.failedFast += failed;
+}
+
+RecoveryStats ServiceRecovery::GetStats() const
+{
+    lock_guard<mutex> lock(mutex_);
+    RecoveryStats stats = stats_;
+    stats.state = state_;
+    return stats;
+}
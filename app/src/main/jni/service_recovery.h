@@ -0,0 +1,94 @@
+/*
+ * @file service_recovery.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_SERVICE_RECOVERY_H
+#define HIAI_DEMO_SERVICE_RECOVERY_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+enum ServiceState {
+    SERVICE_READY = 0,
+    // the service died, the models are being loaded on a new client
+    SERVICE_RECOVERING = 1,
+    // every reload failed; requests fail fast from then on
+    SERVICE_LOST = 2,
+};
+
+struct RecoveryStats {
+    ServiceState state = SERVICE_READY;
+    uint32_t deaths = 0;
+    uint32_t recoveries = 0;
+    uint32_t failedRecoveries = 0;
+    // from OnServiceDied until the requests in flight are replayed
+    int64_t lastRecoveryUs = 0;
+    int64_t maxRecoveryUs = 0;
+    // requests in flight when the service died
+    uint64_t replayed = 0;
+    uint64_t failedFast = 0;
+};
+
+/*
+ * Brings a client back after the NPU service dies. OnServiceDied starts the
+ * recovery on a thread of its own: reload runs, with a backoff between
+ * attempts, until it succeeds or RECOVERY_ATTEMPTS are spent, then replay
+ * resubmits or fails the requests the dead client lost. If the new client
+ * dies before the replay is over, both run again. Submitters wait in
+ * WaitReady meanwhile, so no request goes to a dead client.
+ */
+class ServiceRecovery {
+public:
+    using Clock = std::chrono::steady_clock;
+    // load the models on a new client and make it current; false if it failed
+    using Reload = std::function<bool()>;
+    // resubmit the requests lost with the dead client, or fail them if !recovered
+    using Replay = std::function<void(bool recovered)>;
+
+    ServiceRecovery(const Reload& reload, const Replay& replay);
+
+    ServiceRecovery(const ServiceRecovery&) = delete;
+    ServiceRecovery& operator=(const ServiceRecovery&) = delete;
+
+    /*
+    * @brief Start a recovery; a death reported during one makes it reload again
+    */
+    void OnServiceDied();
+
+    /*
+    * @brief Block while a recovery runs
+    * @return false if the service is lost, or still recovering at deadline
+    */
+    bool WaitReady(Clock::time_point deadline);
+
+    /*
+    * @brief Count the requests handled by a replay
+    */
+    void CountReplayed(uint32_t replayed, uint32_t failed);
+
+    RecoveryStats GetStats() const;
+
+private:
+    void Recover(Clock::time_point diedTime);
+    bool ReloadWithBackoff();
+
+    Reload reload_;
+    Replay replay_;
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    ServiceState state_ = SERVICE_READY;
+    // a death reported while the reload or the replay runs
+    bool diedAgain_ = false;
+    RecoveryStats stats_;
+};
+
+#endif
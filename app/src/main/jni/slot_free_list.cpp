@@ -0,0 +1,112 @@
+/*
+ * @file slot_free_list.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "slot_free_list.h"
+
+using namespace std;
+
+static const uint64_t LINK_MASK = 0xFFFFFFFFull;
+static const uint64_t TAG_ONE = 1ull << 32;
+
+SlotFreeList::SlotFreeList(uint32_t depth)
+    : head_(0), next_(new atomic<uint32_t>[depth]), depth_(depth), waiters_(0)
+{
+    // slot 0 on top, each slot linked to the next one
+    for (uint32_t i = 0; i < depth; ++i) {
+        next_[i].store(i + 1 < depth ? i + 2 : 0, memory_order_relaxed);
+    }
+    head_.store(depth > 0 ? 1 : 0, memory_order_release);
+}
+
+bool SlotFreeList::TryAcquire(uint32_t& slot)
+{
+    uint64_t head = head_.load();
+    for (;;) {
+        uint32_t link = (uint32_t)(head & LINK_MASK);
+        if (link == 0) {
+            return false;
+        }
+        // next_ may be stale if another thread popped in between; the tag then
+        // differs and the exchange fails
+        uint64_t next = (head & ~LINK_MASK) + TAG_ONE + next_[link - 1].load(memory_order_relaxed);
+        if (head_.compare_exchange_weak(head, next, memory_order_acq_rel, memory_order_acquire)) {
+            slot = link - 1;
+            return true;
+        }
+    }
+}
+
+void SlotFreeList::Acquire(uint32_t& slot)
+{
+    if (TryAcquire(slot)) {
+        return;
+    }
+    // Release checks waiters_ after its push: either it sees this waiter and
+    // notifies, or the TryAcquire below sees its slot
+    waiters_.fetch_add(1);
+    {
+        unique_lock<mutex> lock(waitMutex_);
+        waitCondition_.wait(lock, [this, &slot] { return TryAcquire(slot); });
+    }
+    waiters_.fetch_sub(1);
+}
+
+bool SlotFreeList::AcquireUntil(uint32_t& slot, chrono::steady_clock::time_point deadline,
+    const function<bool()>& abandon)
+{
+    if (TryAcquire(slot)) {
+        return true;
+    }
+    waiters_.fetch_add(1);
+    bool acquired = false;
+    {
+        unique_lock<mutex> lock(waitMutex_);
+        waitCondition_.wait_until(lock, deadline, [this, &slot, &abandon, &acquired] {
+            if (abandon()) {
+                return true;
+            }
+            acquired = TryAcquire(slot);
+            return acquired;
+        });
+    }
+    waiters_.fetch_sub(1);
+    if (!acquired) {
+        // a Release may have woken this thread instead of another waiter
+        lock_guard<mutex> lock(waitMutex_);
+        waitCondition_.notify_one();
+    }
+    return acquired;
+}
+
+void SlotFreeList::WakeWaiters()
+{
+    lock_guard<mutex> lock(waitMutex_);
+    waitCondition_.notify_all();
+}
+
+void SlotFreeList::Release(uint32_t slot)
+{
+    if (slot >= depth_) {
+        return;
+    }
+    uint64_t head = head_.load(memory_order_relaxed);
+    for (;;) {
+        next_[slot].store((uint32_t)(head & LINK_MASK), memory_order_relaxed);
+        uint64_t next = (head & ~LINK_MASK) + TAG_ONE + slot + 1;
+        // sequentially consistent, so the waiters_ load below is not ordered before it
+        if (head_.compare_exchange_weak(head, next)) {
+            break;
+        }
+    }
+    if (waiters_.load() > 0) {
+        lock_guard<mutex> lock(waitMutex_);
+        waitCondition_.notify_one();
+    }
+}
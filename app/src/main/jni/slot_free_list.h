@@ -0,0 +1,78 @@
+/*
+ * @file slot_free_list.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_SLOT_FREE_LIST_H
+#define HIAI_DEMO_SLOT_FREE_LIST_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+/*
+ * Free slots 0 .. depth-1 of a fixed ring of tensor sets. Taking and returning
+ * a slot is a lock-free stack operation; the mutex is only used to sleep when
+ * every slot is in flight.
+ */
+class SlotFreeList {
+public:
+    explicit SlotFreeList(uint32_t depth);
+
+    SlotFreeList(const SlotFreeList&) = delete;
+    SlotFreeList& operator=(const SlotFreeList&) = delete;
+
+    uint32_t Depth() const { return depth_; }
+
+    /*
+    * @brief Take a free slot without blocking
+    * @param [out] slot index of the slot
+    * @return false if every slot is in use
+    */
+    bool TryAcquire(uint32_t& slot);
+
+    /*
+    * @brief Take a free slot, waiting for Release while every slot is in use
+    * @param [out] slot index of the slot
+    */
+    void Acquire(uint32_t& slot);
+
+    /*
+    * @brief Acquire that gives up at deadline, or once abandon returns true
+    *        (checked when a slot is released and on WakeWaiters)
+    * @return false if no slot was taken
+    */
+    bool AcquireUntil(uint32_t& slot, std::chrono::steady_clock::time_point deadline,
+        const std::function<bool()>& abandon);
+
+    /*
+    * @brief Make the waiters of AcquireUntil check abandon again
+    */
+    void WakeWaiters();
+
+    /*
+    * @brief Return a slot taken with TryAcquire or Acquire
+    */
+    void Release(uint32_t slot);
+
+private:
+    // low 32 bits: top slot + 1, 0 when empty; high 32 bits: tag against ABA
+    std::atomic<uint64_t> head_;
+    std::unique_ptr<std::atomic<uint32_t>[]> next_;
+    uint32_t depth_;
+
+    std::atomic<uint32_t> waiters_;
+    std::mutex waitMutex_;
+    std::condition_variable waitCondition_;
+};
+
+#endif
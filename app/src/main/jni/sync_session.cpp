@@ -0,0 +1,354 @@
+/*
+ * @file sync_session.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "sync_session.h"
+#include "dynamic_aipp.h"
+#include <android/log.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <shared_mutex>
+
+#define LOG_TAG "SYNC_DDK_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+using namespace hiai;
+
+static const int SUCCESS = 0;
+static const int FAILED = -1;
+
+static const int OUTPUT_LEASE_WAIT_MS = 1000;
+static const int TENSOR_SET_WAIT_MS = 1000;
+// the low bits of a tensor set handle are its index in the pool, the others a check-out serial
+static const uint32_t TENSOR_INDEX_BITS = 4;
+static const uint32_t TENSOR_SERIAL_MASK = 0x7FFFFFFFu >> TENSOR_INDEX_BITS;
+static_assert(MAX_SYNC_TENSOR_SETS <= (1u << TENSOR_INDEX_BITS), "tensor set index does not fit a handle");
+static const int PROCESS_TIMEOUT_MS = 1000;
+// one batch fills while the previous one runs
+static const uint32_t BATCH_STAGES = 2;
+
+// lookups run on every inference, loads are rare
+static shared_timed_mutex sync_sessions_mutex;
+static map<string, shared_ptr<SyncSession>> sync_sessions;
+static atomic<long> time_use_sync(0);
+
+static uint64_t TensorBytes(const vector<shared_ptr<AiTensor>>& tensors)
+{
+    uint64_t bytes = 0;
+    for (auto& tensor : tensors) {
+        bytes += tensor->GetSize();
+    }
+    return bytes;
+}
+
+shared_ptr<SyncSession> SyncSession::Create(const SyncModelConfig& config, ModelLoadTimes& times)
+{
+    shared_ptr<SyncSession> session(new SyncSession(config));
+    ModelResidency& residency = ModelResidency::Shared();
+    LoadClock::time_point start = LoadClock::now();
+    shared_ptr<AiModelMngerClient> client = residency.Acquire(config.name);
+    if (client == nullptr) {
+        return nullptr;
+    }
+    times.loadUs = MicrosSince(start);
+    start = LoadClock::now();
+    string modelNameFull = config.name + ".om";
+    int ret = client->GetModelIOTensorDim(modelNameFull, session->inputDims_, session->outputDims_);
+    session->dynamicAipp_ = IsDynamicAippSupported(*client) && HasModelAippPara(*client, modelNameFull, 0);
+    residency.Release(config.name);
+    times.ioUs = MicrosSince(start);
+    if (ret != 0) {
+        LOGE("[HIAI_DEMO_SYNC] Get Model IO Tensor Dimension failed,ret is %d.", ret);
+        return nullptr;
+    }
+    if (session->inputDims_.size() == 0 || session->outputDims_.size() == 0) {
+        LOGE("[HIAI_DEMO_SYNC] model %s has no input or output.", config.name.c_str());
+        return nullptr;
+    }
+    start = LoadClock::now();
+    if (!session->CreateBatch()) {
+        return nullptr;
+    }
+    // allocated now, while the other models of the call load, rather than on
+    // the first inference
+    unique_ptr<SyncTensorSet> first(new SyncTensorSet());
+    if (!session->CreateInputs(first->inputs) || !session->CreateOutputs(first->outputs)) {
+        return nullptr;
+    }
+    residency.AddTensorBytes(config.name, TensorBytes(first->inputs) + TensorBytes(first->outputs));
+    session->freeTensors_.push_back(first.get());
+    session->tensorSets_.push_back(std::move(first));
+    times.tensorUs = MicrosSince(start);
+    LOGI("[HIAI_DEMO_SYNC] sync load model %s INPUT NCHW : %d %d %d %d.", config.name.c_str(),
+        session->inputDims_[0].GetNumber(), session->inputDims_[0].GetChannel(),
+        session->inputDims_[0].GetHeight(), session->inputDims_[0].GetWidth());
+    return session;
+}
+
+SyncSession::SyncSession(const SyncModelConfig& config) : config_(config), warmup_(config.warmupRuns)
+{
+}
+
+bool SyncSession::CreateInputs(vector<shared_ptr<AiTensor>>& inputs) const
+{
+    for (auto in_dim : inputDims_) {
+        shared_ptr<AiTensor> input = make_shared<AiTensor>();
+        int ret;
+        if (config_.useAipp) {
+            ret = input->Init(in_dim.GetNumber(), in_dim.GetHeight(), in_dim.GetWidth(), AiTensorImage_YUV420SP_U8);
+        } else {
+            ret = input->Init(&in_dim);
+        }
+        if (ret != 0) {
+            LOGE("[HIAI_DEMO_SYNC] model %s AiTensor Init failed(input).", config_.name.c_str());
+            return false;
+        }
+        inputs.push_back(input);
+    }
+    return true;
+}
+
+bool SyncSession::CreateOutputs(vector<shared_ptr<AiTensor>>& outputs) const
+{
+    for (auto out_dim : outputDims_) {
+        shared_ptr<AiTensor> output = make_shared<AiTensor>();
+        if (output->Init(&out_dim) != 0) {
+            LOGE("[HIAI_DEMO_SYNC] model %s AiTensor Init failed(output).", config_.name.c_str());
+            return false;
+        }
+        outputs.push_back(output);
+    }
+    return true;
+}
+
+bool SyncSession::CreateBatch()
+{
+    uint32_t batch = inputDims_[0].GetNumber();
+    if (batch <= 1) {
+        return true;
+    }
+    batchInputs_.resize(BATCH_STAGES);
+    for (auto& inputs : batchInputs_) {
+        if (!CreateInputs(inputs)) {
+            return false;
+        }
+    }
+    if (!CreateOutputs(batchOutputs_.outputs)) {
+        return false;
+    }
+    ModelResidency::Shared().AddTensorBytes(config_.name,
+        TensorBytes(batchInputs_[0]) * BATCH_STAGES + TensorBytes(batchOutputs_.outputs));
+    // the scheduler is owned by this session, so it never outlives this
+    batch_.reset(new BatchScheduler(batch, chrono::microseconds(config_.batchWaitUs), BATCH_STAGES,
+        [this](uint32_t stage, uint32_t count) {
+            LOGI("[HIAI_DEMO_SYNC] model %s runs a batch of %u.", config_.name.c_str(), count);
+            return Run(batchInputs_[stage], batchOutputs_);
+        }));
+    LOGI("[HIAI_DEMO_SYNC] model %s batches up to %u images, waiting %d us.", config_.name.c_str(), batch,
+        config_.batchWaitUs);
+    return true;
+}
+
+SyncTensorSet* SyncSession::TakeFreeTensors(unique_lock<mutex>& lock)
+{
+    if (freeTensors_.empty() && tensorSets_.size() < MAX_SYNC_TENSOR_SETS) {
+        unique_ptr<SyncTensorSet> created(new SyncTensorSet());
+        if (!CreateInputs(created->inputs) || !CreateOutputs(created->outputs)) {
+            return nullptr;
+        }
+        ModelResidency::Shared().AddTensorBytes(config_.name,
+            TensorBytes(created->inputs) + TensorBytes(created->outputs));
+        created->index = (uint32_t)tensorSets_.size();
+        freeTensors_.push_back(created.get());
+        tensorSets_.push_back(std::move(created));
+        LOGI("[HIAI_DEMO_SYNC] model %s has %zu tensor sets.", config_.name.c_str(), tensorSets_.size());
+    }
+    if (!tensorCv_.wait_for(lock, chrono::milliseconds(TENSOR_SET_WAIT_MS), [this] { return !freeTensors_.empty(); })) {
+        LOGE("[HIAI_DEMO_SYNC] the %zu tensor sets of model %s are all in use.", tensorSets_.size(),
+            config_.name.c_str());
+        return nullptr;
+    }
+    SyncTensorSet* set = freeTensors_.back();
+    freeTensors_.pop_back();
+    return set;
+}
+
+int32_t SyncSession::CheckOutTensors()
+{
+    unique_lock<mutex> lock(tensorMutex_);
+    SyncTensorSet* set = TakeFreeTensors(lock);
+    if (set == nullptr) {
+        return NO_SYNC_TENSORS;
+    }
+    uint32_t serial = checkOuts_++ & TENSOR_SERIAL_MASK;
+    set->handle = (int32_t)((serial << TENSOR_INDEX_BITS) | set->index);
+    return set->handle;
+}
+
+SyncTensorSet* SyncSession::CheckedOutLocked(int32_t handle)
+{
+    if (handle < 0) {
+        return nullptr;
+    }
+    uint32_t index = (uint32_t)handle & ((1u << TENSOR_INDEX_BITS) - 1);
+    if (index >= tensorSets_.size() || tensorSets_[index]->handle != handle) {
+        return nullptr;
+    }
+    return tensorSets_[index].get();
+}
+
+SyncTensorSet* SyncSession::TensorsOf(int32_t handle)
+{
+    lock_guard<mutex> lock(tensorMutex_);
+    return CheckedOutLocked(handle);
+}
+
+bool SyncSession::ReturnTensors(int32_t handle)
+{
+    lock_guard<mutex> lock(tensorMutex_);
+    SyncTensorSet* set = CheckedOutLocked(handle);
+    if (set == nullptr) {
+        return false;
+    }
+    {
+        // views of the outputs still in Java must not be read past this point
+        lock_guard<mutex> leaseLock(leaseMutex_);
+        set->outputLease = 0;
+        leaseCv_.notify_all();
+    }
+    set->handle = NO_SYNC_TENSORS;
+    freeTensors_.push_back(set);
+    tensorCv_.notify_one();
+    return true;
+}
+
+int SyncSession::Run(vector<shared_ptr<AiTensor>>& inputs, SyncTensorSet& set)
+{
+    {
+        // do not overwrite outputs Java is still reading
+        unique_lock<mutex> lock(leaseMutex_);
+        if (!leaseCv_.wait_for(lock, chrono::milliseconds(OUTPUT_LEASE_WAIT_MS),
+            [&set] { return set.outputLease == 0; })) {
+            LOGE("[HIAI_DEMO_SYNC] outputs of model %s are still leased.", config_.name.c_str());
+            return FAILED;
+        }
+    }
+
+    int64_t latencyUs = 0;
+    if (Process(inputs, set.outputs, latencyUs) != SUCCESS) {
+        return FAILED;
+    }
+    time_use_sync = (long)(latencyUs / 1000);
+
+    LOGE("[HIAI_DEMO_SYNC] inference time %f ms.\n", latencyUs / 1000.0f);
+    return SUCCESS;
+}
+
+int SyncSession::Process(vector<shared_ptr<AiTensor>>& inputs, vector<shared_ptr<AiTensor>>& outputs,
+    int64_t& latencyUs)
+{
+    AiContext context;
+    string key = "model_name";
+    string value = config_.name;
+    value += ".om";
+    context.AddPara(key, value);
+
+    LOGI("[HIAI_DEMO_SYNC] runModel modelname:%s", config_.name.c_str());
+
+    // loads the model back if it was evicted, and keeps it loaded until Release
+    ModelResidency& residency = ModelResidency::Shared();
+    shared_ptr<AiModelMngerClient> client = residency.Acquire(config_.name);
+    if (client == nullptr) {
+        return FAILED;
+    }
+    // waits behind the requests of higher classes, not counted in latencyUs
+    QosScheduler& scheduler = QosScheduler::Shared();
+    scheduler.Enter(RequestQosClass(config_.qos));
+    auto start = chrono::steady_clock::now();
+    int istamp;
+    int ret = client->Process(context, inputs, outputs, PROCESS_TIMEOUT_MS, istamp);
+    scheduler.Leave();
+    residency.Release(config_.name);
+    if (ret) {
+        LOGE("[HIAI_DEMO_SYNC] Runmodel Failed!, ret=%d\n", ret);
+        return FAILED;
+    }
+    latencyUs = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    return SUCCESS;
+}
+
+void SyncSession::RunWarmup()
+{
+    if (warmup_.Runs() == 0) {
+        return;
+    }
+    // not a thread's set: nobody reads these outputs, and Java cannot lease them
+    SyncTensorSet set;
+    if (!CreateInputs(set.inputs) || !CreateOutputs(set.outputs)) {
+        warmup_.Finish(false);
+        return;
+    }
+    ZeroTensors(set.inputs);
+    warmup_.Start();
+    for (uint32_t i = 0; i < warmup_.Runs(); ++i) {
+        int64_t latencyUs = 0;
+        if (Process(set.inputs, set.outputs, latencyUs) != SUCCESS) {
+            LOGE("[HIAI_DEMO_SYNC] warm-up %u of model %s failed.", i, config_.name.c_str());
+            warmup_.Finish(false);
+            return;
+        }
+        warmup_.Record(latencyUs);
+    }
+    WarmupStats stats = warmup_.GetStats();
+    LOGI("[HIAI_DEMO_SYNC] model %s warmed up: first inference %lld us, then %lld us.", config_.name.c_str(),
+        (long long)stats.coldUs, (long long)stats.warmUs);
+    warmup_.Finish(true);
+}
+
+void SyncSession::LeaseOutputs(SyncTensorSet& set)
+{
+    lock_guard<mutex> lock(leaseMutex_);
+    set.outputLease++;
+}
+
+bool SyncSession::ReleaseOutputs(SyncTensorSet& set)
+{
+    lock_guard<mutex> lock(leaseMutex_);
+    if (set.outputLease == 0) {
+        return false;
+    }
+    set.outputLease--;
+    leaseCv_.notify_all();
+    return true;
+}
+
+shared_ptr<SyncSession> FindSyncSession(const string& modelName)
+{
+    shared_lock<shared_timed_mutex> lock(sync_sessions_mutex);
+    auto it = sync_sessions.find(modelName);
+    if (it == sync_sessions.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+bool AddSyncSession(const shared_ptr<SyncSession>& session)
+{
+    unique_lock<shared_timed_mutex> lock(sync_sessions_mutex);
+    return sync_sessions.emplace(session->Name(), session).second;
+}
+
+long GetLastSyncInferenceMs()
+{
+    return time_use_sync.load();
+}
@@ -0,0 +1,188 @@
+/*
+ * @file sync_session.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_SYNC_SESSION_H
+#define HIAI_DEMO_SYNC_SESSION_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "HiAiModelManagerService.h"
+#include "batch_scheduler.h"
+#include "load_times.h"
+#include "model_residency.h"
+#include "postprocess.h"
+#include "qos_scheduler.h"
+#include "warmup.h"
+
+// handle of no tensor set, as Constant.NO_SYNC_TENSORS
+static const int32_t NO_SYNC_TENSORS = -1;
+
+/* Input and output tensors of one caller of a sync model */
+struct SyncTensorSet {
+    std::vector<std::shared_ptr<hiai::AiTensor>> inputs;
+    std::vector<std::shared_ptr<hiai::AiTensor>> outputs;
+    // camera frame wrapped by an AippTensor, re-created when the frame size changes
+    std::shared_ptr<hiai::AiTensor> aippFrame;
+    // outputs handed to Java by leaseOutputBuffersSync; Run waits until released
+    int outputLease = 0;
+    // position in the pool of the session
+    uint32_t index = 0;
+    // handle it is checked out under, NO_SYNC_TENSORS while in the pool
+    int32_t handle = NO_SYNC_TENSORS;
+};
+
+// callers running one model at once; more wait for a set to come free
+static const size_t MAX_SYNC_TENSOR_SETS = 4;
+
+struct SyncModelConfig {
+    std::string name;
+    bool useAipp = false;
+    PostprocessConfig postprocess;
+    // runModelBatchedSync wait for a full batch, models compiled with batch > 1 only
+    int batchWaitUs = 0;
+    // synthetic inferences run by RunWarmup
+    uint32_t warmupRuns = 0;
+    // class of the requests of threads that set none, and load frequency of the model
+    QosClass qos = QOS_INTERACTIVE;
+};
+
+/*
+ * One model loaded by loadModelSync. Callers run it on tensor sets checked out
+ * of a pool of at most MAX_SYNC_TENSOR_SETS, so threads run it in parallel
+ * without sharing buffers and without a set per thread that ever called it;
+ * the first set is created at load time, the others when every set is out.
+ * A caller that fills the inputs and runs them in separate calls keeps the
+ * handle of its set in between, from any thread, and returns it when done;
+ * a handle is not reused, so a stale one is refused rather than aliasing the
+ * set of another caller. The model itself is held by ModelResidency::Shared(),
+ * which may evict it between two inferences; Run loads it back when needed.
+ */
+class SyncSession {
+public:
+    /*
+    * @brief Load a model added to ModelResidency::Shared(), read its IO dimensions
+    *        and create its session with the tensors of its first thread
+    * @param [out] times loadUs, ioUs and tensorUs of the model
+    * @return nullptr if the model cannot be loaded or its tensors cannot be created
+    */
+    static std::shared_ptr<SyncSession> Create(const SyncModelConfig& config, ModelLoadTimes& times);
+
+    SyncSession(const SyncSession&) = delete;
+    SyncSession& operator=(const SyncSession&) = delete;
+
+    const std::string& Name() const { return config_.name; }
+    const std::vector<hiai::TensorDimension>& InputDims() const { return inputDims_; }
+    const std::vector<hiai::TensorDimension>& OutputDims() const { return outputDims_; }
+    const PostprocessConfig& Postprocess() const { return config_.postprocess; }
+    // AIPP input usable with AippTensor
+    bool DynamicAipp() const { return dynamicAipp_; }
+
+    /*
+    * @brief Check a tensor set out of the pool, waiting up to a second for a
+    *        free one
+    * @return handle of the set, NO_SYNC_TENSORS if none came free
+    */
+    int32_t CheckOutTensors();
+
+    /*
+    * @brief The set checked out under handle
+    * @return nullptr if handle is not checked out, e.g. already returned
+    */
+    SyncTensorSet* TensorsOf(int32_t handle);
+
+    /*
+    * @brief Return a set to the pool; a lease of its outputs ends with it
+    * @return false if handle is not checked out
+    */
+    bool ReturnTensors(int32_t handle);
+
+    /*
+    * @brief Run the model on inputs into the outputs of set, waiting up to a
+    *        second while they are leased
+    */
+    int Run(std::vector<std::shared_ptr<hiai::AiTensor>>& inputs, SyncTensorSet& set);
+
+    /*
+    * @brief Run the warm-up inferences of the model on zero inputs, with
+    *        tensors of their own. Blocks until they are done.
+    */
+    void RunWarmup();
+
+    const WarmupTracker& Warmup() const { return warmup_; }
+
+    const ModelLoadTimes& LoadTimes() const { return loadTimes_; }
+    // before the session is added with AddSyncSession
+    void SetLoadTimes(const ModelLoadTimes& times) { loadTimes_ = times; }
+
+    void LeaseOutputs(SyncTensorSet& set);
+
+    /* @return false if the outputs of set are not leased */
+    bool ReleaseOutputs(SyncTensorSet& set);
+
+    /* Scheduler of runModelBatchedSync, nullptr unless the model is compiled with batch > 1 */
+    BatchScheduler* Batch() const { return batch_.get(); }
+    std::vector<std::shared_ptr<hiai::AiTensor>>& BatchInputs(uint32_t stage) { return batchInputs_[stage]; }
+    // shared by the stages, the scheduler runs one batch at a time
+    SyncTensorSet& BatchOutputs() { return batchOutputs_; }
+
+private:
+    explicit SyncSession(const SyncModelConfig& config);
+    bool CreateInputs(std::vector<std::shared_ptr<hiai::AiTensor>>& inputs) const;
+    bool CreateOutputs(std::vector<std::shared_ptr<hiai::AiTensor>>& outputs) const;
+    bool CreateBatch();
+    SyncTensorSet* TakeFreeTensors(std::unique_lock<std::mutex>& lock);
+    // the set checked out under handle, with tensorMutex_ held
+    SyncTensorSet* CheckedOutLocked(int32_t handle);
+    int Process(std::vector<std::shared_ptr<hiai::AiTensor>>& inputs,
+        std::vector<std::shared_ptr<hiai::AiTensor>>& outputs, int64_t& latencyUs);
+
+    SyncModelConfig config_;
+    bool dynamicAipp_ = false;
+    std::vector<hiai::TensorDimension> inputDims_;
+    std::vector<hiai::TensorDimension> outputDims_;
+    WarmupTracker warmup_;
+    ModelLoadTimes loadTimes_;
+
+    std::mutex tensorMutex_;
+    std::condition_variable tensorCv_;
+    // the pool, the first set created at load time
+    std::vector<std::unique_ptr<SyncTensorSet>> tensorSets_;
+    std::vector<SyncTensorSet*> freeTensors_;
+    // check-outs so far, the serial part of a handle
+    uint32_t checkOuts_ = 0;
+
+    std::mutex leaseMutex_;
+    std::condition_variable leaseCv_;
+
+    std::unique_ptr<BatchScheduler> batch_;
+    std::vector<std::vector<std::shared_ptr<hiai::AiTensor>>> batchInputs_;
+    SyncTensorSet batchOutputs_;
+};
+
+/*
+* @brief Session of a model loaded by loadModelSync, safe to call from any thread
+* @return nullptr if the model is not loaded
+*/
+std::shared_ptr<SyncSession> FindSyncSession(const std::string& modelName);
+
+/*
+* @brief Make a session visible to FindSyncSession
+* @return false if a model of the same name is already registered
+*/
+bool AddSyncSession(const std::shared_ptr<SyncSession>& session);
+
+/* Duration in ms of the last Process of any sync session */
+long GetLastSyncInferenceMs();
+
+#endif
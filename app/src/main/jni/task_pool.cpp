@@ -0,0 +1,291 @@
+/*
+ * @file task_pool.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "task_pool.h"
+#include <algorithm>
+#include <cstdio>
+#include <sched.h>
+#include <unistd.h>
+#include <android/log.h>
+
+#define LOG_TAG "TASK_POOL_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+// ParallelFor cuts a range into this many chunks per thread, so a thread
+// slowed down (or a LITTLE core) does not hold up the others
+static const uint32_t CHUNKS_PER_THREAD = 4;
+
+static thread_local TaskPool* t_pool = nullptr;
+static thread_local uint32_t t_workerIndex = 0;
+
+static long ReadMaxFrequency(long cpu)
+{
+    char path[96];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%ld/cpufreq/cpuinfo_max_freq", cpu);
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    long frequency = 0;
+    if (fscanf(file, "%ld", &frequency) != 1) {
+        frequency = 0;
+    }
+    fclose(file);
+    return frequency;
+}
+
+/*
+* @brief CPUs of the requested cluster, told apart by their maximum frequency
+* @return empty when the workers should not be pinned
+*/
+static vector<int> SelectCpus(CoreAffinity affinity)
+{
+    vector<int> cpus;
+    if (affinity == CORES_ANY) {
+        return cpus;
+    }
+    long count = sysconf(_SC_NPROCESSORS_CONF);
+    vector<long> frequencies;
+    for (long cpu = 0; cpu < count; ++cpu) {
+        long frequency = ReadMaxFrequency(cpu);
+        if (frequency <= 0) {
+            LOGE("[HIAI_DEMO_POOL] frequency of cpu %ld is unknown, workers are not pinned.", cpu);
+            return cpus;
+        }
+        frequencies.push_back(frequency);
+    }
+    if (frequencies.empty()) {
+        return cpus;
+    }
+    long target = affinity == CORES_BIG ? *max_element(frequencies.begin(), frequencies.end())
+                                        : *min_element(frequencies.begin(), frequencies.end());
+    for (size_t cpu = 0; cpu < frequencies.size(); ++cpu) {
+        if (frequencies[cpu] == target) {
+            cpus.push_back((int)cpu);
+        }
+    }
+    return cpus;
+}
+
+TaskPool::TaskPool(const TaskPoolConfig& config)
+    : nextWorker_(0), queued_(0), sleeping_(0), executed_(0), stolen_(0)
+{
+    vector<int> cpus = SelectCpus(config.affinity);
+    uint32_t threads = config.threads;
+    if (threads == 0) {
+        threads = cpus.empty() ? max(1u, thread::hardware_concurrency()) : (uint32_t)cpus.size();
+    }
+    for (uint32_t i = 0; i < threads; ++i) {
+        workers_.emplace_back(new Worker());
+    }
+    // every deque exists before a worker may steal from it
+    for (uint32_t i = 0; i < threads; ++i) {
+        workers_[i]->thread = thread(&TaskPool::WorkerLoop, this, i, cpus);
+    }
+    LOGI("[HIAI_DEMO_POOL] %u workers on %zu pinned cpus.", threads, cpus.size());
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        lock_guard<mutex> lock(sleepMutex_);
+        stop_ = true;
+        wake_.notify_all();
+    }
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+void TaskPool::Submit(Task task)
+{
+    uint32_t index = t_pool == this ? t_workerIndex : nextWorker_++ % Threads();
+    Worker& worker = *workers_[index];
+    {
+        lock_guard<mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+        queued_++;
+    }
+    // pairs with the sleeping_ increment of WorkerLoop: either the worker
+    // sees the task, or this thread sees the sleeper
+    if (sleeping_.load() > 0) {
+        lock_guard<mutex> lock(sleepMutex_);
+        wake_.notify_one();
+    }
+}
+
+bool TaskPool::TakeTask(uint32_t index, Task& task)
+{
+    {
+        Worker& own = *workers_[index];
+        lock_guard<mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued_--;
+            return true;
+        }
+    }
+    uint32_t count = Threads();
+    for (uint32_t i = 1; i < count; ++i) {
+        Worker& victim = *workers_[(index + i) % count];
+        lock_guard<mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued_--;
+            stolen_++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskPool::WorkerLoop(uint32_t index, vector<int> cpus)
+{
+    t_pool = this;
+    t_workerIndex = index;
+    if (!cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) {
+            CPU_SET(cpu, &set);
+        }
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            LOGE("[HIAI_DEMO_POOL] worker %u cannot be pinned.", index);
+        }
+    }
+
+    for (;;) {
+        Task task;
+        if (TakeTask(index, task)) {
+            task();
+            executed_++;
+            continue;
+        }
+        unique_lock<mutex> lock(sleepMutex_);
+        sleeping_++;
+        wake_.wait(lock, [this] { return stop_ || queued_.load() > 0; });
+        sleeping_--;
+        if (stop_ && queued_.load() == 0) {
+            break;
+        }
+    }
+    t_pool = nullptr;
+}
+
+TaskPoolStats TaskPool::GetStats() const
+{
+    TaskPoolStats stats;
+    stats.threads = Threads();
+    stats.executed = executed_.load();
+    stats.stolen = stolen_.load();
+    return stats;
+}
+
+static mutex shared_pool_mutex;
+static TaskPoolConfig shared_pool_config;
+static atomic<TaskPool*> shared_pool(nullptr);
+
+TaskPool& TaskPool::Shared()
+{
+    TaskPool* pool = shared_pool.load(memory_order_acquire);
+    if (pool != nullptr) {
+        return *pool;
+    }
+    lock_guard<mutex> lock(shared_pool_mutex);
+    pool = shared_pool.load(memory_order_relaxed);
+    if (pool == nullptr) {
+        // never deleted: native stages may use it until the process exits
+        pool = new TaskPool(shared_pool_config);
+        shared_pool.store(pool, memory_order_release);
+    }
+    return *pool;
+}
+
+bool TaskPool::ConfigureShared(const TaskPoolConfig& config)
+{
+    lock_guard<mutex> lock(shared_pool_mutex);
+    if (shared_pool.load(memory_order_relaxed) != nullptr) {
+        return false;
+    }
+    shared_pool_config = config;
+    return true;
+}
+
+namespace {
+struct RangeWork {
+    uint32_t count;
+    uint32_t chunk;
+    uint32_t chunks;
+    // only called for a claimed chunk, and ParallelFor waits for those
+    const function<void(uint32_t, uint32_t)>* body;
+    atomic<uint32_t> next;
+    atomic<uint32_t> done;
+    mutex doneMutex;
+    condition_variable finished;
+};
+}
+
+static void RunChunks(RangeWork& work)
+{
+    uint32_t ran = 0;
+    for (;;) {
+        uint32_t chunk = work.next++;
+        if (chunk >= work.chunks) {
+            break;
+        }
+        uint32_t first = chunk * work.chunk;
+        (*work.body)(first, min(work.count, first + work.chunk));
+        ran++;
+    }
+    if (ran > 0 && work.done.fetch_add(ran) + ran == work.chunks) {
+        lock_guard<mutex> lock(work.doneMutex);
+        work.finished.notify_all();
+    }
+}
+
+void ParallelFor(TaskPool& pool, uint32_t count, uint32_t grain,
+    const function<void(uint32_t first, uint32_t last)>& body, uint32_t maxParallel)
+{
+    if (count == 0) {
+        return;
+    }
+    uint32_t parallel = pool.Threads() + 1;
+    if (maxParallel > 0 && maxParallel < parallel) {
+        parallel = maxParallel;
+    }
+    uint32_t chunk = max(max(grain, 1u), (count + parallel * CHUNKS_PER_THREAD - 1) / (parallel * CHUNKS_PER_THREAD));
+    uint32_t chunks = (count + chunk - 1) / chunk;
+    uint32_t helpers = min(parallel - 1, chunks - 1);
+    if (helpers == 0) {
+        body(0, count);
+        return;
+    }
+
+    shared_ptr<RangeWork> work = make_shared<RangeWork>();
+    work->count = count;
+    work->chunk = chunk;
+    work->chunks = chunks;
+    work->body = &body;
+    work->next = 0;
+    work->done = 0;
+    for (uint32_t i = 0; i < helpers; ++i) {
+        // a helper that starts late finds nothing left and returns
+        pool.Submit([work] { RunChunks(*work); });
+    }
+    RunChunks(*work);
+    unique_lock<mutex> lock(work->doneMutex);
+    work->finished.wait(lock, [&work] { return work->done.load() == work->chunks; });
+}
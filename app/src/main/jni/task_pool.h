@@ -0,0 +1,117 @@
+/*
+ * @file task_pool.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_TASK_POOL_H
+#define HIAI_DEMO_TASK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Cores the workers of a pool may run on, on big.LITTLE SoCs */
+enum CoreAffinity {
+    CORES_ANY = 0,
+    // cores with the highest maximum frequency
+    CORES_BIG = 1,
+    // cores with the lowest maximum frequency
+    CORES_LITTLE = 2,
+};
+
+struct TaskPoolConfig {
+    // 0 starts one worker per core of the selected cores
+    uint32_t threads = 0;
+    CoreAffinity affinity = CORES_ANY;
+};
+
+struct TaskPoolStats {
+    uint32_t threads = 0;
+    uint64_t executed = 0;
+    // tasks a worker took from the deque of another worker
+    uint64_t stolen = 0;
+};
+
+/*
+ * Work-stealing thread pool. Every worker owns a deque: tasks submitted from
+ * a worker go to the back of its own deque and are taken back LIFO, while
+ * idle workers steal from the front of the others, so related work stays on
+ * one core and a burst spreads over all of them. Tasks submitted from other
+ * threads are dealt round-robin.
+ *
+ * Tasks must not wait on other tasks or on resources released by them (an
+ * async slot, a listener): every worker could be waiting at once. ParallelFor
+ * is safe, its caller runs the chunks nobody took.
+ */
+class TaskPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit TaskPool(const TaskPoolConfig& config);
+    // runs the tasks already submitted, then joins the workers
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    void Submit(Task task);
+
+    uint32_t Threads() const { return (uint32_t)workers_.size(); }
+
+    TaskPoolStats GetStats() const;
+
+    /*
+    * @brief Pool shared by the native stages, started on first use
+    */
+    static TaskPool& Shared();
+
+    /*
+    * @brief Configure the shared pool before its first use
+    * @return false if the shared pool is already started
+    */
+    static bool ConfigureShared(const TaskPoolConfig& config);
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void WorkerLoop(uint32_t index, std::vector<int> cpus);
+    bool TakeTask(uint32_t index, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<uint32_t> nextWorker_;
+    // submitted and not taken yet; workers sleep only while it is 0
+    std::atomic<uint64_t> queued_;
+    std::atomic<uint32_t> sleeping_;
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+
+    std::atomic<uint64_t> executed_;
+    std::atomic<uint64_t> stolen_;
+};
+
+/*
+* @brief Run body(first, last) over [0, count) in chunks of at least grain
+*        items, on the calling thread and on idle workers of pool. Returns
+*        once every chunk is done.
+* @param [in] maxParallel threads working at once, 0 for the caller and every worker
+*/
+void ParallelFor(TaskPool& pool, uint32_t count, uint32_t grain,
+    const std::function<void(uint32_t first, uint32_t last)>& body, uint32_t maxParallel = 0);
+
+#endif
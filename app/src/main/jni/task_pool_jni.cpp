@@ -0,0 +1,50 @@
+/*
+ * @file task_pool_jni.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include <jni.h>
+
+#include <android/log.h>
+#include "task_pool.h"
+
+#define LOG_TAG "TASK_POOL_MSG"
+
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_configureTaskPool(JNIEnv *env, jclass type, jint threads,
+    jint affinity)
+{
+    if (threads < 0 || affinity < CORES_ANY || affinity > CORES_LITTLE) {
+        LOGE("[HIAI_DEMO_POOL] configureTaskPool invalid params.");
+        return JNI_FALSE;
+    }
+    TaskPoolConfig config;
+    config.threads = (uint32_t)threads;
+    config.affinity = static_cast<CoreAffinity>(affinity);
+    if (!TaskPool::ConfigureShared(config)) {
+        LOGE("[HIAI_DEMO_POOL] the task pool is already running.");
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_huawei_hiaidemo_utils_ModelManager_getTaskPoolStats(JNIEnv *env, jclass type)
+{
+    TaskPoolStats stats = TaskPool::Shared().GetStats();
+    jlong values[] = { (jlong)stats.threads, (jlong)stats.executed, (jlong)stats.stolen };
+    jlongArray result = env->NewLongArray(3);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, 3, values);
+    }
+    return result;
+}
@@ -0,0 +1,65 @@
+/*
+ * @file warmup.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "warmup.h"
+#include <cstring>
+
+using namespace std;
+using namespace hiai;
+
+WarmupTracker::WarmupTracker(uint32_t runs) : runs_(runs)
+{
+    if (runs_ == 0) {
+        stats_.state = WARMUP_READY;
+    }
+}
+
+void WarmupTracker::Start()
+{
+    lock_guard<mutex> lock(mutex_);
+    stats_.state = WARMUP_RUNNING;
+}
+
+void WarmupTracker::Record(int64_t latencyUs)
+{
+    lock_guard<mutex> lock(mutex_);
+    if (stats_.runs == 0) {
+        stats_.coldUs = latencyUs;
+    } else {
+        warmTotalUs_ += latencyUs;
+        stats_.warmUs = warmTotalUs_ / stats_.runs;
+    }
+    stats_.runs++;
+}
+
+void WarmupTracker::Finish(bool ok)
+{
+    lock_guard<mutex> lock(mutex_);
+    stats_.state = ok ? WARMUP_READY : WARMUP_FAILED;
+}
+
+bool WarmupTracker::IsReady() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return stats_.state == WARMUP_READY;
+}
+
+WarmupStats WarmupTracker::GetStats() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+void ZeroTensors(const vector<shared_ptr<AiTensor>>& tensors)
+{
+    for (auto& tensor : tensors) {
+        memset(tensor->GetBuffer(), 0, tensor->GetSize());
+    }
+}
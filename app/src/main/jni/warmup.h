@@ -0,0 +1,71 @@
+/*
+ * @file warmup.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_WARMUP_H
+#define HIAI_DEMO_WARMUP_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "HiAiModelManagerService.h"
+
+/* Same values as Constant.WARMUP_* */
+enum WarmupState {
+    // loaded, warm-up not started yet
+    WARMUP_COLD = 0,
+    WARMUP_RUNNING = 1,
+    // warmed up, or loaded without warm-up
+    WARMUP_READY = 2,
+    // a warm-up inference failed; the model can still be run
+    WARMUP_FAILED = 3,
+};
+
+struct WarmupStats {
+    WarmupState state = WARMUP_COLD;
+    uint32_t runs = 0;
+    // latency of the first inference after load
+    int64_t coldUs = 0;
+    // mean latency of the other warm-up inferences, 0 with a single run
+    int64_t warmUs = 0;
+};
+
+/*
+ * Progress of the synthetic inferences run on a model after it is loaded, so
+ * that callers can send traffic to it only once the first, slow Process is
+ * behind it. Safe to read from any thread while the warm-up runs.
+ */
+class WarmupTracker {
+public:
+    /* @param [in] runs warm-up inferences to run, 0 makes the model ready at once */
+    explicit WarmupTracker(uint32_t runs);
+
+    uint32_t Runs() const { return runs_; }
+
+    void Start();
+    void Record(int64_t latencyUs);
+    void Finish(bool ok);
+
+    bool IsReady() const;
+    WarmupStats GetStats() const;
+
+private:
+    uint32_t runs_;
+    mutable std::mutex mutex_;
+    WarmupStats stats_;
+    int64_t warmTotalUs_ = 0;
+};
+
+/*
+* @brief Zero the buffers of tensors, for synthetic warm-up inputs
+*/
+void ZeroTensors(const std::vector<std::shared_ptr<hiai::AiTensor>>& tensors);
+
+#endif
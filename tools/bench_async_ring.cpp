@@ -0,0 +1,154 @@
+/*
+ * @file bench_async_ring.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * Throughput of the asynchronous path against the depth of its ring of tensor
+ * sets, as classify_async_jni.cpp runs it: the submitter preprocesses a frame
+ * into a free slot and hands it to the stub NPU of hiai_stub.cpp, whose
+ * completions go to a delivery thread that runs the callback and only then
+ * returns the slot. With one slot the three stages take turns; deeper rings
+ * let them overlap, up to the slowest of them.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bounded_queue.h"
+#include "hiai_stub.h"
+#include "host_bench.h"
+#include "slot_free_list.h"
+
+using namespace std;
+using namespace hiai;
+
+using Clock = chrono::steady_clock;
+
+static const char* MODEL_NAME = "ring_model";
+// per frame: the submitter, the NPU, the callback on the delivery thread
+static const uint32_t PREPROCESS_US = 2000;
+static const uint32_t NPU_US = 4000;
+static const uint32_t CALLBACK_US = 1500;
+static const uint32_t DEPTHS[] = { 1, 2, 4, 8 };
+
+// CPU work, not a sleep: the stages compete for the cores as on a phone
+static void Spin(uint32_t us)
+{
+    Clock::time_point end = Clock::now() + chrono::microseconds(us);
+    while (Clock::now() < end) {
+    }
+}
+
+struct Completion {
+    uint32_t slot;
+    uint32_t frame;
+};
+
+class RingListener : public AiModelManagerClientListener {
+public:
+    explicit RingListener(BoundedQueue<Completion>& delivery) : delivery_(delivery)
+    {
+    }
+
+    void OnProcessDone(const AiContext& context, int32_t result, const vector<shared_ptr<AiTensor>>& outTensor,
+        int32_t stamp) override
+    {
+        (void)result;
+        (void)outTensor;
+        (void)stamp;
+        AiContext request = context;
+        Completion completion;
+        completion.slot = (uint32_t)stoul(request.GetPara("slot"));
+        completion.frame = (uint32_t)stoul(request.GetPara("frame"));
+        delivery_.Push(completion);
+    }
+
+    void OnServiceDied() override
+    {
+    }
+
+private:
+    BoundedQueue<Completion>& delivery_;
+};
+
+struct RingResult {
+    double framesPerS;
+    HostLatency latency;
+};
+
+static RingResult RunRing(uint32_t depth, uint32_t frames)
+{
+    BoundedQueue<Completion> delivery(256);
+    SlotFreeList freeSlots(depth);
+    vector<Clock::time_point> submitted(frames);
+    vector<double> latencyUs(frames);
+    AiModelMngerClient client;
+    client.Init(make_shared<RingListener>(delivery));
+    vector<shared_ptr<AiModelDescription>> models = { make_shared<AiModelDescription>(MODEL_NAME, 3, 0, 0, 0) };
+    client.Load(models);
+
+    thread deliverer([&] {
+        Completion completion;
+        while (delivery.Pop(completion)) {
+            Spin(CALLBACK_US);
+            freeSlots.Release(completion.slot);
+            latencyUs[completion.frame] =
+                chrono::duration<double, micro>(Clock::now() - submitted[completion.frame]).count();
+        }
+    });
+    Clock::time_point start = Clock::now();
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        // the latency of a frame includes its wait for a slot
+        submitted[frame] = Clock::now();
+        uint32_t slot = 0;
+        freeSlots.Acquire(slot);
+        Spin(PREPROCESS_US);
+        AiContext context;
+        context.AddPara("model_name", MODEL_NAME);
+        context.AddPara("slot", to_string(slot));
+        context.AddPara("frame", to_string(frame));
+        vector<shared_ptr<AiTensor>> inputs;
+        vector<shared_ptr<AiTensor>> outputs;
+        int32_t stamp = -1;
+        client.Process(context, inputs, outputs, 1000, stamp);
+    }
+    // every slot back: every frame delivered
+    for (uint32_t i = 0; i < depth; ++i) {
+        uint32_t slot = 0;
+        freeSlots.Acquire(slot);
+    }
+    double elapsedS = chrono::duration<double>(Clock::now() - start).count();
+    delivery.Close();
+    deliverer.join();
+    RingResult result;
+    result.framesPerS = frames / elapsedS;
+    result.latency = HostLatencyOf(latencyUs);
+    return result;
+}
+
+HOST_BENCH(AsyncRingDepth)
+{
+    HostDdkLatency ddk;
+    ddk.processUs = NPU_US;
+    HostSetDdkLatency(ddk);
+    const uint32_t frames = HostBenchScale(300u, 10u);
+    printf("  preprocess %u us, npu %u us, callback %u us per frame\n", PREPROCESS_US, NPU_US, CALLBACK_US);
+    for (uint32_t depth : DEPTHS) {
+        RingResult result = RunRing(depth, frames);
+        char label[32];
+        snprintf(label, sizeof(label), "depth %u", depth);
+        HostBenchPrint(label, "%6.1f frames/s  latency p50 %7.0f us  p99 %7.0f us", result.framesPerS,
+            result.latency.p50Us, result.latency.p99Us);
+    }
+    HostSetDdkLatency(HostDdkLatency());
+}
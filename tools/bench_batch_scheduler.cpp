@@ -0,0 +1,115 @@
+/*
+ * @file bench_batch_scheduler.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * Throughput and latency of BatchScheduler against its batch size and wait
+ * window, with concurrent callers of a model whose run costs a fixed part plus
+ * a part per image, as an NPU run does. Batch 1 is the unbatched baseline.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "batch_scheduler.h"
+#include "host_bench.h"
+
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+// cost of a run of the stub model
+static const uint32_t RUN_FIXED_US = 3000;
+static const uint32_t RUN_PER_IMAGE_US = 400;
+// as sync_session.cpp
+static const uint32_t BATCH_STAGES = 2;
+static const uint32_t CALLERS = 8;
+// a row of the input and output of the stub model
+static const size_t ROW_BYTES = 3 * 224 * 224;
+static const uint32_t BATCHES[] = { 1, 2, 4, 8 };
+static const uint32_t WAITS_US[] = { 0, 500, 2000 };
+
+struct BatchResult {
+    double imagesPerS;
+    double meanBatch;
+    HostLatency latency;
+};
+
+static BatchResult RunBatches(uint32_t maxBatch, uint32_t waitUs, chrono::milliseconds duration)
+{
+    vector<vector<uint8_t>> staging(BATCH_STAGES, vector<uint8_t>(ROW_BYTES * maxBatch));
+    atomic<uint64_t> runs{ 0 };
+    atomic<uint64_t> rows{ 0 };
+    BatchScheduler scheduler(maxBatch, chrono::microseconds(waitUs), BATCH_STAGES,
+        [&](uint32_t stage, uint32_t count) {
+            (void)stage;
+            this_thread::sleep_for(chrono::microseconds(RUN_FIXED_US + RUN_PER_IMAGE_US * count));
+            runs++;
+            rows += count;
+            return 0;
+        });
+
+    mutex samplesMutex;
+    vector<double> samplesUs;
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + duration;
+    vector<thread> callers;
+    for (uint32_t c = 0; c < CALLERS; ++c) {
+        callers.emplace_back([&] {
+            vector<uint8_t> input(ROW_BYTES, 1);
+            vector<uint8_t> output(ROW_BYTES);
+            vector<double> mine;
+            while (Clock::now() < end) {
+                Clock::time_point submitted = Clock::now();
+                scheduler.Submit(
+                    [&](uint32_t stage, uint32_t row) {
+                        memcpy(&staging[stage][row * ROW_BYTES], input.data(), ROW_BYTES);
+                    },
+                    [&](uint32_t stage, uint32_t row) {
+                        memcpy(output.data(), &staging[stage][row * ROW_BYTES], ROW_BYTES);
+                    });
+                mine.push_back(chrono::duration<double, micro>(Clock::now() - submitted).count());
+            }
+            lock_guard<mutex> lock(samplesMutex);
+            samplesUs.insert(samplesUs.end(), mine.begin(), mine.end());
+        });
+    }
+    for (thread& caller : callers) {
+        caller.join();
+    }
+    double elapsedS = chrono::duration<double>(Clock::now() - start).count();
+    BatchResult result;
+    result.imagesPerS = rows / elapsedS;
+    result.meanBatch = runs > 0 ? (double)rows / runs : 0;
+    result.latency = HostLatencyOf(samplesUs);
+    return result;
+}
+
+HOST_BENCH(BatchScheduler)
+{
+    const chrono::milliseconds duration(HostBenchScale(500, 20));
+    printf("  %u callers, a run takes %u us + %u us per image\n", CALLERS, RUN_FIXED_US, RUN_PER_IMAGE_US);
+    for (uint32_t batch : BATCHES) {
+        for (uint32_t waitUs : WAITS_US) {
+            if (batch == 1 && waitUs > 0) {
+                continue;
+            }
+            BatchResult result = RunBatches(batch, waitUs, duration);
+            char label[48];
+            snprintf(label, sizeof(label), "batch %u wait %u us", batch, waitUs);
+            HostBenchPrint(label, "%6.0f images/s  mean batch %4.1f  p50 %6.0f us  p99 %6.0f us",
+                result.imagesPerS, result.meanBatch, result.latency.p50Us, result.latency.p99Us);
+        }
+    }
+}
@@ -0,0 +1,138 @@
+/*
+ * @file bench_image_preprocess.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * Benchmarks of the image conversions of image_preprocess.cpp against their
+ * scalar or multi-pass references, at the input size of a classifier, a VGA
+ * camera frame and a 1080p one; CropResizeNormalize also against the bitmap
+ * steps of the Java side it replaced. The SIMD paths are those of the
+ * compiler flags of the build: SSE2 on x86-64 by default, NEON on ARM.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "host_bench.h"
+#include "image_preprocess.h"
+
+using namespace std;
+
+struct BenchSize {
+    const char* name;
+    uint32_t width;
+    uint32_t height;
+};
+
+static const BenchSize SIZES[] = {
+    { "224x224", 224, 224 },
+    { "640x480", 640, 480 },
+    { "1920x1080", 1920, 1080 },
+};
+
+static vector<uint8_t> RandomRgba(uint32_t width, uint32_t height)
+{
+    mt19937 rng(width * height);
+    vector<uint8_t> rgba((size_t)width * height * 4);
+    for (uint8_t& v : rgba) {
+        v = static_cast<uint8_t>(rng());
+    }
+    return rgba;
+}
+
+HOST_BENCH(RgbaToNv12)
+{
+    for (const BenchSize& size : SIZES) {
+        vector<uint8_t> rgba = RandomRgba(size.width, size.height);
+        vector<uint8_t> yuv((size_t)size.width * size.height * 3 / 2);
+        const uint32_t stride = size.width * 4;
+        double refUs = HostBenchTimeUs([&] {
+            RgbaToYuv420spRef(rgba.data(), size.width, size.height, stride, hiai::BT_601_NARROW, false, yuv.data());
+        });
+        double simdUs = HostBenchTimeUs([&] {
+            RgbaToYuv420sp(rgba.data(), size.width, size.height, stride, hiai::BT_601_NARROW, false, yuv.data());
+        });
+        double mpix = (double)size.width * size.height / simdUs;
+        HostBenchPrint(size.name, "ref %9.1f us  simd %9.1f us  x%4.1f  %6.0f Mpix/s", refUs, simdUs,
+            refUs / simdUs, mpix);
+    }
+}
+
+// What the Java side did before the fused kernel, allocations included:
+// bitmap.copy, createScaledBitmap to the short side, extractThumbnail,
+// getPixels, then the per-plane normalize
+static void JavaPathResizeNormalize(const vector<uint8_t>& frame, uint32_t srcW, uint32_t srcH, uint32_t dstW,
+    uint32_t dstH, const NormalizeSpec& spec, float* dst)
+{
+    vector<uint8_t> copy(frame);
+    const float scale = max((float)dstW / srcW, (float)dstH / srcH);
+    const uint32_t scaledW = max(dstW, (uint32_t)(srcW * scale + 0.5f));
+    const uint32_t scaledH = max(dstH, (uint32_t)(srcH * scale + 0.5f));
+    vector<AxisTap> xs;
+    vector<AxisTap> ys;
+    BuildAxis(srcW, 0, (float)srcW, scaledW, xs);
+    BuildAxis(srcH, 0, (float)srcH, scaledH, ys);
+    vector<uint8_t> scaled((size_t)scaledW * scaledH * 4);
+    for (uint32_t y = 0; y < scaledH; ++y) {
+        const uint8_t* row0 = copy.data() + (size_t)ys[y].i0 * srcW * 4;
+        const uint8_t* row1 = copy.data() + (size_t)ys[y].i1 * srcW * 4;
+        uint8_t* out = scaled.data() + (size_t)y * scaledW * 4;
+        for (uint32_t x = 0; x < scaledW; ++x) {
+            for (uint32_t c = 0; c < 4; ++c) {
+                float a0 = row0[xs[x].i0 * 4 + c];
+                float a1 = row0[xs[x].i1 * 4 + c];
+                float b0 = row1[xs[x].i0 * 4 + c];
+                float b1 = row1[xs[x].i1 * 4 + c];
+                float h0 = a0 + xs[x].w * (a1 - a0);
+                float h1 = b0 + xs[x].w * (b1 - b0);
+                out[x * 4 + c] = (uint8_t)(h0 + ys[y].w * (h1 - h0) + 0.5f);
+            }
+        }
+    }
+    vector<uint8_t> thumbnail((size_t)dstW * dstH * 4);
+    const uint32_t left = (scaledW - dstW) / 2;
+    const uint32_t top = (scaledH - dstH) / 2;
+    for (uint32_t y = 0; y < dstH; ++y) {
+        memcpy(&thumbnail[(size_t)y * dstW * 4], &scaled[((size_t)(top + y) * scaledW + left) * 4], dstW * 4);
+    }
+    vector<uint8_t> pixels(thumbnail);
+    const uint32_t planeSize = dstW * dstH;
+    for (uint32_t p = 0; p < 3; ++p) {
+        const uint32_t c = spec.bgr ? 2 - p : p;
+        for (uint32_t i = 0; i < planeSize; ++i) {
+            dst[p * planeSize + i] = (pixels[i * 4 + c] - spec.mean[p]) * spec.scale[p];
+        }
+    }
+}
+
+HOST_BENCH(CropResizeNormalize)
+{
+    // the input of a classifier, from a frame of each size
+    const uint32_t dstW = 224;
+    const uint32_t dstH = 224;
+    NormalizeSpec spec = { { 123.675f, 116.28f, 103.53f }, { 1 / 58.395f, 1 / 57.12f, 1 / 57.375f }, false };
+    vector<float> tensor(3 * dstW * dstH);
+    for (const BenchSize& size : SIZES) {
+        vector<uint8_t> rgba = RandomRgba(size.width, size.height);
+        const uint32_t stride = size.width * 4;
+        double javaUs = HostBenchTimeUs([&] {
+            JavaPathResizeNormalize(rgba, size.width, size.height, dstW, dstH, spec, tensor.data());
+        });
+        double refUs = HostBenchTimeUs([&] {
+            CropResizeNormalizeRef(rgba.data(), size.width, size.height, stride, dstW, dstH, spec, tensor.data());
+        });
+        double fusedUs = HostBenchTimeUs([&] {
+            CropResizeNormalize(rgba.data(), size.width, size.height, stride, dstW, dstH, spec, tensor.data());
+        });
+        HostBenchPrint(size.name, "java path %8.1f us  multi-pass %8.1f us  fused %8.1f us  x%4.1f", javaUs, refUs,
+            fusedUs, javaUs / fusedUs);
+    }
+}
@@ -0,0 +1,235 @@
+/*
+ * @file bench_model_mapping.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * Load time and memory of a model mapped with MapModel against the path it
+ * replaced: the asset copied to app storage through a growing byte array
+ * (Untils.copyModelsFromAssetToAppModels), then the copy read onto the heap
+ * (InputMemBufferCreate(path)). Each variant runs in a child process whose
+ * peak RSS comes from wait4, less that of a child that loads nothing; the
+ * model is read once through, as Load does, with a warm page cache.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include "HiAiModelManagerService.h"
+#include "host_bench.h"
+#include "model_mapping.h"
+
+using namespace std;
+using namespace hiai;
+
+using Clock = chrono::steady_clock;
+
+static const char* MODEL_NAME = "mapped_model";
+static const size_t PAGE = 4096;
+
+// what a child reports back through its pipe
+struct LoadReport {
+    double loadMs = 0;
+    uint64_t anonKbAfterLoad = 0;
+    uint32_t checksum = 0;
+    bool ok = false;
+};
+
+struct LoadResult {
+    LoadReport report;
+    long maxRssKb = 0;
+};
+
+static uint64_t AnonRssKb()
+{
+    FILE* status = fopen("/proc/self/status", "r");
+    if (status == nullptr) {
+        return 0;
+    }
+    char line[256];
+    unsigned long long kb = 0;
+    while (fgets(line, sizeof(line), status) != nullptr) {
+        if (sscanf(line, "RssAnon: %llu kB", &kb) == 1) {
+            break;
+        }
+    }
+    fclose(status);
+    return kb;
+}
+
+// the DDK reads the model once through while it loads it
+static uint32_t ReadThrough(const void* data, size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint32_t sum = 0;
+    for (size_t i = 0; i < size; i += PAGE / 4) {
+        sum += bytes[i];
+    }
+    return sum;
+}
+
+static bool LoadBuffer(const void* data, size_t size, uint32_t& checksum)
+{
+    shared_ptr<AiModelDescription> desc = make_shared<AiModelDescription>(MODEL_NAME, 3, 0, 0, 0);
+    desc->SetModelBuffer(data, (uint32_t)size);
+    checksum = ReadThrough(data, size);
+    AiModelMngerClient client;
+    client.Init(nullptr);
+    vector<shared_ptr<AiModelDescription>> models = { desc };
+    return client.Load(models) == AI_SUCCESS;
+}
+
+// copyModelsFromAssetToAppModels: a ByteArrayOutputStream filled in 8 KB reads, then written out
+static bool CopyToStorage(const string& asset, const string& copy)
+{
+    FILE* in = fopen(asset.c_str(), "rb");
+    if (in == nullptr) {
+        return false;
+    }
+    vector<uint8_t> stream;
+    stream.reserve(32);
+    uint8_t chunk[8192];
+    size_t n = 0;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+        if (stream.size() + n > stream.capacity()) {
+            stream.reserve(max(stream.capacity() * 2, stream.size() + n));
+        }
+        stream.insert(stream.end(), chunk, chunk + n);
+    }
+    fclose(in);
+    // toByteArray() copies it once more before the write
+    vector<uint8_t> bytes(stream);
+    FILE* out = fopen(copy.c_str(), "wb");
+    if (out == nullptr) {
+        return false;
+    }
+    bool written = fwrite(bytes.data(), 1, bytes.size(), out) == bytes.size();
+    return fclose(out) == 0 && written;
+}
+
+static LoadReport CopyAndReadLoad(const string& asset, const string& copy)
+{
+    LoadReport report;
+    Clock::time_point start = Clock::now();
+    if (!CopyToStorage(asset, copy)) {
+        return report;
+    }
+    // InputMemBufferCreate(path)
+    FILE* in = fopen(copy.c_str(), "rb");
+    if (in == nullptr) {
+        return report;
+    }
+    fseek(in, 0, SEEK_END);
+    size_t size = (size_t)ftell(in);
+    fseek(in, 0, SEEK_SET);
+    vector<uint8_t> buffer(size);
+    bool read = fread(buffer.data(), 1, size, in) == size;
+    fclose(in);
+    report.ok = read && LoadBuffer(buffer.data(), size, report.checksum);
+    report.loadMs = chrono::duration<double, milli>(Clock::now() - start).count();
+    report.anonKbAfterLoad = AnonRssKb();
+    return report;
+}
+
+static LoadReport MappedLoad(const string& asset)
+{
+    LoadReport report;
+    Clock::time_point start = Clock::now();
+    ModelSource source;
+    source.path = asset;
+    shared_ptr<ModelMapping> model = MapModel(source);
+    report.ok = model != nullptr && LoadBuffer(model->Data(), model->Size(), report.checksum);
+    report.loadMs = chrono::duration<double, milli>(Clock::now() - start).count();
+    report.anonKbAfterLoad = AnonRssKb();
+    return report;
+}
+
+template <typename Load>
+static LoadResult InChild(Load&& load)
+{
+    LoadResult result;
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return result;
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        LoadReport report = load();
+        ssize_t written = write(fds[1], &report, sizeof(report));
+        _exit(written == (ssize_t)sizeof(report) ? 0 : 1);
+    }
+    close(fds[1]);
+    if (pid < 0 || read(fds[0], &result.report, sizeof(result.report)) != (ssize_t)sizeof(result.report)) {
+        result.report.ok = false;
+    }
+    close(fds[0]);
+    int status = 0;
+    rusage usage;
+    if (pid > 0 && wait4(pid, &status, 0, &usage) == pid) {
+        result.maxRssKb = usage.ru_maxrss;
+    }
+    return result;
+}
+
+HOST_BENCH(ModelLoad)
+{
+    const size_t modelBytes = HostBenchScale<size_t>(64, 4) << 20;
+    const char* tmp = getenv("TMPDIR") != nullptr ? getenv("TMPDIR") : "/tmp";
+    string asset = string(tmp) + "/host_bench_model_XXXXXX";
+    int fd = mkstemp(&asset[0]);
+    if (fd < 0) {
+        printf("  no temporary file in %s\n", tmp);
+        return;
+    }
+    vector<uint8_t> model(modelBytes);
+    for (size_t i = 0; i < model.size(); ++i) {
+        model[i] = static_cast<uint8_t>(i * 2654435761u >> 24);
+    }
+    bool written = write(fd, model.data(), model.size()) == (ssize_t)model.size();
+    close(fd);
+    vector<uint8_t>().swap(model);
+    string copy = asset + ".copy";
+    if (written) {
+        // warm the page cache for both variants
+        InChild([&] { return MappedLoad(asset); });
+
+        LoadResult idle = InChild([] {
+            LoadReport report;
+            report.ok = true;
+            report.anonKbAfterLoad = AnonRssKb();
+            return report;
+        });
+        LoadResult before = InChild([&] { return CopyAndReadLoad(asset, copy); });
+        LoadResult after = InChild([&] { return MappedLoad(asset); });
+        printf("  %zu MB model, RSS over a child that loads nothing\n", modelBytes >> 20);
+        const LoadResult* results[] = { &before, &after };
+        const char* names[] = { "copy to storage + read to heap", "MapModel" };
+        for (int i = 0; i < 2; ++i) {
+            const LoadReport& report = results[i]->report;
+            if (!report.ok) {
+                HostBenchPrint(names[i], "failed");
+                continue;
+            }
+            HostBenchPrint(names[i], "load %7.1f ms  peak RSS %7.1f MB  anonymous RSS after load %7.1f MB",
+                report.loadMs, (results[i]->maxRssKb - idle.maxRssKb) / 1024.0,
+                ((double)report.anonKbAfterLoad - idle.report.anonKbAfterLoad) / 1024.0);
+        }
+    }
+    unlink(copy.c_str());
+    unlink(asset.c_str());
+}
@@ -0,0 +1,80 @@
+/*
+ * @file bench_postprocess.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * Benchmark of the top-K of postprocess.cpp against TopKRef, its
+ * std::partial_sort reference, at the output size of an ImageNet-1k
+ * classifier, of a larger label set and of ImageNet-21k.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "host_bench.h"
+#include "postprocess.h"
+
+using namespace std;
+
+static const uint32_t CLASS_COUNTS[] = { 1000, 5000, 21841 };
+static const uint32_t KS[] = { 1, 3, 5, 10 };
+
+// logits of a classifier: a few confident classes over noise
+static vector<float> RandomLogits(uint32_t count)
+{
+    mt19937 rng(count);
+    normal_distribution<float> noise(0.0f, 2.0f);
+    vector<float> scores(count);
+    for (float& v : scores) {
+        v = noise(rng);
+    }
+    for (uint32_t i = 0; i < 5; ++i) {
+        scores[rng() % count] += 12.0f;
+    }
+    return scores;
+}
+
+HOST_BENCH(TopK)
+{
+    uint32_t indices[10];
+    float values[10];
+    for (uint32_t count : CLASS_COUNTS) {
+        vector<float> scores = RandomLogits(count);
+        for (bool softmax : { false, true }) {
+            for (uint32_t k : KS) {
+                double refUs = HostBenchTimeUs([&] {
+                    TopKRef(scores.data(), count, k, softmax, indices, values);
+                });
+                double topKUs = HostBenchTimeUs([&] {
+                    TopK(scores.data(), count, k, softmax, indices, values);
+                });
+                char label[64];
+                snprintf(label, sizeof(label), "%u classes k=%u%s", count, k, softmax ? " softmax" : "");
+                HostBenchPrint(label, "partial_sort %8.2f us  topk %8.2f us  x%4.1f", refUs, topKUs, refUs / topKUs);
+            }
+        }
+    }
+}
+
+HOST_BENCH(TopKPacked)
+{
+    // what the JNI side runs per request, into the float[] for Java
+    PostprocessConfig config;
+    config.topK = 5;
+    config.softmax = true;
+    float packed[10];
+    for (uint32_t count : CLASS_COUNTS) {
+        vector<float> scores = RandomLogits(count);
+        double us = HostBenchTimeUs([&] { TopKPacked(scores.data(), count, config, packed); });
+        char label[64];
+        snprintf(label, sizeof(label), "%u classes k=5 softmax", count);
+        HostBenchPrint(label, "%8.2f us", us);
+    }
+}
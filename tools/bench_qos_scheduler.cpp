@@ -0,0 +1,128 @@
+/*
+ * @file bench_qos_scheduler.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * Latency of interactive requests under a mixed load: a camera-rate
+ * interactive stream alone, then with background threads sending bulk
+ * requests back to back, through QosScheduler with inFlight unbounded and
+ * bounded, QOS_DEFAULT_IN_FLIGHT by default. The stub NPU serves one Process call at a time in
+ * arrival order, so what the scheduler lets through is what waits there.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "host_bench.h"
+#include "qos_scheduler.h"
+
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+static const chrono::microseconds INTERACTIVE_RUN(3000);
+static const chrono::microseconds INTERACTIVE_PERIOD(20000);
+static const chrono::microseconds BACKGROUND_RUN(8000);
+static const uint32_t BACKGROUND_THREADS = 4;
+
+// one execution unit, calls served first come first served
+class StubNpu {
+public:
+    void Run(chrono::microseconds duration)
+    {
+        unique_lock<mutex> lock(mutex_);
+        uint64_t ticket = nextTicket_++;
+        turn_.wait(lock, [this, ticket] { return serving_ == ticket; });
+        lock.unlock();
+        this_thread::sleep_for(duration);
+        lock.lock();
+        serving_++;
+        turn_.notify_all();
+    }
+
+private:
+    mutex mutex_;
+    condition_variable turn_;
+    uint64_t nextTicket_ = 0;
+    uint64_t serving_ = 0;
+};
+
+struct MixedResult {
+    HostLatency interactive;
+    double backgroundPerS;
+};
+
+static MixedResult RunMixed(uint32_t inFlight, uint32_t backgroundThreads, chrono::milliseconds duration)
+{
+    QosConfig config;
+    config.inFlight = inFlight;
+    QosScheduler scheduler(config);
+    StubNpu npu;
+    auto process = [&](QosClass qos, chrono::microseconds run) {
+        scheduler.Enter(qos);
+        npu.Run(run);
+        scheduler.Leave();
+    };
+
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + duration;
+    atomic<uint64_t> backgroundDone{ 0 };
+    vector<thread> background;
+    for (uint32_t t = 0; t < backgroundThreads; ++t) {
+        background.emplace_back([&] {
+            while (Clock::now() < end) {
+                process(QOS_BACKGROUND, BACKGROUND_RUN);
+                backgroundDone++;
+            }
+        });
+    }
+    vector<double> latencyUs;
+    for (Clock::time_point frame = start; frame < end; frame += INTERACTIVE_PERIOD) {
+        this_thread::sleep_until(frame);
+        Clock::time_point submitted = Clock::now();
+        process(QOS_INTERACTIVE, INTERACTIVE_RUN);
+        latencyUs.push_back(chrono::duration<double, micro>(Clock::now() - submitted).count());
+    }
+    for (thread& t : background) {
+        t.join();
+    }
+    MixedResult result;
+    result.interactive = HostLatencyOf(latencyUs);
+    result.backgroundPerS = backgroundDone / chrono::duration<double>(Clock::now() - start).count();
+    return result;
+}
+
+HOST_BENCH(QosMixedLoad)
+{
+    const chrono::milliseconds duration(HostBenchScale(2000, 60));
+    printf("  interactive %lld us every %lld us, %u background threads of %lld us requests\n",
+        (long long)INTERACTIVE_RUN.count(), (long long)INTERACTIVE_PERIOD.count(), BACKGROUND_THREADS,
+        (long long)BACKGROUND_RUN.count());
+    struct Scenario {
+        const char* name;
+        uint32_t inFlight;
+        uint32_t backgroundThreads;
+    };
+    const Scenario scenarios[] = {
+        { "interactive alone", QOS_IN_FLIGHT_UNBOUNDED, 0 },
+        { "mixed, inFlight unbounded", QOS_IN_FLIGHT_UNBOUNDED, BACKGROUND_THREADS },
+        { "mixed, inFlight 2 (default)", QOS_DEFAULT_IN_FLIGHT, BACKGROUND_THREADS },
+        { "mixed, inFlight 1", 1, BACKGROUND_THREADS },
+    };
+    for (const Scenario& scenario : scenarios) {
+        MixedResult result = RunMixed(scenario.inFlight, scenario.backgroundThreads, duration);
+        HostBenchPrint(scenario.name, "interactive p50 %6.0f us  p99 %6.0f us  background %5.1f/s",
+            result.interactive.p50Us, result.interactive.p99Us, result.backgroundPerS);
+    }
+}
@@ -0,0 +1,130 @@
+/*
+ * @file bench_task_pool.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * Task throughput of TaskPool: small tasks submitted from outside the pool
+ * and fanned out from inside it, and the crop/resize/normalize of a frame
+ * split with ParallelFor against one thread and against the threads spawned
+ * and joined per call that the CPU AIPP used before the pool.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+#include "host_bench.h"
+#include "image_preprocess.h"
+#include "task_pool.h"
+
+using namespace std;
+
+static const uint32_t THREADS[] = { 1, 2, 4 };
+// work of a small task, a few hundred nanoseconds
+static const uint32_t TASK_WORK = 64;
+
+static uint32_t SmallWork(uint32_t seed)
+{
+    uint32_t x = seed;
+    for (uint32_t i = 0; i < TASK_WORK; ++i) {
+        x = x * 1664525u + 1013904223u;
+    }
+    return x;
+}
+
+// submits tasks and waits for them without blocking a worker
+static void WaitFor(const atomic<uint32_t>& done, uint32_t tasks)
+{
+    while (done.load(memory_order_acquire) < tasks) {
+        this_thread::yield();
+    }
+}
+
+HOST_BENCH(TaskPoolThroughput)
+{
+    const uint32_t tasks = HostBenchScale(20000u, 100u);
+    atomic<uint32_t> sink{ 0 };
+    for (uint32_t threads : THREADS) {
+        TaskPoolConfig config;
+        config.threads = threads;
+        TaskPool pool(config);
+        atomic<uint32_t> done{ 0 };
+        double externalUs = HostBenchTimeUs([&] {
+            done = 0;
+            for (uint32_t i = 0; i < tasks; ++i) {
+                pool.Submit([&sink, &done, i] {
+                    sink += SmallWork(i);
+                    done.fetch_add(1, memory_order_release);
+                });
+            }
+            WaitFor(done, tasks);
+        });
+        // one task fans out the others from a worker: LIFO on its deque, stolen by the rest
+        double fanOutUs = HostBenchTimeUs([&] {
+            done = 0;
+            pool.Submit([&pool, &sink, &done, tasks] {
+                for (uint32_t i = 1; i < tasks; ++i) {
+                    pool.Submit([&sink, &done, i] {
+                        sink += SmallWork(i);
+                        done.fetch_add(1, memory_order_release);
+                    });
+                }
+                done.fetch_add(1, memory_order_release);
+            });
+            WaitFor(done, tasks);
+        });
+        TaskPoolStats stats = pool.GetStats();
+        char label[32];
+        snprintf(label, sizeof(label), "%u workers", threads);
+        HostBenchPrint(label, "external %6.2f Mtasks/s  fan-out %6.2f Mtasks/s  stolen %4.1f%%",
+            tasks / externalUs, tasks / fanOutUs, 100.0 * stats.stolen / max<uint64_t>(stats.executed, 1));
+    }
+}
+
+HOST_BENCH(TaskPoolParallelFor)
+{
+    const uint32_t srcW = 1920;
+    const uint32_t srcH = 1080;
+    const uint32_t dstW = 224;
+    const uint32_t dstH = 224;
+    const uint32_t rowsPerTask = 16;
+    mt19937 rng(1);
+    vector<uint8_t> rgba((size_t)srcW * srcH * 4);
+    for (uint8_t& v : rgba) {
+        v = static_cast<uint8_t>(rng());
+    }
+    NormalizeSpec spec = { { 123.675f, 116.28f, 103.53f }, { 1 / 58.395f, 1 / 57.12f, 1 / 57.375f }, false };
+    vector<float> tensor(3 * dstW * dstH);
+    auto rows = [&](uint32_t first, uint32_t last) {
+        CropResizeNormalizeRows(rgba.data(), srcW, srcH, srcW * 4, dstW, dstH, spec, first, last, tensor.data());
+    };
+    double serialUs = HostBenchTimeUs([&] { rows(0, dstH); });
+    HostBenchPrint("1080p to 224x224, 1 thread", "%8.1f us", serialUs);
+    for (uint32_t threads : THREADS) {
+        TaskPoolConfig config;
+        config.threads = threads;
+        TaskPool pool(config);
+        double poolUs = HostBenchTimeUs([&] { ParallelFor(pool, dstH, rowsPerTask, rows); });
+        double spawnUs = HostBenchTimeUs([&] {
+            vector<thread> bands;
+            const uint32_t band = (dstH + threads - 1) / threads;
+            for (uint32_t first = 0; first < dstH; first += band) {
+                bands.emplace_back(rows, first, min(dstH, first + band));
+            }
+            for (thread& t : bands) {
+                t.join();
+            }
+        });
+        char label[32];
+        snprintf(label, sizeof(label), "%u workers", threads);
+        HostBenchPrint(label, "ParallelFor %8.1f us  spawn+join %8.1f us", poolUs, spawnUs);
+    }
+}
@@ -0,0 +1,38 @@
+/*
+ * @file asset_manager.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_HOST_ANDROID_ASSET_MANAGER_H
+#define HIAI_DEMO_HOST_ANDROID_ASSET_MANAGER_H
+
+#include <sys/types.h>
+
+/* Host stand-in of the NDK assets: there is no APK, so no asset opens */
+
+struct AAssetManager;
+struct AAsset;
+
+enum {
+    AASSET_MODE_UNKNOWN = 0,
+    AASSET_MODE_RANDOM = 1,
+    AASSET_MODE_STREAMING = 2,
+    AASSET_MODE_BUFFER = 3,
+};
+
+extern "C" {
+AAsset* AAssetManager_open(AAssetManager* mgr, const char* filename, int mode);
+void AAsset_close(AAsset* asset);
+const void* AAsset_getBuffer(AAsset* asset);
+off_t AAsset_getLength(AAsset* asset);
+off64_t AAsset_getLength64(AAsset* asset);
+int AAsset_openFileDescriptor64(AAsset* asset, off64_t* outStart, off64_t* outLength);
+int AAsset_isAllocated(AAsset* asset);
+}
+
+#endif
@@ -0,0 +1,25 @@
+/*
+ * @file log.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_HOST_ANDROID_LOG_H
+#define HIAI_DEMO_HOST_ANDROID_LOG_H
+
+/* Host stand-in of the NDK log, implemented in android_stub.cpp */
+
+enum {
+    ANDROID_LOG_DEBUG = 3,
+    ANDROID_LOG_INFO = 4,
+    ANDROID_LOG_WARN = 5,
+    ANDROID_LOG_ERROR = 6,
+};
+
+extern "C" int __android_log_print(int prio, const char* tag, const char* fmt, ...);
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * @file android_stub.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <android/asset_manager.h>
+#include <android/log.h>
+
+// quiet unless HIAI_HOST_LOG is set: the tests provoke errors on purpose
+int __android_log_print(int prio, const char* tag, const char* fmt, ...)
+{
+    static const bool enabled = getenv("HIAI_HOST_LOG") != nullptr;
+    if (!enabled) {
+        return 0;
+    }
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "%d %s: ", prio, tag);
+    int n = vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    return n;
+}
+
+AAsset* AAssetManager_open(AAssetManager*, const char*, int)
+{
+    return nullptr;
+}
+
+void AAsset_close(AAsset*)
+{
+}
+
+const void* AAsset_getBuffer(AAsset*)
+{
+    return nullptr;
+}
+
+off_t AAsset_getLength(AAsset*)
+{
+    return 0;
+}
+
+off64_t AAsset_getLength64(AAsset*)
+{
+    return 0;
+}
+
+int AAsset_openFileDescriptor64(AAsset*, off64_t*, off64_t*)
+{
+    return -1;
+}
+
+int AAsset_isAllocated(AAsset*)
+{
+    return 0;
+}
@@ -0,0 +1,856 @@
+/*
+ * @file hiai_stub.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * Host implementation of the parts of the DDK (HiAiModelManagerService.h) the
+ * host tests link against. It holds values and does no inference; a client
+ * answers after the latency a test sets and can be told to die.
+ */
+
+#include "hiai_stub.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace hiai {
+
+TensorDimension::TensorDimension()
+{
+}
+
+TensorDimension::~TensorDimension()
+{
+}
+
+TensorDimension::TensorDimension(uint32_t number, uint32_t channel, uint32_t height, uint32_t width)
+    : n(number), c(channel), h(height), w(width)
+{
+}
+
+void TensorDimension::SetNumber(const uint32_t number)
+{
+    n = number;
+}
+
+uint32_t TensorDimension::GetNumber() const
+{
+    return n;
+}
+
+void TensorDimension::SetChannel(const uint32_t channel)
+{
+    c = channel;
+}
+
+uint32_t TensorDimension::GetChannel() const
+{
+    return c;
+}
+
+void TensorDimension::SetHeight(const uint32_t height)
+{
+    h = height;
+}
+
+uint32_t TensorDimension::GetHeight() const
+{
+    return h;
+}
+
+void TensorDimension::SetWidth(const uint32_t width)
+{
+    w = width;
+}
+
+uint32_t TensorDimension::GetWidth() const
+{
+    return w;
+}
+
+bool TensorDimension::IsEqual(const TensorDimension& dim)
+{
+    return n == dim.n && c == dim.c && h == dim.h && w == dim.w;
+}
+
+// owns the buffer of an AiTensor
+class AiTensorLegacy {
+public:
+    explicit AiTensorLegacy(size_t size) : data(size, 0) {}
+    std::vector<uint8_t> data;
+};
+
+AiTensor::AiTensor()
+{
+}
+
+AiTensor::~AiTensor()
+{
+}
+
+AIStatus AiTensor::InitWithSize(uint32_t n, uint32_t c, uint32_t h, uint32_t w, uint32_t size)
+{
+    if (size == 0) {
+        return AI_INVALID_PARA;
+    }
+    tensorLegacy_ = std::make_shared<AiTensorLegacy>(size);
+    buffer_ = tensorLegacy_->data.data();
+    size_ = size;
+    tensorDimension_ = TensorDimension(n, c, h, w);
+    return AI_SUCCESS;
+}
+
+AIStatus AiTensor::Init(const TensorDimension* dim)
+{
+    return Init(dim, HIAI_DATATYPE_FLOAT32);
+}
+
+AIStatus AiTensor::Init(const TensorDimension* dim, HIAI_DataType pdataType)
+{
+    if (dim == nullptr) {
+        return AI_INVALID_POINTER;
+    }
+    static const uint32_t typeSizes[] = { 1, 4, 2, 4, 1, 2, 1, 8, 4, 8 };
+    if (pdataType < HIAI_DATATYPE_UINT8 || pdataType > HIAI_DATATYPE_DOUBLE) {
+        return AI_INVALID_PARA;
+    }
+    uint64_t size = (uint64_t)dim->GetNumber() * dim->GetChannel() * dim->GetHeight() * dim->GetWidth() *
+        typeSizes[pdataType];
+    if (size > UINT32_MAX) {
+        return AI_INVALID_PARA;
+    }
+    return InitWithSize(dim->GetNumber(), dim->GetChannel(), dim->GetHeight(), dim->GetWidth(), (uint32_t)size);
+}
+
+AIStatus AiTensor::Init(uint32_t number, uint32_t height, uint32_t width, AiTensorImage_Format format)
+{
+    uint64_t pixels = (uint64_t)number * height * width;
+    uint64_t size = 0;
+    uint32_t channel = 3;
+    switch (format) {
+        case AiTensorImage_YUV420SP_U8:
+            size = pixels * 3 / 2;
+            break;
+        case AiTensorImage_YUV400_U8:
+            size = pixels;
+            channel = 1;
+            break;
+        case AiTensorImage_XRGB8888_U8:
+        case AiTensorImage_ARGB8888_U8:
+        case AiTensorImage_AYUV444_U8:
+            size = pixels * 4;
+            channel = 4;
+            break;
+        case AiTensorImage_YUYV_U8:
+        case AiTensorImage_YUV422SP_U8:
+            size = pixels * 2;
+            break;
+        case AiTensorImage_RGB888_U8:
+        case AiTensorImage_BGR888_U8:
+        case AiTensorImage_YUV444SP_U8:
+        case AiTensorImage_YVU444SP_U8:
+            size = pixels * 3;
+            break;
+        default:
+            return AI_INVALID_PARA;
+    }
+    if (size > UINT32_MAX) {
+        return AI_INVALID_PARA;
+    }
+    return InitWithSize(number, channel, height, width, (uint32_t)size);
+}
+
+void* AiTensor::GetBuffer() const
+{
+    return buffer_;
+}
+
+uint32_t AiTensor::GetSize() const
+{
+    return size_;
+}
+
+AIStatus AiTensor::SetTensorDimension(const TensorDimension* dim)
+{
+    if (dim == nullptr) {
+        return AI_INVALID_POINTER;
+    }
+    tensorDimension_ = *dim;
+    return AI_SUCCESS;
+}
+
+TensorDimension AiTensor::GetTensorDimension() const
+{
+    return tensorDimension_;
+}
+
+void* AiTensor::GetTensorBuffer() const
+{
+    return buffer_;
+}
+
+// every parameter an AippPara was given, per batch where the DDK keeps them per batch
+class AippParaImpl {
+public:
+    static AippParaImpl& Of(AippPara& para)
+    {
+        return *para.aippParaImpl;
+    }
+
+    uint32_t batchCount = 0;
+    int32_t inputIndex = -1;
+    int32_t inputAippIndex = -1;
+    AippInputShape inputShape;
+    AiTensorImage_Format inputFormat = AiTensorImage_INVALID;
+    AippCscPara csc;
+    HostAippCscRequest cscRequest;
+    AippChannelSwapPara channelSwap;
+    std::vector<AippCropPara> crop;
+    std::vector<AippResizePara> resize;
+    std::vector<AippPaddingPara> padding;
+    std::vector<AippDtcPara> dtc;
+};
+
+AippPara::AippPara() : aippParaImpl(new AippParaImpl())
+{
+}
+
+AippPara::~AippPara()
+{
+}
+
+AIStatus AippPara::Init(uint32_t batchCount)
+{
+    if (batchCount == 0 || aippParaImpl->batchCount != 0) {
+        return AI_INVALID_PARA;
+    }
+    aippParaImpl->batchCount = batchCount;
+    aippParaImpl->crop.resize(batchCount);
+    aippParaImpl->resize.resize(batchCount);
+    aippParaImpl->padding.resize(batchCount);
+    aippParaImpl->dtc.resize(batchCount);
+    return AI_SUCCESS;
+}
+
+uint32_t AippPara::GetBatchCount()
+{
+    return aippParaImpl->batchCount;
+}
+
+AIStatus AippPara::SetInputIndex(uint32_t inputIndex)
+{
+    aippParaImpl->inputIndex = (int32_t)inputIndex;
+    return aippParaImpl->batchCount == 0 ? AI_NOT_INIT : AI_SUCCESS;
+}
+
+int32_t AippPara::GetInputIndex()
+{
+    return aippParaImpl->inputIndex;
+}
+
+AIStatus AippPara::SetInputAippIndex(uint32_t inputAippIndex)
+{
+    aippParaImpl->inputAippIndex = (int32_t)inputAippIndex;
+    return aippParaImpl->batchCount == 0 ? AI_NOT_INIT : AI_SUCCESS;
+}
+
+int32_t AippPara::GetInputAippIndex()
+{
+    return aippParaImpl->inputAippIndex;
+}
+
+AIStatus AippPara::SetInputShape(AippInputShape inputShape)
+{
+    if (inputShape.srcImageSizeW == 0 || inputShape.srcImageSizeH == 0) {
+        return AI_INVALID_PARA;
+    }
+    aippParaImpl->inputShape = inputShape;
+    return AI_SUCCESS;
+}
+
+AippInputShape AippPara::GetInputShape()
+{
+    return aippParaImpl->inputShape;
+}
+
+AIStatus AippPara::SetInputFormat(AiTensorImage_Format inputFormat)
+{
+    aippParaImpl->inputFormat = inputFormat;
+    return AI_SUCCESS;
+}
+
+AiTensorImage_Format AippPara::GetInputFormat()
+{
+    return aippParaImpl->inputFormat;
+}
+
+// YUV to RGB888 matrices of the DDK, 8 fractional bits, rows R, G, B
+static AIStatus FillYuvToRgbCsc(ImageType imageType, AippCscPara& csc)
+{
+    struct Matrix {
+        int32_t m[9];
+        int32_t yBias;
+    };
+    static const Matrix FULL = { { 256, 0, 359, 256, -88, -183, 256, 454, 0 }, 0 };
+    static const Matrix BT601 = { { 298, 0, 409, 298, -100, -208, 298, 516, 0 }, 16 };
+    static const Matrix BT709 = { { 298, 0, 460, 298, -55, -137, 298, 541, 0 }, 16 };
+    const Matrix* matrix = nullptr;
+    switch (imageType) {
+        case JPEG:
+        case BT_601_FULL:
+            matrix = &FULL;
+            break;
+        case BT_601_NARROW:
+            matrix = &BT601;
+            break;
+        case BT_709_NARROW:
+            matrix = &BT709;
+            break;
+        default:
+            return AI_INVALID_PARA;
+    }
+    csc = AippCscPara();
+    csc.switch_ = true;
+    const int32_t* m = matrix->m;
+    csc.matrixR0C0 = m[0]; csc.matrixR0C1 = m[1]; csc.matrixR0C2 = m[2];
+    csc.matrixR1C0 = m[3]; csc.matrixR1C1 = m[4]; csc.matrixR1C2 = m[5];
+    csc.matrixR2C0 = m[6]; csc.matrixR2C1 = m[7]; csc.matrixR2C2 = m[8];
+    csc.inputBias0 = matrix->yBias;
+    csc.inputBias1 = 128;
+    csc.inputBias2 = 128;
+    return AI_SUCCESS;
+}
+
+AIStatus AippPara::SetCscPara(AiTensorImage_Format targetFormat, ImageType imageType)
+{
+    AippParaImpl& impl = *aippParaImpl;
+    impl.cscRequest.set = true;
+    impl.cscRequest.targetFormat = targetFormat;
+    impl.cscRequest.imageType = imageType;
+    if (impl.inputFormat != AiTensorImage_YUV420SP_U8 || targetFormat != AiTensorImage_RGB888_U8) {
+        // the demo only converts YUV420SP frames to RGB
+        return AI_INVALID_PARA;
+    }
+    return FillYuvToRgbCsc(imageType, impl.csc);
+}
+
+AippCscPara AippPara::GetCscPara()
+{
+    return aippParaImpl->csc;
+}
+
+AIStatus AippPara::SetChannelSwapPara(AippChannelSwapPara channelSwapPara)
+{
+    aippParaImpl->channelSwap = channelSwapPara;
+    return AI_SUCCESS;
+}
+
+AippChannelSwapPara AippPara::GetChannelSwapPara()
+{
+    return aippParaImpl->channelSwap;
+}
+
+template<typename T>
+static AIStatus SetForBatch(std::vector<T>& values, uint32_t batchIndex, const T& value)
+{
+    if (batchIndex >= values.size()) {
+        return AI_INVALID_PARA;
+    }
+    values[batchIndex] = value;
+    return AI_SUCCESS;
+}
+
+template<typename T>
+static AIStatus SetForAll(std::vector<T>& values, const T& value)
+{
+    if (values.empty()) {
+        return AI_NOT_INIT;
+    }
+    std::fill(values.begin(), values.end(), value);
+    return AI_SUCCESS;
+}
+
+template<typename T>
+static T GetForBatch(const std::vector<T>& values, uint32_t batchIndex)
+{
+    return batchIndex < values.size() ? values[batchIndex] : T();
+}
+
+AIStatus AippPara::SetCropPara(AippCropPara cropPara)
+{
+    return SetForAll(aippParaImpl->crop, cropPara);
+}
+
+AIStatus AippPara::SetCropPara(uint32_t batchIndex, AippCropPara cropPara)
+{
+    return SetForBatch(aippParaImpl->crop, batchIndex, cropPara);
+}
+
+AippCropPara AippPara::GetCropPara(uint32_t batchIndex)
+{
+    return GetForBatch(aippParaImpl->crop, batchIndex);
+}
+
+AIStatus AippPara::SetResizePara(AippResizePara resizePara)
+{
+    return SetForAll(aippParaImpl->resize, resizePara);
+}
+
+AIStatus AippPara::SetResizePara(uint32_t batchIndex, AippResizePara resizePara)
+{
+    return SetForBatch(aippParaImpl->resize, batchIndex, resizePara);
+}
+
+AippResizePara AippPara::GetResizePara(uint32_t batchIndex)
+{
+    return GetForBatch(aippParaImpl->resize, batchIndex);
+}
+
+AIStatus AippPara::SetPaddingPara(AippPaddingPara paddingPara)
+{
+    return SetForAll(aippParaImpl->padding, paddingPara);
+}
+
+AIStatus AippPara::SetPaddingPara(uint32_t batchIndex, AippPaddingPara paddingPara)
+{
+    return SetForBatch(aippParaImpl->padding, batchIndex, paddingPara);
+}
+
+AippPaddingPara AippPara::GetPaddingPara(uint32_t batchIndex)
+{
+    return GetForBatch(aippParaImpl->padding, batchIndex);
+}
+
+AIStatus AippPara::SetDtcPara(AippDtcPara dtcPara)
+{
+    return SetForAll(aippParaImpl->dtc, dtcPara);
+}
+
+AIStatus AippPara::SetDtcPara(uint32_t batchIndex, AippDtcPara dtcPara)
+{
+    return SetForBatch(aippParaImpl->dtc, batchIndex, dtcPara);
+}
+
+AippDtcPara AippPara::GetDtcPara(uint32_t batchIndex)
+{
+    return GetForBatch(aippParaImpl->dtc, batchIndex);
+}
+
+AippTensor::AippTensor(std::shared_ptr<AiTensor> tensor, std::vector<std::shared_ptr<AippPara>> aippParas)
+    : tensor(tensor), aippParas(aippParas)
+{
+}
+
+AippTensor::~AippTensor()
+{
+}
+
+void* AippTensor::GetBuffer() const
+{
+    return tensor == nullptr ? nullptr : tensor->GetBuffer();
+}
+
+uint32_t AippTensor::GetSize() const
+{
+    return tensor == nullptr ? 0 : tensor->GetSize();
+}
+
+std::shared_ptr<AiTensor> AippTensor::GetAiTensor() const
+{
+    return tensor;
+}
+
+std::vector<std::shared_ptr<AippPara>> AippTensor::GetAippParas() const
+{
+    return aippParas;
+}
+
+std::shared_ptr<AippPara> AippTensor::GetAippParas(uint32_t index) const
+{
+    return index < aippParas.size() ? aippParas[index] : nullptr;
+}
+
+std::string AiContext::GetPara(const std::string& key) const
+{
+    auto it = paras_.find(key);
+    return it == paras_.end() ? std::string() : it->second;
+}
+
+void AiContext::AddPara(const std::string& key, const std::string& value)
+{
+    paras_.insert(std::make_pair(key, value));
+}
+
+void AiContext::SetPara(const std::string& key, const std::string& value)
+{
+    paras_[key] = value;
+}
+
+void AiContext::DelPara(const std::string& key)
+{
+    paras_.erase(key);
+}
+
+void AiContext::ClearPara()
+{
+    paras_.clear();
+}
+
+AIStatus AiContext::GetAllKeys(std::vector<std::string>& keys)
+{
+    keys.clear();
+    for (const auto& para : paras_) {
+        keys.push_back(para.first);
+    }
+    return AI_SUCCESS;
+}
+
+AiModelDescription::AiModelDescription(const std::string& pmodelName, const int32_t frequency,
+    const int32_t framework, const int32_t pmodelType, const int32_t pdeviceType)
+    : model_name_(pmodelName), frequency_(frequency), framework_(framework), modelType_(pmodelType),
+      deviceType_(pdeviceType)
+{
+}
+
+AiModelDescription::~AiModelDescription()
+{
+}
+
+std::string AiModelDescription::GetName() const
+{
+    return model_name_;
+}
+
+void* AiModelDescription::GetModelBuffer() const
+{
+    return modelNetBuffer_;
+}
+
+AIStatus AiModelDescription::SetModelBuffer(const void* data, uint32_t size)
+{
+    modelNetBuffer_ = const_cast<void*>(data);
+    modelNetSize_ = size;
+    return AI_SUCCESS;
+}
+
+int32_t AiModelDescription::GetFrequency() const
+{
+    return frequency_;
+}
+
+int32_t AiModelDescription::GetFramework() const
+{
+    return framework_;
+}
+
+int32_t AiModelDescription::GetModelType() const
+{
+    return modelType_;
+}
+
+int32_t AiModelDescription::GetDeviceType() const
+{
+    return deviceType_;
+}
+
+uint32_t AiModelDescription::GetModelNetSize() const
+{
+    return modelNetSize_;
+}
+
+static std::mutex g_stubMutex;
+static std::string g_ddkVersion = AIPP_BASE_VERSION;
+static HostDdkLatency g_latency;
+// Process calls accepted by live clients so far, and those that kill their client
+static uint32_t g_acceptedProcesses = 0;
+static std::set<uint32_t> g_killAt;
+static uint32_t g_failingLoads = 0;
+static std::map<std::string, std::pair<std::vector<TensorDimension>, std::vector<TensorDimension>>> g_modelIo;
+
+/*
+ * A client serves its asynchronous requests in order on a thread of its own,
+ * like the NPU service does. A dead client refuses every call and drops what
+ * it had not answered yet.
+ */
+class AiModelMngerClientImpl {
+public:
+    struct Request {
+        AiContext context;
+        std::vector<std::shared_ptr<AiTensor>> outputs;
+        int32_t stamp;
+    };
+
+    ~AiModelMngerClientImpl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        pending.notify_all();
+        if (!worker.joinable()) {
+            return;
+        }
+        // the last reference may go in a listener call, on the worker itself
+        if (worker.get_id() == std::this_thread::get_id()) {
+            worker.detach();
+        } else {
+            worker.join();
+        }
+    }
+
+    void Serve()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            pending.wait(lock, [this] { return stopping || !requests.empty(); });
+            if (stopping) {
+                return;
+            }
+            Request request = requests.front();
+            requests.pop_front();
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::microseconds(processUs));
+            lock.lock();
+            if (!alive || stopping) {
+                continue;
+            }
+            std::shared_ptr<AiModelManagerClientListener> done = listener;
+            lock.unlock();
+            done->OnProcessDone(request.context, AI_SUCCESS, request.outputs, request.stamp);
+            lock.lock();
+        }
+    }
+
+    void Kill()
+    {
+        std::shared_ptr<AiModelManagerClientListener> died;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!alive) {
+                return;
+            }
+            alive = false;
+            requests.clear();
+            died = listener;
+        }
+        if (died != nullptr) {
+            // reported from another thread, as by the binder, but before the killing call returns
+            std::thread([died] { died->OnServiceDied(); }).join();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable pending;
+    std::shared_ptr<AiModelManagerClientListener> listener;
+    std::string version;
+    std::vector<std::string> models;
+    std::deque<Request> requests;
+    std::thread worker;
+    uint32_t processUs = 0;
+    int32_t nextStamp = 0;
+    bool alive = true;
+    bool stopping = false;
+};
+
+// clientImpl_ is private to the DDK header: HostKillClient finds it here
+static std::map<const AiModelMngerClient*, std::shared_ptr<AiModelMngerClientImpl>> g_clients;
+
+AiModelMngerClient::AiModelMngerClient() : clientImpl_(std::make_shared<AiModelMngerClientImpl>())
+{
+    std::lock_guard<std::mutex> lock(g_stubMutex);
+    g_clients[this] = clientImpl_;
+}
+
+AiModelMngerClient::~AiModelMngerClient()
+{
+    std::lock_guard<std::mutex> lock(g_stubMutex);
+    g_clients.erase(this);
+}
+
+AIStatus AiModelMngerClient::Init(std::shared_ptr<AiModelManagerClientListener> listener)
+{
+    std::lock_guard<std::mutex> lock(clientImpl_->mutex);
+    clientImpl_->listener = listener;
+    if (listener != nullptr && !clientImpl_->worker.joinable()) {
+        AiModelMngerClientImpl* impl = clientImpl_.get();
+        clientImpl_->worker = std::thread([impl] { impl->Serve(); });
+    }
+    return AI_SUCCESS;
+}
+
+AIStatus AiModelMngerClient::Load(std::vector<std::shared_ptr<AiModelDescription>>& pmodelDesc)
+{
+    uint32_t loadUs = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_stubMutex);
+        loadUs = g_latency.loadUs;
+        if (g_failingLoads > 0) {
+            g_failingLoads--;
+            return AI_FAILED;
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(loadUs * pmodelDesc.size()));
+    std::lock_guard<std::mutex> lock(clientImpl_->mutex);
+    if (!clientImpl_->alive) {
+        return AI_FAILED;
+    }
+    for (const auto& desc : pmodelDesc) {
+        if (desc == nullptr) {
+            return AI_INVALID_PARA;
+        }
+        clientImpl_->models.push_back(desc->GetName());
+    }
+    return AI_SUCCESS;
+}
+
+AIStatus AiModelMngerClient::Process(AiContext& context, std::vector<std::shared_ptr<AiTensor>>& pinputTensor,
+    std::vector<std::shared_ptr<AiTensor>>& poutputTensor, uint32_t timeout, int32_t& piStamp)
+{
+    (void)pinputTensor;
+    (void)timeout;
+    bool kill = false;
+    uint32_t processUs = 0;
+    {
+        std::lock_guard<std::mutex> lock(clientImpl_->mutex);
+        if (!clientImpl_->alive || clientImpl_->models.empty()) {
+            return AI_FAILED;
+        }
+        std::lock_guard<std::mutex> stubLock(g_stubMutex);
+        kill = g_killAt.erase(++g_acceptedProcesses) > 0;
+        processUs = g_latency.processUs;
+        if (clientImpl_->listener != nullptr) {
+            piStamp = clientImpl_->nextStamp++;
+            clientImpl_->processUs = processUs;
+            clientImpl_->requests.push_back(AiModelMngerClientImpl::Request{ context, poutputTensor, piStamp });
+            clientImpl_->pending.notify_one();
+        }
+    }
+    if (kill) {
+        // the request is accepted, then lost with the client
+        clientImpl_->Kill();
+        return AI_SUCCESS;
+    }
+    if (clientImpl_->listener == nullptr) {
+        std::this_thread::sleep_for(std::chrono::microseconds(processUs));
+    }
+    return AI_SUCCESS;
+}
+
+AIStatus AiModelMngerClient::CheckModelCompatibility(AiModelDescription& pmodelDesc, bool& pisModelCompatibility)
+{
+    pisModelCompatibility = !pmodelDesc.GetName().empty();
+    return AI_SUCCESS;
+}
+
+AIStatus AiModelMngerClient::GetModelIOTensorDim(const std::string& pmodelName,
+    std::vector<TensorDimension>& pinputTensor, std::vector<TensorDimension>& poutputTensor)
+{
+    {
+        std::lock_guard<std::mutex> lock(clientImpl_->mutex);
+        auto& models = clientImpl_->models;
+        if (!clientImpl_->alive || std::find(models.begin(), models.end(), pmodelName) == models.end()) {
+            return AI_FAILED;
+        }
+    }
+    std::lock_guard<std::mutex> lock(g_stubMutex);
+    auto io = g_modelIo.find(pmodelName);
+    if (io == g_modelIo.end()) {
+        // a classifier of the demo
+        pinputTensor = { TensorDimension(1, 3, 224, 224) };
+        poutputTensor = { TensorDimension(1, 1000, 1, 1) };
+    } else {
+        pinputTensor = io->second.first;
+        poutputTensor = io->second.second;
+    }
+    return AI_SUCCESS;
+}
+
+char* AiModelMngerClient::GetVersion()
+{
+    std::lock_guard<std::mutex> lock(g_stubMutex);
+    clientImpl_->version = g_ddkVersion;
+    return &clientImpl_->version[0];
+}
+
+AIStatus AiModelMngerClient::GetModelAippPara(const std::string& modelName,
+    std::vector<std::shared_ptr<AippPara>>& aippPara)
+{
+    // models of the host tests are not built with AIPP
+    aippPara.clear();
+    return modelName.empty() ? AI_INVALID_PARA : AI_SUCCESS;
+}
+
+AIStatus AiModelMngerClient::GetModelAippPara(const std::string& modelName, uint32_t index,
+    std::vector<std::shared_ptr<AippPara>>& aippPara)
+{
+    (void)index;
+    return GetModelAippPara(modelName, aippPara);
+}
+
+AIStatus AiModelMngerClient::UnLoadModel()
+{
+    std::lock_guard<std::mutex> lock(clientImpl_->mutex);
+    clientImpl_->models.clear();
+    clientImpl_->requests.clear();
+    return AI_SUCCESS;
+}
+
+} // namespace hiai
+
+HostAippCscRequest HostAippCscRequestOf(hiai::AippPara& para)
+{
+    return hiai::AippParaImpl::Of(para).cscRequest;
+}
+
+void HostSetDdkVersion(const std::string& version)
+{
+    std::lock_guard<std::mutex> lock(hiai::g_stubMutex);
+    hiai::g_ddkVersion = version;
+}
+
+void HostSetDdkLatency(const HostDdkLatency& latency)
+{
+    std::lock_guard<std::mutex> lock(hiai::g_stubMutex);
+    hiai::g_latency = latency;
+}
+
+void HostSetModelIo(const std::string& modelName, const std::vector<hiai::TensorDimension>& inputs,
+    const std::vector<hiai::TensorDimension>& outputs)
+{
+    std::lock_guard<std::mutex> lock(hiai::g_stubMutex);
+    hiai::g_modelIo[modelName] = std::make_pair(inputs, outputs);
+}
+
+void HostKillClient(hiai::AiModelMngerClient& client)
+{
+    std::shared_ptr<hiai::AiModelMngerClientImpl> impl;
+    {
+        std::lock_guard<std::mutex> lock(hiai::g_stubMutex);
+        impl = hiai::g_clients[&client];
+    }
+    impl->Kill();
+}
+
+void HostKillClientAt(uint32_t processCall)
+{
+    std::lock_guard<std::mutex> lock(hiai::g_stubMutex);
+    hiai::g_killAt.insert(hiai::g_acceptedProcesses + processCall);
+}
+
+void HostFailLoads(uint32_t loads)
+{
+    std::lock_guard<std::mutex> lock(hiai::g_stubMutex);
+    hiai::g_failingLoads = loads;
+}
@@ -0,0 +1,72 @@
+/*
+ * @file hiai_stub.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_HOST_HIAI_STUB_H
+#define HIAI_DEMO_HOST_HIAI_STUB_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "HiAiModelManagerService.h"
+
+/*
+ * What hiai_stub.cpp lets a host test see of the DDK calls, beyond what the
+ * getters of HiAiModelManagerService.h give back.
+ */
+
+/* SetCscPara request recorded by an AippPara */
+struct HostAippCscRequest {
+    bool set = false;
+    hiai::AiTensorImage_Format targetFormat = hiai::AiTensorImage_INVALID;
+    hiai::ImageType imageType = hiai::JPEG;
+};
+
+/*
+* @brief Arguments of the last SetCscPara call on para. The matrix the stub
+*        filled in for them is GetCscPara().
+*/
+HostAippCscRequest HostAippCscRequestOf(hiai::AippPara& para);
+
+/* DDK version every client reports from now on, AIPP_BASE_VERSION at start */
+void HostSetDdkVersion(const std::string& version);
+
+/* Time the stub NPU takes, 0 at start */
+struct HostDdkLatency {
+    // per model loaded
+    uint32_t loadUs = 0;
+    uint32_t processUs = 0;
+};
+
+void HostSetDdkLatency(const HostDdkLatency& latency);
+
+/*
+* @brief Dims GetModelIOTensorDim gives for modelName, instead of those of a
+*        224x224 classifier with 1000 labels
+*/
+void HostSetModelIo(const std::string& modelName, const std::vector<hiai::TensorDimension>& inputs,
+    const std::vector<hiai::TensorDimension>& outputs);
+
+/*
+* @brief Kill client as the NPU service dies: the requests it has not answered
+*        are dropped, every call fails from now on, and its listener gets
+*        OnServiceDied before this returns
+*/
+void HostKillClient(hiai::AiModelMngerClient& client);
+
+/*
+* @brief Kill the client that accepts the processCall-th Process call from
+*        now on, right after it accepted it; calls to dead clients do not count
+*/
+void HostKillClientAt(uint32_t processCall);
+
+/* The next loads Load calls fail */
+void HostFailLoads(uint32_t loads);
+
+#endif
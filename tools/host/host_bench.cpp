@@ -0,0 +1,56 @@
+/*
+ * @file host_bench.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * main of host_bench: host_bench [--quick] [filter]
+ */
+
+#include "host_bench.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+void HostBenchPrint(const char* label, const char* fmt, ...)
+{
+    printf("  %-36s ", label);
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    printf("\n");
+    fflush(stdout);
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            HostBenchQuick() = true;
+        } else {
+            filter = argv[i];
+        }
+    }
+    int run = 0;
+    for (const HostBenchCase& bench : HostBenchCases()) {
+        if (filter != nullptr && strstr(bench.name, filter) == nullptr) {
+            continue;
+        }
+        printf("[%s]\n", bench.name);
+        fflush(stdout);
+        bench.run();
+        run++;
+    }
+    if (run == 0) {
+        fprintf(stderr, "no benchmark matches %s\n", filter != nullptr ? filter : "");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * @file host_bench.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_HOST_BENCH_H
+#define HIAI_DEMO_HOST_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Minimal harness of the host benchmarks in tools/, all built into the one
+ * host_bench binary. A file declares its benchmarks with HOST_BENCH and prints
+ * its results with HostBenchPrint; host_bench runs those whose name contains
+ * its argument, or all of them. With --quick every benchmark shrinks to a
+ * smoke run, so that ctest keeps them building and running.
+ */
+
+struct HostBenchCase {
+    const char* name;
+    void (*run)();
+};
+
+inline std::vector<HostBenchCase>& HostBenchCases()
+{
+    static std::vector<HostBenchCase> cases;
+    return cases;
+}
+
+/* True under --quick: loads and time budgets shrink to a smoke run */
+inline bool& HostBenchQuick()
+{
+    static bool quick = false;
+    return quick;
+}
+
+struct HostBenchRegistrar {
+    HostBenchRegistrar(const char* name, void (*run)())
+    {
+        HostBenchCases().push_back(HostBenchCase{ name, run });
+    }
+};
+
+#define HOST_BENCH(name)                                                \
+    static void name();                                                 \
+    static HostBenchRegistrar name##Registrar(#name, name);             \
+    static void name()
+
+/* full unless --quick */
+template <typename T>
+inline T HostBenchScale(T full, T quick)
+{
+    return HostBenchQuick() ? quick : full;
+}
+
+/*
+* @brief Mean time of one call of body, the best of three rounds of at least
+*        100 ms each, after a call to warm the caches
+* @return microseconds per call
+*/
+template <typename Body>
+double HostBenchTimeUs(Body&& body)
+{
+    using Clock = std::chrono::steady_clock;
+    const int rounds = HostBenchScale(3, 1);
+    const std::chrono::milliseconds budget(HostBenchScale(100, 1));
+    body();
+    double best = 0;
+    for (int round = 0; round < rounds; ++round) {
+        uint64_t calls = 0;
+        Clock::time_point start = Clock::now();
+        Clock::time_point now;
+        do {
+            body();
+            calls++;
+            now = Clock::now();
+        } while (now - start < budget);
+        double us = std::chrono::duration<double, std::micro>(now - start).count() / calls;
+        best = round == 0 ? us : std::min(best, us);
+    }
+    return best;
+}
+
+struct HostLatency {
+    double meanUs = 0;
+    double p50Us = 0;
+    double p99Us = 0;
+    double maxUs = 0;
+};
+
+/* Distribution of latency samples, in microseconds */
+inline HostLatency HostLatencyOf(std::vector<double> samplesUs)
+{
+    HostLatency latency;
+    if (samplesUs.empty()) {
+        return latency;
+    }
+    std::sort(samplesUs.begin(), samplesUs.end());
+    double total = 0;
+    for (double us : samplesUs) {
+        total += us;
+    }
+    const size_t last = samplesUs.size() - 1;
+    latency.meanUs = total / samplesUs.size();
+    latency.p50Us = samplesUs[last / 2];
+    latency.p99Us = samplesUs[last * 99 / 100];
+    latency.maxUs = samplesUs[last];
+    return latency;
+}
+
+/*
+* @brief Print one result line: the label in a column of its own, then the
+*        values as formatted by fmt
+*/
+void HostBenchPrint(const char* label, const char* fmt, ...);
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * @file host_test.h
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef HIAI_DEMO_HOST_TEST_H
+#define HIAI_DEMO_HOST_TEST_H
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/*
+ * Minimal test harness of the host tests in tools/, so that they build with
+ * nothing but a compiler. A test file declares its cases with HOST_TEST and
+ * ends with HOST_TEST_MAIN(); a case fails on the first HOST_CHECK that does
+ * not hold and the binary returns non-zero if any case failed, for ctest.
+ */
+
+struct HostTestCase {
+    const char* name;
+    void (*run)();
+};
+
+inline std::vector<HostTestCase>& HostTestCases()
+{
+    static std::vector<HostTestCase> cases;
+    return cases;
+}
+
+// set by HOST_CHECK when the running case fails
+inline bool& HostTestFailed()
+{
+    static bool failed = false;
+    return failed;
+}
+
+struct HostTestRegistrar {
+    HostTestRegistrar(const char* name, void (*run)())
+    {
+        HostTestCases().push_back(HostTestCase{ name, run });
+    }
+};
+
+#define HOST_TEST(name)                                                 \
+    static void name();                                                 \
+    static HostTestRegistrar name##Registrar(#name, name);              \
+    static void name()
+
+#define HOST_CHECK(cond, ...)                                           \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            fprintf(stderr, "%s:%d: check failed: %s: ", __FILE__, __LINE__, #cond); \
+            fprintf(stderr, __VA_ARGS__);                               \
+            fprintf(stderr, "\n");                                      \
+            HostTestFailed() = true;                                    \
+            return;                                                     \
+        }                                                               \
+    } while (0)
+
+/*
+* @brief Run the cases whose name contains argv[1], or all of them
+* @return 0 if every case passed
+*/
+inline int RunHostTests(int argc, char** argv)
+{
+    int failed = 0;
+    for (const HostTestCase& test : HostTestCases()) {
+        if (argc > 1 && strstr(test.name, argv[1]) == nullptr) {
+            continue;
+        }
+        HostTestFailed() = false;
+        test.run();
+        printf("[%s] %s\n", HostTestFailed() ? "FAILED" : "OK", test.name);
+        failed += HostTestFailed() ? 1 : 0;
+    }
+    return failed == 0 ? 0 : 1;
+}
+
+#define HOST_TEST_MAIN()                                                \
+    int main(int argc, char** argv)                                     \
+    {                                                                   \
+        return RunHostTests(argc, argv);                                \
+    }
+
+#endif
@@ -0,0 +1,344 @@
+/*
+ * @file pack_model_bundle.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * Host tool packing an OM file, its labels, its preprocessing and its IO dims
+ * into a model bundle (app/src/main/jni/model_bundle_format.h) for
+ * ModelManager.readModelBundle. Build it from the repository root with
+ *
+ *   g++ -std=c++14 -O2 -I app/src/main/jni -o pack_model_bundle tools/pack_model_bundle.cpp
+ *
+ * (tools/CMakeLists.txt builds it too, for test_model_bundle.cpp), then, for
+ * the model of the demo:
+ *
+ *   ./pack_model_bundle --model app/src/main/assets/hiai_noaipp.om --labels app/src/main/assets/labels.txt \
+ *       --out app/src/main/assets/hiai_noaipp.omb --mean 103.939,116.779,123.68 --order bgr
+ *
+ * --input and --output add the dims the loader checks the model against.
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "model_bundle_format.h"
+
+using namespace std;
+
+struct PackOptions {
+    string model;
+    string labels;
+    string out;
+    BundlePreprocess preprocess;
+    vector<BundleDims> inputs;
+    vector<BundleDims> outputs;
+};
+
+static void Usage()
+{
+    fprintf(stderr,
+        "usage: pack_model_bundle --model <om> --out <omb> [options]\n"
+        "  --labels <txt>          one label per line\n"
+        "  --mean <a,b,c>          CPU normalization: out = (pixel - mean) / std, per plane\n"
+        "  --std <a,b,c>           default 1,1,1\n"
+        "  --order <bgr|rgb>       plane order of the input, default bgr\n"
+        "  --layout <nchw|nhwc>    default nchw\n"
+        "  --input <NxCxHxW>       expected input dims, repeated for each input\n"
+        "  --output <NxCxHxW>      expected output dims, repeated for each output\n"
+        "  --aipp                  the input is a YUV420SP frame processed by AIPP\n"
+        "  --image-type <jpeg|bt601-narrow|bt601-full|bt709-narrow>  AIPP colour matrix, default bt601-narrow\n"
+        "  --nv21                  AIPP frames store V before U\n"
+        "  --crop <x,y,w,h>        AIPP crop\n"
+        "  --dtc-mean <a,b,c>      AIPP DTC mean\n"
+        "  --dtc-var-reci <a,b,c>  AIPP DTC variance reciprocal, default 1,1,1\n");
+}
+
+static bool ReadFile(const string& path, vector<uint8_t>& data)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        fprintf(stderr, "cannot open %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    uint8_t buffer[1 << 16];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    return ok;
+}
+
+// "a,b,c" into count floats
+static bool ParseFloats(const char* text, float* values, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        char* end = nullptr;
+        values[i] = strtof(text, &end);
+        if (end == text || *end != (i + 1 < count ? ',' : '\0')) {
+            return false;
+        }
+        text = end + 1;
+    }
+    return true;
+}
+
+// "a<sep>b<sep>..." into count unsigned values
+static bool ParseUints(const char* text, char sep, uint32_t* values, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        char* end = nullptr;
+        unsigned long value = strtoul(text, &end, 10);
+        if (end == text || value > UINT32_MAX || *end != (i + 1 < count ? sep : '\0')) {
+            return false;
+        }
+        values[i] = (uint32_t)value;
+        text = end + 1;
+    }
+    return true;
+}
+
+static bool ParseDims(const char* text, vector<BundleDims>& dims)
+{
+    uint32_t v[4];
+    if (!ParseUints(text, 'x', v, 4) || dims.size() >= BUNDLE_MAX_TENSORS) {
+        return false;
+    }
+    dims.push_back(BundleDims { v[0], v[1], v[2], v[3] });
+    return true;
+}
+
+static bool ParseImageType(const string& name, uint32_t& type)
+{
+    const char* names[] = { "jpeg", "bt601-narrow", "bt601-full", "bt709-narrow" };
+    for (uint32_t i = 0; i < 4; ++i) {
+        if (name == names[i]) {
+            type = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ParseArgs(int argc, char** argv, PackOptions& options)
+{
+    BundlePreprocess& pre = options.preprocess;
+    memset(&pre, 0, sizeof(pre));
+    pre.std[0] = pre.std[1] = pre.std[2] = 1.0f;
+    pre.channelOrder = BUNDLE_CHANNELS_BGR;
+    pre.layout = BUNDLE_LAYOUT_NCHW;
+    pre.aippImageType = 1;
+    pre.aippDtcVarReci[0] = pre.aippDtcVarReci[1] = pre.aippDtcVarReci[2] = 1.0f;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--aipp") {
+            pre.useAipp = 1;
+            continue;
+        }
+        if (arg == "--nv21") {
+            pre.aippNv21 = 1;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "%s needs a value\n", arg.c_str());
+            return false;
+        }
+        const char* value = argv[++i];
+        bool ok = true;
+        if (arg == "--model") {
+            options.model = value;
+        } else if (arg == "--labels") {
+            options.labels = value;
+        } else if (arg == "--out") {
+            options.out = value;
+        } else if (arg == "--mean") {
+            ok = ParseFloats(value, pre.mean, 3);
+        } else if (arg == "--std") {
+            ok = ParseFloats(value, pre.std, 3) && pre.std[0] > 0.0f && pre.std[1] > 0.0f && pre.std[2] > 0.0f;
+        } else if (arg == "--order") {
+            ok = strcmp(value, "bgr") == 0 || strcmp(value, "rgb") == 0;
+            pre.channelOrder = strcmp(value, "bgr") == 0 ? BUNDLE_CHANNELS_BGR : BUNDLE_CHANNELS_RGB;
+        } else if (arg == "--layout") {
+            ok = strcmp(value, "nchw") == 0 || strcmp(value, "nhwc") == 0;
+            pre.layout = strcmp(value, "nchw") == 0 ? BUNDLE_LAYOUT_NCHW : BUNDLE_LAYOUT_NHWC;
+        } else if (arg == "--input") {
+            ok = ParseDims(value, options.inputs);
+        } else if (arg == "--output") {
+            ok = ParseDims(value, options.outputs);
+        } else if (arg == "--image-type") {
+            ok = ParseImageType(value, pre.aippImageType);
+        } else if (arg == "--crop") {
+            uint32_t rect[4] = { 0, 0, 0, 0 };
+            ok = ParseUints(value, ',', rect, 4) && rect[2] > 0 && rect[3] > 0;
+            pre.aippCropSwitch = 1;
+            pre.aippCropX = rect[0];
+            pre.aippCropY = rect[1];
+            pre.aippCropW = rect[2];
+            pre.aippCropH = rect[3];
+        } else if (arg == "--dtc-mean") {
+            ok = ParseFloats(value, pre.aippDtcMean, 3);
+        } else if (arg == "--dtc-var-reci") {
+            ok = ParseFloats(value, pre.aippDtcVarReci, 3);
+        } else {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return false;
+        }
+        if (!ok) {
+            fprintf(stderr, "invalid value %s for %s\n", value, arg.c_str());
+            return false;
+        }
+    }
+    if (options.model.empty() || options.out.empty()) {
+        return false;
+    }
+    if (options.inputs.empty() != options.outputs.empty()) {
+        fprintf(stderr, "give both --input and --output dims, or neither\n");
+        return false;
+    }
+    return true;
+}
+
+// label table section of a label file, \n or \r\n separated
+static bool PackLabels(const vector<uint8_t>& text, vector<uint8_t>& section)
+{
+    vector<uint32_t> offsets(1, 0);
+    string labels;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = start;
+        while (end < text.size() && text[end] != '\n') {
+            ++end;
+        }
+        size_t length = end - start;
+        if (length > 0 && text[start + length - 1] == '\r') {
+            --length;
+        }
+        labels.append(reinterpret_cast<const char*>(text.data()) + start, length);
+        if (labels.size() > UINT32_MAX) {
+            return false;
+        }
+        offsets.push_back((uint32_t)labels.size());
+        start = end + 1;
+    }
+    uint32_t count = (uint32_t)offsets.size() - 1;
+    section.resize(BundleLabelsSize(count, (uint32_t)labels.size()));
+    memcpy(section.data(), &count, sizeof(count));
+    memcpy(section.data() + sizeof(count), offsets.data(), offsets.size() * sizeof(uint32_t));
+    memcpy(section.data() + sizeof(count) + offsets.size() * sizeof(uint32_t), labels.data(), labels.size());
+    return true;
+}
+
+static bool Pack(const PackOptions& options, vector<uint8_t>& file)
+{
+    vector<uint8_t> model;
+    if (!ReadFile(options.model, model)) {
+        return false;
+    }
+    struct Part {
+        uint32_t type;
+        vector<uint8_t> data;
+    };
+    vector<Part> parts;
+    parts.push_back(Part { BUNDLE_SECTION_PREPROCESS, vector<uint8_t>(sizeof(BundlePreprocess)) });
+    memcpy(parts.back().data.data(), &options.preprocess, sizeof(BundlePreprocess));
+    if (!options.inputs.empty()) {
+        uint32_t counts[2] = { (uint32_t)options.inputs.size(), (uint32_t)options.outputs.size() };
+        vector<uint8_t> io(BundleIoDimsSize(counts[0], counts[1]));
+        memcpy(io.data(), counts, sizeof(counts));
+        memcpy(io.data() + sizeof(counts), options.inputs.data(), options.inputs.size() * sizeof(BundleDims));
+        memcpy(io.data() + sizeof(counts) + options.inputs.size() * sizeof(BundleDims), options.outputs.data(),
+            options.outputs.size() * sizeof(BundleDims));
+        parts.push_back(Part { BUNDLE_SECTION_IO_DIMS, io });
+    }
+    if (!options.labels.empty()) {
+        vector<uint8_t> text;
+        vector<uint8_t> labels;
+        if (!ReadFile(options.labels, text) || !PackLabels(text, labels)) {
+            fprintf(stderr, "cannot pack the labels of %s\n", options.labels.c_str());
+            return false;
+        }
+        parts.push_back(Part { BUNDLE_SECTION_LABELS, labels });
+    }
+    // last: the small sections share the first pages
+    parts.push_back(Part { BUNDLE_SECTION_MODEL, model });
+
+    BundleHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = BUNDLE_MAGIC;
+    header.version = BUNDLE_VERSION;
+    header.headerSize = sizeof(BundleHeader);
+    header.sectionCount = (uint32_t)parts.size();
+    vector<BundleSection> sections(parts.size());
+    uint64_t offset = sizeof(BundleHeader) + sizeof(BundleSection) * parts.size();
+    for (size_t i = 0; i < parts.size(); ++i) {
+        uint64_t align = parts[i].type == BUNDLE_SECTION_MODEL ? BUNDLE_MODEL_ALIGN : BUNDLE_SECTION_ALIGN;
+        offset = (offset + align - 1) / align * align;
+        sections[i] = BundleSection { parts[i].type, (uint32_t)offset, (uint32_t)parts[i].data.size(), 0 };
+        offset += parts[i].data.size();
+        if (offset > UINT32_MAX) {
+            fprintf(stderr, "the bundle would be larger than 4 GB\n");
+            return false;
+        }
+    }
+    header.fileSize = (uint32_t)offset;
+
+    file.assign(offset, 0);
+    memcpy(file.data(), &header, sizeof(header));
+    memcpy(file.data() + sizeof(header), sections.data(), sizeof(BundleSection) * sections.size());
+    for (size_t i = 0; i < parts.size(); ++i) {
+        memcpy(file.data() + sections[i].offset, parts[i].data.data(), parts[i].data.size());
+    }
+    header.checksum = BundleMetaChecksum(file.data());
+    memcpy(file.data(), &header, sizeof(header));
+    return true;
+}
+
+static bool WriteFile(const string& path, const vector<uint8_t>& data)
+{
+    string temp = path + ".tmp";
+    FILE* file = fopen(temp.c_str(), "wb");
+    if (file == nullptr) {
+        fprintf(stderr, "cannot create %s: %s\n", temp.c_str(), strerror(errno));
+        return false;
+    }
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temp.c_str(), path.c_str()) != 0) {
+        fprintf(stderr, "cannot write %s\n", path.c_str());
+        remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    // the format is little-endian, as every Android ABI
+    const uint32_t one = 1;
+    if (*reinterpret_cast<const uint8_t*>(&one) != 1) {
+        fprintf(stderr, "pack_model_bundle runs on little-endian hosts only\n");
+        return 1;
+    }
+    PackOptions options;
+    if (!ParseArgs(argc, argv, options)) {
+        Usage();
+        return 1;
+    }
+    vector<uint8_t> file;
+    if (!Pack(options, file) || !WriteFile(options.out, file)) {
+        return 1;
+    }
+    printf("%s: %zu bytes, %u inputs, %u outputs%s\n", options.out.c_str(), file.size(),
+        (uint32_t)options.inputs.size(), (uint32_t)options.outputs.size(), options.labels.empty() ? "" : ", labels");
+    return 0;
+}
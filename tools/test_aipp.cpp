@@ -0,0 +1,272 @@
+/*
+ * @file test_aipp.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * Host test of the AIPP paths of a camera frame: the CPU fallback (RunCpuAipp
+ * on BuildDynamicAippConfig) against a float reference of crop, CSC, U/V swap
+ * and DTC, and the parameters CreateDynamicAippTensor submits to the DDK, as
+ * the stub of hiai_stub.cpp records them, against the CPU fallback.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "cpu_aipp.h"
+#include "dynamic_aipp.h"
+#include "hiai_stub.h"
+#include "host_test.h"
+
+using namespace std;
+using namespace hiai;
+
+static const uint32_t FRAME_W = 64;
+static const uint32_t FRAME_H = 48;
+
+struct AippCase {
+    ImageType imageType;
+    bool nv21;
+    AippCropPara crop;
+    bool dtc;
+};
+
+static vector<AippCase> AippCases()
+{
+    vector<AippCase> cases;
+    AippCropPara none;
+    AippCropPara even;
+    even.switch_ = true;
+    even.cropStartPosW = 8;
+    even.cropStartPosH = 6;
+    even.cropSizeW = 40;
+    even.cropSizeH = 30;
+    // YUV420SP crops start on even pixels: 7,5 is taken as 6,4
+    AippCropPara odd = even;
+    odd.cropStartPosW = 7;
+    odd.cropStartPosH = 5;
+    for (ImageType imageType : { JPEG, BT_601_NARROW, BT_601_FULL, BT_709_NARROW }) {
+        for (bool nv21 : { false, true }) {
+            for (const AippCropPara& crop : { none, even, odd }) {
+                for (bool dtc : { false, true }) {
+                    cases.push_back(AippCase{ imageType, nv21, crop, dtc });
+                }
+            }
+        }
+    }
+    return cases;
+}
+
+static DynamicAippRequest MakeRequest(const AippCase& c)
+{
+    DynamicAippRequest request;
+    request.frameW = FRAME_W;
+    request.frameH = FRAME_H;
+    request.crop = c.crop;
+    request.imageType = c.imageType;
+    request.nv21 = c.nv21;
+    if (c.dtc) {
+        // fractional means, as ImageNet ones: the fraction goes to the DTC min
+        const float mean[3] = { 123.68f, 116.779f, 103.939f };
+        const float varReci[3] = { 0.0171f, 0.0175f, 0.0174f };
+        for (int i = 0; i < 3; ++i) {
+            request.mean[i] = mean[i];
+            request.varReci[i] = varReci[i];
+        }
+    }
+    return request;
+}
+
+static vector<uint8_t> RandomFrame(mt19937& rng)
+{
+    vector<uint8_t> frame(FRAME_W * FRAME_H * 3 / 2);
+    for (uint8_t& v : frame) {
+        v = static_cast<uint8_t>(rng());
+    }
+    return frame;
+}
+
+static bool RunFallback(const CpuAippConfig& config, const vector<uint8_t>& frame, vector<float>& output)
+{
+    CpuAippShape shape;
+    if (CpuAippOutputShape(config, shape) != AI_SUCCESS) {
+        return false;
+    }
+    output.assign((size_t)shape.number * shape.channel * shape.height * shape.width, NAN);
+    return RunCpuAipp(config, frame.data(), (uint32_t)frame.size(), output.data(),
+        (uint32_t)(output.size() * sizeof(float)), 1) == AI_SUCCESS;
+}
+
+/* YUV to RGB in float, from the colour matrix definitions, clamped to 8 bits */
+static void ReferenceRgb(ImageType imageType, int y, int u, int v, float rgb[3])
+{
+    float luma = static_cast<float>(y);
+    float kr = 0.299f;
+    float kb = 0.114f;
+    float lumaScale = 1.0f;
+    float chromaScale = 1.0f;
+    if (imageType == BT_601_NARROW || imageType == BT_709_NARROW) {
+        luma -= 16.0f;
+        lumaScale = 255.0f / 219.0f;
+        chromaScale = 255.0f / 224.0f;
+    }
+    if (imageType == BT_709_NARROW) {
+        kr = 0.2126f;
+        kb = 0.0722f;
+    }
+    const float cb = (u - 128.0f) * chromaScale;
+    const float cr = (v - 128.0f) * chromaScale;
+    const float kg = 1.0f - kr - kb;
+    const float r = luma * lumaScale + 2.0f * (1.0f - kr) * cr;
+    const float b = luma * lumaScale + 2.0f * (1.0f - kb) * cb;
+    const float g = (luma * lumaScale - kr * r - kb * b) / kg;
+    rgb[0] = fminf(fmaxf(r, 0.0f), 255.0f);
+    rgb[1] = fminf(fmaxf(g, 0.0f), 255.0f);
+    rgb[2] = fminf(fmaxf(b, 0.0f), 255.0f);
+}
+
+HOST_TEST(FallbackMatchesReference)
+{
+    mt19937 rng(5);
+    for (const AippCase& c : AippCases()) {
+        const DynamicAippRequest request = MakeRequest(c);
+        const vector<uint8_t> frame = RandomFrame(rng);
+        const uint32_t cropX = c.crop.switch_ ? (c.crop.cropStartPosW & ~1u) : 0;
+        const uint32_t cropY = c.crop.switch_ ? (c.crop.cropStartPosH & ~1u) : 0;
+        const uint32_t outW = c.crop.switch_ ? c.crop.cropSizeW : FRAME_W;
+        const uint32_t outH = c.crop.switch_ ? c.crop.cropSizeH : FRAME_H;
+        // no resize: every output pixel is one frame pixel
+        CpuAippConfig config;
+        HOST_CHECK(BuildDynamicAippConfig(request, outW, outH, config) == AI_SUCCESS, "type %d: no config",
+            c.imageType);
+        vector<float> output;
+        HOST_CHECK(RunFallback(config, frame, output), "type %d: RunCpuAipp failed", c.imageType);
+
+        const uint8_t* chroma = frame.data() + FRAME_W * FRAME_H;
+        float worst = 0.0f;
+        for (uint32_t y = 0; y < outH; ++y) {
+            for (uint32_t x = 0; x < outW; ++x) {
+                const uint32_t fx = cropX + x;
+                const uint32_t fy = cropY + y;
+                const uint8_t* uv = chroma + (fy / 2) * FRAME_W + (fx & ~1u);
+                const int u = c.nv21 ? uv[1] : uv[0];
+                const int v = c.nv21 ? uv[0] : uv[1];
+                float rgb[3];
+                ReferenceRgb(c.imageType, frame[fy * FRAME_W + fx], u, v, rgb);
+                for (uint32_t ch = 0; ch < 3; ++ch) {
+                    const float expected = (rgb[ch] - request.mean[ch]) * request.varReci[ch];
+                    const float actual = output[(ch * outH + y) * outW + x];
+                    // the 8-bit fixed point matrix of the DDK is within 2 levels of the float one
+                    worst = fmaxf(worst, fabsf(actual - expected) / request.varReci[ch]);
+                }
+            }
+        }
+        HOST_CHECK(worst <= 2.0f, "type %d nv21 %d crop %d dtc %d: %.2f levels off the reference", c.imageType,
+            c.nv21, c.crop.switch_, c.dtc, worst);
+    }
+}
+
+HOST_TEST(SubmittedParametersMatchRequest)
+{
+    for (const AippCase& c : AippCases()) {
+        const DynamicAippRequest request = MakeRequest(c);
+        CpuAippConfig config;
+        HOST_CHECK(BuildDynamicAippConfig(request, 24, 20, config) == AI_SUCCESS, "no config");
+        shared_ptr<AiTensor> frame = make_shared<AiTensor>();
+        HOST_CHECK(frame->Init(1, FRAME_H, FRAME_W, AiTensorImage_YUV420SP_U8) == AI_SUCCESS, "no frame tensor");
+        shared_ptr<AippTensor> tensor = CreateDynamicAippTensor(frame, config, c.imageType, 2);
+        HOST_CHECK(tensor != nullptr, "CreateDynamicAippTensor failed");
+        HOST_CHECK(tensor->GetAiTensor() == frame && tensor->GetBuffer() == frame->GetBuffer(),
+            "the AippTensor does not wrap the frame");
+        HOST_CHECK(tensor->GetAippParas().size() == 1, "%zu AippParas", tensor->GetAippParas().size());
+
+        AippPara& para = *tensor->GetAippParas(0);
+        HOST_CHECK(para.GetBatchCount() == 1 && para.GetInputIndex() == 2, "batch or input index differs");
+        HOST_CHECK(para.GetInputFormat() == AiTensorImage_YUV420SP_U8 &&
+            para.GetInputShape().srcImageSizeW == FRAME_W && para.GetInputShape().srcImageSizeH == FRAME_H,
+            "input differs");
+        HostAippCscRequest csc = HostAippCscRequestOf(para);
+        HOST_CHECK(csc.set && csc.targetFormat == AiTensorImage_RGB888_U8 && csc.imageType == c.imageType,
+            "SetCscPara(%d, %d) for image type %d", csc.targetFormat, csc.imageType, c.imageType);
+        HOST_CHECK(para.GetChannelSwapPara().rbuvSwapSwitch == c.nv21 && !para.GetChannelSwapPara().axSwapSwitch,
+            "channel swap differs for nv21 %d", c.nv21);
+        AippCropPara crop = para.GetCropPara(0);
+        HOST_CHECK(crop.switch_ == c.crop.switch_, "crop switch differs");
+        if (c.crop.switch_) {
+            HOST_CHECK(crop.cropStartPosW == (c.crop.cropStartPosW & ~1u) &&
+                crop.cropStartPosH == (c.crop.cropStartPosH & ~1u) && crop.cropSizeW == c.crop.cropSizeW &&
+                crop.cropSizeH == c.crop.cropSizeH, "crop differs");
+        }
+        AippResizePara resize = para.GetResizePara(0);
+        HOST_CHECK(resize.switch_ && resize.resizeOutputSizeW == 24 && resize.resizeOutputSizeH == 20,
+            "resize differs");
+        AippDtcPara dtc = para.GetDtcPara(0);
+        HOST_CHECK(fabsf(dtc.pixelMeanChn0 + dtc.pixelMinChn0 - request.mean[0]) < 1e-4f &&
+            fabsf(dtc.pixelMeanChn2 + dtc.pixelMinChn2 - request.mean[2]) < 1e-4f &&
+            dtc.pixelVarReciChn1 == request.varReci[1], "DTC differs");
+    }
+}
+
+HOST_TEST(SubmittedParametersRunLikeFallback)
+{
+    // what the NPU would be asked to do, run by the CPU engine, is what the
+    // fallback does: same crop, swap, CSC, resize and DTC
+    mt19937 rng(6);
+    for (const AippCase& c : AippCases()) {
+        const DynamicAippRequest request = MakeRequest(c);
+        const vector<uint8_t> frame = RandomFrame(rng);
+        for (uint32_t dst : { 16u, 30u }) {
+            CpuAippConfig config;
+            HOST_CHECK(BuildDynamicAippConfig(request, dst, dst, config) == AI_SUCCESS, "no config");
+            shared_ptr<AiTensor> frameTensor = make_shared<AiTensor>();
+            frameTensor->Init(1, FRAME_H, FRAME_W, AiTensorImage_YUV420SP_U8);
+            shared_ptr<AippTensor> tensor = CreateDynamicAippTensor(frameTensor, config, c.imageType, 0);
+            HOST_CHECK(tensor != nullptr, "CreateDynamicAippTensor failed");
+            CpuAippConfig submitted;
+            HOST_CHECK(CpuAippConfigFromPara(*tensor->GetAippParas(0), submitted) == AI_SUCCESS,
+                "submitted parameters do not convert");
+
+            vector<float> expected;
+            vector<float> actual;
+            HOST_CHECK(RunFallback(config, frame, expected), "fallback failed");
+            HOST_CHECK(RunFallback(submitted, frame, actual), "submitted parameters do not run");
+            HOST_CHECK(expected == actual, "type %d nv21 %d crop %d dtc %d to %u: submitted parameters differ "
+                "from the fallback", c.imageType, c.nv21, c.crop.switch_, c.dtc, dst);
+        }
+    }
+}
+
+HOST_TEST(InvalidRequestsAreRejected)
+{
+    CpuAippConfig config;
+    DynamicAippRequest request;
+    request.frameW = FRAME_W + 1;
+    request.frameH = FRAME_H;
+    HOST_CHECK(BuildDynamicAippConfig(request, 16, 16, config) == AI_INVALID_PARA, "odd frame width accepted");
+    request.frameW = FRAME_W;
+    request.crop.switch_ = true;
+    request.crop.cropStartPosW = FRAME_W - 8;
+    request.crop.cropSizeW = 16;
+    request.crop.cropSizeH = 16;
+    HOST_CHECK(BuildDynamicAippConfig(request, 16, 16, config) == AI_INVALID_PARA, "crop past the frame accepted");
+    request.crop.cropStartPosW = 0;
+    request.crop.cropSizeW = 0;
+    HOST_CHECK(BuildDynamicAippConfig(request, 16, 16, config) == AI_INVALID_PARA, "empty crop accepted");
+}
+
+HOST_TEST(DynamicAippNeedsDdkVersion)
+{
+    AiModelMngerClient client;
+    HostSetDdkVersion("100.310.010.013");
+    HOST_CHECK(!IsDynamicAippSupported(client), "dynamic AIPP used before %s", AIPP_BASE_VERSION);
+    HostSetDdkVersion(AIPP_BASE_VERSION);
+    HOST_CHECK(IsDynamicAippSupported(client), "dynamic AIPP not used with %s", AIPP_BASE_VERSION);
+}
+
+HOST_TEST_MAIN()
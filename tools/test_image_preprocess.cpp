@@ -0,0 +1,153 @@
+/*
+ * @file test_image_preprocess.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * Host test of the SIMD packer of image_preprocess.cpp against its scalar
+ * reference, and of the fused crop-resize at the input size. The SIMD loops take 4 or 8 pixels at a time and leave the rest
+ * of a row to the scalar tail, so the widths go around those steps, and the
+ * strides include padded and unaligned rows. The image is allocated to the
+ * last byte of its last row, so an over-read shows under ASan.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "host_test.h"
+#include "image_preprocess.h"
+
+using namespace std;
+
+static const float MEAN[3] = { 103.939f, 116.779f, 123.68f };
+// guard written after the tensor, the packer must not touch it
+static const float GUARD = -12345.0f;
+
+struct PackCase {
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+};
+
+static vector<PackCase> PackCases()
+{
+    vector<PackCase> cases;
+    vector<uint32_t> widths;
+    for (uint32_t w = 1; w <= 33; ++w) {
+        widths.push_back(w);
+    }
+    widths.insert(widths.end(), { 63, 65, 223, 225, 227, 639, 1079 });
+    for (uint32_t w : widths) {
+        for (uint32_t height : { 1u, 3u, 8u }) {
+            // tight, padded to 16 bytes, padded by a few pixels, unaligned
+            for (uint32_t stride : { w * 4, (w * 4 + 15) / 16 * 16, w * 4 + 12, w * 4 + 3 }) {
+                cases.push_back(PackCase{ w, height, stride });
+            }
+        }
+    }
+    return cases;
+}
+
+static vector<uint8_t> RandomImage(const PackCase& c, mt19937& rng)
+{
+    vector<uint8_t> rgba((c.height - 1) * (size_t)c.stride + c.width * 4);
+    for (uint8_t& v : rgba) {
+        v = static_cast<uint8_t>(rng());
+    }
+    return rgba;
+}
+
+static bool SameFloats(const vector<float>& a, const vector<float>& b)
+{
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+HOST_TEST(PackMatchesReference)
+{
+    mt19937 rng(1);
+    for (const PackCase& c : PackCases()) {
+        vector<uint8_t> rgba = RandomImage(c, rng);
+        const size_t count = 3 * (size_t)c.width * c.height;
+        vector<float> expected(count);
+        vector<float> actual(count + 1, GUARD);
+        PackRgbaToBgrPlanesRef(rgba.data(), c.width, c.height, c.stride, MEAN, expected.data());
+        PackRgbaToBgrPlanes(rgba.data(), c.width, c.height, c.stride, MEAN, actual.data());
+        HOST_CHECK(actual[count] == GUARD, "%ux%u stride %u wrote past the tensor", c.width, c.height, c.stride);
+        actual.pop_back();
+        HOST_CHECK(SameFloats(expected, actual), "%ux%u stride %u differs from the reference",
+            c.width, c.height, c.stride);
+    }
+}
+
+HOST_TEST(PackRowsMatchReference)
+{
+    mt19937 rng(2);
+    for (const PackCase& c : PackCases()) {
+        if (c.height < 3) {
+            continue;
+        }
+        vector<uint8_t> rgba = RandomImage(c, rng);
+        const size_t count = 3 * (size_t)c.width * c.height;
+        vector<float> expected(count);
+        vector<float> actual(count, GUARD);
+        PackRgbaToBgrPlanesRef(rgba.data(), c.width, c.height, c.stride, MEAN, expected.data());
+        // uneven bands, as ParallelFor cuts them
+        const uint32_t cuts[] = { 0, 1, c.height / 2, c.height };
+        for (int band = 0; band < 3; ++band) {
+            PackRgbaToBgrPlanesRows(rgba.data(), c.width, c.height, c.stride, MEAN, cuts[band], cuts[band + 1],
+                actual.data());
+        }
+        HOST_CHECK(SameFloats(expected, actual), "%ux%u stride %u by bands differs from the reference",
+            c.width, c.height, c.stride);
+    }
+}
+
+HOST_TEST(PackExtremePixels)
+{
+    // 0 and 255 in every channel, alpha included, must not leak across lanes
+    for (uint32_t width : { 7u, 8u, 9u, 17u }) {
+        for (uint8_t fill : { (uint8_t)0, (uint8_t)255 }) {
+            vector<uint8_t> rgba(width * 4, fill);
+            for (uint32_t x = 0; x < width; x += 3) {
+                rgba[x * 4 + 3] = static_cast<uint8_t>(255 - fill);
+            }
+            vector<float> expected(3 * width);
+            vector<float> actual(3 * width);
+            PackRgbaToBgrPlanesRef(rgba.data(), width, 1, width * 4, MEAN, expected.data());
+            PackRgbaToBgrPlanes(rgba.data(), width, 1, width * 4, MEAN, actual.data());
+            HOST_CHECK(SameFloats(expected, actual), "width %u filled with %u differs from the reference", width, fill);
+        }
+    }
+}
+
+HOST_TEST(CropResizeAtInputSizeCopies)
+{
+    // a bitmap already scaled to the input, as SyncClassifyActivity passes it,
+    // must come out exactly as (pixel - mean) * scale, R,G,B planes
+    const NormalizeSpec spec = { { 0.0f, 0.0f, 0.0f }, { 1 / 255.0f, 1 / 255.0f, 1 / 255.0f }, false };
+    mt19937 rng(3);
+    for (const PackCase& c : { PackCase{ 7, 5, 7 * 4 }, PackCase{ 224, 224, 224 * 4 + 12 } }) {
+        vector<uint8_t> rgba = RandomImage(c, rng);
+        const size_t planeSize = (size_t)c.width * c.height;
+        vector<float> expected(3 * planeSize);
+        for (uint32_t y = 0; y < c.height; ++y) {
+            for (uint32_t x = 0; x < c.width; ++x) {
+                for (uint32_t p = 0; p < 3; ++p) {
+                    float v = rgba[y * (size_t)c.stride + x * 4 + p];
+                    expected[p * planeSize + y * c.width + x] = (v - spec.mean[p]) * spec.scale[p];
+                }
+            }
+        }
+        vector<float> actual(3 * planeSize);
+        CropResizeNormalize(rgba.data(), c.width, c.height, c.stride, c.width, c.height, spec, actual.data());
+        HOST_CHECK(SameFloats(expected, actual), "%ux%u is not copied as is", c.width, c.height);
+    }
+}
+
+HOST_TEST_MAIN()
@@ -0,0 +1,281 @@
+/*
+ * @file test_model_bundle.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * Host test of pack_model_bundle against ModelBundle: a bundle packed by the
+ * tool opens with everything that went in, and a damaged one does not open.
+ * PACK_MODEL_BUNDLE is the path of the tool and TEST_TMP_DIR a directory for
+ * the files, both given by CMakeLists.txt.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "host_test.h"
+#include "model_bundle.h"
+
+using namespace std;
+using namespace hiai;
+
+static const char* const LABELS[] = { "tench", "goldfish", "great white shark", "", "tiger shark, Galeocerdo" };
+static const uint32_t LABEL_COUNT = sizeof(LABELS) / sizeof(LABELS[0]);
+static const size_t MODEL_SIZE = 10000;
+
+static string TmpPath(const string& name)
+{
+    return string(TEST_TMP_DIR) + "/" + name;
+}
+
+static bool WriteBytes(const string& path, const vector<uint8_t>& data)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool ok = data.empty() || fwrite(data.data(), 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && ok;
+}
+
+static vector<uint8_t> ReadBytes(const string& path)
+{
+    vector<uint8_t> data;
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return data;
+    }
+    uint8_t buffer[1 << 16];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    fclose(file);
+    return data;
+}
+
+static vector<uint8_t> FakeModel()
+{
+    mt19937 rng(7);
+    vector<uint8_t> model(MODEL_SIZE);
+    for (uint8_t& v : model) {
+        v = static_cast<uint8_t>(rng());
+    }
+    return model;
+}
+
+/* Pack a fake model with CRLF labels, every preprocessing field and dims */
+static bool PackDemoBundle(const string& path)
+{
+    string labels;
+    for (uint32_t i = 0; i < LABEL_COUNT; ++i) {
+        labels += string(LABELS[i]) + (i % 2 == 0 ? "\r\n" : "\n");
+    }
+    if (!WriteBytes(TmpPath("model.om"), FakeModel()) ||
+        !WriteBytes(TmpPath("labels.txt"), vector<uint8_t>(labels.begin(), labels.end()))) {
+        return false;
+    }
+    string command = string(PACK_MODEL_BUNDLE) + " --model " + TmpPath("model.om") + " --labels " +
+        TmpPath("labels.txt") + " --out " + path +
+        " --mean 103.5,116.25,123.75 --std 58.5,57.0,57.5 --order rgb --input 1x3x224x224 --output 1x1000x1x1" +
+        " --aipp --image-type bt709-narrow --nv21 --crop 8,16,200,100 --dtc-mean 1,2,3 --dtc-var-reci 0.5,0.25,2" +
+        " > /dev/null";
+    return system(command.c_str()) == 0;
+}
+
+static shared_ptr<ModelBundle> OpenBytes(const vector<uint8_t>& data)
+{
+    const string path = TmpPath("damaged.omb");
+    if (!WriteBytes(path, data)) {
+        return nullptr;
+    }
+    return ModelBundle::Open(ModelMapping::MapFile(path));
+}
+
+/* End of the last section but the model: the bytes a flip can damage unseen by the DDK */
+static uint32_t MetadataEnd(const vector<uint8_t>& data)
+{
+    const BundleHeader* header = reinterpret_cast<const BundleHeader*>(data.data());
+    const BundleSection* sections = reinterpret_cast<const BundleSection*>(data.data() + header->headerSize);
+    uint32_t end = header->headerSize + sizeof(BundleSection) * header->sectionCount;
+    for (uint32_t i = 0; i < header->sectionCount; ++i) {
+        if (sections[i].type != BUNDLE_SECTION_MODEL) {
+            end = max(end, sections[i].offset + sections[i].size);
+        }
+    }
+    return end;
+}
+
+/* Bytes the checksum covers, as BundleMetaChecksum walks them */
+static vector<bool> ChecksumCoverage(const vector<uint8_t>& data)
+{
+    const BundleHeader* header = reinterpret_cast<const BundleHeader*>(data.data());
+    const BundleSection* sections = reinterpret_cast<const BundleSection*>(data.data() + header->headerSize);
+    vector<bool> covered(data.size(), false);
+    fill(covered.begin(), covered.begin() + header->headerSize + sizeof(BundleSection) * header->sectionCount, true);
+    for (uint32_t i = 0; i < header->sectionCount; ++i) {
+        if (sections[i].type != BUNDLE_SECTION_MODEL) {
+            fill(covered.begin() + sections[i].offset, covered.begin() + sections[i].offset + sections[i].size, true);
+        }
+    }
+    return covered;
+}
+
+HOST_TEST(RoundTrip)
+{
+    const string path = TmpPath("demo.omb");
+    HOST_CHECK(PackDemoBundle(path), "pack_model_bundle failed");
+    shared_ptr<ModelMapping> file = ModelMapping::MapFile(path);
+    HOST_CHECK(file != nullptr && ModelBundle::IsBundle(*file), "the packed file is not a bundle");
+    shared_ptr<ModelBundle> bundle = ModelBundle::Open(file);
+    HOST_CHECK(bundle != nullptr, "the packed bundle does not open");
+
+    shared_ptr<ModelMapping> model = bundle->Model();
+    vector<uint8_t> expected = FakeModel();
+    HOST_CHECK(model != nullptr && model->Size() == expected.size() &&
+        memcmp(model->Data(), expected.data(), expected.size()) == 0, "the model differs from the packed one");
+    HOST_CHECK(reinterpret_cast<uintptr_t>(model->Data()) % BUNDLE_MODEL_ALIGN == 0, "the model is not page aligned");
+    HOST_CHECK(model->Mapped(), "the model slice is not a mapping");
+
+    HOST_CHECK(bundle->LabelCount() == LABEL_COUNT, "%u labels", bundle->LabelCount());
+    for (uint32_t i = 0; i < LABEL_COUNT; ++i) {
+        size_t length = 0;
+        const char* label = bundle->Label(i, length);
+        HOST_CHECK(label != nullptr && string(label, length) == LABELS[i], "label %u differs", i);
+    }
+    size_t length = 0;
+    HOST_CHECK(bundle->Label(LABEL_COUNT, length) == nullptr, "a label past the table");
+
+    const BundlePreprocess* pre = bundle->Preprocess();
+    HOST_CHECK(pre != nullptr, "no preprocessing");
+    HOST_CHECK(pre->useAipp == 1 && pre->aippNv21 == 1 && pre->aippImageType == BT_709_NARROW, "AIPP input differs");
+    HOST_CHECK(pre->aippCropSwitch == 1 && pre->aippCropX == 8 && pre->aippCropY == 16 && pre->aippCropW == 200 &&
+        pre->aippCropH == 100, "AIPP crop differs");
+    HOST_CHECK(pre->aippDtcMean[2] == 3.0f && pre->aippDtcVarReci[0] == 0.5f && pre->aippDtcVarReci[2] == 2.0f,
+        "AIPP DTC differs");
+    HOST_CHECK(pre->layout == BUNDLE_LAYOUT_NCHW, "layout differs");
+    NormalizeSpec spec = bundle->Normalize();
+    HOST_CHECK(!spec.bgr && spec.mean[0] == 103.5f && spec.mean[2] == 123.75f && spec.scale[1] == 1.0f / 57.0f,
+        "normalization differs");
+
+    vector<TensorDimension> inputs = { TensorDimension(1, 3, 224, 224) };
+    vector<TensorDimension> outputs = { TensorDimension(1, 1000, 1, 1) };
+    vector<TensorDimension> otherOutputs = { TensorDimension(1, 1001, 1, 1) };
+    HOST_CHECK(bundle->MatchesIo(inputs, outputs), "the packed dims do not match");
+    HOST_CHECK(!bundle->MatchesIo(inputs, otherOutputs), "other output dims match");
+    HOST_CHECK(!bundle->MatchesIo(inputs, {}), "a missing output matches");
+}
+
+HOST_TEST(BitFlipsAreRejected)
+{
+    const string path = TmpPath("flips.omb");
+    HOST_CHECK(PackDemoBundle(path), "pack_model_bundle failed");
+    const vector<uint8_t> data = ReadBytes(path);
+    const vector<bool> covered = ChecksumCoverage(data);
+    const uint32_t end = MetadataEnd(data);
+    // every bit of the metadata; padding between sections is all the checksum may miss
+    for (uint32_t offset = 0; offset < end; ++offset) {
+        for (int bit = 0; bit < 8; ++bit) {
+            vector<uint8_t> damaged = data;
+            damaged[offset] ^= static_cast<uint8_t>(1 << bit);
+            bool opened = OpenBytes(damaged) != nullptr;
+            HOST_CHECK(!opened || !covered[offset], "bit %d of byte %u flipped, the bundle still opens", bit, offset);
+        }
+    }
+}
+
+HOST_TEST(TruncationsAreRejected)
+{
+    const string path = TmpPath("truncated.omb");
+    HOST_CHECK(PackDemoBundle(path), "pack_model_bundle failed");
+    const vector<uint8_t> data = ReadBytes(path);
+    for (size_t size = 0; size < data.size(); ++size) {
+        vector<uint8_t> truncated(data.begin(), data.begin() + size);
+        HOST_CHECK(OpenBytes(truncated) == nullptr, "truncated to %zu of %zu bytes, the bundle still opens",
+            size, data.size());
+    }
+    vector<uint8_t> extended = data;
+    extended.push_back(0);
+    HOST_CHECK(OpenBytes(extended) == nullptr, "one byte appended, the bundle still opens");
+}
+
+/* Every accessor of an opened bundle stays inside its file */
+static bool InsideFile(const ModelBundle& bundle, const vector<uint8_t>& data, const ModelMapping& file)
+{
+    const uint8_t* begin = static_cast<const uint8_t*>(file.Data());
+    auto inside = [&](const void* p, size_t size) {
+        const uint8_t* q = static_cast<const uint8_t*>(p);
+        return q >= begin && q + size <= begin + data.size();
+    };
+    shared_ptr<ModelMapping> model = bundle.Model();
+    if (model == nullptr || !inside(model->Data(), model->Size())) {
+        return false;
+    }
+    for (uint32_t i = 0; i < bundle.LabelCount(); ++i) {
+        size_t length = 0;
+        const char* label = bundle.Label(i, length);
+        if (!inside(label, length)) {
+            return false;
+        }
+    }
+    const BundleIoDims* io = bundle.IoDims();
+    return (bundle.Preprocess() == nullptr || inside(bundle.Preprocess(), sizeof(BundlePreprocess))) &&
+        (io == nullptr || inside(io, BundleIoDimsSize(io->inputCount, io->outputCount)));
+}
+
+HOST_TEST(RandomHeadersAreSafe)
+{
+    // random section tables behind a valid header; where the sections are in
+    // bounds the checksum is made right, so the structural checks are what rejects
+    mt19937 rng(3);
+    const string path = TmpPath("random.omb");
+    uint32_t checked = 0;
+    for (int round = 0; round < 20000; ++round) {
+        vector<uint8_t> data(sizeof(BundleHeader) + rng() % 8192);
+        for (uint8_t& v : data) {
+            v = static_cast<uint8_t>(rng());
+        }
+        BundleHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = BUNDLE_MAGIC;
+        header.version = BUNDLE_VERSION;
+        header.headerSize = sizeof(BundleHeader);
+        header.sectionCount = rng() % 6;
+        header.fileSize = rng() % 8 == 0 ? static_cast<uint32_t>(rng()) : static_cast<uint32_t>(data.size());
+        const uint64_t tableEnd = sizeof(BundleHeader) + sizeof(BundleSection) * header.sectionCount;
+        bool inBounds = tableEnd <= data.size();
+        for (uint32_t i = 0; i < header.sectionCount && inBounds; ++i) {
+            BundleSection section;
+            section.type = 1 + rng() % 5;
+            section.offset = (rng() % 2 == 0 ? BUNDLE_SECTION_ALIGN : BUNDLE_MODEL_ALIGN) * (rng() % 4);
+            section.size = rng() % 3 == 0 ? static_cast<uint32_t>(rng()) : rng() % 512;
+            section.reserved = 0;
+            memcpy(data.data() + sizeof(BundleHeader) + i * sizeof(BundleSection), &section, sizeof(section));
+            inBounds = (uint64_t)section.offset + section.size <= data.size();
+        }
+        memcpy(data.data(), &header, sizeof(header));
+        if (inBounds) {
+            header.checksum = BundleMetaChecksum(data.data());
+            memcpy(data.data(), &header, sizeof(header));
+            checked++;
+        }
+        if (!WriteBytes(path, data)) {
+            HOST_CHECK(false, "cannot write %s", path.c_str());
+        }
+        shared_ptr<ModelMapping> file = ModelMapping::MapFile(path);
+        shared_ptr<ModelBundle> bundle = ModelBundle::Open(file);
+        HOST_CHECK(bundle == nullptr || InsideFile(*bundle, data, *file), "round %d opened out of bounds", round);
+    }
+    HOST_CHECK(checked > 1000, "only %u rounds got past the checksum", checked);
+}
+
+HOST_TEST_MAIN()
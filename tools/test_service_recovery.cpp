@@ -0,0 +1,319 @@
+/*
+ * @file test_service_recovery.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * Host test of ServiceRecovery under a stream of asynchronous requests, with
+ * the stub client of hiai_stub.cpp killed in the middle of it. Stream does
+ * what classify_async_jni.cpp does around the recovery: it tags requests with
+ * the generation of the client they went to, and its replay resubmits those
+ * of older generations on the new client. Every request must complete exactly
+ * once, whenever the clients die.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "hiai_stub.h"
+#include "host_test.h"
+#include "service_recovery.h"
+
+using namespace std;
+using namespace hiai;
+
+static const char* MODEL_NAME = "stream_model";
+// a submitter gives up on a service that does not come back within it
+static const chrono::seconds SUBMIT_TIMEOUT(3);
+
+class Stream {
+public:
+    explicit Stream(uint32_t requests)
+        : completions_(requests, 0), recovery_([this] { return Reload(); }, [this](bool recovered) { Replay(recovered); })
+    {
+        Reload();
+    }
+
+    ~Stream()
+    {
+        vector<shared_ptr<AiModelMngerClient>> clients;
+        {
+            lock_guard<mutex> lock(mutex_);
+            clients.swap(clients_);
+        }
+        // joins the workers of the clients, which may be waiting for mutex_
+        clients.clear();
+    }
+
+    /*
+    * @brief Submit request id to the current client, waiting for a recovery
+    * @return false if the service did not come back
+    */
+    bool Submit(int id)
+    {
+        ServiceRecovery::Clock::time_point deadline = ServiceRecovery::Clock::now() + SUBMIT_TIMEOUT;
+        while (ServiceRecovery::Clock::now() < deadline && recovery_.WaitReady(deadline)) {
+            {
+                lock_guard<mutex> lock(mutex_);
+                if (ProcessLocked(id)) {
+                    return true;
+                }
+            }
+            // the client died after WaitReady returned: its death is on the way
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        lock_guard<mutex> lock(mutex_);
+        failed_++;
+        return false;
+    }
+
+    void KillCurrent()
+    {
+        shared_ptr<AiModelMngerClient> client;
+        {
+            lock_guard<mutex> lock(mutex_);
+            client = client_;
+        }
+        HostKillClient(*client);
+    }
+
+    bool WaitSettled(chrono::milliseconds timeout)
+    {
+        unique_lock<mutex> lock(mutex_);
+        return settled_.wait_for(lock, timeout, [this] { return completed_ + failed_ == completions_.size(); });
+    }
+
+    bool EachCompletedOnce()
+    {
+        lock_guard<mutex> lock(mutex_);
+        for (uint32_t count : completions_) {
+            if (count != 1) {
+                return false;
+            }
+        }
+        return lost_.empty() && inflight_.empty();
+    }
+
+    uint32_t Failed()
+    {
+        lock_guard<mutex> lock(mutex_);
+        return failed_;
+    }
+
+    ServiceRecovery& Recovery()
+    {
+        return recovery_;
+    }
+
+private:
+    class Listener : public AiModelManagerClientListener {
+    public:
+        Listener(Stream* stream, uint32_t generation) : stream_(stream), generation_(generation)
+        {
+        }
+
+        void OnProcessDone(const AiContext& context, int32_t result,
+            const vector<shared_ptr<AiTensor>>& outTensor, int32_t stamp) override
+        {
+            (void)context;
+            (void)result;
+            (void)outTensor;
+            stream_->Done(generation_, stamp);
+        }
+
+        void OnServiceDied() override
+        {
+            // as JNIListener: the death of a client already replaced is old news
+            if (generation_ == stream_->generation_) {
+                stream_->recovery_.OnServiceDied();
+            }
+        }
+
+    private:
+        Stream* stream_;
+        uint32_t generation_;
+    };
+
+    bool Reload()
+    {
+        uint32_t generation = ++nextGeneration_;
+        shared_ptr<AiModelMngerClient> client = make_shared<AiModelMngerClient>();
+        client->Init(make_shared<Listener>(this, generation));
+        vector<shared_ptr<AiModelDescription>> models = { make_shared<AiModelDescription>(MODEL_NAME, 3, 0, 0, 0) };
+        bool loaded = client->Load(models) == AI_SUCCESS;
+        lock_guard<mutex> lock(mutex_);
+        // kept to the end: a worker of a dead client may be waiting for mutex_
+        clients_.push_back(client);
+        if (loaded) {
+            client_ = client;
+            generation_ = generation;
+        }
+        return loaded;
+    }
+
+    void Replay(bool recovered)
+    {
+        lock_guard<mutex> lock(mutex_);
+        vector<int> lost;
+        lost.swap(lost_);
+        for (auto it = inflight_.begin(); it != inflight_.end();) {
+            if (!recovered || it->first.first < generation_) {
+                lost.push_back(it->second);
+                it = inflight_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        uint32_t replayed = 0;
+        for (int id : lost) {
+            if (!recovered) {
+                failed_++;
+            } else if (ProcessLocked(id)) {
+                replayed++;
+            } else {
+                // the new client died under the replay: for the next one
+                lost_.push_back(id);
+            }
+        }
+        recovery_.CountReplayed(replayed, recovered ? 0 : lost.size());
+        settled_.notify_all();
+    }
+
+    bool ProcessLocked(int id)
+    {
+        AiContext context;
+        context.AddPara("model_name", MODEL_NAME);
+        vector<shared_ptr<AiTensor>> inputs;
+        vector<shared_ptr<AiTensor>> outputs;
+        int32_t stamp = -1;
+        if (client_->Process(context, inputs, outputs, 1000, stamp) != AI_SUCCESS) {
+            return false;
+        }
+        inflight_[make_pair(generation_.load(), stamp)] = id;
+        return true;
+    }
+
+    void Done(uint32_t generation, int32_t stamp)
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto it = inflight_.find(make_pair(generation, stamp));
+        if (it == inflight_.end()) {
+            return;
+        }
+        completions_[it->second]++;
+        completed_++;
+        inflight_.erase(it);
+        settled_.notify_all();
+    }
+
+    mutex mutex_;
+    condition_variable settled_;
+    shared_ptr<AiModelMngerClient> client_;
+    vector<shared_ptr<AiModelMngerClient>> clients_;
+    // read by the listeners without mutex_: the stub reports a death inside Process
+    atomic<uint32_t> generation_{ 0 };
+    uint32_t nextGeneration_ = 0;
+    // (generation, stamp) of a request in flight -> its id
+    map<pair<uint32_t, int32_t>, int> inflight_;
+    // lost with a client that died under the replay
+    vector<int> lost_;
+    vector<uint32_t> completions_;
+    size_t completed_ = 0;
+    size_t failed_ = 0;
+    ServiceRecovery recovery_;
+};
+
+static void ResetDdk(uint32_t processUs)
+{
+    HostDdkLatency latency;
+    latency.loadUs = 2000;
+    latency.processUs = processUs;
+    HostSetDdkLatency(latency);
+    HostFailLoads(0);
+}
+
+HOST_TEST(KillMidStream)
+{
+    ResetDdk(500);
+    const uint32_t submitters = 3;
+    const uint32_t perSubmitter = 100;
+    Stream stream(submitters * perSubmitter);
+    HostKillClientAt(40);
+    HostKillClientAt(170);
+    vector<thread> threads;
+    for (uint32_t s = 0; s < submitters; ++s) {
+        threads.emplace_back([&stream, s, perSubmitter] {
+            for (uint32_t i = 0; i < perSubmitter; ++i) {
+                stream.Submit(s * perSubmitter + i);
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    HOST_CHECK(stream.WaitSettled(chrono::milliseconds(5000)), "requests still in flight");
+    HOST_CHECK(stream.Failed() == 0, "%u requests failed", stream.Failed());
+    HOST_CHECK(stream.EachCompletedOnce(), "a request was lost or completed twice");
+    stream.Recovery().WaitReady(ServiceRecovery::Clock::now() + chrono::seconds(1));
+    RecoveryStats stats = stream.Recovery().GetStats();
+    HOST_CHECK(stats.state == SERVICE_READY, "state %d", stats.state);
+    HOST_CHECK(stats.deaths == 2 && stats.recoveries == 2, "%u deaths, %u recoveries", stats.deaths,
+        stats.recoveries);
+    HOST_CHECK(stats.replayed > 0, "nothing was replayed");
+}
+
+HOST_TEST(KillDuringReplay)
+{
+    // slow enough that every request is still in flight when the client dies
+    ResetDdk(20000);
+    const uint32_t requests = 10;
+    Stream stream(requests);
+    // the 5th request kills the first client, the 2nd request the replay resubmits the next one
+    HostKillClientAt(5);
+    HostKillClientAt(7);
+    for (uint32_t i = 0; i < requests; ++i) {
+        HOST_CHECK(stream.Submit(i), "request %u was not submitted: the service never came back", i);
+    }
+    HOST_CHECK(stream.WaitSettled(chrono::milliseconds(5000)), "requests still in flight");
+    HOST_CHECK(stream.EachCompletedOnce(), "a request was lost or completed twice");
+    stream.Recovery().WaitReady(ServiceRecovery::Clock::now() + chrono::seconds(1));
+    RecoveryStats stats = stream.Recovery().GetStats();
+    HOST_CHECK(stats.state == SERVICE_READY, "state %d", stats.state);
+    // the death under the replay is part of the same recovery
+    HOST_CHECK(stats.deaths == 2 && stats.recoveries == 1, "%u deaths, %u recoveries", stats.deaths,
+        stats.recoveries);
+}
+
+HOST_TEST(FailedReloadsLoseTheService)
+{
+    ResetDdk(20000);
+    const uint32_t requests = 6;
+    Stream stream(requests);
+    for (uint32_t i = 0; i < requests / 2; ++i) {
+        HOST_CHECK(stream.Submit(i), "request %u was not submitted", i);
+    }
+    HostFailLoads(1000);
+    stream.KillCurrent();
+    for (uint32_t i = requests / 2; i < requests; ++i) {
+        HOST_CHECK(!stream.Submit(i), "request %u went to a lost service", i);
+    }
+    HOST_CHECK(stream.WaitSettled(chrono::milliseconds(100)), "requests in flight on a lost service");
+    HOST_CHECK(stream.Failed() == requests, "%u of %u requests failed", stream.Failed(), requests);
+    RecoveryStats stats = stream.Recovery().GetStats();
+    HOST_CHECK(stats.state == SERVICE_LOST, "state %d", stats.state);
+    HOST_CHECK(stats.failedRecoveries == 1 && stats.failedFast == requests / 2, "%u failed recoveries, %llu failed fast",
+        stats.failedRecoveries, (unsigned long long)stats.failedFast);
+    HostFailLoads(0);
+}
+
+HOST_TEST_MAIN()
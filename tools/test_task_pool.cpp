@@ -0,0 +1,183 @@
+/*
+ * @file test_task_pool.cpp
+ *
+ * Copyright (C) 2019. Huawei Technologies Co., Ltd. All rights reserved.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * Host test of TaskPool saturated with the images of assets/val_batch, as the
+ * app loads them: every image is decoded to RGBA with libjpeg (BitmapFactory
+ * on the device) and cropped, resized and normalized in row bands on the pool
+ * by several callers at once, some of them pool tasks themselves, as the
+ * pipeline and the sync callers do. Each tensor must match the one computed
+ * on a single thread. VAL_BATCH_DIR is the directory of the images.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+// after cstddef and cstdio, which it needs
+#include <jpeglib.h>
+#include "host_test.h"
+#include "image_preprocess.h"
+#include "task_pool.h"
+
+using namespace std;
+
+static const uint32_t INPUT_W = 224;
+static const uint32_t INPUT_H = 224;
+static const uint32_t ROWS_PER_TASK = 16;
+static const uint32_t CALLERS = 4;
+static const uint32_t ROUNDS = 3;
+
+struct Image {
+    string name;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    vector<uint8_t> rgba;
+};
+
+static bool DecodeJpeg(const string& path, Image& image)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    jpeg_decompress_struct info;
+    jpeg_error_mgr error;
+    info.err = jpeg_std_error(&error);
+    jpeg_create_decompress(&info);
+    jpeg_stdio_src(&info, file);
+    jpeg_read_header(&info, TRUE);
+    info.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&info);
+    image.width = info.output_width;
+    image.height = info.output_height;
+    image.rgba.assign((size_t)image.width * image.height * 4, 255);
+    vector<uint8_t> row((size_t)image.width * 3);
+    while (info.output_scanline < info.output_height) {
+        uint8_t* out = &image.rgba[(size_t)info.output_scanline * image.width * 4];
+        JSAMPROW rows[1] = { row.data() };
+        jpeg_read_scanlines(&info, rows, 1);
+        for (uint32_t x = 0; x < image.width; ++x) {
+            memcpy(&out[x * 4], &row[x * 3], 3);
+        }
+    }
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+    fclose(file);
+    return true;
+}
+
+static vector<Image> LoadValBatch()
+{
+    vector<Image> images;
+    DIR* dir = opendir(VAL_BATCH_DIR);
+    if (dir == nullptr) {
+        return images;
+    }
+    while (dirent* entry = readdir(dir)) {
+        string name = entry->d_name;
+        if (name.size() < 4 || name.compare(name.size() - 4, 4, ".jpg") != 0) {
+            continue;
+        }
+        Image image;
+        image.name = name;
+        if (DecodeJpeg(string(VAL_BATCH_DIR) + "/" + name, image)) {
+            images.push_back(move(image));
+        }
+    }
+    closedir(dir);
+    return images;
+}
+
+static const NormalizeSpec SPEC = { { 123.675f, 116.28f, 103.53f }, { 1 / 58.395f, 1 / 57.12f, 1 / 57.375f }, false };
+
+static void Preprocess(TaskPool& pool, const Image& image, float* tensor)
+{
+    ParallelFor(pool, INPUT_H, ROWS_PER_TASK, [&](uint32_t first, uint32_t last) {
+        CropResizeNormalizeRows(image.rgba.data(), image.width, image.height, image.width * 4, INPUT_W, INPUT_H,
+            SPEC, first, last, tensor);
+    });
+}
+
+HOST_TEST(SaturatedWithValBatch)
+{
+    vector<Image> images = LoadValBatch();
+    HOST_CHECK(images.size() >= 100, "%zu images decoded from %s", images.size(), VAL_BATCH_DIR);
+    const size_t tensorSize = 3 * INPUT_W * INPUT_H;
+    vector<vector<float>> expected(images.size(), vector<float>(tensorSize));
+    for (size_t i = 0; i < images.size(); ++i) {
+        CropResizeNormalize(images[i].rgba.data(), images[i].width, images[i].height, images[i].width * 4, INPUT_W,
+            INPUT_H, SPEC, expected[i].data());
+    }
+
+    // one tensor per image, caller and round
+    const size_t jobs = images.size() * CALLERS * ROUNDS;
+    vector<vector<float>> tensors(jobs, vector<float>(tensorSize));
+    mutex doneMutex;
+    condition_variable doneCv;
+    size_t done = 0;
+    auto finish = [&] {
+        lock_guard<mutex> lock(doneMutex);
+        done++;
+        doneCv.notify_all();
+    };
+    // after what its tasks use: a pool runs what is left of them when destroyed
+    TaskPoolConfig config;
+    config.threads = 4;
+    TaskPool pool(config);
+    vector<thread> callers;
+    for (uint32_t c = 0; c < CALLERS; ++c) {
+        callers.emplace_back([&, c] {
+            for (uint32_t round = 0; round < ROUNDS; ++round) {
+                for (size_t i = 0; i < images.size(); ++i) {
+                    float* tensor = tensors[(c * ROUNDS + round) * images.size() + i].data();
+                    if (c % 2 == 0) {
+                        // a sync caller: its bands run on it and on idle workers
+                        Preprocess(pool, images[i], tensor);
+                        finish();
+                    } else {
+                        // a pipeline stage: a pool task whose bands nest on the pool
+                        pool.Submit([&pool, &images, i, tensor, &finish] {
+                            Preprocess(pool, images[i], tensor);
+                            finish();
+                        });
+                    }
+                }
+            }
+        });
+    }
+    for (thread& caller : callers) {
+        caller.join();
+    }
+    {
+        unique_lock<mutex> lock(doneMutex);
+        HOST_CHECK(doneCv.wait_for(lock, chrono::seconds(30), [&] { return done == jobs; }),
+            "%zu of %zu images preprocessed: the pool stalled", done, jobs);
+    }
+    for (size_t job = 0; job < jobs; ++job) {
+        const size_t i = job % images.size();
+        HOST_CHECK(memcmp(tensors[job].data(), expected[i].data(), tensorSize * sizeof(float)) == 0,
+            "%s differs from its single-thread tensor", images[i].name.c_str());
+    }
+    TaskPoolStats stats = pool.GetStats();
+    HOST_CHECK(stats.threads == config.threads, "%u threads", stats.threads);
+    HOST_CHECK(stats.executed >= images.size() * ROUNDS * (CALLERS / 2), "%llu tasks executed",
+        (unsigned long long)stats.executed);
+}
+
+HOST_TEST_MAIN()